@@ -19,6 +19,8 @@
 #include <memory>
 #include <string>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/carnot.h"
 #include "src/carnot/engine_state.h"
 #include "src/carnot/exec/exec_graph.h"
@@ -32,6 +34,16 @@
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int64(carnot_result_cache_bytes, gflags::Int64FromEnv("PL_CARNOT_RESULT_CACHE_BYTES", 0),
+             "The number of bytes of plan fragment results Carnot keeps to serve repeated queries "
+             "over unchanged tables. 0 disables the cache.");
+DEFINE_int64(carnot_query_memory_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_LIMIT_BYTES", 0),
+             "The most memory that a query may have allocated at a time. 0 is no limit.");
+DEFINE_int64(carnot_query_cpu_time_limit_ms,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_CPU_TIME_LIMIT_MS", 0),
+             "The most CPU time that a query may use. 0 is no limit.");
+
 namespace px {
 namespace carnot {
 
@@ -63,6 +75,9 @@ class CarnotImpl final : public Carnot {
 
   Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze) override;
 
+  Status SendExecutionError(const planpb::Plan& plan, const sole::uuid& query_id,
+                            const Status& exec_error) override;
+
   void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) override {
     agent_md_callback_ = func;
   };
@@ -99,6 +114,8 @@ class CarnotImpl final : public Carnot {
   std::unique_ptr<grpc::Server> grpc_server_;
   std::unique_ptr<exec::GRPCRouter> grpc_router_;
   int grpc_server_port_;
+  // Caches the results of plan fragments, or nullptr if disabled.
+  std::unique_ptr<exec::ResultCache> result_cache_;
 
   // The id of the agent that owns this Carnot instance.
   sole::uuid agent_id_;
@@ -114,6 +131,9 @@ Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registr
   grpc_server_creds_ = grpc_server_creds;
   grpc_server_port_ = grpc_server_port;
   grpc_router_ = std::make_unique<exec::GRPCRouter>();
+  if (FLAGS_carnot_result_cache_bytes > 0) {
+    result_cache_ = std::make_unique<exec::ResultCache>(FLAGS_carnot_result_cache_bytes);
+  }
   if (grpc_server_port_ > 0) {
     grpc_server_thread_ = std::make_unique<std::thread>(&CarnotImpl::GRPCServerFunc, this);
   }
@@ -283,6 +303,8 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // For each of the plan fragments in the plan, execute the query.
   std::vector<std::string> output_table_strs;
   auto exec_state = engine_state_->CreateExecState(query_id);
+  exec_state->set_memory_limit_bytes(FLAGS_carnot_query_memory_limit_bytes);
+  exec_state->set_cpu_time_limit_ns(FLAGS_carnot_query_cpu_time_limit_ms * 1000 * 1000);
 
   // TODO(michellenguyen/zasgar, PP-2579): We should periodically update the metadata state for
   // long-running queries after a certain time duration or number of row batches processed. For now,
@@ -300,6 +322,7 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   queryresultspb::AgentExecutionStats agent_operator_exec_stats;
   ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
   timer.Start();
+  exec_state->cpu_timer()->Start();
   // Unclear how we'll use plan fragments in the future (they're currently unused). For now, we will
   // share the schema between plan fragments.
   auto schema = std::make_unique<table_store::schema::Schema>();
@@ -309,6 +332,15 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
             auto exec_graph = exec::ExecutionGraph();
             PL_RETURN_IF_ERROR(exec_graph.Init(schema.get(), plan_state.get(), exec_state.get(), pf,
                                                /* collect_exec_node_stats */ analyze));
+            // Analyze asks for the stats of an actual execution, so it bypasses the cache.
+            if (result_cache_ != nullptr && !analyze) {
+              for (const auto& pf_pb : logical_plan.nodes()) {
+                if (static_cast<int64_t>(pf_pb.id()) == pf->id()) {
+                  exec_graph.UseResultCache(result_cache_.get(),
+                                            exec::ResultCache::Fingerprint(pf_pb));
+                }
+              }
+            }
             PL_RETURN_IF_ERROR(exec_graph.Execute());
             std::vector<std::string> frag_sinks = exec_graph.OutputTables();
             output_table_strs.insert(output_table_strs.end(), frag_sinks.begin(), frag_sinks.end());
@@ -338,6 +370,31 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                 stats_pb->set_records_output(stats->rows_output);
                 stats_pb->set_total_execution_time_ns(total_time_ns);
                 stats_pb->set_self_execution_time_ns(self_time_ns);
+                stats_pb->set_total_cpu_time_ns(stats->TotalCPUTime());
+                stats_pb->set_self_cpu_time_ns(stats->SelfCPUTime());
+                stats_pb->set_bytes_input(stats->bytes_input);
+                stats_pb->set_records_input(stats->rows_input);
+                stats_pb->set_self_bytes_allocated(stats->SelfBytesAllocated());
+                stats_pb->set_wait_time_ns(stats->WaitTime());
+                const auto& hist_counts = stats->batch_self_time_hist.counts();
+                for (int bucket = 0; bucket < exec::LatencyHistogram::kNumBuckets; ++bucket) {
+                  if (hist_counts[bucket] == 0) {
+                    continue;
+                  }
+                  auto* bucket_pb = stats_pb->mutable_batch_self_time()->add_buckets();
+                  bucket_pb->set_upper_bound_ns(exec::LatencyHistogram::BucketUpperBoundNS(bucket));
+                  bucket_pb->set_count(hist_counts[bucket]);
+                }
+                for (const auto& [name, udf_stats] : stats->udf_stats) {
+                  auto* udf_stats_pb = stats_pb->add_udf_stats();
+                  udf_stats_pb->set_name(name);
+                  udf_stats_pb->set_calls(udf_stats.calls);
+                  udf_stats_pb->set_records_processed(udf_stats.rows);
+                  udf_stats_pb->set_execution_time_ns(udf_stats.exec_time_ns);
+                }
+                for (int64_t child_id : pf->dag().DependenciesOf(node_id)) {
+                  stats_pb->add_child_node_ids(child_id);
+                }
 
                 for (const auto& [k, v] : stats->extra_metrics) {
                   (*stats_pb->mutable_extra_metrics())[k] = v;
@@ -358,6 +415,7 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
     incoming_agents.push_back(id);
   }
   timer.Stop();
+  exec_state->cpu_timer()->Stop();
   int64_t exec_time_ns = timer.ElapsedTime_us() * 1000;
 
   std::vector<queryresultspb::AgentExecutionStats> input_agent_stats;
@@ -376,6 +434,8 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   agent_operator_exec_stats.set_execution_time_ns(exec_time_ns);
   agent_operator_exec_stats.set_bytes_processed(bytes_processed);
   agent_operator_exec_stats.set_records_processed(rows_processed);
+  agent_operator_exec_stats.set_cpu_time_ns(exec_state->cpu_time_ns());
+  agent_operator_exec_stats.set_peak_memory_bytes(exec_state->peak_memory_bytes());
 
   std::vector<queryresultspb::AgentExecutionStats> all_agent_stats;
   if (analyze) {
@@ -391,6 +451,47 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                                                 agent_operator_exec_stats, all_agent_stats);
 }
 
+Status CarnotImpl::SendExecutionError(const planpb::Plan& plan, const sole::uuid& query_id,
+                                      const Status& exec_error) {
+  // The exec state holds the stubs, as it does for the GRPC sinks of an executed query.
+  auto exec_state = engine_state_->CreateExecState(query_id);
+  ::px::carnotpb::TransferResultChunkRequest req;
+  ToProto(query_id, req.mutable_query_id());
+  exec_error.ToProto(req.mutable_execution_error());
+
+  absl::flat_hash_set<std::string> addresses;
+  for (const auto& pf : plan.nodes()) {
+    for (const auto& node : pf.nodes()) {
+      if (node.op().op_type() != planpb::GRPC_SINK_OPERATOR ||
+          !node.op().grpc_sink_op().has_output_table()) {
+        continue;
+      }
+      const auto& sink = node.op().grpc_sink_op();
+      if (!addresses.insert(sink.address()).second) {
+        continue;
+      }
+      auto server = exec_state->ResultSinkServiceStub(sink.address(),
+                                                      sink.connection_options().ssl_targetname());
+      ::px::carnotpb::TransferResultChunkResponse resp;
+      req.set_address(sink.address());
+      grpc::ClientContext context;
+      engine_state_->add_auth_to_grpc_context_func()(&context);
+      context.set_deadline(std::chrono::system_clock::now() + kRPCResultTimeout);
+      auto writer = server->TransferResultChunk(&context, &resp);
+      writer->Write(req);
+      writer->WritesDone();
+      auto status = writer->Finish();
+      if (!status.ok()) {
+        return error::Internal(
+            "Failed to call Finish on TransferResultChunk while sending query execution error. "
+            "Status: $0",
+            status.error_message());
+      }
+    }
+  }
+  return Status::OK();
+}
+
 CarnotImpl::~CarnotImpl() {
   if (grpc_server_ && grpc_server_thread_) {
     grpc_server_->Shutdown();
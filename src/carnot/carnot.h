@@ -72,6 +72,15 @@ class Carnot : public NotCopyable {
   virtual Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id,
                              bool analyze = false) = 0;
 
+  /**
+   * Sends the error that kept the plan from being executed to the receivers of its result tables
+   * (i.e. the query broker), so that they fail the query rather than wait for its results.
+   * Plans that only send their results to other Carnot instances have nothing to send it to, and
+   * the query fails once the downstream instance gives up on their results.
+   */
+  virtual Status SendExecutionError(const planpb::Plan& plan, const sole::uuid& query_id,
+                                    const Status& exec_error) = 0;
+
   /**
    * Registers the callback for updating the agents metadata state.
    */
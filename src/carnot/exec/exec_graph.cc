@@ -21,7 +21,10 @@
 #include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "src/carnot/exec/agg_node.h"
 #include "src/carnot/exec/empty_source_node.h"
@@ -70,27 +73,33 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         return OnOperatorImpl<plan::MemorySinkOperator, MemorySinkNode>(node, &descriptors);
       })
       .OnAggregate([&](auto& node) {
+        row_local_ = false;
         return OnOperatorImpl<plan::AggregateOperator, AggNode>(node, &descriptors);
       })
       .OnMemorySource([&](auto& node) {
+        memory_sources_.push_back(node.id());
         return OnOperatorImpl<plan::MemorySourceOperator, MemorySourceNode>(node, &descriptors);
       })
       .OnFilter([&](auto& node) {
         return OnOperatorImpl<plan::FilterOperator, FilterNode>(node, &descriptors);
       })
       .OnLimit([&](auto& node) {
+        row_local_ = false;
         return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors);
       })
       .OnUnion([&](auto& node) {
+        row_local_ = false;
         return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors);
       })
       .OnJoin([&](auto& node) {
+        row_local_ = false;
         return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors);
       })
       .OnGRPCSource([&](auto& node) {
         auto s = OnOperatorImpl<plan::GRPCSourceOperator, GRPCSourceNode>(node, &descriptors);
         PL_RETURN_IF_ERROR(s);
         grpc_sources_.insert(node.id());
+        has_uncacheable_sources_ = true;
         return exec_state->grpc_router()->AddGRPCSourceNode(
             exec_state->query_id(), node.id(), static_cast<GRPCSourceNode*>(nodes_[node.id()]),
             std::bind(&ExecutionGraph::Continue, this));
@@ -100,6 +109,7 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         return OnOperatorImpl<plan::GRPCSinkOperator, GRPCSinkNode>(node, &descriptors);
       })
       .OnUDTFSource([&](auto& node) {
+        has_uncacheable_sources_ = true;
         return OnOperatorImpl<plan::UDTFSourceOperator, UDTFSourceNode>(node, &descriptors);
       })
       .OnEmptySource([&](auto& node) {
@@ -220,6 +230,7 @@ Status ExecutionGraph::ExecuteSources() {
       }
     }
     PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+    PL_RETURN_IF_ERROR(exec_state_->CheckResourceLimits());
 
     // Flush all of the completed sources.
     for (SourceNode* source : completed_sources_execute_loop) {
@@ -247,6 +258,13 @@ Status ExecutionGraph::ExecuteSources() {
       YieldWithTimeout();
       timer.Stop();
 
+      // None of the sources had data, so the GRPC sources among them were blocked on it.
+      for (SourceNode* source : running_sources) {
+        if (grpc_sources_.contains(source_to_id.at(source))) {
+          source->stats()->AddWaitTime(timer.ElapsedTime_us() * 1000);
+        }
+      }
+
       absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
 
       // This check is used for Memory sources that are waiting on data, because we don't currently
@@ -304,9 +322,40 @@ Status ExecutionGraph::Execute() {
     PL_RETURN_IF_ERROR(node->Open(exec_state_));
   }
 
+  std::string cache_key = ResultCacheKey();
+  std::shared_ptr<const ResultCache::Entry> cached;
+  // The first of the cached sink inputs that are replayed.
+  int64_t first_cached_input = 0;
+  // Whether the sources run. If not, the cached entry is replayed in their place.
+  bool execute_sources = true;
+  if (!cache_key.empty()) {
+    cached = result_cache_->Get(cache_key);
+    if (cached != nullptr && !IncrementallyCacheable()) {
+      // The key pins the rows that the sources read, so the entry holds all of the results.
+      execute_sources = false;
+    } else if (cached != nullptr &&
+               (first_cached_input = ReplaceRowsWithCached(cached, &execute_sources)) >= 0) {
+      if (execute_sources) {
+        // The entry is replaced by one that covers the rows of this execution.
+        RecordSinkInputs();
+      }
+    } else {
+      cached = nullptr;
+      if (result_cache_->Admit(cache_key)) {
+        RecordSinkInputs();
+      }
+    }
+  }
+  served_from_result_cache_ = cached != nullptr;
+
   // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
   // nodes, even if there was an error during execution.
-  Status source_status = ExecuteSources();
+  Status source_status = Status::OK();
+  if (execute_sources) {
+    source_status = ExecuteSources();
+  } else {
+    source_status = ReplaySinkInputs(*cached, first_cached_input, /* end_of_stream */ true);
+  }
   Status close_status = Status::OK();
 
   for (auto node : nodes) {
@@ -324,9 +373,135 @@ Status ExecutionGraph::Execute() {
   if (!source_status.ok()) {
     return source_status;
   }
+  if (close_status.ok() && recording_sink_inputs_ &&
+      recorded_sink_input_bytes_ <= result_cache_->max_bytes()) {
+    result_cache_->Put(cache_key, {std::move(recorded_sink_inputs_), ResultCacheWatermark()});
+  }
   return close_status;
 }
 
+bool ExecutionGraph::IncrementallyCacheable() const {
+  return row_local_ && memory_sources_.size() == 1;
+}
+
+std::string ExecutionGraph::ResultCacheKey() const {
+  if (result_cache_ == nullptr || has_uncacheable_sources_) {
+    return "";
+  }
+  std::string key = result_cache_fingerprint_;
+  for (int64_t src_id : memory_sources_) {
+    auto source = static_cast<const MemorySourceNode*>(nodes_.at(src_id));
+    // Streaming sources never finish, so there are no final results to cache.
+    if (source->infinite_stream()) {
+      return "";
+    }
+    absl::StrAppend(&key, "|", src_id);
+    // Incremental entries cover any rows of the source, see ReplaceRowsWithCached().
+    if (!IncrementallyCacheable()) {
+      auto [start, stop] = source->row_id_range();
+      absl::StrAppend(&key, ":", start, ":", stop);
+    }
+  }
+  // Metadata UDFs resolve against the metadata state, so its updates invalidate results too.
+  if (exec_state_->metadata_state() != nullptr) {
+    absl::StrAppend(&key, "|md:", exec_state_->metadata_state()->content_version());
+  }
+  return key;
+}
+
+int64_t ExecutionGraph::ResultCacheWatermark() const {
+  if (!IncrementallyCacheable()) {
+    return -1;
+  }
+  auto source = static_cast<const MemorySourceNode*>(nodes_.at(memory_sources_.front()));
+  return source->row_id_range().second;
+}
+
+int64_t ExecutionGraph::ReplaceRowsWithCached(std::shared_ptr<const ResultCache::Entry> entry,
+                                              bool* execute_sources) {
+  auto source = static_cast<MemorySourceNode*>(nodes_.at(memory_sources_.front()));
+  auto [start, stop] = source->row_id_range();
+  // A watermark past the stop comes from a wider time window than this execution's.
+  if (start == -1 || entry->watermark <= start || entry->watermark > stop) {
+    return -1;
+  }
+  // The inputs of the rows before the start, which expired or are outside of the time window of
+  // this execution, are left out. The rows of a batch that straddles the start are read again.
+  const auto& inputs = entry->sink_inputs;
+  int64_t first_input = 0;
+  while (first_input < static_cast<int64_t>(inputs.size()) &&
+         inputs[first_input].row_ids.first < start) {
+    ++first_input;
+  }
+  if (first_input == static_cast<int64_t>(inputs.size()) ||
+      inputs[first_input].row_ids.first >= entry->watermark) {
+    return -1;
+  }
+  int64_t begin = inputs[first_input].row_ids.first;
+  if (begin == start && entry->watermark == stop) {
+    *execute_sources = false;
+    return first_input;
+  }
+  bool replaced =
+      source->ReplaceRowIDRange(begin, entry->watermark, [this, entry, first_input]() {
+        return ReplaySinkInputs(*entry, first_input, /* end_of_stream */ false);
+      });
+  return replaced ? first_input : -1;
+}
+
+void ExecutionGraph::RecordSinkInputs() {
+  recording_sink_inputs_ = true;
+  recorded_sink_inputs_.clear();
+  recorded_sink_input_bytes_ = 0;
+  std::vector<int64_t> sink_ids(sinks_.begin(), sinks_.end());
+  sink_ids.insert(sink_ids.end(), grpc_sinks_.begin(), grpc_sinks_.end());
+  for (int64_t sink_id : sink_ids) {
+    nodes_.at(sink_id)->set_input_recorder([this, sink_id](const RowBatch& rb, size_t parent) {
+      if (recorded_sink_input_bytes_ > result_cache_->max_bytes()) {
+        return;
+      }
+      recorded_sink_input_bytes_ += rb.NumBytes();
+      if (recorded_sink_input_bytes_ > result_cache_->max_bytes()) {
+        // Too large to ever be cached, so stop holding onto the batches.
+        recorded_sink_inputs_.clear();
+        return;
+      }
+      std::pair<int64_t, int64_t> row_ids = {-1, -1};
+      if (replayed_sink_input_ != nullptr) {
+        row_ids = replayed_sink_input_->row_ids;
+      } else if (IncrementallyCacheable()) {
+        row_ids = static_cast<const MemorySourceNode*>(nodes_.at(memory_sources_.front()))
+                      ->last_row_id_range();
+      }
+      recorded_sink_inputs_.push_back(
+          {sink_id, parent, std::make_shared<const RowBatch>(rb), row_ids});
+    });
+  }
+}
+
+Status ExecutionGraph::ReplaySinkInputs(const ResultCache::Entry& entry, size_t first_input,
+                                        bool end_of_stream) {
+  for (size_t i = first_input; i < entry.sink_inputs.size(); ++i) {
+    const auto& input = entry.sink_inputs[i];
+    ExecNode* sink = nodes_.at(input.sink_id);
+    replayed_sink_input_ = &input;
+    Status s;
+    if (end_of_stream || !input.rb->eos()) {
+      s = sink->ConsumeNext(exec_state_, *input.rb, input.parent_index);
+    } else if (input.rb->num_rows() > 0) {
+      // The rows past the watermark follow, so the stream doesn't end here. The columns are
+      // shared, only the flags are copied.
+      RowBatch rb = *input.rb;
+      rb.set_eow(false);
+      rb.set_eos(false);
+      s = sink->ConsumeNext(exec_state_, rb, input.parent_index);
+    }
+    replayed_sink_input_ = nullptr;
+    PL_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
 std::vector<std::string> ExecutionGraph::OutputTables() const {
   std::vector<std::string> output_tables;
   // Go through the sinks.
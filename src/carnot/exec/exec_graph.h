@@ -32,6 +32,7 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/result_cache.h"
 #include "src/carnot/plan/plan_fragment.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/common/base/base.h"
@@ -121,6 +122,23 @@ class ExecutionGraph {
     return node->second;
   }
 
+  /**
+   * Serves the results of this graph out of the cache when its sources would read the same rows
+   * as an earlier execution of the same fragment, and records them into the cache otherwise.
+   * Only graphs whose sources are all finite memory sources are cached.
+   * @param cache The result cache, which must outlive the graph.
+   * @param fingerprint The ResultCache::Fingerprint() of the plan fragment.
+   */
+  void UseResultCache(ResultCache* cache, std::string fingerprint) {
+    result_cache_ = cache;
+    result_cache_fingerprint_ = std::move(fingerprint);
+  }
+
+  /**
+   * Whether the last Execute() replayed its results from the result cache.
+   */
+  bool served_from_result_cache() const { return served_from_result_cache_; }
+
   /**
    * Executes the current graph until there is no more work that can be done synchronously.
    */
@@ -210,6 +228,25 @@ class ExecutionGraph {
 
   Status ExecuteSources();
 
+  // Whether the graph only maps and filters the rows of a single memory source, so that its
+  // results for more rows of the source are its cached results plus those of the new rows.
+  bool IncrementallyCacheable() const;
+  // Returns the result cache key of this graph's execution, or an empty string if it shouldn't be
+  // cached. Must be called after the sources are opened.
+  std::string ResultCacheKey() const;
+  // Returns the stop row ID of the memory source of an incrementally cacheable graph, or -1.
+  int64_t ResultCacheWatermark() const;
+  // Sets up the replay of the inputs of an incremental entry for the rows of the memory source
+  // that it covers, from the first input it returns. The memory source reads the other rows,
+  // unless the entry covers all of them, in which case execute_sources is cleared. Returns -1 if
+  // the entry can't be used.
+  int64_t ReplaceRowsWithCached(std::shared_ptr<const ResultCache::Entry> entry,
+                                bool* execute_sources);
+  void RecordSinkInputs();
+  // Replays the cached sink inputs from the given one. Unless end_of_stream is set, the end of
+  // stream flags are left out, since the sources run after the replay.
+  Status ReplaySinkInputs(const ResultCache::Entry& entry, size_t first_input, bool end_of_stream);
+
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
   table_store::schema::Schema* schema_;
@@ -219,8 +256,24 @@ class ExecutionGraph {
   std::vector<int64_t> sinks_;
   absl::flat_hash_set<int64_t> grpc_sources_;
   absl::flat_hash_set<int64_t> grpc_sinks_;
+  std::vector<int64_t> memory_sources_;
+  // Whether the graph has a source other than memory sources and empty sources.
+  bool has_uncacheable_sources_ = false;
+  // Whether every operator works on each row on its own (i.e. maps and filters), across row
+  // batches and executions alike.
+  bool row_local_ = true;
   std::unordered_map<int64_t, ExecNode*> nodes_;
 
+  ResultCache* result_cache_ = nullptr;
+  std::string result_cache_fingerprint_;
+  // The sink inputs recorded during this execution, dropped if they outgrow the cache.
+  bool recording_sink_inputs_ = false;
+  std::vector<ResultCache::SinkInput> recorded_sink_inputs_;
+  int64_t recorded_sink_input_bytes_ = 0;
+  // The cached sink input that is being replayed, if any.
+  const ResultCache::SinkInput* replayed_sink_input_ = nullptr;
+  bool served_from_result_cache_ = false;
+
   SystemTimePoint query_start_time_;
 
   // How long to wait for any upstream result to make the initial connection to this query.
@@ -290,6 +290,198 @@ TEST_F(ExecGraphTest, execute_time) {
           ->Equals(types::ToArrow(out_in2, arrow::default_memory_pool())));
 }
 
+TEST_F(ExecGraphTest, execute_with_profile) {
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(planpb::testutils::kLinearPlanFragment, &pf_pb));
+  std::shared_ptr<plan::PlanFragment> plan_fragment_ = std::make_shared<plan::PlanFragment>(1);
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  auto plan_state = std::make_unique<plan::PlanState>(func_registry_.get());
+
+  auto schema = std::make_shared<table_store::schema::Schema>();
+  schema->AddRelation(
+      1, table_store::schema::Relation(
+             std::vector<types::DataType>(
+                 {types::DataType::INT64, types::DataType::BOOLEAN, types::DataType::FLOAT64}),
+             std::vector<std::string>({"a", "b", "c"})));
+
+  table_store::schema::Relation rel(
+      {types::DataType::INT64, types::DataType::BOOLEAN, types::DataType::FLOAT64},
+      {"col1", "col2", "col3"});
+  auto table = Table::Create("test", rel);
+
+  auto rb1 = RowBatch(RowDescriptor(rel.col_types()), 3);
+  std::vector<types::Int64Value> col1_in1 = {1, 2, 3};
+  std::vector<types::BoolValue> col2_in1 = {true, false, true};
+  std::vector<types::Float64Value> col3_in1 = {1.4, 6.2, 10.2};
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(col2_in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(col3_in1, arrow::default_memory_pool())));
+  EXPECT_OK(table->WriteRowBatch(rb1));
+
+  auto rb2 = RowBatch(RowDescriptor(rel.col_types()), 2);
+  std::vector<types::Int64Value> col1_in2 = {4, 5};
+  std::vector<types::BoolValue> col2_in2 = {false, false};
+  std::vector<types::Float64Value> col3_in2 = {3.4, 1.2};
+  EXPECT_OK(rb2.AddColumn(types::ToArrow(col1_in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb2.AddColumn(types::ToArrow(col2_in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb2.AddColumn(types::ToArrow(col3_in2, arrow::default_memory_pool())));
+  EXPECT_OK(table->WriteRowBatch(rb2));
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  table_store->AddTable("numbers", table);
+  auto exec_state_ = std::make_unique<ExecState>(
+      func_registry_.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+
+  EXPECT_OK(exec_state_->AddScalarUDF(
+      0, "add", std::vector<types::DataType>({types::DataType::INT64, types::DataType::FLOAT64})));
+  EXPECT_OK(exec_state_->AddScalarUDF(
+      1, "multiply",
+      std::vector<types::DataType>({types::DataType::FLOAT64, types::DataType::INT64})));
+
+  ExecutionGraph e;
+  ASSERT_OK(e.Init(schema.get(), plan_state.get(), exec_state_.get(), plan_fragment_.get(),
+                   /* collect_exec_node_stats */ true));
+  EXPECT_OK(e.Execute());
+
+  ASSERT_OK_AND_ASSIGN(ExecNode * add_node, e.node(2));
+  ExecNodeStats* stats = add_node->stats();
+  EXPECT_EQ(5, stats->rows_input);
+  EXPECT_EQ(2, stats->batches_input);
+
+  // Each batch that the node consumed lands in the histogram.
+  int64_t num_batches = 0;
+  for (int64_t count : stats->batch_self_time_hist.counts()) {
+    num_batches += count;
+  }
+  EXPECT_EQ(2, num_batches);
+
+  ASSERT_TRUE(stats->udf_stats.contains("add(INT64,FLOAT64)"));
+  EXPECT_EQ(2, stats->udf_stats["add(INT64,FLOAT64)"].calls);
+  EXPECT_EQ(5, stats->udf_stats["add(INT64,FLOAT64)"].rows);
+  EXPECT_EQ(1, stats->udf_stats.size());
+  EXPECT_EQ(0, stats->WaitTime());
+}
+
+TEST_F(ExecGraphTest, result_cache) {
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(planpb::testutils::kLinearPlanFragment, &pf_pb));
+  std::shared_ptr<plan::PlanFragment> plan_fragment_ = std::make_shared<plan::PlanFragment>(1);
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  table_store::schema::Relation rel(
+      {types::DataType::INT64, types::DataType::BOOLEAN, types::DataType::FLOAT64},
+      {"col1", "col2", "col3"});
+  // The table holds 6 rows, so that the third row batch expires the first.
+  constexpr int64_t kRowBytes = sizeof(int64_t) + sizeof(bool) + sizeof(double);
+  auto table = std::make_shared<Table>("test", rel, 6 * kRowBytes, kRowBytes);
+  auto write_row_batch = [&](std::vector<types::Int64Value> col1,
+                             std::vector<types::BoolValue> col2,
+                             std::vector<types::Float64Value> col3) {
+    auto rb = RowBatch(RowDescriptor(rel.col_types()), col1.size());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(col2, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(col3, arrow::default_memory_pool())));
+    EXPECT_OK(table->WriteRowBatch(rb));
+  };
+  write_row_batch({1, 2, 3}, {true, false, true}, {1.4, 6.2, 10.2});
+
+  ResultCache cache(1024 * 1024);
+  // Executes the fragment against a fresh output table, and returns its first column.
+  auto execute = [&](bool* served_from_cache) {
+    auto table_store = std::make_shared<table_store::TableStore>();
+    table_store->AddTable("numbers", table);
+    auto exec_state = std::make_unique<ExecState>(
+        func_registry_.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+    EXPECT_OK(exec_state->AddScalarUDF(
+        0, "add",
+        std::vector<types::DataType>({types::DataType::INT64, types::DataType::FLOAT64})));
+    EXPECT_OK(exec_state->AddScalarUDF(
+        1, "multiply",
+        std::vector<types::DataType>({types::DataType::FLOAT64, types::DataType::INT64})));
+
+    auto plan_state = std::make_unique<plan::PlanState>(func_registry_.get());
+    auto schema = std::make_shared<table_store::schema::Schema>();
+    schema->AddRelation(1, rel);
+    ExecutionGraph e;
+    EXPECT_OK(e.Init(schema.get(), plan_state.get(), exec_state.get(), plan_fragment_.get(),
+                     /* collect_exec_node_stats */ false));
+    e.UseResultCache(&cache, ResultCache::Fingerprint(pf_pb));
+    EXPECT_OK(e.Execute());
+    *served_from_cache = e.served_from_result_cache();
+
+    auto output_table = exec_state->table_store()->GetTable("output");
+    std::vector<std::shared_ptr<arrow::Array>> output;
+    for (auto slice = output_table->FirstBatch(); slice.IsValid();
+         slice = output_table->NextBatch(slice)) {
+      output.push_back(output_table
+                           ->GetRowBatchSlice(slice, std::vector<int64_t>({0}),
+                                              arrow::default_memory_pool())
+                           .ConsumeValueOrDie()
+                           ->ColumnAt(0));
+    }
+    return output;
+  };
+
+  auto first_batch = types::ToArrow(std::vector<types::Float64Value>({4.8, 16.4, 26.4}),
+                                    arrow::default_memory_pool());
+  bool served_from_cache = false;
+  auto first = execute(&served_from_cache);
+  EXPECT_FALSE(served_from_cache);
+  ASSERT_EQ(1, first.size());
+  EXPECT_TRUE(first[0]->Equals(first_batch));
+  // Results are only cached once the query is seen again.
+  EXPECT_EQ(0, cache.num_entries());
+
+  auto second = execute(&served_from_cache);
+  EXPECT_FALSE(served_from_cache);
+  ASSERT_EQ(1, second.size());
+  EXPECT_TRUE(second[0]->Equals(first_batch));
+  EXPECT_EQ(1, cache.num_entries());
+
+  // The table hasn't changed, so the results are replayed.
+  auto third = execute(&served_from_cache);
+  EXPECT_TRUE(served_from_cache);
+  ASSERT_EQ(1, third.size());
+  EXPECT_TRUE(third[0]->Equals(first_batch));
+
+  // New data moves the end of the table. Only the new rows are executed, after the cached results.
+  write_row_batch({4, 5}, {false, false}, {3.4, 1.2});
+  auto second_batch = types::ToArrow(std::vector<types::Float64Value>({14.8, 12.4}),
+                                     arrow::default_memory_pool());
+  auto fourth = execute(&served_from_cache);
+  EXPECT_TRUE(served_from_cache);
+  ASSERT_EQ(2, fourth.size());
+  EXPECT_TRUE(fourth[0]->Equals(first_batch));
+  EXPECT_TRUE(fourth[1]->Equals(second_batch));
+  // The entry is extended in place, rather than added next to the stale one.
+  EXPECT_EQ(1, cache.num_entries());
+
+  auto fifth = execute(&served_from_cache);
+  EXPECT_TRUE(served_from_cache);
+  ASSERT_EQ(2, fifth.size());
+  EXPECT_TRUE(fifth[0]->Equals(first_batch));
+  EXPECT_TRUE(fifth[1]->Equals(second_batch));
+
+  // Expiry moves the start of the table. The cached results of the rows that remain are replayed,
+  // and only the new rows are executed.
+  write_row_batch({6, 7}, {true, false}, {0.5, 2.5});
+  auto third_batch = types::ToArrow(std::vector<types::Float64Value>({13.0, 19.0}),
+                                    arrow::default_memory_pool());
+  auto sixth = execute(&served_from_cache);
+  EXPECT_TRUE(served_from_cache);
+  ASSERT_EQ(2, sixth.size());
+  EXPECT_TRUE(sixth[0]->Equals(second_batch));
+  EXPECT_TRUE(sixth[1]->Equals(third_batch));
+  EXPECT_EQ(1, cache.num_entries());
+
+  auto seventh = execute(&served_from_cache);
+  EXPECT_TRUE(served_from_cache);
+  ASSERT_EQ(2, seventh.size());
+  EXPECT_TRUE(seventh[0]->Equals(second_batch));
+  EXPECT_TRUE(seventh[1]->Equals(third_batch));
+}
+
 TEST_F(ExecGraphTest, two_limits_dont_interfere) {
   planpb::PlanFragment pf_pb;
   ASSERT_TRUE(
@@ -18,10 +18,13 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "src/carnot/exec/exec_profile.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
@@ -63,24 +66,80 @@ struct ExecNodeStats {
       return;
     }
     children_timer.Resume();
+    children_cpu_timer.Resume();
   }
   void StopChildTimer() {
     if (!collect_exec_stats) {
       return;
     }
     children_timer.Stop();
+    children_cpu_timer.Stop();
   }
   void ResumeTotalTimer() {
     if (!collect_exec_stats) {
       return;
     }
     total_timer.Resume();
+    total_cpu_timer.Resume();
   }
   void StopTotalTimer() {
     if (!collect_exec_stats) {
       return;
     }
     total_timer.Stop();
+    total_cpu_timer.Stop();
+  }
+
+  // Brackets a single call into the node, to profile the batch that it processes.
+  void StartBatch(int64_t query_bytes_allocated) {
+    if (!collect_exec_stats) {
+      return;
+    }
+    batch_start_self_time_ns_ = SelfExecTime();
+    batch_start_bytes_allocated_ = query_bytes_allocated;
+  }
+  void EndBatch(int64_t query_bytes_allocated) {
+    if (!collect_exec_stats) {
+      return;
+    }
+    batch_self_time_hist.Record(SelfExecTime() - batch_start_self_time_ns_);
+    bytes_allocated += query_bytes_allocated - batch_start_bytes_allocated_;
+  }
+  // Brackets the calls into the children of the node, whose allocations don't count as the node's.
+  void StartChildren(int64_t query_bytes_allocated) {
+    if (!collect_exec_stats) {
+      return;
+    }
+    children_start_bytes_allocated_ = query_bytes_allocated;
+  }
+  void EndChildren(int64_t query_bytes_allocated) {
+    if (!collect_exec_stats) {
+      return;
+    }
+    children_bytes_allocated += query_bytes_allocated - children_start_bytes_allocated_;
+  }
+
+  // The wait timer tracks the time the node is blocked on something other than computation, such
+  // as a GRPC write.
+  void ResumeWaitTimer() {
+    if (!collect_exec_stats) {
+      return;
+    }
+    wait_timer.Resume();
+  }
+  void StopWaitTimer() {
+    if (!collect_exec_stats) {
+      return;
+    }
+    wait_timer.Stop();
+  }
+  // Adds time that the node spent waiting outside of its own calls, such as a GRPC source waiting
+  // on data to arrive.
+  void AddWaitTime(int64_t wait_time_ns) {
+    if (!collect_exec_stats) {
+      return;
+    }
+    extra_wait_time_ns += wait_time_ns;
   }
 
   void AddExtraMetric(std::string_view key, double value) {
@@ -102,6 +161,17 @@ struct ExecNodeStats {
   int64_t ChildExecTime() const { return children_timer.ElapsedTime_us() * 1000; }
   int64_t TotalExecTime() const { return total_timer.ElapsedTime_us() * 1000; }
   int64_t SelfExecTime() const { return TotalExecTime() - ChildExecTime(); }
+  int64_t ChildCPUTime() const { return children_cpu_timer.ElapsedTime_us() * 1000; }
+  int64_t TotalCPUTime() const { return total_cpu_timer.ElapsedTime_us() * 1000; }
+  int64_t SelfCPUTime() const { return TotalCPUTime() - ChildCPUTime(); }
+  int64_t WaitTime() const { return wait_timer.ElapsedTime_us() * 1000 + extra_wait_time_ns; }
+  int64_t SelfBytesAllocated() const { return bytes_allocated - children_bytes_allocated; }
+
+  /**
+   * Returns the UDF stats for the node's expression evaluators to fill in, or nullptr if stats are
+   * not being collected.
+   */
+  UDFExecStatsMap* mutable_udf_stats() { return collect_exec_stats ? &udf_stats : nullptr; }
 
   // Total bytes input to this exec node.
   int64_t bytes_input = 0;
@@ -119,12 +189,32 @@ struct ExecNodeStats {
   ElapsedTimer total_timer;
   // Total timer for the children of the ndoe.
   ElapsedTimer children_timer;
+  // The CPU time counterparts of the timers above. A query runs on a single thread, so the CPU
+  // time of that thread is the CPU time of the node.
+  ThreadCPUTimer total_cpu_timer;
+  ThreadCPUTimer children_cpu_timer;
+  // The distribution of the self time of the node per call, ie. per batch that it processes.
+  LatencyHistogram batch_self_time_hist;
+  // Bytes allocated from the query's memory pool by the node and its children, and by the children.
+  int64_t bytes_allocated = 0;
+  int64_t children_bytes_allocated = 0;
+  // Time spent blocked, as part of the node's own time.
+  ElapsedTimer wait_timer;
+  // Time spent blocked outside of the node's calls.
+  int64_t extra_wait_time_ns = 0;
+  // The work done by each of the UDFs that the node evaluates.
+  UDFExecStatsMap udf_stats;
   // Flag to determine whether to collect stats or not.
   bool collect_exec_stats;
 
   // Extra metrics to store.
   absl::flat_hash_map<std::string, double> extra_metrics;
   absl::flat_hash_map<std::string, std::string> extra_info;
+
+ private:
+  int64_t batch_start_self_time_ns_ = 0;
+  int64_t batch_start_bytes_allocated_ = 0;
+  int64_t children_start_bytes_allocated_ = 0;
 };
 
 /**
@@ -195,9 +285,11 @@ class ExecNode {
     DCHECK(is_initialized_);
     DCHECK(type() == ExecNodeType::kSourceNode);
     stats_->ResumeTotalTimer();
+    stats_->StartBatch(exec_state->total_memory_bytes_allocated());
     PL_RETURN_IF_ERROR(GenerateNextImpl(exec_state));
+    stats_->EndBatch(exec_state->total_memory_bytes_allocated());
     stats_->StopTotalTimer();
-    return Status::OK();
+    return exec_state->CheckMemoryLimit();
   }
 
   /**
@@ -219,10 +311,15 @@ class ExecNode {
           "ConsumeNext received row batch with end of stream set but not end of window.");
     }
     stats_->AddInputStats(rb);
+    if (input_recorder_) {
+      input_recorder_(rb, parent_index);
+    }
     stats_->ResumeTotalTimer();
+    stats_->StartBatch(exec_state->total_memory_bytes_allocated());
     PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, rb, parent_index));
+    stats_->EndBatch(exec_state->total_memory_bytes_allocated());
     stats_->StopTotalTimer();
-    return Status::OK();
+    return exec_state->CheckMemoryLimit();
   }
 
   /**
@@ -275,6 +372,14 @@ class ExecNode {
 
   ExecNodeStats* stats() const { return stats_.get(); }
 
+  using InputRecorder =
+      std::function<void(const table_store::schema::RowBatch& rb, size_t parent_index)>;
+  /**
+   * Registers a function that is handed every row batch this node consumes.
+   * The ExecutionGraph uses it to record the inputs of sinks into the result cache.
+   */
+  void set_input_recorder(InputRecorder recorder) { input_recorder_ = std::move(recorder); }
+
  protected:
   /**
    * Send data to children row batches.
@@ -284,9 +389,11 @@ class ExecNode {
    */
   Status SendRowBatchToChildren(ExecState* exec_state, const table_store::schema::RowBatch& rb) {
     stats_->ResumeChildTimer();
+    stats_->StartChildren(exec_state->total_memory_bytes_allocated());
     for (size_t i = 0; i < children_.size(); ++i) {
       PL_RETURN_IF_ERROR(children_[i]->ConsumeNext(exec_state, rb, parent_ids_for_children_[i]));
     }
+    stats_->EndChildren(exec_state->total_memory_bytes_allocated());
     stats_->StopChildTimer();
     stats_->AddOutputStats(rb);
     if (rb.eos()) {
@@ -323,6 +430,7 @@ class ExecNode {
  private:
   // The stats of this exec node.
   std::unique_ptr<ExecNodeStats> stats_;
+  InputRecorder input_recorder_;
   // Unowned reference to the children. Must remain valid for the duration of query.
   std::vector<ExecNode*> children_;
   // For each of the children (which may have multiple parents) which parent is this node?
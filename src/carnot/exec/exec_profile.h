@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * LatencyHistogram counts durations in buckets of doubling width, so that it can hold anything from
+ * microseconds to minutes in a few dozen counters.
+ * Bucket i counts the durations in [2^(i-1), 2^i) ns; bucket 0 counts durations of 0.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kNumBuckets = 48;
+
+  void Record(int64_t duration_ns) {
+    int bucket = duration_ns <= 0 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(duration_ns));
+    ++counts_[std::min(bucket, kNumBuckets - 1)];
+  }
+
+  /**
+   * The exclusive upper bound of the bucket. The last bucket is unbounded, and returns its lower
+   * bound instead.
+   */
+  static int64_t BucketUpperBoundNS(int bucket) {
+    return int64_t{1} << std::min(bucket, kNumBuckets - 2);
+  }
+
+  const std::array<int64_t, kNumBuckets>& counts() const { return counts_; }
+
+ private:
+  std::array<int64_t, kNumBuckets> counts_ = {};
+};
+
+/**
+ * The work done by a single scalar UDF across all of the row batches that an operator evaluated.
+ */
+struct UDFExecStats {
+  // The number of batches that the UDF was called on.
+  int64_t calls = 0;
+  // The number of rows that the UDF was called on.
+  int64_t rows = 0;
+  // The time spent in the UDF, excluding the evaluation of its arguments.
+  int64_t exec_time_ns = 0;
+};
+
+// Keyed by the name and argument types of the UDF, eg. add(INT64,FLOAT64), so that overloads are
+// counted separately.
+using UDFExecStatsMap = absl::flat_hash_map<std::string, UDFExecStats>;
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -31,8 +31,10 @@
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/grpc_router.h"
 #include "src/carnot/exec/ml/model_pool.h"
+#include "src/carnot/exec/query_memory_pool.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
+#include "src/common/perf/perf.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/table_store/table/table_store.h"
 
@@ -74,9 +76,51 @@ class ExecState {
       grpc_router_->DeleteQuery(query_id_);
     }
   }
-  arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
-    return arrow::default_memory_pool();
+  /**
+   * The pool that the query allocates its memory from, which accounts for it.
+   */
+  arrow::MemoryPool* exec_mem_pool() { return mem_pool_.get(); }
+
+  /**
+   * Limits the memory the query may have allocated at a time. 0 is no limit.
+   */
+  void set_memory_limit_bytes(int64_t limit) { memory_limit_bytes_ = limit; }
+  int64_t memory_bytes() const { return mem_pool_->bytes_allocated(); }
+  int64_t peak_memory_bytes() const { return mem_pool_->max_memory(); }
+  int64_t total_memory_bytes_allocated() const { return mem_pool_->total_bytes_allocated(); }
+
+  /**
+   * The CPU time of the thread executing the query. Carnot runs it while it executes the query.
+   */
+  ThreadCPUTimer* cpu_timer() { return &cpu_timer_; }
+  int64_t cpu_time_ns() const { return cpu_timer_.ElapsedTime_us() * 1000; }
+
+  /**
+   * Limits the CPU time that the query may use. 0 is no limit.
+   */
+  void set_cpu_time_limit_ns(int64_t limit) { cpu_time_limit_ns_ = limit; }
+
+  /**
+   * Returns an error if the query has gone over its memory limit. Exec nodes check it after each
+   * row batch, since allocations themselves aren't failed.
+   */
+  Status CheckMemoryLimit() const {
+    if (memory_limit_bytes_ > 0 && peak_memory_bytes() > memory_limit_bytes_) {
+      return error::ResourceUnavailable("Query $0 exceeded its memory limit of $1 bytes ($2 bytes)",
+                                        query_id_.str(), memory_limit_bytes_, peak_memory_bytes());
+    }
+    return Status::OK();
+  }
+
+  /**
+   * Returns an error if the query has used up its CPU time or gone over its memory limit.
+   */
+  Status CheckResourceLimits() const {
+    if (cpu_time_limit_ns_ > 0 && cpu_time_ns() > cpu_time_limit_ns_) {
+      return error::ResourceUnavailable("Query $0 exceeded its CPU time limit of $1",
+                                        query_id_.str(), PrettyDuration(cpu_time_limit_ns_));
+    }
+    return CheckMemoryLimit();
   }
 
   udf::Registry* func_registry() { return func_registry_; }
@@ -150,6 +194,7 @@ class ExecState {
   void set_metadata_state(std::shared_ptr<const md::AgentMetadataState> metadata_state) {
     metadata_state_ = metadata_state;
   }
+  const md::AgentMetadataState* metadata_state() const { return metadata_state_.get(); }
 
   GRPCRouter* grpc_router() { return grpc_router_; }
 
@@ -167,6 +212,10 @@ class ExecState {
   udf::Registry* func_registry_;
   std::shared_ptr<table_store::TableStore> table_store_;
   std::shared_ptr<const md::AgentMetadataState> metadata_state_;
+  QueryMemoryPool::Ptr mem_pool_ = QueryMemoryPool::Create(arrow::default_memory_pool());
+  int64_t memory_limit_bytes_ = 0;
+  ThreadCPUTimer cpu_timer_;
+  int64_t cpu_time_limit_ns_ = 0;
   const ResultSinkStubGenerator stub_generator_;
   std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map_;
   std::map<int64_t, udf::UDADefinition*> id_to_uda_map_;
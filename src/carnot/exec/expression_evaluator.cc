@@ -232,7 +232,9 @@ VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
         }
         auto output = types::ColumnWrapper::Make(def->exec_return_type(), num_rows);
         // TODO(zasgar): need a better way to handle errors.
-        PL_CHECK_OK(def->ExecBatch(udf, function_ctx_, raw_children, output.get(), num_rows));
+        PL_CHECK_OK(ExecUDF(fn, num_rows, [&] {
+          return def->ExecBatch(udf, function_ctx_, raw_children, output.get(), num_rows);
+        }));
         return output;
       });
 
@@ -327,7 +329,9 @@ Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
           raw_children.push_back(child.get());
         }
 
-        PL_CHECK_OK(def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows));
+        PL_CHECK_OK(ExecUDF(fn, num_rows, [&] {
+          return def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows);
+        }));
 
         std::shared_ptr<arrow::Array> output_array;
         PL_CHECK_OK(output->Finish(&output_array));
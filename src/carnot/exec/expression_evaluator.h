@@ -19,6 +19,7 @@
 #pragma once
 
 #include <arrow/array.h>
+#include <chrono>
 #include <cstddef>
 #include <map>
 #include <memory>
@@ -26,9 +27,11 @@
 #include <utility>
 #include <vector>
 
+#include "src/carnot/exec/exec_profile.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
+#include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
@@ -114,7 +117,29 @@ class ScalarExpressionEvaluator : public ExpressionEvaluator {
                   table_store::schema::RowBatch* output) override;
   std::string DebugString() override;
 
+  /**
+   * Has the evaluator record the work done by each UDF into udf_stats. nullptr disables it.
+   */
+  void set_udf_stats(UDFExecStatsMap* udf_stats) { udf_stats_ = udf_stats; }
+
  protected:
+  // Calls the UDF through exec, and records it into udf_stats_ if set.
+  template <typename TExecFn>
+  Status ExecUDF(const plan::ScalarFunc& fn, size_t num_rows, TExecFn exec) {
+    if (udf_stats_ == nullptr) {
+      return exec();
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto s = exec();
+    auto& stats = (*udf_stats_)[udf::RegistryKey(fn.name(), fn.registry_arg_types()).DebugString()];
+    ++stats.calls;
+    stats.rows += num_rows;
+    stats.exec_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    return s;
+  }
+
   // Function called for each individual expression in expressions_.
   // Implement in derived class.
   virtual Status EvaluateSingleExpression(ExecState* exec_state,
@@ -126,6 +151,7 @@ class ScalarExpressionEvaluator : public ExpressionEvaluator {
   plan::ConstScalarExpressionVector expressions_;
   udf::FunctionContext* function_ctx_ = nullptr;
   std::map<int64_t, std::unique_ptr<udf::ScalarUDF>> id_to_udf_map_;
+  UDFExecStatsMap* udf_stats_ = nullptr;
 };
 
 /**
@@ -217,6 +217,29 @@ TEST_P(ScalarExpressionTest, eval_add_nested) {
   EXPECT_EQ(1345, casted->Value(2));
 }
 
+TEST_P(ScalarExpressionTest, udf_stats) {
+  RowDescriptor rd_output({types::DataType::INT64});
+  RowBatch output_rb(rd_output, input_rb_->num_rows());
+
+  function_ctx_ = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  auto se = ScalarExpressionOf(kAddScalarFuncNestedPbtxt);
+  auto evaluator = ScalarExpressionEvaluator::Create({se}, GetParam(), function_ctx_.get());
+  UDFExecStatsMap udf_stats;
+  evaluator->set_udf_stats(&udf_stats);
+  ASSERT_OK(evaluator->Open(exec_state_.get()));
+  ASSERT_OK(evaluator->Evaluate(exec_state_.get(), *input_rb_, &output_rb));
+  ASSERT_OK(evaluator->Close(exec_state_.get()));
+
+  // The nested calls are to different overloads of add, which are counted separately.
+  ASSERT_EQ(2, udf_stats.size());
+  for (const auto& key : {"add(FLOAT64,FLOAT64)", "add(FLOAT64,INT64)"}) {
+    ASSERT_TRUE(udf_stats.contains(key));
+    EXPECT_EQ(1, udf_stats[key].calls);
+    EXPECT_EQ(3, udf_stats[key].rows);
+    EXPECT_GE(udf_stats[key].exec_time_ns, 0);
+  }
+}
+
 TEST_P(ScalarExpressionTest, eval_uint128_constant) {
   RowDescriptor rd_output({types::DataType::UINT128});
   RowBatch output_rb(rd_output, input_rb_->num_rows());
@@ -62,6 +62,7 @@ Status FilterNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
   evaluator_ = std::make_unique<VectorNativeScalarExpressionEvaluator>(
       plan::ConstScalarExpressionVector{plan_node_->expression()}, function_ctx_.get());
+  evaluator_->set_udf_stats(stats()->mutable_udf_stats());
   return Status::OK();
 }
 
@@ -31,6 +31,15 @@
 #include "src/common/uuid/uuid_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_bool(carnot_columnar_transfer, gflags::BoolFromEnv("PL_CARNOT_COLUMNAR_TRANSFER", false),
+            "Send row batches to other Carnot instances in the columnar format, which is much "
+            "cheaper to encode and decode than repeated fields. Every Carnot instance that "
+            "receives results must be able to read it.");
+DEFINE_bool(carnot_transfer_compression,
+            gflags::BoolFromEnv("PL_CARNOT_TRANSFER_COMPRESSION", false),
+            "Compress the row batches that are sent to other Carnot instances in the columnar "
+            "format with zlib, trading CPU for bandwidth.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -99,6 +108,15 @@ Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
   const auto* sink_plan_node = static_cast<const plan::GRPCSinkOperator*>(&plan_node);
   plan_node_ = std::make_unique<plan::GRPCSinkOperator>(*sink_plan_node);
+
+  // The columnar format is only read by Carnot, so results headed elsewhere, such as to the query
+  // broker, stay in the row batch protobuf.
+  if (FLAGS_carnot_columnar_transfer && plan_node_->has_grpc_source_id()) {
+    wire_format_.columnar = true;
+    if (FLAGS_carnot_transfer_compression) {
+      wire_format_.compression = table_store::schemapb::BUFFER_COMPRESSION_ZLIB;
+    }
+  }
   return Status::OK();
 }
 
@@ -160,7 +178,10 @@ Status GRPCSinkNode::CancelledByServer(ExecState* exec_state) {
 
 Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
                                      const carnotpb::TransferResultChunkRequest& req) {
-  if (writer_->Write(req)) {
+  stats()->ResumeWaitTimer();
+  bool written = writer_->Write(req);
+  stats()->StopWaitTimer();
+  if (written) {
     last_send_time_ = std::chrono::system_clock::now();
     return Status::OK();
   }
@@ -196,8 +217,10 @@ Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
   if (writer_ == nullptr) {
     return Status::OK();
   }
+  stats()->ResumeWaitTimer();
   writer_->WritesDone();
   auto s = writer_->Finish();
+  stats()->StopWaitTimer();
   if (!s.ok()) {
     LOG(ERROR) << absl::Substitute(
         "GRPCSinkNode $0 in query $1: Error calling Finish on stream, message: $2",
@@ -319,7 +342,7 @@ Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb,
 Status GRPCSinkNode::ConsumeNextImplNoSplit(ExecState* exec_state, const RowBatch& rb, size_t) {
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
   // Serialize the RowBatch.
-  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch(), wire_format_));
 
   PL_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
 
@@ -108,6 +108,9 @@ class GRPCSinkNode : public SinkNode {
 
   size_t max_batch_size_;
   float batch_size_factor_;
+
+  // How the row batches are laid out on this connection.
+  table_store::schema::WireFormat wire_format_;
 };
 
 }  // namespace exec
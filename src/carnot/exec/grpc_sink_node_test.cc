@@ -35,6 +35,8 @@
 #include "src/common/uuid/uuid_utils.h"
 #include "src/shared/types/types.h"
 
+DECLARE_bool(carnot_columnar_transfer);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -231,6 +233,49 @@ TEST_F(GRPCSinkNodeTest, internal_result) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, internal_result_columnar) {
+  FLAGS_carnot_columnar_transfer = true;
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(2);
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  std::vector<types::Int64Value> data = {1, 2, 3};
+  auto rb = RowBatchBuilder(output_rd, 3, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>(data)
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  tester.Close();
+
+  EXPECT_TRUE(actual_protos[0].query_result().initiate_result_stream());
+  const auto& rb_pb = actual_protos[1].query_result().row_batch();
+  EXPECT_EQ(0, rb_pb.cols_size());
+  EXPECT_EQ(1, rb_pb.column_buffers_size());
+  ASSERT_OK_AND_ASSIGN(auto output_rb, RowBatch::FromProto(rb_pb));
+  EXPECT_TRUE(output_rb->eos());
+  EXPECT_TRUE(output_rb->ColumnAt(0)->Equals(rb.ColumnAt(0)));
+
+  FLAGS_carnot_columnar_transfer = false;
+}
+
 constexpr char kExpectedExternalInitialization[] = R"proto(
 address: "localhost:1234"
 query_id {
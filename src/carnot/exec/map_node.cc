@@ -48,6 +48,7 @@ Status MapNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
   evaluator_ = ScalarExpressionEvaluator::Create(
       plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative, function_ctx_.get());
+  evaluator_->set_udf_stats(stats()->mutable_udf_stats());
   return Status::OK();
 }
 
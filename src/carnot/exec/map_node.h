@@ -51,7 +51,7 @@ class MapNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
-  std::unique_ptr<ExpressionEvaluator> evaluator_;
+  std::unique_ptr<ScalarExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::MapOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
 };
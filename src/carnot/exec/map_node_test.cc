@@ -143,6 +143,24 @@ TEST_F(MapNodeTest, child_fail) {
                                0, error::InvalidArgument("args"));
 }
 
+TEST_F(MapNodeTest, over_memory_limit) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  // The output column alone takes more than a byte.
+  exec_state_->set_memory_limit_bytes(1);
+  auto tester = exec::ExecNodeTester<MapNode, plan::MapOperator>(*plan_node_, output_rd, {},
+                                                                 exec_state_.get());
+  auto s = tester.node()->ConsumeNext(exec_state_.get(),
+                                      RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                                          .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                                          .AddColumn<types::Int64Value>({1, 3, 6, 9})
+                                          .get(),
+                                      0);
+  ASSERT_NOT_OK(s);
+  EXPECT_TRUE(error::IsResourceUnavailable(s)) << s.msg();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
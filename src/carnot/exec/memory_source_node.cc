@@ -18,8 +18,10 @@
 
 #include "src/carnot/exec/memory_source_node.h"
 
+#include <functional>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/substitute.h>
@@ -76,6 +78,22 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
   return Status::OK();
 }
 
+bool MemorySourceNode::ReplaceRowIDRange(int64_t begin, int64_t end,
+                                         std::function<Status()> replace) {
+  auto batch_after = table_store::BatchSlice::Invalid();
+  if (end < stop_) {
+    batch_after = table_->SliceFromRowID(end, stop_);
+    if (!batch_after.IsValid()) {
+      return false;
+    }
+  }
+  current_batch_ = table_->SliceIfPastStop(current_batch_, begin);
+  replace_rows_ = std::move(replace);
+  replaced_rows_begin_ = begin;
+  batch_after_replaced_rows_ = batch_after;
+  return true;
+}
+
 Status MemorySourceNode::CloseImpl(ExecState*) {
   stats()->AddExtraInfo("infinite_stream", infinite_stream_ ? "true" : "false");
   return Status::OK();
@@ -98,6 +116,7 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
   }
 
   if (!current_batch_.IsValid()) {
+    last_row_id_range_ = {stop_, stop_};
     return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ !infinite_stream_,
                                   /* eos */ !infinite_stream_);
   }
@@ -108,7 +127,10 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
 
   rows_processed_ += row_batch->num_rows();
   bytes_processed_ += row_batch->NumBytes();
-  auto next_batch = table_->NextBatch(current_batch_, stop_);
+  last_row_id_range_ = {current_batch_.uniq_row_start_idx, current_batch_.uniq_row_end_idx + 1};
+  // The rows before the replaced ones end where the replaced rows begin.
+  auto next_batch =
+      table_->NextBatch(current_batch_, replace_rows_ != nullptr ? replaced_rows_begin_ : stop_);
   if (infinite_stream_ && !next_batch.IsValid()) {
     wait_for_valid_next_ = true;
   } else {
@@ -118,7 +140,7 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
   // If infinite stream is set, we don't send Eow or Eos. Infinite streams therefore never cause
   // HasBatchesRemaining to be false. Instead the outer loop that calls GenerateNext() is
   // responsible for managing whether we continue the stream or end it.
-  if (!current_batch_.IsValid() && !infinite_stream_) {
+  if (!current_batch_.IsValid() && !infinite_stream_ && replace_rows_ == nullptr) {
     row_batch->set_eow(true);
     row_batch->set_eos(true);
   }
@@ -126,6 +148,13 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
 }
 
 Status MemorySourceNode::GenerateNextImpl(ExecState* exec_state) {
+  if (replace_rows_ != nullptr && !current_batch_.IsValid()) {
+    // The rows before the replaced ones are read, so the replacement keeps the rows in order.
+    auto replace = std::move(replace_rows_);
+    replace_rows_ = nullptr;
+    PL_RETURN_IF_ERROR(replace());
+    current_batch_ = batch_after_replaced_rows_;
+  }
   PL_ASSIGN_OR_RETURN(auto row_batch, GetNextRowBatch(exec_state));
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *row_batch));
   return Status::OK();
@@ -19,8 +19,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/exec/exec_node.h"
@@ -44,6 +46,30 @@ class MemorySourceNode : public SourceNode {
 
   bool NextBatchReady() override;
 
+  bool infinite_stream() const { return infinite_stream_; }
+
+  /**
+   * Returns the first and the stop unique row IDs that this source reads, as resolved at Open().
+   * The first row ID is -1 if there are no rows to read.
+   */
+  std::pair<int64_t, table_store::Table::StopPosition> row_id_range() const {
+    return {current_batch_.uniq_row_start_idx, stop_};
+  }
+
+  /**
+   * Returns the unique row IDs [first, stop) of the last row batch that this source sent.
+   */
+  std::pair<int64_t, int64_t> last_row_id_range() const { return last_row_id_range_; }
+
+  /**
+   * Instead of reading the rows from the begin row ID up to the end row ID, calls replace at the
+   * point where they would have been read, then reads on from the end row ID. Must be called
+   * after Open(), before any row is read, with begin at or past the first row ID and end at most
+   * the stop.
+   * @return false, leaving the source untouched, if the row at end is not in the table anymore.
+   */
+  bool ReplaceRowIDRange(int64_t begin, int64_t end, std::function<Status()> replace);
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -63,6 +89,11 @@ class MemorySourceNode : public SourceNode {
   bool wait_for_valid_next_ = false;
   table_store::BatchSlice current_batch_;
   table_store::Table::StopPosition stop_;
+  std::pair<int64_t, int64_t> last_row_id_range_ = {-1, -1};
+  // The rows to replace, see ReplaceRowIDRange(). Cleared once they are replaced.
+  std::function<Status()> replace_rows_;
+  int64_t replaced_rows_begin_ = -1;
+  table_store::BatchSlice batch_after_replaced_rows_;
 
   std::unique_ptr<plan::MemorySourceOperator> plan_node_;
   table_store::Table* table_ = nullptr;
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/query_memory_pool.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+void QueryMemoryPool::Reserve(int64_t size) {
+  int64_t allocated = bytes_allocated_ += size;
+  if (size > 0) {
+    total_bytes_allocated_ += size;
+  }
+  int64_t max_memory = max_memory_;
+  while (allocated > max_memory && !max_memory_.compare_exchange_weak(max_memory, allocated)) {
+  }
+}
+
+arrow::Status QueryMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  Reserve(size);
+  auto s = parent_->Allocate(size, out);
+  if (!s.ok()) {
+    Unreserve(size);
+    return s;
+  }
+  Ref();
+  return s;
+}
+
+arrow::Status QueryMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  Reserve(new_size - old_size);
+  auto s = parent_->Reallocate(old_size, new_size, ptr);
+  if (!s.ok()) {
+    Unreserve(new_size - old_size);
+  }
+  return s;
+}
+
+void QueryMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  parent_->Free(buffer, size);
+  Unreserve(size);
+  Unref();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
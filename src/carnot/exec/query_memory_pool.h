@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * QueryMemoryPool accounts for the memory a single query allocates, on top of a parent pool.
+ *
+ * It doesn't fail allocations over the query's memory limit: many allocation paths (e.g.
+ * types::ToArrow()) treat allocation failures as fatal. ExecState::CheckMemoryLimit() enforces
+ * the limit between row batches instead, off the peak that the pool tracks.
+ *
+ * Arrow buffers keep a raw pointer to the pool they were allocated from, and can outlive the query
+ * (e.g. arrays that tables cache, or results in the result cache). The pool is therefore reference
+ * counted by its owner plus its live allocations, and deletes itself once both are gone. Use
+ * QueryMemoryPool::Create(), and let the returned pointer release it.
+ */
+class QueryMemoryPool : public arrow::MemoryPool {
+ public:
+  struct Releaser {
+    void operator()(QueryMemoryPool* pool) const { pool->Release(); }
+  };
+  using Ptr = std::unique_ptr<QueryMemoryPool, Releaser>;
+
+  /**
+   * @param parent The pool to allocate from.
+   */
+  static Ptr Create(arrow::MemoryPool* parent) { return Ptr(new QueryMemoryPool(parent)); }
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  int64_t bytes_allocated() const override { return bytes_allocated_; }
+  int64_t max_memory() const override { return max_memory_; }
+  // The bytes allocated over the lifetime of the pool, regardless of whether they were freed since.
+  int64_t total_bytes_allocated() const { return total_bytes_allocated_; }
+  std::string backend_name() const override { return parent_->backend_name(); }
+
+ private:
+  explicit QueryMemoryPool(arrow::MemoryPool* parent) : parent_(parent) {}
+  ~QueryMemoryPool() override = default;
+
+  // Accounts for the bytes, and for the new peak if they make one.
+  void Reserve(int64_t size);
+  void Unreserve(int64_t size) { bytes_allocated_ -= size; }
+
+  void Ref() { ++refs_; }
+  void Unref() {
+    if (--refs_ == 0) {
+      delete this;
+    }
+  }
+  void Release() { Unref(); }
+
+  arrow::MemoryPool* parent_;
+  std::atomic<int64_t> bytes_allocated_ = 0;
+  std::atomic<int64_t> max_memory_ = 0;
+  std::atomic<int64_t> total_bytes_allocated_ = 0;
+  // One for the owner, plus one per live allocation.
+  std::atomic<int64_t> refs_ = 1;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
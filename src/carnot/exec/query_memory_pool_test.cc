@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <arrow/memory_pool.h>
+
+#include "src/carnot/exec/query_memory_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(QueryMemoryPoolTest, tracks_bytes_and_peak) {
+  auto pool = QueryMemoryPool::Create(arrow::default_memory_pool());
+
+  uint8_t* a;
+  uint8_t* b;
+  ASSERT_TRUE(pool->Allocate(64, &a).ok());
+  ASSERT_TRUE(pool->Allocate(128, &b).ok());
+  EXPECT_EQ(192, pool->bytes_allocated());
+
+  ASSERT_TRUE(pool->Reallocate(64, 256, &a).ok());
+  EXPECT_EQ(384, pool->bytes_allocated());
+
+  pool->Free(a, 256);
+  pool->Free(b, 128);
+  EXPECT_EQ(0, pool->bytes_allocated());
+  EXPECT_EQ(384, pool->max_memory());
+
+  ASSERT_TRUE(pool->Allocate(32, &a).ok());
+  pool->Free(a, 32);
+  EXPECT_EQ(384, pool->max_memory());
+  EXPECT_EQ(416, pool->total_bytes_allocated());
+}
+
+TEST(QueryMemoryPoolTest, allocations_outlive_owner) {
+  auto pool = QueryMemoryPool::Create(arrow::default_memory_pool());
+  QueryMemoryPool* raw_pool = pool.get();
+
+  uint8_t* a;
+  ASSERT_TRUE(raw_pool->Allocate(1024, &a).ok());
+  // Releasing the owner's reference leaves the pool alive for the allocation, which frees into it
+  // once the buffer holding it is done.
+  pool.reset();
+  a[1023] = 1;
+  EXPECT_EQ(1024, raw_pool->bytes_allocated());
+  raw_pool->Free(a, 1024);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/result_cache.h"
+
+#include <utility>
+
+#include <absl/hash/hash.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+std::string ResultCache::Fingerprint(const planpb::PlanFragment& pf) {
+  planpb::PlanFragment canonical = pf;
+  for (auto& node : *canonical.mutable_nodes()) {
+    if (node.op().op_type() == planpb::MEMORY_SOURCE_OPERATOR) {
+      node.mutable_op()->mutable_mem_source_op()->clear_start_time();
+      node.mutable_op()->mutable_mem_source_op()->clear_stop_time();
+    }
+  }
+
+  std::string fingerprint;
+  {
+    google::protobuf::io::StringOutputStream output(&fingerprint);
+    google::protobuf::io::CodedOutputStream coded_output(&output);
+    coded_output.SetSerializationDeterministic(true);
+    canonical.SerializeToCodedStream(&coded_output);
+  }
+  return fingerprint;
+}
+
+std::shared_ptr<const ResultCache::Entry> ResultCache::Get(const std::string& key) {
+  absl::MutexLock lock(&lock_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+  return it->second.entry;
+}
+
+bool ResultCache::Admit(const std::string& key) {
+  size_t hash = absl::Hash<std::string>{}(key);
+  absl::MutexLock lock(&lock_);
+  if (candidates_.contains(hash)) {
+    return true;
+  }
+  candidates_.insert(hash);
+  candidate_order_.push_back(hash);
+  if (candidate_order_.size() > kMaxCandidates) {
+    candidates_.erase(candidate_order_.front());
+    candidate_order_.pop_front();
+  }
+  return false;
+}
+
+void ResultCache::Put(const std::string& key, Entry entry) {
+  int64_t bytes = key.size();
+  for (const auto& input : entry.sink_inputs) {
+    bytes += input.rb->NumBytes();
+  }
+  if (bytes > max_bytes_) {
+    return;
+  }
+
+  absl::MutexLock lock(&lock_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    size_bytes_ -= it->second.bytes;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+  EvictToFit(bytes);
+
+  lru_.push_front(key);
+  entries_[key] =
+      CachedEntry{std::make_shared<const Entry>(std::move(entry)), bytes, lru_.begin()};
+  size_bytes_ += bytes;
+}
+
+void ResultCache::EvictToFit(int64_t bytes) {
+  while (!lru_.empty() && size_bytes_ + bytes > max_bytes_) {
+    auto it = entries_.find(lru_.back());
+    DCHECK(it != entries_.end());
+    size_bytes_ -= it->second.bytes;
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+int64_t ResultCache::size_bytes() const {
+  absl::MutexLock lock(&lock_);
+  return size_bytes_;
+}
+
+size_t ResultCache::num_entries() const {
+  absl::MutexLock lock(&lock_);
+  return entries_.size();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ResultCache keeps the output of recently executed plan fragments. When a fragment is executed
+ * again (e.g. a dashboard refresh), the row batches its sinks consumed last time are replayed
+ * instead of re-reading and re-processing its tables.
+ *
+ * Entries are keyed by the fingerprint of the fragment, the tables it reads and the content
+ * version of the agent metadata:
+ *  - Fragments that only map and filter the rows of a single memory source are cached
+ *    incrementally, which is the only kind of reuse across different rows of a table. Their entry
+ *    records the source rows that each sink input was produced from, and the stop row ID it covers
+ *    (its watermark). A later execution replays the inputs of the rows it still reads, and only
+ *    processes the rows before them (e.g. of a wider time window) and past the watermark. As the
+ *    table expires rows or the time window slides, the replayed inputs are the suffix of the entry.
+ *  - Other fragments (e.g. aggregates) are only served from the cache when they read exactly the
+ *    same rows, so their key also includes the first and stop row IDs of each memory source.
+ *    Expiry moves the first row, which changes the key, and the stale entry ages out of the cache
+ *    in LRU order.
+ *
+ * An entry is only recorded the second time its key is looked up, so that executions that are
+ * never repeated don't hold onto their results.
+ */
+class ResultCache : public NotCopyable {
+ public:
+  // A row batch consumed by a sink of the fragment.
+  struct SinkInput {
+    int64_t sink_id;
+    size_t parent_index;
+    std::shared_ptr<const table_store::schema::RowBatch> rb;
+    // The unique row IDs [first, stop) of the memory source batch that the input was produced
+    // from, for incremental entries.
+    std::pair<int64_t, int64_t> row_ids = {-1, -1};
+  };
+  struct Entry {
+    // The sink inputs of an execution, in the order they were consumed.
+    std::vector<SinkInput> sink_inputs;
+    // The stop row ID of the memory source that the sink inputs cover, for incremental entries.
+    int64_t watermark = -1;
+  };
+
+  explicit ResultCache(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /**
+   * Returns a canonical fingerprint of the plan fragment. The time bounds of memory sources are
+   * left out: the row IDs they resolve to are matched against the entry instead, so plans whose
+   * time windows overlap share an entry.
+   */
+  static std::string Fingerprint(const planpb::PlanFragment& pf);
+
+  /**
+   * Returns the entry for the key, or nullptr if there is none.
+   */
+  std::shared_ptr<const Entry> Get(const std::string& key);
+
+  /**
+   * Returns true if the key was looked up before, recently, so that an entry is worth recording.
+   */
+  bool Admit(const std::string& key);
+
+  /**
+   * Inserts the entry, evicting the least recently used entries to make room for it.
+   * Entries larger than the whole cache are dropped.
+   */
+  void Put(const std::string& key, Entry entry);
+
+  int64_t max_bytes() const { return max_bytes_; }
+  int64_t size_bytes() const;
+  size_t num_entries() const;
+
+ private:
+  struct CachedEntry {
+    std::shared_ptr<const Entry> entry;
+    int64_t bytes;
+    std::list<std::string>::iterator lru_it;
+  };
+
+  void EvictToFit(int64_t bytes) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // The number of recently missed keys that Admit() remembers.
+  static constexpr size_t kMaxCandidates = 1024;
+
+  const int64_t max_bytes_;
+
+  mutable absl::Mutex lock_;
+  int64_t size_bytes_ ABSL_GUARDED_BY(lock_) = 0;
+  // Keys ordered from the most to the least recently used.
+  std::list<std::string> lru_ ABSL_GUARDED_BY(lock_);
+  absl::flat_hash_map<std::string, CachedEntry> entries_ ABSL_GUARDED_BY(lock_);
+  // Hashes of the keys passed to Admit(), oldest first.
+  std::deque<size_t> candidate_order_ ABSL_GUARDED_BY(lock_);
+  absl::flat_hash_set<size_t> candidates_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
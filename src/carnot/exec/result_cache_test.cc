@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/result_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planpb/test_proto.h"
+#include "src/common/base/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using google::protobuf::TextFormat;
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+ResultCache::Entry MakeEntry(int64_t num_rows) {
+  auto rb = std::make_shared<RowBatch>(RowDescriptor({types::DataType::INT64}), num_rows);
+  std::vector<types::Int64Value> col(num_rows, 1);
+  EXPECT_OK(rb->AddColumn(types::ToArrow(col, arrow::default_memory_pool())));
+  ResultCache::Entry entry;
+  entry.sink_inputs.push_back({/*sink_id*/ 1, /*parent_index*/ 0, rb});
+  return entry;
+}
+
+TEST(ResultCacheTest, fingerprint_ignores_memory_source_times) {
+  planpb::PlanFragment pf;
+  ASSERT_TRUE(TextFormat::MergeFromString(planpb::testutils::kLinearPlanFragment, &pf));
+  auto fingerprint = ResultCache::Fingerprint(pf);
+
+  auto* mem_src = pf.mutable_nodes(0)->mutable_op()->mutable_mem_source_op();
+  mem_src->mutable_start_time()->set_value(10);
+  mem_src->mutable_stop_time()->set_value(20);
+  EXPECT_EQ(fingerprint, ResultCache::Fingerprint(pf));
+
+  mem_src->set_name("other_table");
+  EXPECT_NE(fingerprint, ResultCache::Fingerprint(pf));
+}
+
+TEST(ResultCacheTest, get_put) {
+  ResultCache cache(1024 * 1024);
+  EXPECT_EQ(nullptr, cache.Get("a"));
+
+  cache.Put("a", MakeEntry(10));
+  auto entry = cache.Get("a");
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(1, entry->sink_inputs.size());
+  EXPECT_EQ(10, entry->sink_inputs[0].rb->num_rows());
+  EXPECT_EQ(1, cache.num_entries());
+  EXPECT_GT(cache.size_bytes(), 10 * static_cast<int64_t>(sizeof(int64_t)));
+
+  // Replacing an entry doesn't leak its bytes.
+  auto size_bytes = cache.size_bytes();
+  cache.Put("a", MakeEntry(10));
+  EXPECT_EQ(size_bytes, cache.size_bytes());
+}
+
+TEST(ResultCacheTest, evicts_least_recently_used) {
+  auto entry_bytes = 1 + MakeEntry(100).sink_inputs[0].rb->NumBytes();
+  ResultCache cache(2 * entry_bytes);
+
+  cache.Put("a", MakeEntry(100));
+  cache.Put("b", MakeEntry(100));
+  // Touch "a", so "b" is the least recently used entry.
+  EXPECT_NE(nullptr, cache.Get("a"));
+  cache.Put("c", MakeEntry(100));
+
+  EXPECT_EQ(2, cache.num_entries());
+  EXPECT_NE(nullptr, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_NE(nullptr, cache.Get("c"));
+  EXPECT_LE(cache.size_bytes(), cache.max_bytes());
+}
+
+TEST(ResultCacheTest, admits_keys_seen_before) {
+  ResultCache cache(1024 * 1024);
+  EXPECT_FALSE(cache.Admit("a"));
+  EXPECT_TRUE(cache.Admit("a"));
+  EXPECT_FALSE(cache.Admit("b"));
+}
+
+TEST(ResultCacheTest, drops_entries_larger_than_cache) {
+  ResultCache cache(64);
+  cache.Put("a", MakeEntry(1000));
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(0, cache.size_bytes());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
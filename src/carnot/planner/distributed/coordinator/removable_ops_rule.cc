@@ -139,16 +139,15 @@ class StringBloomFilterMatcher : public FilterExpressionMatcher {
       return md_filter->ContainsEntity(md_type_, val_);
     }
 
+    std::vector<std::string_view> strs;
+    strs.reserve(doc.Size());
     for (rapidjson::SizeType i = 0; i < doc.Size(); ++i) {
       if (!doc[i].IsString()) {
         return false;
       }
-      auto str = doc[i].GetString();
-      if (md_filter->ContainsEntity(md_type_, str)) {
-        return true;
-      }
+      strs.emplace_back(doc[i].GetString(), doc[i].GetStringLength());
     }
-    return false;
+    return md_filter->ContainsAnyEntity(md_type_, strs);
   }
 
   void ParseExpression(ExpressionIR* expr) override {
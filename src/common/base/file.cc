@@ -18,12 +18,15 @@
 
 #include <sys/stat.h>
 
+#include <cstring>
 #include <fstream>
 #include <string>
 
 #include "src/common/base/error.h"
 #include "src/common/base/file.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/logging.h"
+#include "src/common/base/utils.h"
 
 namespace px {
 
@@ -51,4 +54,35 @@ Status WriteFileFromString(const std::string& filename, std::string_view content
   return Status::OK();
 }
 
+StatusOr<uint64_t> HashFileContents(const std::string& filename) {
+  constexpr size_t kChunkSize = 1024 * 1024;
+
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) {
+    return error::Internal("Failed to open file=$0", filename);
+  }
+
+  std::string buf(kChunkSize, '\0');
+  uint64_t hash = 0;
+  uint64_t total_bytes = 0;
+  while (ifs) {
+    ifs.read(buf.data(), kChunkSize);
+    const size_t num_bytes = ifs.gcount();
+    // Zero-pad the tail, so it can be consumed as a whole word.
+    const size_t padded_num_bytes = SnapUpToMultiple(num_bytes, sizeof(uint64_t));
+    std::memset(buf.data() + num_bytes, 0, padded_num_bytes - num_bytes);
+    for (size_t i = 0; i < padded_num_bytes; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, buf.data() + i, sizeof(uint64_t));
+      hash = HashCombine(hash, word);
+    }
+    total_bytes += num_bytes;
+  }
+  if (ifs.bad()) {
+    return error::Internal("Failed to read file=$0", filename);
+  }
+
+  return HashCombine(hash, total_bytes);
+}
+
 }  // namespace px
@@ -30,4 +30,10 @@ StatusOr<std::string> ReadFileToString(const std::string& filename,
 Status WriteFileFromString(const std::string& filename, std::string_view contents,
                            std::ios_base::openmode mode = std::ios_base::out);
 
+/**
+ * Returns a hash of the contents of the file, which is stable across processes and restarts,
+ * so it can be used as a persistent key. It is not a cryptographic hash.
+ */
+StatusOr<uint64_t> HashFileContents(const std::string& filename);
+
 }  // namespace px
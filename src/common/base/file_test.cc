@@ -40,4 +40,23 @@ It has two lines.)";
   EXPECT_EQ(read_val, write_val);
 }
 
+TEST(FileUtils, HashFileContents) {
+  TempDir tmp_dir;
+  const std::filesystem::path file1 = tmp_dir.path() / "file1";
+  const std::filesystem::path file2 = tmp_dir.path() / "file2";
+  const std::filesystem::path file3 = tmp_dir.path() / "file3";
+
+  // Same contents in a different file, and contents that only differ by a trailing zero.
+  ASSERT_OK(WriteFileFromString(file1, "contents"));
+  ASSERT_OK(WriteFileFromString(file2, "contents"));
+  ASSERT_OK(WriteFileFromString(file3, std::string("contents\0", 9)));
+
+  ASSERT_OK_AND_ASSIGN(uint64_t hash1, HashFileContents(file1));
+  EXPECT_OK_AND_EQ(HashFileContents(file2), hash1);
+  ASSERT_OK_AND_ASSIGN(uint64_t hash3, HashFileContents(file3));
+  EXPECT_NE(hash3, hash1);
+
+  EXPECT_NOT_OK(HashFileContents(tmp_dir.path() / "bogus"));
+}
+
 }  // namespace px
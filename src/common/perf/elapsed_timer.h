@@ -17,6 +17,8 @@
  */
 
 #pragma once
+#include <time.h>
+
 #include <chrono>
 #include <iostream>
 
@@ -24,12 +26,32 @@
 
 namespace px {
 
+/**
+ * A clock that measures the CPU time consumed by the calling thread.
+ */
+struct ThreadCPUClock {
+  using duration = std::chrono::nanoseconds;
+  using rep = duration::rep;
+  using period = duration::period;
+  using time_point = std::chrono::time_point<ThreadCPUClock>;
+  static constexpr bool is_steady = true;
+
+  static time_point now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+  }
+};
+
 /**
  * Timing class.
  *
  * Allows for measurement with high resolution timer with clocks that can be started and stopped.
+ * The timer measures wall time by default; a ThreadCPUClock timer measures the CPU time of the
+ * thread, so it must be resumed and stopped on the same thread.
  */
-class ElapsedTimer : public NotCopyable {
+template <typename TClock>
+class BasicElapsedTimer : public NotCopyable {
  public:
   /**
    * Start the timer.
@@ -54,7 +76,7 @@ class ElapsedTimer : public NotCopyable {
   void Resume() {
     DCHECK(!timer_running_) << "Timer already running";
     timer_running_ = true;
-    start_time_ = std::chrono::high_resolution_clock::now();
+    start_time_ = TClock::now();
   }
 
   /**
@@ -72,12 +94,15 @@ class ElapsedTimer : public NotCopyable {
 
  private:
   uint64_t TimeDiff() const {
-    auto current = std::chrono::high_resolution_clock::now();
+    auto current = TClock::now();
     return std::chrono::duration_cast<std::chrono::microseconds>(current - start_time_).count();
   }
   bool timer_running_ = false;
-  std::chrono::high_resolution_clock::time_point start_time_;
+  typename TClock::time_point start_time_;
   uint64_t elapsed_time_us_ = 0;
 };
 
+using ElapsedTimer = BasicElapsedTimer<std::chrono::high_resolution_clock>;
+using ThreadCPUTimer = BasicElapsedTimer<ThreadCPUClock>;
+
 }  // namespace px
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+#include "src/common/perf/elapsed_timer.h"
+
+namespace px {
+
+TEST(ThreadCPUTimer, excludes_sleep) {
+  ThreadCPUTimer cpu_timer;
+  ElapsedTimer wall_timer;
+  cpu_timer.Start();
+  wall_timer.Start();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  // Spin until 100ms of wall time have passed, so about half of it is spent on the CPU.
+  volatile uint64_t spins = 0;
+  while (wall_timer.ElapsedTime_us() < 100 * 1000) {
+    spins = spins + 1;
+  }
+
+  cpu_timer.Stop();
+  wall_timer.Stop();
+  EXPECT_GE(wall_timer.ElapsedTime_us(), 100 * 1000);
+  EXPECT_GT(cpu_timer.ElapsedTime_us(), 20 * 1000);
+  EXPECT_LT(cpu_timer.ElapsedTime_us(), 80 * 1000);
+}
+
+}  // namespace px
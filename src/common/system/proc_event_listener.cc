@@ -0,0 +1,257 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/proc_event_listener.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace px {
+namespace system {
+
+namespace {
+
+// Events are only read once per polling iteration, so the socket buffer must be large enough to
+// hold all events in between; e.g. a build that spawns thousands of short-lived processes.
+// Note that the kernel caps this at net.core.rmem_max.
+constexpr int kReceiveBufferSize = 4 * 1024 * 1024;
+
+constexpr int kRecvBufSize = 8192;
+
+// The kernel acknowledges the listen request right away; this only bounds a broken kernel.
+constexpr std::chrono::milliseconds kListenAckTimeout{1000};
+
+// Like recv(MSG_DONTWAIT), but drops the messages that were not sent by the kernel,
+// e.g. proc events forged by another process.
+ssize_t RecvFromKernel(int fd, void* buf, size_t len) {
+  while (true) {
+    struct sockaddr_nl src_addr = {};
+    socklen_t src_addr_len = sizeof(src_addr);
+    ssize_t num_bytes = recvfrom(fd, buf, len, MSG_DONTWAIT,
+                                 reinterpret_cast<struct sockaddr*>(&src_addr), &src_addr_len);
+    if (num_bytes < 0 || src_addr.nl_pid == 0) {
+      return num_bytes;
+    }
+  }
+}
+
+// Returns the proc event carried by the netlink message, or nullptr if there is none.
+const struct proc_event* GetProcEvent(const struct nlmsghdr* msg_header) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  const auto* cn_msg = reinterpret_cast<const struct cn_msg*>(NLMSG_DATA(msg_header));
+#pragma GCC diagnostic pop
+  if (cn_msg->id.idx != CN_IDX_PROC || cn_msg->id.val != CN_VAL_PROC ||
+      cn_msg->len < sizeof(struct proc_event)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const struct proc_event*>(cn_msg->data);
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<ProcEventListener>> ProcEventListener::Create() {
+  auto listener = std::unique_ptr<ProcEventListener>(new ProcEventListener);
+  PL_RETURN_IF_ERROR(listener->Connect());
+  return listener;
+}
+
+ProcEventListener::~ProcEventListener() {
+  if (fd_ >= 0) {
+    // Best effort; the kernel stops sending events once the socket is closed anyways.
+    ECHECK_OK(SendListenOp(false));
+    close(fd_);
+  }
+}
+
+Status ProcEventListener::Connect() {
+  fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd_ < 0) {
+    return error::Internal("Could not create NETLINK_CONNECTOR connection. [errno=$0]", errno);
+  }
+
+  if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferSize, sizeof(kReceiveBufferSize)) <
+      0) {
+    LOG(WARNING) << absl::Substitute("Could not set the proc connector receive buffer [errno=$0]",
+                                     errno);
+  }
+
+  struct sockaddr_nl nl_addr = {};
+  nl_addr.nl_family = AF_NETLINK;
+  nl_addr.nl_groups = CN_IDX_PROC;
+  // Let the kernel assign a unique port ID, so that multiple listeners can coexist.
+  nl_addr.nl_pid = 0;
+  if (bind(fd_, reinterpret_cast<struct sockaddr*>(&nl_addr), sizeof(nl_addr)) < 0) {
+    return error::Internal("Could not bind to the proc connector. [errno=$0]", errno);
+  }
+
+  PL_RETURN_IF_ERROR(SendListenOp(true));
+  return WaitForListenAck();
+}
+
+Status ProcEventListener::WaitForListenAck() {
+  alignas(struct nlmsghdr) uint8_t buf[kRecvBufSize];
+
+  const auto deadline = std::chrono::steady_clock::now() + kListenAckTimeout;
+  while (true) {
+    const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (timeout.count() <= 0) {
+      return error::DeadlineExceeded("The proc connector did not acknowledge the listen request.");
+    }
+
+    struct pollfd poll_fd = {};
+    poll_fd.fd = fd_;
+    poll_fd.events = POLLIN;
+    if (poll(&poll_fd, 1, timeout.count()) < 0 && errno != EINTR) {
+      return error::Internal("Poll call failed. [errno=$0]", errno);
+    }
+
+    ssize_t num_bytes = RecvFromKernel(fd_, &buf, sizeof(buf));
+    if (num_bytes < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
+      }
+      return error::Internal("Receive call failed. [errno=$0]", errno);
+    }
+
+    // Events that arrive before the acknowledgement are dropped. They predate the first scan of
+    // /proc, which callers do once they are listening.
+    struct nlmsghdr* msg_header = reinterpret_cast<struct nlmsghdr*>(buf);
+    for (; NLMSG_OK(msg_header, num_bytes); msg_header = NLMSG_NEXT(msg_header, num_bytes)) {
+      if (msg_header->nlmsg_type == NLMSG_ERROR) {
+        return error::Internal("Netlink error");
+      }
+      const struct proc_event* proc_event = GetProcEvent(msg_header);
+      if (proc_event == nullptr || proc_event->what != proc_event::PROC_EVENT_NONE) {
+        continue;
+      }
+      // E.g. EPERM without CAP_NET_ADMIN in the initial user namespace.
+      if (proc_event->event_data.ack.err != 0) {
+        return error::PermissionDenied("The proc connector rejected the listen request. [errno=$0]",
+                                       proc_event->event_data.ack.err);
+      }
+      return Status::OK();
+    }
+  }
+}
+
+Status ProcEventListener::SendListenOp(bool listen) {
+  // The message is a netlink header, followed by a connector header, followed by the operation.
+  constexpr size_t kMsgSize =
+      NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+  alignas(struct nlmsghdr) uint8_t buf[kMsgSize] = {};
+
+  auto* msg_header = reinterpret_cast<struct nlmsghdr*>(buf);
+  msg_header->nlmsg_len = kMsgSize;
+  msg_header->nlmsg_type = NLMSG_DONE;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  auto* cn_msg = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(msg_header));
+#pragma GCC diagnostic pop
+  cn_msg->id.idx = CN_IDX_PROC;
+  cn_msg->id.val = CN_VAL_PROC;
+  cn_msg->len = sizeof(enum proc_cn_mcast_op);
+
+  const enum proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+  std::memcpy(cn_msg->data, &op, sizeof(op));
+
+  if (send(fd_, buf, kMsgSize, 0) != static_cast<ssize_t>(kMsgSize)) {
+    return error::Internal("Could not subscribe to proc connector events. [errno=$0]", errno);
+  }
+  return Status::OK();
+}
+
+Status ProcEventListener::ReadEvents(std::vector<ProcEvent>* events) {
+  alignas(struct nlmsghdr) uint8_t buf[kRecvBufSize];
+
+  bool events_dropped = false;
+  while (true) {
+    ssize_t num_bytes = RecvFromKernel(fd_, &buf, sizeof(buf));
+    if (num_bytes < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == ENOBUFS) {
+        // The socket buffer overflowed. Keep reading, to drain what is left.
+        events_dropped = true;
+        continue;
+      }
+      return error::Internal("Receive call failed. [errno=$0]", errno);
+    }
+
+    struct nlmsghdr* msg_header = reinterpret_cast<struct nlmsghdr*>(buf);
+
+    for (; NLMSG_OK(msg_header, num_bytes); msg_header = NLMSG_NEXT(msg_header, num_bytes)) {
+      if (msg_header->nlmsg_type == NLMSG_ERROR) {
+        return error::Internal("Netlink error");
+      }
+      if (msg_header->nlmsg_type == NLMSG_NOOP) {
+        continue;
+      }
+
+      const struct proc_event* proc_event = GetProcEvent(msg_header);
+      if (proc_event == nullptr) {
+        continue;
+      }
+
+      switch (proc_event->what) {
+        case proc_event::PROC_EVENT_FORK:
+          events->push_back({ProcEvent::Type::kFork,
+                             static_cast<pid_t>(proc_event->event_data.fork.child_tgid),
+                             static_cast<pid_t>(proc_event->event_data.fork.child_pid)});
+          break;
+        case proc_event::PROC_EVENT_EXEC:
+          events->push_back({ProcEvent::Type::kExec,
+                             static_cast<pid_t>(proc_event->event_data.exec.process_tgid),
+                             static_cast<pid_t>(proc_event->event_data.exec.process_pid)});
+          break;
+        case proc_event::PROC_EVENT_EXIT:
+          events->push_back({ProcEvent::Type::kExit,
+                             static_cast<pid_t>(proc_event->event_data.exit.process_tgid),
+                             static_cast<pid_t>(proc_event->event_data.exit.process_pid)});
+          break;
+        default:
+          // Includes acknowledgements of listen requests (PROC_EVENT_NONE), e.g. of other
+          // listeners, and events that do not affect the set of processes (uid/gid changes,
+          // ptrace, etc.).
+          break;
+      }
+    }
+  }
+
+  if (events_dropped) {
+    return error::ResourceUnavailable("The proc connector dropped events.");
+  }
+  return Status::OK();
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace system {
+
+/**
+ * A process lifecycle event, as reported by the kernel's proc connector.
+ */
+struct ProcEvent {
+  enum class Type {
+    kFork,
+    kExec,
+    kExit,
+  };
+
+  Type type;
+
+  // The process (thread group ID) that the event is about. For kFork, this is the child.
+  pid_t pid;
+
+  // The thread that the event is about. Equal to pid for the main thread of a process.
+  // For kFork, a tid different from pid means a new thread, rather than a new process.
+  pid_t tid;
+};
+
+/**
+ * Subscribes to process fork, exec and exit events through the netlink proc connector
+ * (NETLINK_CONNECTOR, CN_IDX_PROC). Lets callers keep track of the running processes without
+ * rescanning /proc.
+ *
+ * Note that subscribing requires CAP_NET_ADMIN, and that the kernel must be built with
+ * CONFIG_PROC_EVENTS. Create() returns an error otherwise, so callers can fall back to scanning.
+ * Messages that were not sent by the kernel are ignored.
+ */
+class ProcEventListener : public NotCopyMoveable {
+ public:
+  static StatusOr<std::unique_ptr<ProcEventListener>> Create();
+
+  ~ProcEventListener();
+
+  /**
+   * Appends all events received since the last call to events. Does not block.
+   *
+   * @return ResourceUnavailable if the kernel dropped events, because they were not read fast
+   * enough. The events returned are then incomplete, and callers should rebuild their state
+   * from /proc. Other errors mean that the listener is no longer usable.
+   */
+  Status ReadEvents(std::vector<ProcEvent>* events);
+
+ private:
+  ProcEventListener() = default;
+
+  Status Connect();
+  Status SendListenOp(bool listen);
+  // Waits for the kernel to acknowledge the listen request, and returns the error it reports.
+  Status WaitForListenAck();
+
+  int fd_ = -1;
+};
+
+}  // namespace system
+}  // namespace px
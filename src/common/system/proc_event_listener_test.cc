@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/proc_event_listener.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+using ::testing::AllOf;
+using ::testing::Contains;
+using ::testing::Field;
+using ::testing::Not;
+
+auto ProcEventIs(ProcEvent::Type type, pid_t pid, pid_t tid) {
+  return AllOf(Field(&ProcEvent::type, type), Field(&ProcEvent::pid, pid),
+               Field(&ProcEvent::tid, tid));
+}
+
+TEST(ProcEventListenerTest, ForkExecExit) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ProcEventListener> listener, ProcEventListener::Create());
+
+  pid_t child_pid = fork();
+  if (child_pid == 0) {
+    execl("/bin/true", "true", nullptr);
+    _exit(1);
+  }
+  ASSERT_GT(child_pid, 0);
+  ASSERT_EQ(waitpid(child_pid, nullptr, 0), child_pid);
+
+  std::vector<ProcEvent> events;
+  // Events are delivered asynchronously.
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_OK(listener->ReadEvents(&events));
+    bool exited = false;
+    for (const auto& event : events) {
+      exited |= (event.type == ProcEvent::Type::kExit && event.pid == child_pid);
+    }
+    if (exited) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  EXPECT_THAT(events, Contains(ProcEventIs(ProcEvent::Type::kFork, child_pid, child_pid)));
+  EXPECT_THAT(events, Contains(ProcEventIs(ProcEvent::Type::kExec, child_pid, child_pid)));
+  EXPECT_THAT(events, Contains(ProcEventIs(ProcEvent::Type::kExit, child_pid, child_pid)));
+}
+
+TEST(ProcEventListenerTest, ThreadEvents) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ProcEventListener> listener, ProcEventListener::Create());
+
+  std::thread thread([] {});
+  thread.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::vector<ProcEvent> events;
+  ASSERT_OK(listener->ReadEvents(&events));
+
+  // A new thread is reported as a fork in the same process, with a different thread ID.
+  const pid_t pid = getpid();
+  EXPECT_THAT(events,
+              Contains(AllOf(Field(&ProcEvent::type, ProcEvent::Type::kFork),
+                             Field(&ProcEvent::pid, pid), Field(&ProcEvent::tid, Not(pid)))));
+}
+
+}  // namespace system
+}  // namespace px
@@ -16,6 +16,14 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
 #include <fstream>
 #include <limits>
 #include <string>
@@ -95,6 +103,110 @@ constexpr int kProcStatStartTimeField = 21;
 constexpr int kProcStatVSizeField = 22;
 constexpr int kProcStatRSSField = 23;
 
+namespace {
+
+/*************************************************
+ * Allocation-free reading and scanning of /proc files.
+ *
+ * The files are read with pread() into a per-thread buffer that is reused across calls, and
+ * scanned in place, instead of going through std::ifstream and std::getline. On nodes with
+ * thousands of processes, that overhead would otherwise dominate the cost of collecting stats.
+ *************************************************/
+
+// Reads the file at path, relative to dirfd (or AT_FDCWD), into a buffer that is reused by
+// subsequent calls on the same thread. The returned view is valid until then.
+// Reads at most max_size bytes, for callers that only need the beginning of a long file.
+StatusOr<std::string_view> ReadProcFile(int dirfd, const char* path,
+                                        size_t max_size = std::numeric_limits<size_t>::max()) {
+  constexpr size_t kInitialBufferSize = 4096;
+  thread_local std::string buf;
+
+  const int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open file $0 [errno=$1]", path, errno);
+  }
+
+  if (buf.size() < kInitialBufferSize) {
+    buf.resize(kInitialBufferSize);
+  }
+  size_t size = 0;
+  while (size < max_size) {
+    if (size == buf.size()) {
+      buf.resize(2 * buf.size());
+    }
+    const ssize_t n = pread(fd, buf.data() + size, std::min(buf.size(), max_size) - size, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // E.g. ESRCH once the process exited.
+      const int read_errno = errno;
+      close(fd);
+      return error::Internal("Failed to read file $0 [errno=$1]", path, read_errno);
+    }
+    if (n == 0) {
+      break;
+    }
+    size += n;
+  }
+  close(fd);
+
+  return std::string_view(buf.data(), size);
+}
+
+// Formats <proc_base_path>/<pid>/<file> into a stack buffer.
+class ProcPIDFilePath {
+ public:
+  ProcPIDFilePath(const std::string& proc_base_path, pid_t pid, const char* file) {
+    std::snprintf(path_, sizeof(path_), "%s/%d/%s", proc_base_path.c_str(), pid, file);
+  }
+  const char* c_str() const { return path_; }
+
+ private:
+  char path_[PATH_MAX];
+};
+
+bool IsFieldSeparator(char c) { return c == ' ' || c == '\t'; }
+
+// Returns the next whitespace-separated token of *str, and removes it from *str.
+// Returns an empty view once *str has no more tokens.
+std::string_view NextToken(std::string_view* str) {
+  size_t begin = 0;
+  while (begin < str->size() && (IsFieldSeparator((*str)[begin]) || (*str)[begin] == '\n')) {
+    ++begin;
+  }
+  size_t end = begin;
+  while (end < str->size() && !IsFieldSeparator((*str)[end]) && (*str)[end] != '\n') {
+    ++end;
+  }
+  std::string_view token = str->substr(begin, end - begin);
+  str->remove_prefix(end);
+  return token;
+}
+
+// Returns the next line of *str (without the newline), and removes it from *str.
+std::string_view NextLine(std::string_view* str) {
+  const size_t pos = str->find('\n');
+  std::string_view line = str->substr(0, pos);
+  str->remove_prefix(pos == std::string_view::npos ? str->size() : pos + 1);
+  return line;
+}
+
+// Splits the whitespace-separated line into up to fields->size() fields.
+// Returns the number of fields, which may exceed fields->size().
+size_t SplitFields(std::string_view line, absl::Span<std::string_view> fields) {
+  size_t num_fields = 0;
+  for (std::string_view token = NextToken(&line); !token.empty(); token = NextToken(&line)) {
+    if (num_fields < fields.size()) {
+      fields[num_fields] = token;
+    }
+    ++num_fields;
+  }
+  return num_fields;
+}
+
+}  // namespace
+
 std::filesystem::path ProcParser::ProcPidPath(pid_t pid) const {
   return std::filesystem::path(proc_base_path_) / std::to_string(pid);
 }
@@ -106,8 +218,34 @@ ProcParser::ProcParser(const system::Config& cfg) {
   proc_base_path_ = cfg.proc_path();
 }
 
+ProcParser::PIDDir& ProcParser::PIDDir::operator=(PIDDir&& other) {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    pid_ = other.pid_;
+    fd_ = std::exchange(other.fd_, -1);
+  }
+  return *this;
+}
+
+ProcParser::PIDDir::~PIDDir() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+StatusOr<ProcParser::PIDDir> ProcParser::OpenPIDDir(pid_t pid) const {
+  const ProcPIDFilePath path(proc_base_path_, pid, "");
+  const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open directory $0 [errno=$1]", path.c_str(), errno);
+  }
+  return PIDDir(pid, fd);
+}
+
 Status ProcParser::ParseNetworkStatAccumulateIFaceData(
-    const std::vector<std::string_view>& dev_stat_record, NetworkStats* out) {
+    absl::Span<const std::string_view> dev_stat_record, NetworkStats* out) {
   DCHECK(out != nullptr);
 
   int64_t val;
@@ -170,33 +308,43 @@ Status ProcParser::ParseProcPIDNetDev(int32_t pid, NetworkStats* out) const {
    */
   DCHECK(out != nullptr);
 
-  std::string fpath = absl::Substitute("$0/$1/net/dev", proc_base_path_, pid);
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
+  const ProcPIDFilePath fpath(proc_base_path_, pid, "net/dev");
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(AT_FDCWD, fpath.c_str()));
 
   // Ignore the first two lines since they are just headers;
   const int kHeaderLines = 2;
   for (int i = 0; i < kHeaderLines; ++i) {
-    ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    NextLine(&contents);
   }
 
-  std::string line;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  std::array<std::string_view, kProcNetDevNumFields> fields;
+  while (!contents.empty()) {
+    std::string_view line = NextLine(&contents);
+    if (line.empty()) {
+      continue;
+    }
+
+    // The interface name is terminated by a colon, which is not always followed by a space
+    // (e.g. "eth0:1234567890").
+    const size_t colon_pos = line.find(':');
+    if (colon_pos == std::string_view::npos) {
+      return error::Internal("failed to parse net dev file, missing interface name");
+    }
+    std::string_view iface = line.substr(0, colon_pos);
+    fields[kProcNetDevIFaceField] = NextToken(&iface);
+    const size_t num_fields =
+        1 + SplitFields(line.substr(colon_pos + 1), absl::MakeSpan(fields).subspan(1));
     // We check less than in case more fields are added later.
-    if (split.size() < kProcNetDevNumFields) {
+    if (num_fields < kProcNetDevNumFields) {
       return error::Internal("failed to parse net dev file, incorrect number of fields");
     }
 
-    if (!ShouldIncludeNetIFace(split[kProcNetDevIFaceField])) {
+    if (!ShouldIncludeNetIFace(fields[kProcNetDevIFaceField])) {
       continue;
     }
 
     // We should track this interface. Accumulate the results.
-    auto s = ParseNetworkStatAccumulateIFaceData(split, out);
+    auto s = ParseNetworkStatAccumulateIFaceData(fields, out);
     if (!s.ok()) {
       // Empty out the stats so we don't leave intermediate results.
       return s;
@@ -206,6 +354,38 @@ Status ProcParser::ParseProcPIDNetDev(int32_t pid, NetworkStats* out) const {
   return Status::OK();
 }
 
+namespace {
+
+// Splits the contents of /proc/<pid>/stat into its fields.
+// The process name (field 1) may itself contain spaces and parentheses, so it is taken to be
+// everything between the first '(' and the last ')'. The parentheses are kept.
+Status SplitProcPIDStat(std::string_view contents,
+                        std::array<std::string_view, kProcStatNumFields>* fields) {
+  const size_t name_begin = contents.find('(');
+  const size_t name_end = contents.rfind(')');
+  if (name_begin == std::string_view::npos || name_end == std::string_view::npos ||
+      name_end < name_begin) {
+    return error::Internal("Could not find the process name in stat file.");
+  }
+
+  std::string_view pid_str = contents.substr(0, name_begin);
+  (*fields)[kProcStatPIDField] = NextToken(&pid_str);
+  (*fields)[kProcStatProcessNameField] = contents.substr(name_begin, name_end - name_begin + 1);
+
+  contents.remove_prefix(name_end + 1);
+  const size_t num_fields =
+      kProcStatProcessNameField + 1 +
+      SplitFields(NextLine(&contents),
+                  absl::MakeSpan(*fields).subspan(kProcStatProcessNameField + 1));
+  // We check less than in case more fields are added later.
+  if (num_fields < kProcStatNumFields) {
+    return error::Internal("Unexpected number of fields in stat file [fields = $0].", num_fields);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 Status ProcParser::ParseProcPIDStat(int32_t pid, ProcessStats* out) const {
   /**
    * Sample file:
@@ -216,54 +396,58 @@ Status ProcParser::ParseProcPIDStat(int32_t pid, ProcessStats* out) const {
    * 140730842488200 140730842492896 0
    */
   DCHECK(out != nullptr);
-  std::string fpath = absl::Substitute("$0/$1/stat", proc_base_path_, pid);
+  const ProcPIDFilePath fpath(proc_base_path_, pid, "stat");
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(AT_FDCWD, fpath.c_str()));
+  Status s = ParseProcPIDStatContents(contents, out);
+  if (!s.ok()) {
+    return error::Internal("Failed to parse stat file $0: $1", fpath.c_str(), s.msg());
+  }
+  return Status::OK();
+}
 
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
+Status ProcParser::ParseProcPIDStat(const PIDDir& pid_dir, ProcessStats* out) const {
+  DCHECK(out != nullptr);
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(pid_dir.fd(), "stat"));
+  Status s = ParseProcPIDStatContents(contents, out);
+  if (!s.ok()) {
+    return error::Internal("Failed to parse stat file of pid $0: $1", pid_dir.pid(), s.msg());
   }
+  return Status::OK();
+}
 
-  std::string line;
-  bool ok = true;
-  if (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-    // We check less than in case more fields are added later.
-    if (split.size() < kProcStatNumFields) {
-      return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatPIDField], &out->pid);
-    // The name is surrounded by () we remove it here.
-    const std::string_view& name_field = split[kProcStatProcessNameField];
-    if (name_field.length() > 2) {
-      out->process_name = std::string(name_field.substr(1, name_field.size() - 2));
-    } else {
-      ok = false;
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatMinorFaultsField], &out->minor_faults);
-    ok &= absl::SimpleAtoi(split[kProcStatMajorFaultsField], &out->major_faults);
+Status ProcParser::ParseProcPIDStatContents(std::string_view contents, ProcessStats* out) const {
+  std::array<std::string_view, kProcStatNumFields> split;
+  PL_RETURN_IF_ERROR(SplitProcPIDStat(contents, &split));
 
-    ok &= absl::SimpleAtoi(split[kProcStatUTimeField], &out->utime_ns);
-    ok &= absl::SimpleAtoi(split[kProcStatKTimeField], &out->ktime_ns);
-    // The kernel tracks utime and ktime in kernel ticks.
-    out->utime_ns *= ns_per_kernel_tick_;
-    out->ktime_ns *= ns_per_kernel_tick_;
+  bool ok = true;
+  ok &= absl::SimpleAtoi(split[kProcStatPIDField], &out->pid);
+  // The name is surrounded by () we remove it here.
+  const std::string_view& name_field = split[kProcStatProcessNameField];
+  if (name_field.length() > 2) {
+    out->process_name.assign(name_field.substr(1, name_field.size() - 2));
+  } else {
+    ok = false;
+  }
+  ok &= absl::SimpleAtoi(split[kProcStatMinorFaultsField], &out->minor_faults);
+  ok &= absl::SimpleAtoi(split[kProcStatMajorFaultsField], &out->major_faults);
 
-    ok &= absl::SimpleAtoi(split[kProcStatNumThreadsField], &out->num_threads);
-    ok &= absl::SimpleAtoi(split[kProcStatVSizeField], &out->vsize_bytes);
-    ok &= absl::SimpleAtoi(std::string(split[kProcStatRSSField]), &out->rss_bytes);
+  ok &= absl::SimpleAtoi(split[kProcStatUTimeField], &out->utime_ns);
+  ok &= absl::SimpleAtoi(split[kProcStatKTimeField], &out->ktime_ns);
+  // The kernel tracks utime and ktime in kernel ticks.
+  out->utime_ns *= ns_per_kernel_tick_;
+  out->ktime_ns *= ns_per_kernel_tick_;
 
-    // RSS is in pages.
-    out->rss_bytes *= bytes_per_page_;
+  ok &= absl::SimpleAtoi(split[kProcStatNumThreadsField], &out->num_threads);
+  ok &= absl::SimpleAtoi(split[kProcStatVSizeField], &out->vsize_bytes);
+  ok &= absl::SimpleAtoi(split[kProcStatRSSField], &out->rss_bytes);
 
-  } else {
-    return error::Internal("Failed to read proc stat file: $0", fpath);
-  }
+  // RSS is in pages.
+  out->rss_bytes *= bytes_per_page_;
 
   if (!ok) {
     // This should never happen since it requires the file to be ill-formed
     // by the kernel.
-    return error::Internal("failed to parse stat file ($0). ATOI failed.", fpath);
+    return error::Internal("ATOI failed.");
   }
   return Status::OK();
 }
@@ -280,8 +464,18 @@ Status ProcParser::ParseProcPIDStatIO(int32_t pid, ProcessStats* out) const {
    *   cancelled_write_bytes: 192512
    */
   DCHECK(out != nullptr);
-  std::string fpath = absl::Substitute("$0/$1/io", proc_base_path_, pid);
+  const ProcPIDFilePath fpath(proc_base_path_, pid, "io");
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(AT_FDCWD, fpath.c_str()));
+  return ParseProcPIDStatIOContents(contents, out);
+}
+
+Status ProcParser::ParseProcPIDStatIO(const PIDDir& pid_dir, ProcessStats* out) const {
+  DCHECK(out != nullptr);
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(pid_dir.fd(), "io"));
+  return ParseProcPIDStatIOContents(contents, out);
+}
 
+Status ProcParser::ParseProcPIDStatIOContents(std::string_view contents, ProcessStats* out) {
   // Just to be safe when using offsetof, make sure object is standard layout.
   static_assert(std::is_standard_layout<ProcessStats>::value);
 
@@ -292,8 +486,8 @@ Status ProcParser::ParseProcPIDStatIO(int32_t pid, ProcessStats* out) const {
       {"write_bytes:", offsetof(ProcessStats, write_bytes)},
   };
 
-  return ParseFromKeyValueFile(fpath, field_name_to_offset_map, reinterpret_cast<uint8_t*>(out),
-                               1 /*field_value_multipler*/);
+  return ParseFromKeyValueContents(contents, field_name_to_offset_map,
+                                   reinterpret_cast<uint8_t*>(out), 1 /*field_value_multipler*/);
 }
 
 Status ProcParser::ParseProcStat(SystemStats* out) const {
@@ -304,20 +498,20 @@ Status ProcParser::ParseProcStat(SystemStats* out) const {
    * ...
    */
   CHECK(out != nullptr);
-  std::string fpath = absl::Substitute("$0/stat", proc_base_path_);
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
-
-  std::string line;
+  const std::string fpath = absl::StrCat(proc_base_path_, "/stat");
+  // The aggregate cpu line comes first. The rest of the file grows with the number of CPUs
+  // and interrupts, and is not needed.
+  constexpr size_t kMaxReadSize = 4096;
+  PL_ASSIGN_OR_RETURN(std::string_view contents,
+                      ReadProcFile(AT_FDCWD, fpath.c_str(), kMaxReadSize));
+
+  std::array<std::string_view, kProcStatCPUNumFields> split;
   bool ok = true;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  while (!contents.empty()) {
+    const size_t num_fields = SplitFields(NextLine(&contents), absl::MakeSpan(split));
 
-    if (!split.empty() && split[0] == "cpu") {
-      if (split.size() < kProcStatCPUNumFields) {
+    if (num_fields > 0 && split[0] == "cpu") {
+      if (num_fields < kProcStatCPUNumFields) {
         return error::Unknown("Incorrect number of fields in proc/stat CPU");
       }
 
@@ -345,7 +539,8 @@ Status ProcParser::ParseProcMemInfo(SystemStats* out) const {
    * ...
    */
   CHECK(out != nullptr);
-  std::string fpath = absl::Substitute("$0/meminfo", proc_base_path_);
+  const std::string fpath = absl::StrCat(proc_base_path_, "/meminfo");
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(AT_FDCWD, fpath.c_str()));
 
   // Just to be safe when using offsetof, make sure object is standard layout.
   static_assert(std::is_standard_layout<SystemStats>::value);
@@ -365,31 +560,26 @@ Status ProcParser::ParseProcMemInfo(SystemStats* out) const {
 
   // This is a key value pair with a unit (that is always KB when present).
   constexpr int kKBToByteMultiplier = 1024;
-  return ParseFromKeyValueFile(fpath, field_name_to_offset_map, reinterpret_cast<uint8_t*>(out),
-                               kKBToByteMultiplier);
+  return ParseFromKeyValueContents(contents, field_name_to_offset_map,
+                                   reinterpret_cast<uint8_t*>(out), kKBToByteMultiplier);
 }
 
-Status ProcParser::ParseFromKeyValueFile(
-    const std::string& fpath,
+Status ProcParser::ParseFromKeyValueContents(
+    std::string_view contents,
     const absl::flat_hash_map<std::string_view, size_t>& field_name_to_value_map, uint8_t* out_base,
     int64_t field_value_multiplier) {
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
+  // This is a key value pair with a unit (that is always KB when present).
+  // If the number is 0 then the units are missing so we either have 2 or 3
+  // for the width of the field.
+  constexpr size_t kMemInfoMinFields = 2;
+  constexpr size_t kMemInfoMaxFields = 3;
+  std::array<std::string_view, kMemInfoMaxFields> split;
 
-  std::string line;
   size_t read_count = 0;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-    // This is a key value pair with a unit (that is always KB when present).
-    // If the number is 0 then the units are missing so we either have 2 or 3
-    // for the width of the field.
-    const int kMemInfoMinFields = 2;
-    const int kMemInfoMaxFields = 3;
-
-    if (split.size() >= kMemInfoMinFields && split.size() <= kMemInfoMaxFields) {
+  while (!contents.empty()) {
+    const size_t num_fields = SplitFields(NextLine(&contents), absl::MakeSpan(split));
+
+    if (num_fields >= kMemInfoMinFields && num_fields <= kMemInfoMaxFields) {
       const auto& key = split[0];
       const auto& val = split[1];
 
@@ -410,7 +600,7 @@ Status ProcParser::ParseFromKeyValueFile(
 
       // Check to see if we have read all the fields, if so we can skip the
       // rest. We assume no duplicates.
-      if (read_count == field_name_to_value_map.size()) {
+      if (++read_count == field_name_to_value_map.size()) {
         break;
       }
     }
@@ -544,46 +734,15 @@ StatusOr<int64_t> GetPIDStartTimeTicks(const std::filesystem::path& proc_pid_pat
   const std::filesystem::path proc_pid_stat_path = proc_pid_path / "stat";
   const std::string fpath = proc_pid_stat_path.string();
 
-  std::string line;
-
-  // It's usually a big no-no to ifdef based on compilation mode,
-  // but this is a workaround for an ASAN bug that causes crashes and flakiness
-  // in our tests. See //src/common/system/proc_parser_bug_test.cc for details.
-  //
-  // The workaround implementation uses a C functions that don't throw exceptions.
-  // Why not just use the workaround version all the time?
-  // Because it has a hard-coded constant which makes it less robust.
-#if defined(PL_CONFIG_ASAN)
-  std::FILE* fp = std::fopen(fpath.c_str(), "r");
-  if (fp == nullptr) {
-    return error::Internal("Could not open file $0", fpath);
-  }
-
-  // A few quick runs show that /proc/<pid>/stat is <200 characters on my machine,
-  // but a lot of those numbers are 0. If they were non-zero, the string could be much
-  // longer. Hopefully a 4KB block keeps us safe. This is for ASAN only anyways.
-  constexpr int kMaxSupportedProcPIDStatLength = 4096;
-  line.resize(kMaxSupportedProcPIDStatLength);
-  if (std::fgets(line.data(), line.size(), fp) == nullptr) {
-    return error::Internal("Could not get line from file $0", fpath);
-  }
-#else
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Could not open file $0", fpath);
-  }
-
-  if (!std::getline(ifs, line)) {
-    return error::Internal("Could not get line from file $0", fpath);
-  }
-#endif
+  // Note that this intentionally does not use std::ifstream, which throws exceptions from within
+  // ASAN builds when the PID dies while the file is being read.
+  // See //src/common/system/proc_parser_bug_test.cc for details.
+  PL_ASSIGN_OR_RETURN(std::string_view contents, ReadProcFile(AT_FDCWD, fpath.c_str()));
 
-  std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-  // We check less than in case more fields are added later.
-  if (split.size() < kProcStatNumFields) {
-    return error::Internal("Unexpected number of columns in file $0 [columns = $1].", fpath,
-                           split.size());
+  std::array<std::string_view, kProcStatNumFields> split;
+  Status s = SplitProcPIDStat(contents, &split);
+  if (!s.ok()) {
+    return error::Internal("Failed to parse file $0: $1", fpath, s.msg());
   }
 
   int64_t start_time_ticks;
@@ -23,10 +23,12 @@
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/types/span.h>
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 
@@ -118,6 +120,34 @@ class ProcParser {
     void Clear() { *this = SystemStats(); }
   };
 
+  /**
+   * An open /proc/<pid> directory. The files of the process are opened relative to it with
+   * openat(), which skips resolving the full path for every file. It also guarantees that all
+   * files are of the same process: once the process exits, reads fail, even if the PID is reused.
+   */
+  class PIDDir : public NotCopyable {
+   public:
+    PIDDir() = default;
+    PIDDir(PIDDir&& other) : pid_(other.pid_), fd_(std::exchange(other.fd_, -1)) {}
+    PIDDir& operator=(PIDDir&& other);
+    ~PIDDir();
+
+    pid_t pid() const { return pid_; }
+    int fd() const { return fd_; }
+
+   private:
+    friend class ProcParser;
+    PIDDir(pid_t pid, int fd) : pid_(pid), fd_(fd) {}
+
+    pid_t pid_ = -1;
+    int fd_ = -1;
+  };
+
+  /**
+   * Opens /proc/<pid>, for reading multiple files of the process.
+   */
+  StatusOr<PIDDir> OpenPIDDir(pid_t pid) const;
+
   /**
    * Parses /proc/<pid>/stat files
    * @param pid is the pid for which we want stat data..
@@ -125,6 +155,7 @@ class ProcParser {
    * @return Status of parsing.
    */
   Status ParseProcPIDStat(int32_t pid, ProcessStats* out) const;
+  Status ParseProcPIDStat(const PIDDir& pid_dir, ProcessStats* out) const;
 
   /**
    * Specialization of ParseProcPIDStat to just extract the start time.
@@ -152,6 +183,7 @@ class ProcParser {
    * @return Status of the parsing.
    */
   Status ParseProcPIDStatIO(int32_t pid, ProcessStats* out) const;
+  Status ParseProcPIDStatIO(const PIDDir& pid_dir, ProcessStats* out) const;
 
   /**
    * Parses /proc/<pid>/net/dev
@@ -263,13 +295,17 @@ class ProcParser {
 
  private:
   static Status ParseNetworkStatAccumulateIFaceData(
-      const std::vector<std::string_view>& dev_stat_record, NetworkStats* out);
+      absl::Span<const std::string_view> dev_stat_record, NetworkStats* out);
 
-  static Status ParseFromKeyValueFile(
-      const std::string& fpath,
+  static Status ParseFromKeyValueContents(
+      std::string_view contents,
       const absl::flat_hash_map<std::string_view, size_t>& field_name_to_value_map,
       uint8_t* out_base, int64_t field_value_multiplier);
 
+  // Parsers of the file contents, shared by the pid and PIDDir variants.
+  Status ParseProcPIDStatContents(std::string_view contents, ProcessStats* out) const;
+  static Status ParseProcPIDStatIOContents(std::string_view contents, ProcessStats* out);
+
   std::filesystem::path ProcPidPath(pid_t pid) const;
 
   int64_t ns_per_kernel_tick_;
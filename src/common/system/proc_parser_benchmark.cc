@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+#include "src/common/system/config.h"
+#include "src/common/system/proc_parser.h"
+
+namespace px {
+namespace system {
+
+namespace {
+
+// Returns the PIDs of the processes currently running on the host.
+std::vector<pid_t> ListPIDs(const std::filesystem::path& proc_path) {
+  std::vector<pid_t> pids;
+  for (const auto& entry : std::filesystem::directory_iterator(proc_path)) {
+    pid_t pid;
+    if (absl::SimpleAtoi(entry.path().filename().string(), &pid)) {
+      pids.push_back(pid);
+    }
+  }
+  return pids;
+}
+
+// The std::ifstream and absl::StrSplit based parsing of /proc/<pid>/stat that ProcParser used
+// previously, for comparison.
+bool LegacyParseProcPIDStat(const std::filesystem::path& proc_path, pid_t pid,
+                            ProcParser::ProcessStats* out) {
+  std::ifstream ifs(proc_path / std::to_string(pid) / "stat");
+  std::string line;
+  if (!ifs || !std::getline(ifs, line)) {
+    return false;
+  }
+  std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  if (split.size() < 52) {
+    return false;
+  }
+  bool ok = true;
+  ok &= absl::SimpleAtoi(split[0], &out->pid);
+  out->process_name = std::string(split[1]);
+  ok &= absl::SimpleAtoi(split[9], &out->minor_faults);
+  ok &= absl::SimpleAtoi(split[11], &out->major_faults);
+  ok &= absl::SimpleAtoi(split[13], &out->utime_ns);
+  ok &= absl::SimpleAtoi(split[14], &out->ktime_ns);
+  ok &= absl::SimpleAtoi(split[19], &out->num_threads);
+  ok &= absl::SimpleAtoi(split[22], &out->vsize_bytes);
+  ok &= absl::SimpleAtoi(split[23], &out->rss_bytes);
+  return ok;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_legacy_parse_pid_stat(benchmark::State& state) {
+  const std::filesystem::path& proc_path = Config::GetInstance().proc_path();
+  const std::vector<pid_t> pids = ListPIDs(proc_path);
+  ProcParser::ProcessStats stats;
+  for (auto _ : state) {
+    for (pid_t pid : pids) {
+      benchmark::DoNotOptimize(LegacyParseProcPIDStat(proc_path, pid, &stats));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pids.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_pid_stat(benchmark::State& state) {
+  ProcParser parser(Config::GetInstance());
+  const std::vector<pid_t> pids = ListPIDs(Config::GetInstance().proc_path());
+  ProcParser::ProcessStats stats;
+  for (auto _ : state) {
+    for (pid_t pid : pids) {
+      benchmark::DoNotOptimize(parser.ParseProcPIDStat(pid, &stats));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pids.size());
+}
+
+// Parses both stat and io of each process, as the process stats connector does.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_pid_stat_and_io(benchmark::State& state) {
+  ProcParser parser(Config::GetInstance());
+  const std::vector<pid_t> pids = ListPIDs(Config::GetInstance().proc_path());
+  ProcParser::ProcessStats stats;
+  for (auto _ : state) {
+    for (pid_t pid : pids) {
+      benchmark::DoNotOptimize(parser.ParseProcPIDStat(pid, &stats));
+      benchmark::DoNotOptimize(parser.ParseProcPIDStatIO(pid, &stats));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pids.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_pid_stat_and_io_with_pid_dir(benchmark::State& state) {
+  ProcParser parser(Config::GetInstance());
+  const std::vector<pid_t> pids = ListPIDs(Config::GetInstance().proc_path());
+  ProcParser::ProcessStats stats;
+  for (auto _ : state) {
+    for (pid_t pid : pids) {
+      StatusOr<ProcParser::PIDDir> pid_dir = parser.OpenPIDDir(pid);
+      if (!pid_dir.ok()) {
+        continue;
+      }
+      benchmark::DoNotOptimize(parser.ParseProcPIDStat(pid_dir.ValueOrDie(), &stats));
+      benchmark::DoNotOptimize(parser.ParseProcPIDStatIO(pid_dir.ValueOrDie(), &stats));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pids.size());
+}
+
+BENCHMARK(BM_legacy_parse_pid_stat);
+BENCHMARK(BM_parse_pid_stat);
+BENCHMARK(BM_parse_pid_stat_and_io);
+BENCHMARK(BM_parse_pid_stat_and_io_with_pid_dir);
+
+}  // namespace system
+}  // namespace px
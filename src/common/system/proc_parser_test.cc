@@ -25,6 +25,8 @@
 #include <memory>
 #include <sstream>
 
+#include <absl/strings/str_replace.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/config_mock.h"
 #include "src/common/testing/test_environment.h"
@@ -116,6 +118,63 @@ TEST_F(ProcParserTest, ParsePidStat) {
   EXPECT_EQ(2577 * bytes_per_page_, stats.rss_bytes);
 }
 
+TEST_F(ProcParserTest, ParsePidStatWithPIDDir) {
+  ASSERT_OK_AND_ASSIGN(ProcParser::PIDDir pid_dir, parser_->OpenPIDDir(123));
+  EXPECT_EQ(123, pid_dir.pid());
+
+  ProcParser::ProcessStats stats;
+  PL_CHECK_OK(parser_->ParseProcPIDStat(pid_dir, &stats));
+  PL_CHECK_OK(parser_->ParseProcPIDStatIO(pid_dir, &stats));
+
+  // Must be the same as parsing the files by PID.
+  ProcParser::ProcessStats expected_stats;
+  PL_CHECK_OK(parser_->ParseProcPIDStat(123, &expected_stats));
+  PL_CHECK_OK(parser_->ParseProcPIDStatIO(123, &expected_stats));
+
+  EXPECT_EQ(expected_stats.pid, stats.pid);
+  EXPECT_EQ(expected_stats.process_name, stats.process_name);
+  EXPECT_EQ(expected_stats.utime_ns, stats.utime_ns);
+  EXPECT_EQ(expected_stats.ktime_ns, stats.ktime_ns);
+  EXPECT_EQ(expected_stats.num_threads, stats.num_threads);
+  EXPECT_EQ(expected_stats.major_faults, stats.major_faults);
+  EXPECT_EQ(expected_stats.minor_faults, stats.minor_faults);
+  EXPECT_EQ(expected_stats.vsize_bytes, stats.vsize_bytes);
+  EXPECT_EQ(expected_stats.rss_bytes, stats.rss_bytes);
+  EXPECT_EQ(expected_stats.rchar_bytes, stats.rchar_bytes);
+  EXPECT_EQ(expected_stats.wchar_bytes, stats.wchar_bytes);
+  EXPECT_EQ(expected_stats.read_bytes, stats.read_bytes);
+  EXPECT_EQ(expected_stats.write_bytes, stats.write_bytes);
+}
+
+TEST_F(ProcParserTest, OpenPIDDirOfMissingPID) { EXPECT_NOT_OK(parser_->OpenPIDDir(999999)); }
+
+// Tests that process names with spaces and parentheses are parsed correctly.
+TEST_F(ProcParserTest, ParsePidStatNameWithSpaces) {
+  testing::TempDir proc_dir;
+  std::filesystem::create_directory(proc_dir.path() / "123");
+  ASSERT_OK_AND_ASSIGN(std::string stat,
+                       ReadFileToString(GetPathToTestDataFile("testdata/proc/123/stat")));
+  stat = absl::StrReplaceAll(stat, {{"(ibazel)", "(tmux: (server) 2)"}});
+  ASSERT_OK(WriteFileFromString((proc_dir.path() / "123/stat").string(), stat));
+
+  proc_path_ = proc_dir.path();
+  system::MockConfig sysconfig;
+  EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+  EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(10000000));
+  EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path_));
+  ProcParser parser(sysconfig);
+
+  ProcParser::ProcessStats stats;
+  PL_CHECK_OK(parser.ParseProcPIDStat(123, &stats));
+  EXPECT_EQ("tmux: (server) 2", stats.process_name);
+  EXPECT_EQ(4602, stats.pid);
+  EXPECT_EQ(13, stats.num_threads);
+  EXPECT_EQ(2577 * bytes_per_page_, stats.rss_bytes);
+
+  ASSERT_OK_AND_EQ(GetPIDStartTimeTicks(proc_dir.path() / "123"), 14329);
+}
+
 TEST_F(ProcParserTest, ParseStat) {
   ProcParser::SystemStats stats;
   PL_CHECK_OK(parser_->ParseProcStat(&stats));
@@ -117,7 +117,7 @@ Status NetlinkSocketProber::SendDiagReq(const TDiagReqType& msg_req) {
 namespace {
 
 Status ProcessDiagMsg(const struct inet_diag_msg& diag_msg, unsigned int len,
-                      std::map<int, SocketInfo>* socket_info_entries) {
+                      SocketInfoMap* socket_info_entries) {
   if (len < NLMSG_LENGTH(sizeof(diag_msg))) {
     return error::Internal("Not enough bytes");
   }
@@ -160,7 +160,7 @@ Status ProcessDiagMsg(const struct inet_diag_msg& diag_msg, unsigned int len,
 }
 
 Status ProcessDiagMsg(const struct unix_diag_msg& diag_msg, unsigned int len,
-                      std::map<int, SocketInfo>* socket_info_entries) {
+                      SocketInfoMap* socket_info_entries) {
   if (len < NLMSG_LENGTH(sizeof(diag_msg))) {
     return error::Internal("Not enough bytes");
   }
@@ -211,7 +211,7 @@ Status ProcessDiagMsg(const struct unix_diag_msg& diag_msg, unsigned int len,
 }  // namespace
 
 template <typename TDiagMsgType>
-Status NetlinkSocketProber::RecvDiagResp(std::map<int, SocketInfo>* socket_info_entries) {
+Status NetlinkSocketProber::RecvDiagResp(SocketInfoMap* socket_info_entries) {
   static constexpr int kBufSize = 8192;
   uint8_t buf[kBufSize];
 
@@ -250,7 +250,7 @@ Status NetlinkSocketProber::RecvDiagResp(std::map<int, SocketInfo>* socket_info_
 }
 
 namespace {
-void ClassifySocketRoles(std::map<int, SocketInfo>* socket_info_entries) {
+void ClassifySocketRoles(SocketInfoMap* socket_info_entries) {
   absl::flat_hash_set<SockAddrIPv4, SockAddrIPv4HashFn, SockAddrIPv4EqFn> ipv4_listening_sockets;
   absl::flat_hash_set<SockAddrIPv6, SockAddrIPv6HashFn, SockAddrIPv6EqFn> ipv6_listening_sockets;
 
@@ -302,8 +302,7 @@ void ClassifySocketRoles(std::map<int, SocketInfo>* socket_info_entries) {
 }
 }  // namespace
 
-Status NetlinkSocketProber::InetConnections(std::map<int, SocketInfo>* socket_info_entries,
-                                            int conn_states) {
+Status NetlinkSocketProber::InetConnections(SocketInfoMap* socket_info_entries, int conn_states) {
   struct inet_diag_req_v2 msg_req = {};
   msg_req.sdiag_protocol = IPPROTO_TCP;
   msg_req.idiag_states = conn_states;
@@ -326,8 +325,7 @@ Status NetlinkSocketProber::InetConnections(std::map<int, SocketInfo>* socket_in
   return Status::OK();
 }
 
-Status NetlinkSocketProber::UnixConnections(std::map<int, SocketInfo>* socket_info_entries,
-                                            int conn_states) {
+Status NetlinkSocketProber::UnixConnections(SocketInfoMap* socket_info_entries, int conn_states) {
   struct unix_diag_req msg_req = {};
   msg_req.sdiag_family = AF_UNIX;
   msg_req.udiag_states = conn_states;
@@ -461,58 +459,79 @@ void SocketProberManager::Update() {
 //-----------------------------------------------------------------------------
 
 StatusOr<std::unique_ptr<SocketInfoManager>> SocketInfoManager::Create(
-    std::filesystem::path proc_path, int conn_states) {
+    std::filesystem::path proc_path, int conn_states, std::chrono::milliseconds cache_ttl) {
   std::unique_ptr<SocketInfoManager> socket_info_db_ptr(
-      new SocketInfoManager(proc_path, conn_states));
+      new SocketInfoManager(proc_path, conn_states, cache_ttl));
   PL_ASSIGN_OR_RETURN(socket_info_db_ptr->socket_probers_, SocketProberManager::Create());
   return socket_info_db_ptr;
 }
 
-StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
+Status SocketInfoManager::ProbeNamespaceConns(uint32_t net_ns, uint32_t pid,
+                                              NamespaceConns* namespace_conns) {
+  PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
+                      socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
+  DCHECK(socket_prober != nullptr);
 
-  // Step 1: Get the map of connections for this network namespace.
-  // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
+  namespace_conns->conns.clear();
+  namespace_conns->probe_time = std::chrono::steady_clock::now();
+  namespace_conns->probe_flush_count = flush_count_;
 
-  auto ns_iter = connections_.find(net_ns);
-  if (ns_iter != connections_.end()) {
-    // Found a map of connections for this network namespace, so use it.
-    namespace_conns = &ns_iter->second;
-  } else {
-    // No map of connections for this network namespace, so use a socker prober to populate one.
-    PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
-                        socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
-    DCHECK(socket_prober != nullptr);
+  Status s;
 
-    ns_iter = connections_.insert(ns_iter, {net_ns, {}});
-    namespace_conns = &ns_iter->second;
+  s = socket_prober->InetConnections(&namespace_conns->conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    Status s;
+  s = socket_prober->UnixConnections(&namespace_conns->conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    s = socket_prober->InetConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+  ++num_socket_prober_calls_;
 
-    s = socket_prober->UnixConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+  return Status::OK();
+}
 
-    ++num_socket_prober_calls_;
+StatusOr<SocketInfoManager::NamespaceConns*> SocketInfoManager::GetOrProbeNamespaceConns(
+    uint32_t pid, uint32_t* net_ns) {
+  PL_ASSIGN_OR_RETURN(*net_ns, NetNamespace(cfg_proc_path_, pid));
+
+  auto ns_iter = connections_.find(*net_ns);
+  if (ns_iter != connections_.end()) {
+    // Found a snapshot of connections for this network namespace, so use it.
+    return &ns_iter->second;
   }
 
-  return namespace_conns;
+  // No snapshot of connections for this network namespace, so use a socket prober to take one.
+  NamespaceConns namespace_conns;
+  PL_RETURN_IF_ERROR(ProbeNamespaceConns(*net_ns, pid, &namespace_conns));
+  ns_iter = connections_.emplace(*net_ns, std::move(namespace_conns)).first;
+  return &ns_iter->second;
+}
+
+StatusOr<SocketInfoMap*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
+  uint32_t net_ns;
+  PL_ASSIGN_OR_RETURN(NamespaceConns * namespace_conns, GetOrProbeNamespaceConns(pid, &net_ns));
+  return &namespace_conns->conns;
 }
 
 StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num) {
   // Step 1: Get the map of connections for this network namespace.
   // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
-  PL_ASSIGN_OR_RETURN(namespace_conns, GetNamespaceConns(pid));
+  uint32_t net_ns;
+  PL_ASSIGN_OR_RETURN(NamespaceConns * namespace_conns, GetOrProbeNamespaceConns(pid, &net_ns));
 
   // Step 2: Lookup the inode.
-  auto iter = namespace_conns->find(inode_num);
-  if (iter == namespace_conns->end()) {
+  auto iter = namespace_conns->conns.find(inode_num);
+
+  // If the snapshot was carried over from before the last Flush(), the socket may be newer than
+  // the snapshot. Take a new snapshot, but only once per namespace between calls to Flush().
+  if (iter == namespace_conns->conns.end() &&
+      namespace_conns->probe_flush_count != flush_count_) {
+    PL_RETURN_IF_ERROR(ProbeNamespaceConns(net_ns, pid, namespace_conns));
+    iter = namespace_conns->conns.find(inode_num);
+  }
+
+  if (iter == namespace_conns->conns.end()) {
     return error::NotFound(
         "Likely not a TCP/Unix connection (might be some other socket type). Alternatively, might "
         "be looking in the wrong net namespace, which can happen if the target PID has connections "
@@ -524,8 +543,18 @@ StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num
 
 void SocketInfoManager::Flush() {
   socket_probers_->Update();
-  connections_.clear();
+  ++flush_count_;
   num_socket_prober_calls_ = 0;
+
+  // Drop the snapshots that are older than the TTL. All of them, if there is no TTL.
+  const auto expiry_time = std::chrono::steady_clock::now() - cfg_cache_ttl_;
+  for (auto iter = connections_.begin(); iter != connections_.end();) {
+    if (iter->second.probe_time <= expiry_time) {
+      connections_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
 }
 
 }  // namespace system
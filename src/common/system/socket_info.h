@@ -20,6 +20,7 @@
 
 #include <netinet/in.h>
 
+#include <chrono>
 #include <filesystem>
 #include <map>
 #include <memory>
@@ -27,6 +28,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/fs/inode_utils.h"
 
@@ -83,6 +86,9 @@ struct SocketInfo {
   ClientServerRole role = ClientServerRole::kUnknown;
 };
 
+// Socket information, keyed by the inode number of the socket.
+using SocketInfoMap = absl::flat_hash_map<int, SocketInfo>;
+
 /**
  * The NetlinkSocketProber class uses NetLink to probe the Linux kernel about active connections.
  */
@@ -114,7 +120,7 @@ class NetlinkSocketProber {
    *
    * @return error if connection information could not be obtained from kernel.
    */
-  Status InetConnections(std::map<int, SocketInfo>* socket_info_entries,
+  Status InetConnections(SocketInfoMap* socket_info_entries,
                          int conn_states = kTCPEstablishedState);
 
   /**
@@ -126,7 +132,7 @@ class NetlinkSocketProber {
    *
    * @return error if connection information could not be obtained from kernel.
    */
-  Status UnixConnections(std::map<int, SocketInfo>* socket_info_entries,
+  Status UnixConnections(SocketInfoMap* socket_info_entries,
                          int conn_states = kTCPEstablishedState);
 
  private:
@@ -138,7 +144,7 @@ class NetlinkSocketProber {
   Status SendDiagReq(const TDiagReqType& msg_req);
 
   template <typename TDiagMsgType>
-  Status RecvDiagResp(std::map<int, SocketInfo>* socket_info_entries);
+  Status RecvDiagResp(SocketInfoMap* socket_info_entries);
 
   int fd_ = -1;
 };
@@ -251,9 +257,14 @@ class SocketProberManager {
  * network namespace, the information is gathered and then cached. Future queries will operate off
  * that snapshot of the known connections, for efficiency.
  *
- * Note that no attempt is made to check if new connections have been created after the snapshot is
- * established. This responsibility is on the user, who must explicitly call Flush(), so that new
- * connections can be discovered.
+ * Probing a namespace dumps all of its sockets, which is expensive on hosts with many connections.
+ * So the snapshot of a namespace is kept across calls to Flush(), for up to the cache TTL.
+ * Within a TTL, a query for an inode that is not in the snapshot re-probes the namespace, since
+ * the socket may have been created after the snapshot was taken. To bound the cost, this happens
+ * at most once per namespace between calls to Flush().
+ *
+ * With a TTL of zero, all snapshots are dropped on Flush(). The user must then call Flush() so
+ * that new connections can be discovered.
  */
 class SocketInfoManager {
  public:
@@ -262,20 +273,22 @@ class SocketInfoManager {
    *
    * @param proc_path Path to the /proc filesystem
    * @param conn_states The connection states to probe for (established, listening, etc.).
+   * @param cache_ttl How long the snapshot of a network namespace is kept across calls to Flush().
    * @return unique_ptr to the SocketInfoManager, or error if there were not enough privileges to
    * initialize the SocketInfoManager.
    */
   static StatusOr<std::unique_ptr<SocketInfoManager>> Create(
-      std::filesystem::path proc_path, int conn_states = kTCPEstablishedState);
+      std::filesystem::path proc_path, int conn_states = kTCPEstablishedState,
+      std::chrono::milliseconds cache_ttl = std::chrono::milliseconds::zero());
 
   /**
    * Return all socket info for a given network namespace.
    *
    * @param pid The PID used to determine the network namespace.
    * @return A map with inode number as key, and socket information as value. Returns error if
-   * information could not be queried.
+   * information could not be queried. The pointer is valid until the next call to any method.
    */
-  StatusOr<std::map<int, system::SocketInfo>*> GetNamespaceConns(uint32_t pid);
+  StatusOr<SocketInfoMap*> GetNamespaceConns(uint32_t pid);
 
   /**
    * Search for the socket info of a given inode number.
@@ -283,12 +296,13 @@ class SocketInfoManager {
    * @param pid The PID owning the connection. Used to determine the network namespace.
    * @param inode_num The inode number of the local socket.
    * @return Information for socket, including remote endpoint information. Returns error if
-   * information could not be queried.
+   * information could not be queried. The pointer is valid until the next call to any method.
    */
   StatusOr<SocketInfo*> Lookup(uint32_t pid, uint32_t inode_num);
 
   /**
    * Flushes the cache so new connections can be discovered.
+   * Snapshots that are younger than the cache TTL are kept, but may be re-probed again.
    */
   void Flush();
 
@@ -300,8 +314,24 @@ class SocketInfoManager {
   int num_socket_prober_calls() { return num_socket_prober_calls_; }
 
  private:
-  SocketInfoManager(std::filesystem::path proc_path, int conn_states)
-      : cfg_proc_path_(proc_path), cfg_conn_states_(conn_states) {}
+  SocketInfoManager(std::filesystem::path proc_path, int conn_states,
+                    std::chrono::milliseconds cache_ttl)
+      : cfg_proc_path_(proc_path), cfg_conn_states_(conn_states), cfg_cache_ttl_(cache_ttl) {}
+
+  // The snapshot of the connections of a network namespace.
+  struct NamespaceConns {
+    SocketInfoMap conns;
+    std::chrono::steady_clock::time_point probe_time;
+    // The value of flush_count_ when the namespace was last probed.
+    int64_t probe_flush_count = -1;
+  };
+
+  // Gets the snapshot of the connections of the network namespace of the PID, probing the
+  // namespace if there is none yet.
+  StatusOr<NamespaceConns*> GetOrProbeNamespaceConns(uint32_t pid, uint32_t* net_ns);
+
+  // Replaces the snapshot of the connections of a network namespace.
+  Status ProbeNamespaceConns(uint32_t net_ns, uint32_t pid, NamespaceConns* namespace_conns);
 
   const std::filesystem::path cfg_proc_path_;
 
@@ -310,9 +340,14 @@ class SocketInfoManager {
   // See connection states at the top of this file.
   const int cfg_conn_states_;
 
+  const std::chrono::milliseconds cfg_cache_ttl_;
+
   // Two-level to socket information:
   // First key is namespace inode; second key is socket inode.
-  std::map<int, std::map<int, SocketInfo>> connections_;
+  absl::flat_hash_map<uint32_t, NamespaceConns> connections_;
+
+  // Number of calls to Flush(). Used to limit re-probes to one per namespace between Flush() calls.
+  int64_t flush_count_ = 0;
 
   // Portal through which new connection information is gathered,
   // and populated into connections_.
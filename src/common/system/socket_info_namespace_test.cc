@@ -49,7 +49,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -63,7 +63,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create(container_.process_pid()));
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -75,7 +75,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -180,5 +180,42 @@ TEST_F(NetNamespaceTest, SocketInfoManager) {
   }
 }
 
+TEST_F(NetNamespaceTest, SocketInfoManagerWithCacheTTL) {
+  const std::string kProcPath = system::Config::GetInstance().proc_path();
+  const int kPID = container_.process_pid();
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SocketInfoManager> socket_info_db,
+                       SocketInfoManager::Create(kProcPath,
+                                                 kTCPEstablishedState | kTCPListeningState,
+                                                 std::chrono::hours(1)));
+
+  // See the SocketInfoManager test above.
+  uint32_t kFD = 6;
+  std::string fd_path = absl::Substitute("$0/$1/fd/$2", kProcPath, kPID, kFD);
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path fd_link, fs::ReadSymlink(fd_path));
+  ASSERT_OK_AND_ASSIGN(uint32_t inode_num,
+                       fs::ExtractInodeNum(fs::kSocketInodePrefix, fd_link.string()));
+
+  ASSERT_OK(socket_info_db->Lookup(kPID, inode_num));
+  EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+
+  socket_info_db->Flush();
+
+  // The snapshot is kept across the flush, since the TTL has not expired.
+  ASSERT_OK(socket_info_db->Lookup(kPID, inode_num));
+  EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 0);
+
+  // An unknown inode probes again, but only once until the next flush.
+  const uint32_t kUnusedInode = 3;
+  ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+  EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+  ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+  EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+
+  socket_info_db->Flush();
+  ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+  EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+}
+
 }  // namespace system
 }  // namespace px
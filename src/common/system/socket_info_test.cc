@@ -86,7 +86,7 @@ TEST(NetlinkSocketProberTest, EstablishedInetConnection) {
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoMap socket_info_entries;
   ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
 
   EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(client_endpoint)));
@@ -137,7 +137,7 @@ TEST(NetlinkSocketProberTest, EstablishedUnixConnection) {
   // Now begin the test of NetlinkSocketProber.
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoMap socket_info_entries;
   ASSERT_OK(socket_prober->UnixConnections(&socket_info_entries));
 
   EXPECT_THAT(socket_info_entries, Contains(HasLocalUnixEndpoint(client_socket_id)));
@@ -158,7 +158,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
     EXPECT_THAT(socket_info_entries, Not(Contains(HasLocalIPEndpoint(server_endpoint))));
   }
@@ -167,7 +167,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPListeningState));
     EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(server_endpoint)));
   }
@@ -176,7 +176,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(server_endpoint)));
@@ -195,7 +195,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
 
@@ -224,7 +224,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
 
@@ -250,7 +250,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoMap socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
 
     int server_socket_count = 0;
@@ -290,7 +290,7 @@ TEST(NetlinkSocketProberTest, ClosedInetConnection) {
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoMap socket_info_entries;
   ASSERT_OK(socket_prober->InetConnections(&socket_info_entries));
 
   EXPECT_THAT(socket_info_entries, Not(Contains(HasLocalIPEndpoint(client_endpoint))));
@@ -60,5 +60,97 @@ StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
   return out;
 }
 
+namespace {
+
+int WindowBits(Format format) {
+  switch (format) {
+    case Format::kGzip:
+      return MAX_WBITS + 16;
+    case Format::kZlib:
+      return MAX_WBITS;
+    case Format::kRawDeflate:
+      return -MAX_WBITS;
+  }
+  return MAX_WBITS;
+}
+
+}  // namespace
+
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_bytes,
+                                    Format format) {
+  z_stream zs = {};
+
+  if (inflateInit2(&zs, WindowBits(format)) != Z_OK) {
+    return error::Internal("inflateInit2 failed while decompressing.");
+  }
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+
+  // Decompress directly into the output, which is never larger than the limit.
+  std::string out(max_output_bytes, '\0');
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+
+  int ret = Z_OK;
+  while (ret == Z_OK && zs.avail_out > 0 && zs.avail_in > 0) {
+    ret = inflate(&zs, Z_SYNC_FLUSH);
+  }
+
+  out.resize(zs.total_out);
+
+  inflateEnd(&zs);
+
+  // Z_BUF_ERROR means no progress was possible, because the input is truncated.
+  if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+    return error::Internal("Exception during zlib decompression: $0",
+                           zs.msg != nullptr ? zs.msg : "unknown error");
+  }
+
+  return out;
+}
+
+StatusOr<std::string> Deflate(std::string_view in, Format format, int level) {
+  z_stream zs = {};
+
+  if (deflateInit2(&zs, level, Z_DEFLATED, WindowBits(format), /* memLevel */ 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return error::Internal("deflateInit2 failed while compressing.");
+  }
+
+  // The bound lets the whole input be compressed with a single call.
+  std::string out(deflateBound(&zs, in.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+
+  int ret = deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+
+  deflateEnd(&zs);
+
+  if (ret != Z_STREAM_END) {
+    return error::Internal("Exception during zlib compression: $0",
+                           zs.msg != nullptr ? zs.msg : "unknown error");
+  }
+
+  return out;
+}
+
+StatusOr<size_t> GzipDecompressedSize(std::string_view in) {
+  // The gzip header is at least 10 bytes, and the trailer is CRC32 followed by ISIZE,
+  // both 4-byte little-endian values.
+  constexpr size_t kMinGzipSize = 18;
+  if (in.size() < kMinGzipSize || static_cast<uint8_t>(in[0]) != 0x1f ||
+      static_cast<uint8_t>(in[1]) != 0x8b) {
+    return error::InvalidArgument("Not a complete gzip buffer.");
+  }
+
+  const auto* isize = reinterpret_cast<const uint8_t*>(in.data() + in.size() - 4);
+  return static_cast<size_t>(isize[0]) | (static_cast<size_t>(isize[1]) << 8) |
+         (static_cast<size_t>(isize[2]) << 16) | (static_cast<size_t>(isize[3]) << 24);
+}
+
 }  // namespace zlib
 }  // namespace px
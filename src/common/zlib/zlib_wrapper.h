@@ -35,5 +35,45 @@ namespace zlib {
  */
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size = 16384);
 
+// The container format of deflate-compressed data.
+enum class Format {
+  // RFC 1952, as used by HTTP Content-Encoding: gzip.
+  kGzip,
+  // RFC 1950, as used by HTTP Content-Encoding: deflate.
+  kZlib,
+  // RFC 1951, without any header. Some servers send this for Content-Encoding: deflate.
+  kRawDeflate,
+};
+
+/**
+ * @brief Inflates only the first max_output_bytes of the decompressed content.
+ * Decompression stops as soon as the limit is reached, so the cost is proportional to the output
+ * that is kept, rather than to the size of the input. A truncated input is not an error;
+ * the content decompressed up to the point of truncation is returned.
+ *
+ * @param in A view into the source buffer.
+ * @param max_output_bytes The maximum number of decompressed bytes to return.
+ * @param format The container format of the source buffer.
+ * @return Status or the decompressed prefix of the content.
+ */
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_bytes,
+                                    Format format = Format::kGzip);
+
+/**
+ * @brief Deflates a source buffer in a single pass.
+ *
+ * @param in A view into the source buffer.
+ * @param format The container format of the output.
+ * @param level The compression level, from 1 (fastest) to 9 (smallest).
+ * @return Status or the compressed content.
+ */
+StatusOr<std::string> Deflate(std::string_view in, Format format = Format::kGzip, int level = 1);
+
+/**
+ * @brief Returns the decompressed size recorded in the trailer of a gzip buffer.
+ * This does not decompress anything. Note that gzip records the size modulo 2^32.
+ */
+StatusOr<size_t> GzipDecompressedSize(std::string_view in);
+
 }  // namespace zlib
 }  // namespace px
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+
+#include "src/common/zlib/zlib_wrapper.h"
+
+namespace {
+
+// Produces a gzipped, JSON-like body of roughly the requested size.
+std::string GzippedBody(size_t size) {
+  std::string body = "[";
+  for (int i = 0; body.size() < size; ++i) {
+    body.append(R"({"id":)" + std::to_string(i) + R"(,"name":"item","tags":["a","b"]},)");
+  }
+  body.back() = ']';
+
+  z_stream zs = {};
+  deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  std::string out(deflateBound(&zs, body.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(body.data());
+  zs.avail_in = body.size();
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+  deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  return out;
+}
+
+// The number of decompressed bytes that the HTTP tracer keeps, plus one.
+constexpr size_t kKeptBytes = 513;
+
+}  // namespace
+
+namespace px {
+namespace zlib {
+
+// Decompresses the whole body, then truncates it; this is what the HTTP tracer used to do.
+// NOLINTNEXTLINE : runtime/references.
+void BM_InflateThenTruncate(benchmark::State& state) {
+  std::string compressed = GzippedBody(state.range(0));
+  for (auto _ : state) {
+    std::string body = Inflate(compressed).ConsumeValueOrDie();
+    body.resize(std::min(body.size(), kKeptBytes));
+    benchmark::DoNotOptimize(body);
+  }
+  state.SetBytesProcessed(state.iterations() * compressed.size());
+}
+
+// Decompresses only the part of the body that is kept.
+// NOLINTNEXTLINE : runtime/references.
+void BM_InflatePrefix(benchmark::State& state) {
+  std::string compressed = GzippedBody(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(InflatePrefix(compressed, kKeptBytes).ConsumeValueOrDie());
+  }
+  state.SetBytesProcessed(state.iterations() * compressed.size());
+}
+
+BENCHMARK(BM_InflateThenTruncate)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_InflatePrefix)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+}  // namespace zlib
+}  // namespace px
@@ -19,6 +19,7 @@
 #include "src/common/zlib/zlib_wrapper.h"
 #include <zlib.h>
 #include <string>
+#include <string_view>
 
 #include "src/common/testing/testing.h"
 
@@ -46,4 +47,80 @@ TEST_F(ZlibTest, inflate_test) {
   EXPECT_OK_AND_EQ(result, GetExpectedResult());
 }
 
+// Compresses the input with zlib, so that tests don't depend on hard-coded byte arrays.
+std::string Deflate(std::string_view in, int window_bits) {
+  z_stream zs = {};
+  EXPECT_EQ(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8,
+                         Z_DEFAULT_STRATEGY),
+            Z_OK);
+  std::string out(deflateBound(&zs, in.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+  EXPECT_EQ(deflate(&zs, Z_FINISH), Z_STREAM_END);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  return out;
+}
+
+TEST_F(ZlibTest, inflate_prefix_test) {
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 1024), GetExpectedResult());
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 4), "This");
+}
+
+TEST_F(ZlibTest, inflate_prefix_formats) {
+  const std::string content(10000, 'x');
+  // The window bits values select gzip (16+), zlib and raw deflate (negative) respectively.
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(Deflate(content, 16 + MAX_WBITS), 100,
+                                           px::zlib::Format::kGzip),
+                   content.substr(0, 100));
+  EXPECT_OK_AND_EQ(
+      px::zlib::InflatePrefix(Deflate(content, MAX_WBITS), 100, px::zlib::Format::kZlib),
+      content.substr(0, 100));
+  EXPECT_OK_AND_EQ(
+      px::zlib::InflatePrefix(Deflate(content, -MAX_WBITS), 100, px::zlib::Format::kRawDeflate),
+      content.substr(0, 100));
+}
+
+TEST_F(ZlibTest, inflate_prefix_truncated_input) {
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    content.append(std::to_string(i));
+  }
+  std::string compressed = Deflate(content, 16 + MAX_WBITS);
+  compressed.resize(compressed.size() / 2);
+
+  ASSERT_OK_AND_ASSIGN(std::string prefix, px::zlib::InflatePrefix(compressed, content.size()));
+  EXPECT_FALSE(prefix.empty());
+  EXPECT_LT(prefix.size(), content.size());
+  EXPECT_EQ(prefix, content.substr(0, prefix.size()));
+}
+
+TEST_F(ZlibTest, inflate_prefix_invalid_input) {
+  EXPECT_NOT_OK(px::zlib::InflatePrefix("not compressed data", 1024));
+}
+
+TEST_F(ZlibTest, deflate_round_trip) {
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    content.append(std::to_string(i % 10));
+  }
+  for (auto format :
+       {px::zlib::Format::kGzip, px::zlib::Format::kZlib, px::zlib::Format::kRawDeflate}) {
+    ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(content, format));
+    EXPECT_LT(compressed.size(), content.size());
+    EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(compressed, content.size(), format), content);
+  }
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(px::zlib::Deflate(content).ConsumeValueOrDie()), content);
+}
+
+TEST_F(ZlibTest, gzip_decompressed_size) {
+  EXPECT_OK_AND_EQ(px::zlib::GzipDecompressedSize(GetCompressedString()),
+                   GetExpectedResult().size());
+  EXPECT_OK_AND_EQ(px::zlib::GzipDecompressedSize(Deflate(std::string(12345, 'x'), 16 + MAX_WBITS)),
+                   12345);
+  EXPECT_NOT_OK(px::zlib::GzipDecompressedSize(Deflate("abc", MAX_WBITS)));
+}
+
 }  // namespace px
@@ -17,6 +17,8 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -28,11 +30,44 @@ PL_SUPPRESS_WARNINGS_START()
 #include "xxhash.h"
 PL_SUPPRESS_WARNINGS_END()
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace px {
 namespace bloomfilter {
 
+namespace {
+
+// The split-block layout, as used by Parquet and Impala: blocks of eight 32-bit words.
+constexpr size_t kBlockBytes = 32;
+constexpr int kBlockWords = 8;
+
+// Odd multipliers that turn the 32-bit key of an item into the bit to set in each word.
+alignas(32) constexpr uint32_t kBlockSalt[kBlockWords] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+                                                          0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+                                                          0x9efc4947U, 0x5c6bfb31U};
+
+// The number of items whose blocks ContainsMany prefetches before probing them.
+constexpr size_t kContainsBatchSize = 16;
+
+#ifdef __AVX2__
+__m256i BlockMask(uint32_t key) {
+  const __m256i salt = _mm256_load_si256(reinterpret_cast<const __m256i*>(kBlockSalt));
+  __m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), salt);
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), _mm256_srli_epi32(bits, 27));
+}
+#else
+uint32_t WordMask(uint32_t key, int word) {
+  return uint32_t{1} << ((key * kBlockSalt[word]) >> 27);
+}
+#endif
+
+}  // namespace
+
 StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64_t max_entries,
-                                                                           double error_rate) {
+                                                                           double error_rate,
+                                                                           Layout layout) {
   if (error_rate <= 0.0 || error_rate >= 1.0) {
     return error::Internal(
         "Bloom filter error rate must be greater than 0 and less than 1, received %e", error_rate);
@@ -48,10 +83,18 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64
   int64_t num_bits = static_cast<int64_t>(std::ceil(max_entries * bpe));
   int64_t num_bytes = (num_bits / 8) + ((num_bits % 8) ? 1 : 0);
 
+  if (layout == Layout::kSplitBlock) {
+    // Round up to whole blocks. Every item sets one bit in each word of its block.
+    int64_t num_blocks = (num_bytes + kBlockBytes - 1) / kBlockBytes;
+    return std::unique_ptr<XXHash64BloomFilter>(
+        new XXHash64BloomFilter(num_blocks * kBlockBytes, kBlockWords, layout));
+  }
+
   // num hashes = ln(2) * bpe
   int32_t num_hashes = static_cast<int32_t>(std::ceil(std::log(2) * bpe));
 
-  return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(num_bytes, num_hashes));
+  return std::unique_ptr<XXHash64BloomFilter>(
+      new XXHash64BloomFilter(num_bytes, num_hashes, layout));
 }
 
 StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::FromProto(
@@ -65,13 +108,36 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::FromProto(
     return error::Internal("Received 0 hash functions in BloomFilter num_hashes field");
   }
 
+  Layout layout;
+  switch (pb.layout()) {
+    case XXHash64BloomFilterPB::CLASSIC:
+      layout = Layout::kClassic;
+      break;
+    case XXHash64BloomFilterPB::SPLIT_BLOCK:
+      if (bytes_str.size() % kBlockBytes != 0) {
+        return error::Internal("Split-block BloomFilter data of $0 bytes is not whole blocks",
+                               bytes_str.size());
+      }
+      if (pb.num_hashes() != kBlockWords) {
+        return error::Internal("Split-block BloomFilter must use $0 hashes, got $1", kBlockWords,
+                               pb.num_hashes());
+      }
+      layout = Layout::kSplitBlock;
+      break;
+    default:
+      return error::Internal("Unknown BloomFilter layout $0", pb.layout());
+  }
+
   std::vector<uint8_t> data{bytes_str.begin(), bytes_str.end()};
-  return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data, pb.num_hashes()));
+  return std::unique_ptr<XXHash64BloomFilter>(
+      new XXHash64BloomFilter(data, pb.num_hashes(), layout));
 }
 
 XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() {
   XXHash64BloomFilterPB output;
   output.set_num_hashes(num_hashes_);
+  output.set_layout(layout_ == Layout::kSplitBlock ? XXHash64BloomFilterPB::SPLIT_BLOCK
+                                                   : XXHash64BloomFilterPB::CLASSIC);
   std::string bytes_str{buffer_.begin(), buffer_.end()};
   output.set_data(std::move(bytes_str));
   return output;
@@ -89,7 +155,51 @@ bool XXHash64BloomFilter::HasBitSet(int bit_number) const {
   return buffer_[byte_index] & mask;
 }
 
+size_t XXHash64BloomFilter::BlockOffset(uint64_t hash) const {
+  // The upper half of the hash picks the block, the lower half the bits within it.
+  uint64_t num_blocks = buffer_.size() / kBlockBytes;
+  return (((hash >> 32) * num_blocks) >> 32) * kBlockBytes;
+}
+
+void XXHash64BloomFilter::InsertIntoBlock(size_t offset, uint64_t hash) {
+  auto key = static_cast<uint32_t>(hash);
+#ifdef __AVX2__
+  auto* block = reinterpret_cast<__m256i*>(&buffer_[offset]);
+  _mm256_storeu_si256(block, _mm256_or_si256(_mm256_loadu_si256(block), BlockMask(key)));
+#else
+  uint32_t words[kBlockWords];
+  std::memcpy(words, &buffer_[offset], kBlockBytes);
+  for (int i = 0; i < kBlockWords; ++i) {
+    words[i] |= WordMask(key, i);
+  }
+  std::memcpy(&buffer_[offset], words, kBlockBytes);
+#endif
+}
+
+bool XXHash64BloomFilter::BlockContains(size_t offset, uint64_t hash) const {
+  auto key = static_cast<uint32_t>(hash);
+#ifdef __AVX2__
+  auto* block = reinterpret_cast<const __m256i*>(&buffer_[offset]);
+  return _mm256_testc_si256(_mm256_loadu_si256(block), BlockMask(key));
+#else
+  // Written without early exits so the compiler vectorizes the loop.
+  uint32_t words[kBlockWords];
+  std::memcpy(words, &buffer_[offset], kBlockBytes);
+  uint32_t missing = 0;
+  for (int i = 0; i < kBlockWords; ++i) {
+    missing |= ~words[i] & WordMask(key, i);
+  }
+  return missing == 0;
+#endif
+}
+
 void XXHash64BloomFilter::Insert(std::string_view item) {
+  if (layout_ == Layout::kSplitBlock) {
+    uint64_t hash = XXH64(item.data(), item.size(), seed_);
+    InsertIntoBlock(BlockOffset(hash), hash);
+    return;
+  }
+
   uint64_t a = XXH64(item.data(), item.size(), seed_);
   uint64_t b = XXH64(item.data(), item.size(), a);
 
@@ -103,6 +213,11 @@ void XXHash64BloomFilter::Insert(std::string_view item) {
 }
 
 bool XXHash64BloomFilter::Contains(std::string_view item) const {
+  if (layout_ == Layout::kSplitBlock) {
+    uint64_t hash = XXH64(item.data(), item.size(), seed_);
+    return BlockContains(BlockOffset(hash), hash);
+  }
+
   uint64_t a = XXH64(item.data(), item.size(), seed_);
   uint64_t b = XXH64(item.data(), item.size(), a);
 
@@ -116,5 +231,31 @@ bool XXHash64BloomFilter::Contains(std::string_view item) const {
   return true;
 }
 
+void XXHash64BloomFilter::ContainsMany(absl::Span<const std::string_view> items,
+                                       std::vector<bool>* contains) const {
+  contains->resize(items.size());
+  if (layout_ != Layout::kSplitBlock) {
+    for (size_t i = 0; i < items.size(); ++i) {
+      (*contains)[i] = Contains(items[i]);
+    }
+    return;
+  }
+
+  uint64_t hashes[kContainsBatchSize];
+  size_t offsets[kContainsBatchSize];
+  for (size_t start = 0; start < items.size(); start += kContainsBatchSize) {
+    size_t batch_size = std::min(kContainsBatchSize, items.size() - start);
+    for (size_t i = 0; i < batch_size; ++i) {
+      const auto& item = items[start + i];
+      hashes[i] = XXH64(item.data(), item.size(), seed_);
+      offsets[i] = BlockOffset(hashes[i]);
+      __builtin_prefetch(&buffer_[offsets[i]]);
+    }
+    for (size_t i = 0; i < batch_size; ++i) {
+      (*contains)[start + i] = BlockContains(offsets[i], hashes[i]);
+    }
+  }
+}
+
 }  // namespace bloomfilter
 }  // namespace px
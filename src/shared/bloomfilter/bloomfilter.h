@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include <absl/types/span.h>
+
 #include "src/common/base/base.h"
 #include "src/shared/bloomfilterpb/bloomfilter.pb.h"
 
@@ -33,12 +35,26 @@ using XXHash64BloomFilterPB = shared::bloomfilterpb::XXHash64BloomFilter;
 
 class XXHash64BloomFilter {
  public:
+  /**
+   * The layout of the bits of the filter.
+   *  - kClassic spreads the num_hashes bits of an item across the whole buffer, so every probe
+   *    is likely to be a cache miss.
+   *  - kSplitBlock places all bits of an item in one 32-byte block, one bit per 32-bit word.
+   *    A probe touches a single block, and the eight words are tested at once with SIMD.
+   *    The false positive rate is slightly higher than kClassic's for the same size.
+   */
+  enum class Layout {
+    kClassic,
+    kSplitBlock,
+  };
+
   /**
    * Create creates a bloom filter which is sized to meet the criteria for maximum number of
    * entries and the false positive error rate. The false negative error rate is always 0.
    */
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> Create(int64_t max_entries,
-                                                               double error_rate);
+                                                               double error_rate,
+                                                               Layout layout = Layout::kClassic);
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> FromProto(const XXHash64BloomFilterPB& pb);
   XXHash64BloomFilterPB ToProto();
 
@@ -55,6 +71,13 @@ class XXHash64BloomFilter {
   bool Contains(std::string_view item) const;
   bool Contains(const std::string& item) const { return Contains(std::string_view(item)); }
 
+  /**
+   * ContainsMany checks for the presence of each of the items, writing one result per item.
+   * For kSplitBlock filters the hashes of a batch of items are computed up front, and their
+   * blocks prefetched, so the memory accesses of the lookups overlap.
+   */
+  void ContainsMany(absl::Span<const std::string_view> items, std::vector<bool>* contains) const;
+
   /**
    * Get the buffer size in bytes of the bloom filter.
    */
@@ -65,18 +88,29 @@ class XXHash64BloomFilter {
    */
   int num_hashes() const { return num_hashes_; }
 
+  /**
+   * Get the layout of the bloom filter.
+   */
+  Layout layout() const { return layout_; }
+
  protected:
-  XXHash64BloomFilter(int64_t num_bytes, int num_hashes)
-      : XXHash64BloomFilter(std::vector<uint8_t>(num_bytes, 0), num_hashes) {}
+  XXHash64BloomFilter(int64_t num_bytes, int num_hashes, Layout layout)
+      : XXHash64BloomFilter(std::vector<uint8_t>(num_bytes, 0), num_hashes, layout) {}
 
-  XXHash64BloomFilter(const std::vector<uint8_t>& buffer, int32_t num_hashes)
-      : num_hashes_(num_hashes), buffer_(buffer) {}
+  XXHash64BloomFilter(const std::vector<uint8_t>& buffer, int32_t num_hashes, Layout layout)
+      : num_hashes_(num_hashes), layout_(layout), buffer_(buffer) {}
 
  private:
   void SetBit(int bit_number);
   bool HasBitSet(int bit_number) const;
 
+  // The split-block layout: the hash of an item selects its block, and the bit set in each word.
+  size_t BlockOffset(uint64_t hash) const;
+  void InsertIntoBlock(size_t offset, uint64_t hash);
+  bool BlockContains(size_t offset, uint64_t hash) const;
+
   const int num_hashes_;
+  const Layout layout_;
   std::vector<uint8_t> buffer_;
   const uint64_t seed_ = 3091990;
 };
@@ -18,6 +18,10 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+#include "src/common/base/test_utils.h"
 #include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
@@ -113,5 +117,93 @@ TEST(XXHash64BloomFilter, test_create_from_proto) {
   }
 }
 
+TEST(XXHash64BloomFilter, split_block_create) {
+  auto bf1 = XXHash64BloomFilter::Create(10, 0.1, XXHash64BloomFilter::Layout::kSplitBlock)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf1->layout(), XXHash64BloomFilter::Layout::kSplitBlock);
+  EXPECT_EQ(bf1->num_hashes(), 8);
+  EXPECT_EQ(bf1->buffer_size_bytes(), 32);
+
+  auto bf2 = XXHash64BloomFilter::Create(100000, 0.01, XXHash64BloomFilter::Layout::kSplitBlock)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf2->num_hashes(), 8);
+  EXPECT_EQ(bf2->buffer_size_bytes(), 119840);
+}
+
+TEST(XXHash64BloomFilter, split_block_false_positive_rate) {
+  auto bf = XXHash64BloomFilter::Create(10000, 0.01, XXHash64BloomFilter::Layout::kSplitBlock)
+                .ConsumeValueOrDie();
+  for (int i = 0; i < 10000; ++i) {
+    bf->Insert(absl::StrCat("present_", i));
+  }
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(bf->Contains(absl::StrCat("present_", i)));
+  }
+
+  int false_positives = 0;
+  for (int i = 0; i < 100000; ++i) {
+    false_positives += bf->Contains(absl::StrCat("absent_", i));
+  }
+  // Split-block filters trade a slightly higher false positive rate for faster probes.
+  EXPECT_LT(false_positives, 2 * 0.01 * 100000);
+}
+
+TEST(XXHash64BloomFilter, contains_many) {
+  for (auto layout :
+       {XXHash64BloomFilter::Layout::kClassic, XXHash64BloomFilter::Layout::kSplitBlock}) {
+    auto bf = XXHash64BloomFilter::Create(1000, 0.0001, layout).ConsumeValueOrDie();
+    std::vector<std::string> strs;
+    for (int i = 0; i < 50; ++i) {
+      strs.push_back(absl::StrCat("str_", i));
+      if (i % 2 == 0) {
+        bf->Insert(strs.back());
+      }
+    }
+    std::vector<std::string_view> items(strs.begin(), strs.end());
+
+    std::vector<bool> contains;
+    bf->ContainsMany(items, &contains);
+    ASSERT_EQ(contains.size(), items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+      EXPECT_EQ(contains[i], bf->Contains(items[i]));
+      if (i % 2 == 0) {
+        EXPECT_TRUE(contains[i]);
+      }
+    }
+  }
+}
+
+TEST(XXHash64BloomFilter, split_block_create_from_proto) {
+  std::vector<std::string> matches{"foo", "bar", "abc"};
+  std::vector<std::string> non_matches{"123", "456", "789"};
+
+  auto bf = XXHash64BloomFilter::Create(100000, 0.01, XXHash64BloomFilter::Layout::kSplitBlock)
+                .ConsumeValueOrDie();
+  for (const auto& match : matches) {
+    bf->Insert(match);
+  }
+
+  auto proto = bf->ToProto();
+  EXPECT_EQ(proto.layout(), XXHash64BloomFilterPB::SPLIT_BLOCK);
+  auto reconstructed = XXHash64BloomFilter::FromProto(proto).ConsumeValueOrDie();
+  EXPECT_EQ(reconstructed->layout(), XXHash64BloomFilter::Layout::kSplitBlock);
+  EXPECT_EQ(reconstructed->buffer_size_bytes(), bf->buffer_size_bytes());
+  for (const auto& match : matches) {
+    EXPECT_TRUE(reconstructed->Contains(match));
+  }
+  for (const auto& non_match : non_matches) {
+    EXPECT_FALSE(reconstructed->Contains(non_match));
+  }
+
+  // Filters serialized without a layout are classic filters.
+  auto classic_proto = XXHash64BloomFilter::Create(10, 0.1).ConsumeValueOrDie()->ToProto();
+  classic_proto.clear_layout();
+  auto classic = XXHash64BloomFilter::FromProto(classic_proto).ConsumeValueOrDie();
+  EXPECT_EQ(classic->layout(), XXHash64BloomFilter::Layout::kClassic);
+
+  proto.set_data("short");
+  EXPECT_NOT_OK(XXHash64BloomFilter::FromProto(proto));
+}
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package bloomfilterpb_test
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+
+	"px.dev/pixie/src/shared/bloomfilterpb"
+)
+
+// Serialized by the C++ agents: data: "1234", num_hashes: 4, layout: SPLIT_BLOCK.
+var splitBlockFilterBytes = []byte{0x0a, 0x04, 0x31, 0x32, 0x33, 0x34, 0x10, 0x04, 0x18, 0x01}
+
+func TestXXHash64BloomFilter_RoundTrip(t *testing.T) {
+	filter := &bloomfilterpb.XXHash64BloomFilter{
+		Data:      []byte("1234"),
+		NumHashes: 4,
+		Layout:    bloomfilterpb.SPLIT_BLOCK,
+	}
+
+	b, err := filter.Marshal()
+	require.NoError(t, err)
+	assert.Equal(t, splitBlockFilterBytes, b)
+
+	decoded := &bloomfilterpb.XXHash64BloomFilter{}
+	require.NoError(t, decoded.Unmarshal(b))
+	assert.Equal(t, filter, decoded)
+	assert.Equal(t, bloomfilterpb.SPLIT_BLOCK, decoded.GetLayout())
+}
+
+func TestXXHash64BloomFilter_DefaultsToClassic(t *testing.T) {
+	// Filters serialized before the layout field existed.
+	decoded := &bloomfilterpb.XXHash64BloomFilter{}
+	require.NoError(t, decoded.Unmarshal(splitBlockFilterBytes[:8]))
+	assert.Equal(t, []byte("1234"), decoded.Data)
+	assert.Equal(t, int32(4), decoded.NumHashes)
+	assert.Equal(t, bloomfilterpb.CLASSIC, decoded.GetLayout())
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace md {
+
+/**
+ * Returns true if the object is owned by more than one shared_ptr.
+ * If it returns false, the caller is the sole owner and may modify the object.
+ */
+template <typename T>
+bool IsShared(const std::shared_ptr<T>& ptr) {
+  if (ptr.use_count() > 1) {
+    return true;
+  }
+  // use_count() is a relaxed load. Pair it with the release performed when the other owners
+  // dropped their references, so that their reads of the object happen before our writes.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return false;
+}
+
+/**
+ * Returns a mutable pointer to the object, first replacing it with a private copy if it is
+ * shared with other owners. T must provide a Clone() that returns a std::unique_ptr.
+ */
+template <typename T>
+T* CopyOnWrite(std::shared_ptr<T>* ptr) {
+  if (IsShared(*ptr)) {
+    *ptr = std::shared_ptr<T>((*ptr)->Clone());
+  }
+  return ptr->get();
+}
+
+/**
+ * CopyOnWriteMap is a hash map that can be copied in constant time. It is used for the metadata
+ * state, which is copied on every update so that readers can keep an immutable snapshot.
+ *
+ * The entries are spread over a fixed number of shards, by the top bits of their hash, and the
+ * shards are shared between copies of the map. A shard is copied the first time it is modified
+ * after the map was copied, so the cost of an update is proportional to the number of shards it
+ * touches, rather than to the size of the map.
+ *
+ * The values are not copy-on-write themselves. Large values should be held by std::shared_ptr,
+ * and updated through CopyOnWrite(), so that they can be shared between copies too.
+ *
+ * A copy is not thread-safe to modify while another thread copies the same map. Copies that are
+ * not being modified can be read concurrently.
+ */
+template <typename K, typename V, typename Hash = typename absl::flat_hash_map<K, V>::hasher,
+          typename Eq = typename absl::flat_hash_map<K, V>::key_equal>
+class CopyOnWriteMap {
+ public:
+  using Shard = absl::flat_hash_map<K, V, Hash, Eq>;
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = typename Shard::value_type;
+  using size_type = size_t;
+
+  static constexpr int kNumShardBits = 6;
+  static constexpr size_t kNumShards = 1 << kNumShardBits;
+
+ private:
+  using Shards = std::array<std::shared_ptr<Shard>, kNumShards>;
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Shard::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type&;
+    using pointer = const value_type*;
+
+    reference operator*() const { return *it_; }
+    pointer operator->() const { return &*it_; }
+
+    const_iterator& operator++() {
+      ++it_;
+      if (it_ == shards_->at(shard_idx_)->end()) {
+        ++shard_idx_;
+        SeekNonEmptyShard();
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return shard_idx_ == other.shard_idx_ && (shard_idx_ == kNumShards || it_ == other.it_);
+    }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class CopyOnWriteMap;
+
+    // Points to the first entry in the shards at or after shard_idx.
+    const_iterator(const Shards* shards, size_t shard_idx)
+        : shards_(shards), shard_idx_(shard_idx) {
+      SeekNonEmptyShard();
+    }
+
+    // Points to the entry it, in the shard shard_idx.
+    const_iterator(const Shards* shards, size_t shard_idx, typename Shard::const_iterator it)
+        : shards_(shards), shard_idx_(shard_idx), it_(it) {}
+
+    void SeekNonEmptyShard() {
+      for (; shard_idx_ < kNumShards; ++shard_idx_) {
+        const auto& shard = shards_->at(shard_idx_);
+        if (shard != nullptr && !shard->empty()) {
+          it_ = shard->begin();
+          return;
+        }
+      }
+    }
+
+    const Shards* shards_;
+    size_t shard_idx_;
+    typename Shard::const_iterator it_;
+  };
+  using iterator = const_iterator;
+
+  const_iterator begin() const { return const_iterator(&shards_, 0); }
+  const_iterator end() const { return const_iterator(&shards_, kNumShards); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  template <typename Q>
+  const_iterator find(const Q& key) const {
+    size_t idx = ShardIndex(key);
+    const Shard* shard = shards_[idx].get();
+    if (shard == nullptr) {
+      return end();
+    }
+    auto it = shard->find(key);
+    if (it == shard->end()) {
+      return end();
+    }
+    return const_iterator(&shards_, idx, it);
+  }
+
+  template <typename Q>
+  bool contains(const Q& key) const {
+    return find(key) != end();
+  }
+
+  /**
+   * Returns a mutable pointer to the value of the key, or nullptr if the key is not present.
+   * The shard of the key is copied if it is shared, but only if the key is present.
+   */
+  template <typename Q>
+  V* FindMutable(const Q& key) {
+    if (!contains(key)) {
+      return nullptr;
+    }
+    return &MutableShard(ShardIndex(key))->find(key)->second;
+  }
+
+  template <typename... Args>
+  std::pair<V*, bool> try_emplace(const K& key, Args&&... args) {
+    auto [it, inserted] =
+        MutableShard(ShardIndex(key))->try_emplace(key, std::forward<Args>(args)...);
+    if (inserted) {
+      ++size_;
+    }
+    return {&it->second, inserted};
+  }
+
+  V& operator[](const K& key) { return *try_emplace(key).first; }
+
+  template <typename Q>
+  size_t erase(const Q& key) {
+    if (!contains(key)) {
+      return 0;
+    }
+    MutableShard(ShardIndex(key))->erase(key);
+    --size_;
+    return 1;
+  }
+
+  void clear() {
+    for (auto& shard : shards_) {
+      shard.reset();
+    }
+    size_ = 0;
+  }
+
+ private:
+  template <typename Q>
+  static size_t ShardIndex(const Q& key) {
+    // Use the top bits, since the hash table uses the bottom bits to place entries within the
+    // shard.
+    static_assert(sizeof(size_t) == 8);
+    return Hash{}(key) >> (64 - kNumShardBits);
+  }
+
+  Shard* MutableShard(size_t idx) {
+    std::shared_ptr<Shard>& shard = shards_[idx];
+    if (shard == nullptr) {
+      shard = std::make_shared<Shard>();
+    } else if (IsShared(shard)) {
+      shard = std::make_shared<Shard>(*shard);
+    }
+    return shard.get();
+  }
+
+  Shards shards_;
+  size_t size_ = 0;
+};
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/shared/metadata/copy_on_write_map.h"
+
+namespace px {
+namespace md {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(CopyOnWriteMapTest, Basic) {
+  CopyOnWriteMap<std::string, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+
+  map["a"] = 1;
+  EXPECT_TRUE(map.try_emplace("b", 2).second);
+  EXPECT_FALSE(map.try_emplace("b", 3).second);
+
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("a", 1), Pair("b", 2)));
+
+  ASSERT_NE(map.find(std::string_view("a")), map.end());
+  EXPECT_EQ(map.find("a")->second, 1);
+  EXPECT_EQ(map.find("c"), map.end());
+  EXPECT_EQ(map.FindMutable("c"), nullptr);
+
+  *map.FindMutable("a") = 10;
+  EXPECT_EQ(map.erase("b"), 1);
+  EXPECT_EQ(map.erase("b"), 0);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("a", 10)));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(CopyOnWriteMapTest, CopiesAreIndependent) {
+  CopyOnWriteMap<int, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = i;
+  }
+
+  CopyOnWriteMap<int, int> copy = map;
+  copy[0] = -1;
+  copy.erase(1);
+  copy[1000] = 1000;
+  map[2] = -2;
+
+  EXPECT_EQ(map.size(), 1000);
+  EXPECT_EQ(map.find(0)->second, 0);
+  EXPECT_EQ(map.find(1)->second, 1);
+  EXPECT_EQ(map.find(2)->second, -2);
+  EXPECT_FALSE(map.contains(1000));
+
+  EXPECT_EQ(copy.size(), 1000);
+  EXPECT_EQ(copy.find(0)->second, -1);
+  EXPECT_FALSE(copy.contains(1));
+  EXPECT_EQ(copy.find(2)->second, 2);
+  EXPECT_EQ(copy.find(1000)->second, 1000);
+
+  int count = 0;
+  for (const auto& [k, v] : copy) {
+    EXPECT_EQ(copy.find(k)->second, v);
+    ++count;
+  }
+  EXPECT_EQ(count, 1000);
+}
+
+struct Obj {
+  int val;
+  std::unique_ptr<Obj> Clone() const { return std::make_unique<Obj>(*this); }
+};
+
+TEST(CopyOnWriteMapTest, CopyOnWriteValues) {
+  CopyOnWriteMap<int, std::shared_ptr<Obj>> map;
+  map[0] = std::make_shared<Obj>(Obj{0});
+  map[1] = std::make_shared<Obj>(Obj{1});
+
+  CopyOnWriteMap<int, std::shared_ptr<Obj>> copy = map;
+  CopyOnWrite(copy.FindMutable(0))->val = 10;
+
+  // The updated object is copied, and the others are still shared.
+  EXPECT_EQ(map.find(0)->second->val, 0);
+  EXPECT_EQ(copy.find(0)->second->val, 10);
+  EXPECT_EQ(map.find(1)->second.get(), copy.find(1)->second.get());
+
+  // Once the object is no longer shared, it is updated in place.
+  Obj* obj = copy.find(0)->second.get();
+  CopyOnWrite(copy.FindMutable(0))->val = 20;
+  EXPECT_EQ(copy.find(0)->second.get(), obj);
+  EXPECT_EQ(obj->val, 20);
+}
+
+}  // namespace md
+}  // namespace px
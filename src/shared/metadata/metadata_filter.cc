@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -26,8 +27,9 @@ namespace px {
 namespace md {
 
 StatusOr<std::unique_ptr<AgentMetadataFilter>> AgentMetadataFilter::Create(
-    int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& entity_types) {
-  return AgentMetadataFilterImpl::Create(max_entries, error_rate, entity_types);
+    int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& entity_types,
+    XXHash64BloomFilter::Layout layout) {
+  return AgentMetadataFilterImpl::Create(max_entries, error_rate, entity_types, layout);
 }
 
 StatusOr<std::unique_ptr<AgentMetadataFilter>> AgentMetadataFilter::FromProto(
@@ -62,6 +64,19 @@ bool AgentMetadataFilter::ContainsEntity(MetadataType key, std::string_view valu
   return Contains(ToEntityKeyPair(key, value));
 }
 
+bool AgentMetadataFilter::ContainsAnyEntity(MetadataType key,
+                                            const std::vector<std::string_view>& values) const {
+  if (!metadata_types_.contains(key)) {
+    return false;
+  }
+  std::vector<std::string> entities;
+  entities.reserve(values.size());
+  for (const auto& value : values) {
+    entities.push_back(ToEntityKeyPair(key, value));
+  }
+  return ContainsAny(std::vector<std::string_view>(entities.begin(), entities.end()));
+}
+
 MetadataInfo AgentMetadataFilter::ToProto() {
   auto output = ToProtoImpl();
   for (const auto& type : metadata_types_) {
@@ -76,6 +91,12 @@ bool AgentMetadataFilterImpl::Contains(std::string_view val) const {
   return bloomfilter_->Contains(val);
 }
 
+bool AgentMetadataFilterImpl::ContainsAny(const std::vector<std::string_view>& vals) const {
+  std::vector<bool> contains;
+  bloomfilter_->ContainsMany(vals, &contains);
+  return std::find(contains.begin(), contains.end(), true) != contains.end();
+}
+
 MetadataInfo AgentMetadataFilterImpl::ToProtoImpl() const {
   MetadataInfo output;
   *(output.mutable_xxhash64_bloom_filter()) = bloomfilter_->ToProto();
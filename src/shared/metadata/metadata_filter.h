@@ -55,10 +55,14 @@ class AgentMetadataFilter {
    * positive rate.
    * @param error_rate The false positive rate for this filter.
    * @param entity_types The types of entities that are stored in this filter.
+   * @param layout The layout of the bloom filter backing this filter. Planners older than the
+   * split-block layout read every filter as classic, so it should only be used once they have
+   * been upgraded.
    */
   static StatusOr<std::unique_ptr<AgentMetadataFilter>> Create(
       int64_t max_entries, double error_rate,
-      const absl::flat_hash_set<MetadataType>& entity_types);
+      const absl::flat_hash_set<MetadataType>& entity_types,
+      XXHash64BloomFilter::Layout layout = XXHash64BloomFilter::Layout::kClassic);
   static StatusOr<std::unique_ptr<AgentMetadataFilter>> FromProto(const MetadataInfo& proto);
   MetadataInfo ToProto();
   virtual ~AgentMetadataFilter() = default;
@@ -79,6 +83,11 @@ class AgentMetadataFilter {
    */
   bool ContainsEntity(MetadataType key, std::string_view value) const;
 
+  /**
+   * Check whether the filter contains any of the values for a particular key.
+   */
+  bool ContainsAnyEntity(MetadataType key, const std::vector<std::string_view>& values) const;
+
   /**
    * Get the registered metadata keys that are stored in this filter.
    */
@@ -89,6 +98,7 @@ class AgentMetadataFilter {
  protected:
   virtual void Insert(std::string_view value) = 0;
   virtual bool Contains(std::string_view value) const = 0;
+  virtual bool ContainsAny(const std::vector<std::string_view>& values) const = 0;
 
   /**
    * Creates an proto, excluding the metadata_fields field which is taken care of by the
@@ -107,8 +117,9 @@ class AgentMetadataFilter {
 class AgentMetadataFilterImpl : public AgentMetadataFilter {
  public:
   static StatusOr<std::unique_ptr<AgentMetadataFilter>> Create(
-      int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& types) {
-    PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::Create(max_entries, error_rate));
+      int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& types,
+      XXHash64BloomFilter::Layout layout = XXHash64BloomFilter::Layout::kClassic) {
+    PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::Create(max_entries, error_rate, layout));
     return std::unique_ptr<AgentMetadataFilter>(new AgentMetadataFilterImpl(std::move(bf), types));
   }
 
@@ -117,6 +128,7 @@ class AgentMetadataFilterImpl : public AgentMetadataFilter {
  protected:
   void Insert(std::string_view entity) override;
   bool Contains(std::string_view entity) const override;
+  bool ContainsAny(const std::vector<std::string_view>& entities) const override;
   MetadataInfo ToProtoImpl() const override;
 
  private:
@@ -58,5 +58,24 @@ TEST(AgentMetadataFilter, test_proto) {
   EXPECT_FALSE(deserialized->ContainsEntity(MetadataType::POD_NAME, "bar"));
 }
 
+TEST(AgentMetadataFilter, test_split_block) {
+  auto filter =
+      AgentMetadataFilter::Create(100, 0.01, {MetadataType::POD_NAME, MetadataType::CONTAINER_ID},
+                                  XXHash64BloomFilter::Layout::kSplitBlock)
+          .ConsumeValueOrDie();
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_TRUE(filter->ContainsAnyEntity(MetadataType::POD_NAME, {"bar", "foo"}));
+  EXPECT_FALSE(filter->ContainsAnyEntity(MetadataType::POD_NAME, {"bar", "baz"}));
+  EXPECT_FALSE(filter->ContainsAnyEntity(MetadataType::CONTAINER_ID, {"foo"}));
+  EXPECT_FALSE(filter->ContainsAnyEntity(MetadataType::SERVICE_NAME, {"foo"}));
+
+  auto serialized = filter->ToProto();
+  EXPECT_EQ(serialized.xxhash64_bloom_filter().layout(),
+            bloomfilter::XXHash64BloomFilterPB::SPLIT_BLOCK);
+  auto deserialized = AgentMetadataFilter::FromProto(serialized).ConsumeValueOrDie();
+  EXPECT_TRUE(deserialized->ContainsEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_FALSE(deserialized->ContainsEntity(MetadataType::POD_NAME, "bar"));
+}
+
 }  // namespace md
 }  // namespace px
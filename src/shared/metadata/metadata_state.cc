@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_set.h>
 
@@ -42,6 +43,21 @@ const K8sMetadataObject* K8sMetadataState::K8sMetadataObjectByID(UIDView id,
   return it->second.get();
 }
 
+template <typename T>
+T* K8sMetadataState::MutableK8sMetadataObjectByID(UIDView id, K8sObjectType type) {
+  K8sMetadataObjectSPtr* obj = k8s_objects_by_id_.FindMutable(id);
+
+  if (obj == nullptr) {
+    return nullptr;
+  }
+
+  if ((*obj)->type() != type) {
+    return nullptr;
+  }
+
+  return static_cast<T*>(CopyOnWrite(obj));
+}
+
 const PodInfo* K8sMetadataState::PodInfoByID(UIDView pod_id) const {
   auto type = K8sObjectType::kPod;
   return static_cast<const PodInfo*>(K8sMetadataObjectByID(pod_id, type));
@@ -67,6 +83,16 @@ const ContainerInfo* K8sMetadataState::ContainerInfoByID(CIDView id) const {
   return it->second.get();
 }
 
+ContainerInfo* K8sMetadataState::MutableContainerInfoByID(CIDView id) {
+  ContainerInfoSPtr* cinfo = containers_by_id_.FindMutable(id);
+
+  if (cinfo == nullptr) {
+    return nullptr;
+  }
+
+  return CopyOnWrite(cinfo);
+}
+
 UID K8sMetadataState::PodIDByName(K8sNameIdentView pod_name) const {
   auto it = pods_by_name_.find(pod_name);
   return (it == pods_by_name_.end()) ? "" : it->second;
@@ -103,16 +129,10 @@ std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
   other->pod_cidrs_ = pod_cidrs_;
   other->service_cidr_ = service_cidr_;
 
-  other->k8s_objects_by_id_.reserve(k8s_objects_by_id_.size());
-  for (const auto& [k, v] : k8s_objects_by_id_) {
-    other->k8s_objects_by_id_[k] = v->Clone();
-  }
-
-  other->containers_by_id_.reserve(containers_by_id_.size());
-  for (const auto& [k, v] : containers_by_id_) {
-    other->containers_by_id_[k] = v->Clone();
-  }
-
+  // The maps are copy-on-write, so these copies share all the entries and objects with this
+  // state. They are only copied when either state is updated.
+  other->k8s_objects_by_id_ = k8s_objects_by_id_;
+  other->containers_by_id_ = containers_by_id_;
   other->pods_by_name_ = pods_by_name_;
   other->services_by_name_ = services_by_name_;
   other->namespaces_by_name_ = namespaces_by_name_;
@@ -159,13 +179,15 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(object_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto pod = std::make_unique<PodInfo>(update);
+  if (!k8s_objects_by_id_.contains(object_uid)) {
+    auto pod = std::make_shared<PodInfo>(update);
     VLOG(1) << "Adding Pod: " << pod->DebugString();
-    it = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
+    k8s_objects_by_id_.try_emplace(object_uid, std::move(pod));
+  }
+  auto pod_info = MutableK8sMetadataObjectByID<PodInfo>(object_uid, K8sObjectType::kPod);
+  if (pod_info == nullptr) {
+    return error::Internal("Object $0 for pod $1/$2 is not a pod", object_uid, ns, name);
   }
-  auto pod_info = static_cast<PodInfo*>(it->second.get());
 
   // We always just add to the container set even if the container is stopped.
   // We expect all cleanup to happen periodically to allow stale objects to be queried for some
@@ -174,7 +196,8 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   // state might be periodically inconsistent.
 
   for (const auto& cid : update.container_ids()) {
-    if (containers_by_id_.find(cid) == containers_by_id_.end()) {
+    const ContainerInfo* container_info = ContainerInfoByID(cid);
+    if (container_info == nullptr) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
@@ -183,7 +206,11 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     }
 
     pod_info->AddContainer(cid);
-    containers_by_id_[cid]->set_pod_id(object_uid);
+    // Only copy the container if its pod changed, since pod updates are sent for every change
+    // to the pod.
+    if (container_info->pod_id() != object_uid) {
+      MutableContainerInfoByID(cid)->set_pod_id(object_uid);
+    }
   }
 
   pod_info->set_start_time_ns(update.start_timestamp_ns());
@@ -208,15 +235,14 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
 Status K8sMetadataState::HandleContainerUpdate(const ContainerUpdate& update) {
   const CID& cid = update.cid();
 
-  auto it = containers_by_id_.find(cid);
-  if (it == containers_by_id_.end()) {
-    auto container = std::make_unique<ContainerInfo>(update);
+  if (!containers_by_id_.contains(cid)) {
+    auto container = std::make_shared<ContainerInfo>(update);
     VLOG(1) << "Adding Container: " << container->DebugString();
-    it = containers_by_id_.try_emplace(cid, std::move(container)).first;
+    containers_by_id_.try_emplace(cid, std::move(container));
   }
   VLOG(1) << "container update: " << update.name();
 
-  auto* container_info = it->second.get();
+  auto* container_info = MutableContainerInfoByID(cid);
   container_info->set_stop_time_ns(update.stop_timestamp_ns());
   container_info->set_state(ConvertToContainerState(update.container_state()));
   container_info->set_state_message(update.message());
@@ -232,26 +258,34 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(service_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto service = std::make_unique<ServiceInfo>(service_uid, ns, name);
+  if (!k8s_objects_by_id_.contains(service_uid)) {
+    auto service = std::make_shared<ServiceInfo>(service_uid, ns, name);
     VLOG(1) << "Adding Service: " << service->DebugString();
-    it = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
+    k8s_objects_by_id_.try_emplace(service_uid, std::move(service));
+  }
+  auto service_info =
+      MutableK8sMetadataObjectByID<ServiceInfo>(service_uid, K8sObjectType::kService);
+  if (service_info == nullptr) {
+    return error::Internal("Object $0 for service $1/$2 is not a service", service_uid, ns, name);
   }
-  auto service_info = static_cast<ServiceInfo*>(it->second.get());
 
   for (const auto& uid : update.pod_ids()) {
-    if (k8s_objects_by_id_.find(uid) == k8s_objects_by_id_.end()) {
+    if (!k8s_objects_by_id_.contains(uid)) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
       LOG(INFO) << absl::Substitute("Didn't find pod UID $0 for service $1/$2", uid, ns, name);
       continue;
     }
-    ECHECK(k8s_objects_by_id_[uid]->type() == K8sObjectType::kPod);
     // We add the service uid to the pod. Lifetime of service still handled by the service object.
-    PodInfo* pod_info = static_cast<PodInfo*>(k8s_objects_by_id_[uid].get());
-    pod_info->AddService(service_uid);
+    // Only copy the pod if it does not already have the service, since service updates
+    // are sent for every change to the service.
+    const PodInfo* pod_info = PodInfoByID(uid);
+    ECHECK(pod_info != nullptr);
+    if (pod_info == nullptr || pod_info->services().contains(service_uid)) {
+      continue;
+    }
+    MutableK8sMetadataObjectByID<PodInfo>(uid, K8sObjectType::kPod)->AddService(service_uid);
   }
   if (update.start_timestamp_ns() != 0) {
     service_info->set_start_time_ns(update.start_timestamp_ns());
@@ -279,13 +313,16 @@ Status K8sMetadataState::HandleNamespaceUpdate(const NamespaceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.name();
 
-  auto it = k8s_objects_by_id_.find(namespace_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto ns_obj = std::make_unique<NamespaceInfo>(namespace_uid, ns, name);
+  if (!k8s_objects_by_id_.contains(namespace_uid)) {
+    auto ns_obj = std::make_shared<NamespaceInfo>(namespace_uid, ns, name);
     VLOG(1) << "Adding Namespace: " << ns_obj->DebugString();
-    it = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
+    k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj));
+  }
+  auto ns_info =
+      MutableK8sMetadataObjectByID<NamespaceInfo>(namespace_uid, K8sObjectType::kNamespace);
+  if (ns_info == nullptr) {
+    return error::Internal("Object $0 for namespace $1 is not a namespace", namespace_uid, name);
   }
-  auto ns_info = static_cast<NamespaceInfo*>(it->second.get());
 
   ns_info->set_start_time_ns(update.start_timestamp_ns());
   ns_info->set_stop_time_ns(update.stop_timestamp_ns());
@@ -310,11 +347,10 @@ bool IsExpired(const T& obj, int64_t retention_time, int64_t now) {
 Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
   int64_t now = CurrentTimeNS();
 
-  for (auto iter = k8s_objects_by_id_.begin(); iter != k8s_objects_by_id_.end();) {
-    const auto& k8s_object = iter->second;
-
+  // The maps do not support erasing while iterating, so the expired objects are erased after.
+  std::vector<UID> expired_object_ids;
+  for (const auto& [uid, k8s_object] : k8s_objects_by_id_) {
     if (!IsExpired(*k8s_object, retention_time_ns, now)) {
-      ++iter;
       continue;
     }
 
@@ -322,25 +358,25 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
       case K8sObjectType::kPod:
         if (PodIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          pods_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          pods_by_name_.erase(K8sNameIdentView(k8s_object->ns(), k8s_object->name()));
         }
-        if (PodIDByIP(static_cast<PodInfo*>(k8s_object.get())->pod_ip()) ==
+        if (PodIDByIP(static_cast<const PodInfo*>(k8s_object.get())->pod_ip()) ==
             k8s_object
                 ->uid()) {  // There could be a new pod assigned to the podIP now, we should only
                             // delete the IP from the map if it belongs to the terminated pod.
-          pods_by_ip_.erase(static_cast<PodInfo*>(k8s_object.get())->pod_ip());
+          pods_by_ip_.erase(static_cast<const PodInfo*>(k8s_object.get())->pod_ip());
         }
         break;
       case K8sObjectType::kNamespace:
         if (NamespaceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          namespaces_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          namespaces_by_name_.erase(K8sNameIdentView(k8s_object->ns(), k8s_object->name()));
         }
         break;
       case K8sObjectType::kService:
         if (ServiceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          services_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          services_by_name_.erase(K8sNameIdentView(k8s_object->ns(), k8s_object->name()));
         }
         break;
       default:
@@ -348,19 +384,23 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
                                         static_cast<int>(k8s_object->type()));
     }
 
-    k8s_objects_by_id_.erase(iter++);
+    expired_object_ids.push_back(uid);
+  }
+  for (const auto& uid : expired_object_ids) {
+    k8s_objects_by_id_.erase(uid);
   }
 
-  for (auto iter = containers_by_id_.begin(); iter != containers_by_id_.end();) {
-    const auto& cinfo = iter->second;
-
+  std::vector<CID> expired_container_ids;
+  for (const auto& [cid, cinfo] : containers_by_id_) {
     if (!IsExpired(*cinfo, retention_time_ns, now)) {
-      ++iter;
       continue;
     }
 
     containers_by_name_.erase(cinfo->name());
-    containers_by_id_.erase(iter++);
+    expired_container_ids.push_back(cid);
+  }
+  for (const auto& cid : expired_container_ids) {
+    containers_by_id_.erase(cid);
   }
 
   return Status::OK();
@@ -370,12 +410,11 @@ std::shared_ptr<AgentMetadataState> AgentMetadataState::CloneToShared() const {
   auto state = std::make_shared<AgentMetadataState>(hostname_, asid_, agent_id_, pod_name_);
   state->last_update_ts_ns_ = last_update_ts_ns_;
   state->epoch_id_ = epoch_id_;
+  state->content_version_ = content_version_;
   state->asid_ = asid_;
   state->k8s_metadata_state_ = k8s_metadata_state_->Clone();
-  state->pids_by_upid_.reserve(pids_by_upid_.size());
-  for (const auto& [k, v] : pids_by_upid_) {
-    state->pids_by_upid_[k] = v->Clone();
-  }
+  // Shares the PIDInfo objects, see CopyOnWriteMap.
+  state->pids_by_upid_ = pids_by_upid_;
   state->upids_ = upids_;
   return state;
 }
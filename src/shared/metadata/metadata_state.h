@@ -28,6 +28,7 @@
 
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/copy_on_write_map.h"
 #include "src/shared/metadata/k8s_objects.h"
 #include "src/shared/metadata/pids.h"
 #include "src/shared/upid/upid.h"
@@ -35,13 +36,19 @@
 namespace px {
 namespace md {
 
-using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
-using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
-using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+// The objects are shared between copies of the metadata state, and are copied before they are
+// modified if they are shared (see CopyOnWrite()).
+using K8sMetadataObjectSPtr = std::shared_ptr<K8sMetadataObject>;
+using ContainerInfoSPtr = std::shared_ptr<ContainerInfo>;
+using PIDInfoSPtr = std::shared_ptr<PIDInfo>;
+using PIDInfoMap = CopyOnWriteMap<UPID, PIDInfoSPtr>;
 using AgentID = sole::uuid;
 
 /**
  * This class contains all kubernetes relate metadata.
+ *
+ * All the maps are copy-on-write, so Clone() is cheap, and the clone shares everything with the
+ * original until either of them is updated.
  */
 class K8sMetadataState : NotCopyable {
  public:
@@ -91,14 +98,16 @@ class K8sMetadataState : NotCopyable {
     };
   };
   using K8sEntityByNameMap =
-      absl::flat_hash_map<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
+      CopyOnWriteMap<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
 
   using PodsByNameMap = K8sEntityByNameMap;
   using ServicesByNameMap = K8sEntityByNameMap;
   using NamespacesByNameMap = K8sEntityByNameMap;
-  using ContainersByNameMap = absl::flat_hash_map<std::string, CID>;
-  using PodsByPodIpMap = absl::flat_hash_map<std::string, UID>;
-  using ServicesByServiceIpMap = absl::flat_hash_map<std::string, UID>;
+  using ContainersByNameMap = CopyOnWriteMap<std::string, CID>;
+  using PodsByPodIpMap = CopyOnWriteMap<std::string, UID>;
+  using ServicesByServiceIpMap = CopyOnWriteMap<std::string, UID>;
+  using K8sObjectsByIDMap = CopyOnWriteMap<UID, K8sMetadataObjectSPtr>;
+  using ContainersByIDMap = CopyOnWriteMap<CID, ContainerInfoSPtr>;
 
   void set_service_cidr(CIDRBlock cidr) {
     if (!service_cidr_.has_value() || service_cidr_.value() != cidr) {
@@ -150,6 +159,15 @@ class K8sMetadataState : NotCopyable {
    */
   const ContainerInfo* ContainerInfoByID(CIDView id) const;
 
+  /**
+   * MutableContainerInfoByID returns the container info by ID, for updating it.
+   * If the container info is shared with other copies of the state, it is first copied,
+   * so the update is not visible to them.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* MutableContainerInfoByID(CIDView id);
+
   /**
    * ContainerIDByName returns the ContainerID for the container of the given name.
    * @param container_name the container name
@@ -196,12 +214,16 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  const ContainersByIDMap& containers_by_id() const { return containers_by_id_; }
   std::string DebugString(int indent_level = 0) const;
 
  private:
   const K8sMetadataObject* K8sMetadataObjectByID(UIDView id, K8sObjectType type) const;
 
+  // Returns the object for updating it, copying it first if it is shared.
+  template <typename T>
+  T* MutableK8sMetadataObjectByID(UIDView id, K8sObjectType type);
+
   // The CIDR block used for services inside the cluster.
   std::optional<CIDRBlock> service_cidr_;
 
@@ -209,10 +231,10 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  K8sObjectsByIDMap k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  ContainersByIDMap containers_by_id_;
 
   /**
    * Mapping of pods by name.
@@ -271,13 +293,22 @@ class AgentMetadataState : NotCopyable {
   uint64_t epoch_id() const { return epoch_id_; }
   void set_epoch_id(uint64_t id) { epoch_id_ = id; }
 
+  // Unlike the epoch, only changes when the metadata does, so results computed from the metadata
+  // can be reused for as long as it stays the same.
+  uint64_t content_version() const { return content_version_; }
+  void MarkContentChanged() { ++content_version_; }
+
   // Returns an un-owned pointer to the underlying k8s state.
   K8sMetadataState* k8s_metadata_state() { return k8s_metadata_state_.get(); }
   const K8sMetadataState& k8s_metadata_state() const { return *k8s_metadata_state_; }
 
+  /**
+   * Returns a copy of the state. The copy shares all the metadata objects with this state,
+   * until either of them is updated.
+   */
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
-  PIDInfo* GetPIDByUPID(UPID upid) const {
+  const PIDInfo* GetPIDByUPID(UPID upid) const {
     auto it = pids_by_upid_.find(upid);
     if (it != pids_by_upid_.end()) {
       return it->second.get();
@@ -291,19 +322,21 @@ class AgentMetadataState : NotCopyable {
 
     pids_by_upid_[upid] = std::move(pid_info);
     upids_.insert(upid);
+    MarkContentChanged();
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
+    PIDInfoSPtr* pid_info = pids_by_upid_.FindMutable(upid);
     if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
+      CopyOnWrite(pid_info)->set_stop_time_ns(ts);
       upids_.erase(upid);
+      MarkContentChanged();
     } else {
       DCHECK(!upids_.contains(upid));
     }
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const PIDInfoMap& pids_by_upid() const { return pids_by_upid_; }
 
   const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
 
@@ -323,6 +356,10 @@ class AgentMetadataState : NotCopyable {
    */
   uint64_t epoch_id_ = 0;
 
+  // Incremented on every change to the metadata. Copied by CloneToShared(), so it never repeats
+  // across the states of an agent.
+  uint64_t content_version_ = 0;
+
   std::string hostname_;
   std::string pod_name_;
   uint32_t asid_;
@@ -333,7 +370,7 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  PIDInfoMap pids_by_upid_;
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
@@ -169,6 +169,77 @@ TEST(K8sMetadataStateTest, CloneCopiedCIDR) {
   EXPECT_EQ(service_cidr.prefix_length, state_copy->service_cidr()->prefix_length);
 }
 
+TEST(K8sMetadataStateTest, CloneSharesUnchangedObjects) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update));
+  K8sMetadataState::PodUpdate pod0_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod0_update));
+  K8sMetadataState::PodUpdate pod1_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod1UpdatePbTxt, &pod1_update));
+
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+  EXPECT_OK(state.HandlePodUpdate(pod0_update));
+  EXPECT_OK(state.HandlePodUpdate(pod1_update));
+
+  auto state_copy = state.Clone();
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_EQ(state.PodInfoByID("pod1_uid"), state_copy->PodInfoByID("pod1_uid"));
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+
+  // Updating the copy should copy only the updated pod, and leave the original untouched.
+  pod1_update.set_stop_timestamp_ns(1000);
+  EXPECT_OK(state_copy->HandlePodUpdate(pod1_update));
+
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_NE(state.PodInfoByID("pod1_uid"), state_copy->PodInfoByID("pod1_uid"));
+  EXPECT_EQ(1000, state_copy->PodInfoByID("pod1_uid")->stop_time_ns());
+  EXPECT_NE(1000, state.PodInfoByID("pod1_uid")->stop_time_ns());
+  // The pod of the container did not change, so it is still shared.
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+}
+
+TEST(AgentMetadataStateTest, CloneSharesUnchangedPIDs) {
+  AgentMetadataState state(/* asid */ 1);
+  UPID upid0(1, 100, 1000);
+  UPID upid1(1, 101, 1000);
+  state.AddUPID(upid0, std::make_unique<PIDInfo>(upid0, "cmd0", "container0_uid"));
+  state.AddUPID(upid1, std::make_unique<PIDInfo>(upid1, "cmd1", "container0_uid"));
+
+  auto state_copy = state.CloneToShared();
+  state_copy->MarkUPIDAsStopped(upid1, 2000);
+
+  EXPECT_EQ(state.GetPIDByUPID(upid0), state_copy->GetPIDByUPID(upid0));
+  EXPECT_EQ(0, state.GetPIDByUPID(upid1)->stop_time_ns());
+  EXPECT_EQ(2000, state_copy->GetPIDByUPID(upid1)->stop_time_ns());
+  EXPECT_THAT(state.upids(), UnorderedElementsAre(upid0, upid1));
+  EXPECT_THAT(state_copy->upids(), UnorderedElementsAre(upid0));
+}
+
+TEST(AgentMetadataStateTest, ContentVersionOnlyChangesWithContent) {
+  AgentMetadataState state(/* asid */ 1);
+  UPID upid0(1, 100, 1000);
+  state.AddUPID(upid0, std::make_unique<PIDInfo>(upid0, "cmd0", "container0_uid"));
+  uint64_t version = state.content_version();
+
+  // A new epoch of the same metadata keeps the version.
+  auto state_copy = state.CloneToShared();
+  state_copy->set_epoch_id(state.epoch_id() + 1);
+  EXPECT_EQ(version, state_copy->content_version());
+
+  state_copy->MarkUPIDAsStopped(upid0, 2000);
+  EXPECT_GT(state_copy->content_version(), version);
+  EXPECT_EQ(version, state.content_version());
+
+  // Stopping an unknown UPID is not a change.
+  version = state_copy->content_version();
+  state_copy->MarkUPIDAsStopped(UPID(1, 101, 1000), 2000);
+  EXPECT_EQ(version, state_copy->content_version());
+}
+
 TEST(K8sMetadataStateTest, HandleContainerUpdate) {
   K8sMetadataState state;
 
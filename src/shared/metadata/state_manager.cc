@@ -99,10 +99,12 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
     absl::base_internal::SpinLockHolder lock(&cidr_lock_);
     if (service_cidr_.has_value()) {
       shadow_state->k8s_metadata_state()->set_service_cidr(std::move(service_cidr_.value()));
+      shadow_state->MarkContentChanged();
       service_cidr_.reset();
     }
     if (pod_cidrs_.has_value()) {
       shadow_state->k8s_metadata_state()->set_pod_cidrs(std::move(pod_cidrs_.value()));
+      shadow_state->MarkContentChanged();
       pod_cidrs_.reset();
     }
   }
@@ -136,6 +138,7 @@ Status ApplyK8sUpdates(
 
   // Returns false when no more items.
   while (updates->try_dequeue(update)) {
+    state->MarkContentChanged();
     switch (update->update_case()) {
       case ResourceUpdate::kPodUpdate:
         PL_RETURN_IF_ERROR(HandlePodUpdate(update->pod_update(), state, metadata_filter));
@@ -170,29 +173,34 @@ StatusOr<UPID> InitUPID(const system::ProcParser& proc_parser, uint32_t asid, ui
 
 void ProcessContainerPIDUpdates(
     CIDView cid, int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
-    absl::flat_hash_set<UPID>* upids, absl::flat_hash_set<uint32_t>* cgroups_pids,
+    absl::flat_hash_set<uint32_t>* cgroups_pids,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
+  K8sMetadataState* k8s_md_state = md->k8s_metadata_state();
+
   // Iterate through old list of UPIDs, looking for PIDs which have been deleted.
-  auto upids_iter = upids->begin();
-  while (upids_iter != upids->end()) {
-    const auto& prev_upid = *upids_iter;
+  std::vector<UPID> deleted_upids;
+  for (const auto& prev_upid : k8s_md_state->ContainerInfoByID(cid)->active_upids()) {
+    // If we are already tracking this PID, consume it, so cgroups_pids contains only new PIDs at
+    // the end of this loop.
+    if (cgroups_pids->erase(prev_upid.pid()) == 0) {
+      deleted_upids.push_back(prev_upid);
+    }
+  }
 
-    auto cgroups_pids_iter = cgroups_pids->find(prev_upid.pid());
-    if (cgroups_pids_iter == cgroups_pids->end()) {
-      // Deleted PID.
-      md->MarkUPIDAsStopped(prev_upid, ts);
+  if (deleted_upids.empty() && cgroups_pids->empty()) {
+    // Leave the container untouched, so it stays shared with the previous metadata state.
+    return;
+  }
+  absl::flat_hash_set<UPID>* upids =
+      k8s_md_state->MutableContainerInfoByID(cid)->mutable_active_upids();
 
-      // Push deletion events to the queue.
-      pid_updates->enqueue(std::make_unique<PIDTerminatedEvent>(prev_upid, ts));
+  for (const auto& prev_upid : deleted_upids) {
+    md->MarkUPIDAsStopped(prev_upid, ts);
 
-      upids->erase(upids_iter++);
-      continue;
-    }
+    // Push deletion events to the queue.
+    pid_updates->enqueue(std::make_unique<PIDTerminatedEvent>(prev_upid, ts));
 
-    // We are already tracking this PID.
-    // Consume it so cgroups_pids contains only new PIDs at the end of this loop.
-    cgroups_pids->erase(cgroups_pids_iter);
-    ++upids_iter;
+    upids->erase(prev_upid);
   }
 
   // Any PIDs left-over in groups_pids are new.
@@ -221,9 +229,18 @@ Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     CGroupMetadataReader* md_reader,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
-  const auto& k8s_md_state = md->k8s_metadata_state();
+  K8sMetadataState* k8s_md_state = md->k8s_metadata_state();
 
+  // Containers are copied when they are updated below, so collect their IDs up front, rather
+  // than updating them while iterating over them.
+  std::vector<CID> cids;
+  cids.reserve(k8s_md_state->containers_by_id().size());
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
+    cids.push_back(cid);
+  }
+
+  for (const CID& cid : cids) {
+    const ContainerInfo* cinfo = k8s_md_state->ContainerInfoByID(cid);
     if (cinfo->stop_time_ns() != 0) {
       // Ignore dead containers.
       // TODO(zasgar): Come up with a cleaner way of doing this. Probably by using active/inactive
@@ -249,7 +266,8 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->MutableContainerInfoByID(cid)->set_stop_time_ns(pod_info->stop_time_ns());
+      md->MarkContentChanged();
       continue;
     }
 
@@ -267,17 +285,18 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        ContainerInfo* mutable_cinfo = k8s_md_state->MutableContainerInfoByID(cid);
+        mutable_cinfo->set_stop_time_ns(ts);
+        md->MarkContentChanged();
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
-                               &cgroups_active_pids, pid_updates);
+    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, &cgroups_active_pids, pid_updates);
   }
 
   return Status::OK();
@@ -285,6 +304,8 @@ Status ProcessPIDUpdates(
 
 Status DeleteMetadataForDeadObjects(AgentMetadataState* state, int64_t retention_time) {
   PL_RETURN_IF_ERROR(state->k8s_metadata_state()->CleanupExpiredMetadata(retention_time));
+  // Conservatively, since this only runs every kEpochsBetweenObjectDeletion epochs.
+  state->MarkContentChanged();
   return Status::OK();
 }
 
@@ -194,8 +194,15 @@ TEST_F(AgentMetadataStateTest, initialize_md_state) {
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
   GenerateTestUpdateEvents(&updates);
 
+  uint64_t content_version = metadata_state_.content_version();
   EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
   EXPECT_EQ(0, updates.size_approx());
+  EXPECT_GT(metadata_state_.content_version(), content_version);
+
+  // No updates, no change.
+  content_version = metadata_state_.content_version();
+  EXPECT_OK(ApplyK8sUpdates(3000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+  EXPECT_EQ(content_version, metadata_state_.content_version());
 
   EXPECT_EQ("myhost", metadata_state_.hostname());
   EXPECT_EQ("mypod", metadata_state_.pod_name());
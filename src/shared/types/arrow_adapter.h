@@ -131,12 +131,49 @@ inline int64_t GetArrowArrayBytes(const arrow::Array* arr) {
 
 template <>
 inline int64_t GetArrowArrayBytes<types::DataType::STRING>(const arrow::Array* arr) {
-  int64_t total_bytes = 0;
-  // Loop through each string in the Arrow array.
-  for (int64_t i = 0; i < arr->length(); i++) {
-    total_bytes += sizeof(char) * GetValueFromArrowArray<types::DataType::STRING>(arr, i).length();
+  if (arr->length() == 0) {
+    return 0;
   }
-  return total_bytes;
+  // The strings are stored back to back, so the offsets give the total without reading them.
+  auto str_arr = static_cast<const arrow::StringArray*>(arr);
+  return sizeof(char) * (str_arr->value_offset(arr->length()) - str_arr->value_offset(0));
+}
+
+/**
+ * Appends the values of the array at the given indexes to the builder, in that order.
+ * The builder must be of the type that matches TDataType.
+ */
+template <types::DataType TDataType>
+inline Status AppendArrowArrayIndexes(const arrow::Array* arr, const std::vector<size_t>& indexes,
+                                      arrow::ArrayBuilder* builder) {
+  using arrow_builder_type = typename types::DataTypeTraits<TDataType>::arrow_builder_type;
+  auto typed_builder = static_cast<arrow_builder_type*>(builder);
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(indexes.size()));
+  for (size_t idx : indexes) {
+    typed_builder->UnsafeAppend(GetValueFromArrowArray<TDataType>(arr, idx));
+  }
+  return Status::OK();
+}
+
+// Specialization of the above for strings, which copies the bytes without making std::strings.
+template <>
+inline Status AppendArrowArrayIndexes<types::DataType::STRING>(const arrow::Array* arr,
+                                                               const std::vector<size_t>& indexes,
+                                                               arrow::ArrayBuilder* builder) {
+  auto str_arr = static_cast<const arrow::StringArray*>(arr);
+  auto typed_builder = static_cast<arrow::StringBuilder*>(builder);
+  int64_t total_size = 0;
+  for (size_t idx : indexes) {
+    total_size += str_arr->value_length(idx);
+  }
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(indexes.size()));
+  PL_RETURN_IF_ERROR(typed_builder->ReserveData(total_size));
+  for (size_t idx : indexes) {
+    int32_t length;
+    const uint8_t* value = str_arr->GetValue(idx, &length);
+    typed_builder->UnsafeAppend(value, length);
+  }
+  return Status::OK();
 }
 
 template <types::DataType T>
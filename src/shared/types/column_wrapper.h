@@ -92,6 +92,24 @@ class ColumnWrapper {
   // CopyIndexes leaves the original untouched, while MoveIndexes destroys the moved indexes.
   virtual SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const = 0;
   virtual SharedColumnWrapper MoveIndexes(const std::vector<size_t>& indexes) = 0;
+
+  /**
+   * Returns the ColumnWrapperTmpl that holds the values of this column. An arrow-backed column
+   * is converted into one on the first call, which is slow.
+   */
+  virtual ColumnWrapper* Materialize() { return this; }
+
+  /**
+   * Returns the ColumnWrapperTmpl that holds the values of this column, or nullptr if the values
+   * are only held in an arrow array, see arrow_array().
+   */
+  virtual const ColumnWrapper* Materialized() const { return this; }
+
+  /**
+   * Returns the arrow array that holds the values of this column, if it is arrow-backed and has
+   * not been materialized. Returns nullptr otherwise.
+   */
+  virtual const arrow::Array* arrow_array() const { return nullptr; }
 };
 
 /**
@@ -182,6 +200,63 @@ inline int64_t ColumnWrapperTmpl<StringValue>::Bytes() const {
   return bytes;
 }
 
+/**
+ * ArrowColumnWrapper holds a column that is already in arrow format, so that ConvertToArrow()
+ * hands it over without copying. Stirling produces its records in this form, for the table store.
+ *
+ * Const accessors read straight from the arrow array, and never convert it. Mutable access
+ * (e.g. the non-const Get()) first converts the column into a ColumnWrapperTmpl through
+ * Materialize(), which is slow, and is meant for tests and debugging tools. UnsafeRawData() is
+ * only valid once the column has been materialized.
+ */
+class ArrowColumnWrapper : public ColumnWrapper {
+ public:
+  // The data type cannot always be inferred from the array, since TIME64NS is stored as INT64.
+  ArrowColumnWrapper(DataType data_type, std::shared_ptr<arrow::Array> array)
+      : data_type_(data_type), array_(std::move(array)) {}
+
+  ~ArrowColumnWrapper() override = default;
+
+  BaseValueType* UnsafeRawData() override {
+    DCHECK(values_ != nullptr) << "Materialize() the column before accessing its raw data.";
+    return values_ != nullptr ? values_->UnsafeRawData() : nullptr;
+  }
+  const BaseValueType* UnsafeRawData() const override {
+    DCHECK(values_ != nullptr) << "Materialize() the column before accessing its raw data.";
+    return values_ != nullptr ? values_->UnsafeRawData() : nullptr;
+  }
+  DataType data_type() const override { return data_type_; }
+
+  size_t Size() const override {
+    return values_ != nullptr ? values_->Size() : static_cast<size_t>(array_->length());
+  }
+  bool Empty() const override { return Size() == 0; }
+  int64_t Bytes() const override;
+
+  void Reserve(size_t size) override { Materialize()->Reserve(size); }
+  void Clear() override { Materialize()->Clear(); }
+  void ShrinkToFit() override { Materialize()->ShrinkToFit(); }
+
+  std::shared_ptr<arrow::Array> ConvertToArrow(arrow::MemoryPool* mem_pool) override {
+    return values_ != nullptr ? values_->ConvertToArrow(mem_pool) : array_;
+  }
+
+  SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const override;
+  SharedColumnWrapper MoveIndexes(const std::vector<size_t>& indexes) override {
+    return CopyIndexes(indexes);
+  }
+
+  ColumnWrapper* Materialize() override;
+  const ColumnWrapper* Materialized() const override { return values_.get(); }
+  const arrow::Array* arrow_array() const override { return array_.get(); }
+
+ private:
+  DataType data_type_;
+  // Exactly one of these is set.
+  std::shared_ptr<arrow::Array> array_;
+  SharedColumnWrapper values_;
+};
+
 // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
 using BoolValueColumnWrapper = ColumnWrapperTmpl<BoolValue>;
 using Int64ValueColumnWrapper = ColumnWrapperTmpl<Int64Value>;
@@ -293,37 +368,42 @@ inline void ColumnWrapper::Append(TValueType val) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
       << "Expect " << ToString(data_type()) << " got "
       << ToString(ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(Materialize())->Append(val);
 }
 
 template <class TValueType>
 inline TValueType& ColumnWrapper::Get(size_t idx) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  return static_cast<ColumnWrapperTmpl<TValueType>*>(this)->operator[](idx);
+  return static_cast<ColumnWrapperTmpl<TValueType>*>(Materialize())->operator[](idx);
 }
 
 template <class TValueType>
 inline TValueType ColumnWrapper::Get(size_t idx) const {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  return static_cast<const ColumnWrapperTmpl<TValueType>*>(this)->operator[](idx);
+  return GetNoTypeCheck<TValueType>(idx);
 }
 
 template <class TValueType>
 inline void ColumnWrapper::AppendNoTypeCheck(TValueType val) {
   DCHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(Materialize())->Append(val);
 }
 
 template <class TValueType>
 inline TValueType& ColumnWrapper::GetNoTypeCheck(size_t idx) {
   DCHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  return static_cast<ColumnWrapperTmpl<TValueType>*>(this)->operator[](idx);
+  return static_cast<ColumnWrapperTmpl<TValueType>*>(Materialize())->operator[](idx);
 }
 
 template <class TValueType>
 inline TValueType ColumnWrapper::GetNoTypeCheck(size_t idx) const {
   DCHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  return static_cast<ColumnWrapperTmpl<TValueType>*>(this)->operator[](idx);
+  const ColumnWrapper* values = Materialized();
+  if (values == nullptr) {
+    return TValueType(
+        GetValueFromArrowArray<ValueTypeTraits<TValueType>::data_type>(arrow_array(), idx));
+  }
+  return static_cast<const ColumnWrapperTmpl<TValueType>*>(values)->operator[](idx);
 }
 
 template <class TValueType>
@@ -331,7 +411,7 @@ inline void ColumnWrapper::AppendFromVector(const std::vector<TValueType>& val)
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
       << "Expect " << ToString(data_type()) << " got "
       << ToString(ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->AppendFromVector(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(Materialize())->AppendFromVector(val);
 }
 
 template <DataType DT>
@@ -368,10 +448,52 @@ struct ColumnWrapperType<DataType::STRING> {
 };
 
 template <types::DataType DT>
-void ExtractValueToColumnWrapper(ColumnWrapper* wrapper, arrow::Array* arr, int64_t row_idx) {
+void ExtractValueToColumnWrapper(ColumnWrapper* wrapper, const arrow::Array* arr,
+                                 int64_t row_idx) {
   static_cast<typename ColumnWrapperType<DT>::type*>(wrapper)->Append(
       types::GetValueFromArrowArray<DT>(arr, row_idx));
 }
 
+inline ColumnWrapper* ArrowColumnWrapper::Materialize() {
+  if (values_ == nullptr) {
+    int64_t size = array_->length();
+    values_ = Make(data_type_, 0);
+    values_->Reserve(size);
+#define TYPE_CASE(_dt_)                                              \
+  for (int64_t i = 0; i < size; ++i) {                               \
+    ExtractValueToColumnWrapper<_dt_>(values_.get(), array_.get(), i); \
+  }
+    PL_SWITCH_FOREACH_DATATYPE(data_type_, TYPE_CASE);
+#undef TYPE_CASE
+    array_.reset();
+  }
+  return values_.get();
+}
+
+inline int64_t ArrowColumnWrapper::Bytes() const {
+  if (values_ != nullptr) {
+    return values_->Bytes();
+  }
+#define TYPE_CASE(_dt_) return GetArrowArrayBytes<_dt_>(array_.get());
+  PL_SWITCH_FOREACH_DATATYPE(data_type_, TYPE_CASE);
+#undef TYPE_CASE
+  return 0;
+}
+
+inline SharedColumnWrapper ArrowColumnWrapper::CopyIndexes(
+    const std::vector<size_t>& indexes) const {
+  if (values_ != nullptr) {
+    return values_->CopyIndexes(indexes);
+  }
+  auto builder = MakeArrowBuilder(data_type_, arrow::default_memory_pool());
+#define TYPE_CASE(_dt_) \
+  PL_CHECK_OK(AppendArrowArrayIndexes<_dt_>(array_.get(), indexes, builder.get()));
+  PL_SWITCH_FOREACH_DATATYPE(data_type_, TYPE_CASE);
+#undef TYPE_CASE
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder->Finish(&arr));
+  return std::make_shared<ArrowColumnWrapper>(data_type_, std::move(arr));
+}
+
 }  // namespace types
 }  // namespace px
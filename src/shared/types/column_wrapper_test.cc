@@ -283,5 +283,81 @@ TEST(ColumnWrapperTest, MoveIndexes) {
   }
 }
 
+TEST(ArrowColumnWrapperTest, ConvertToArrowIsZeroCopy) {
+  arrow::Int64Builder builder;
+  PL_CHECK_OK(builder.Append(1));
+  PL_CHECK_OK(builder.Append(2));
+  PL_CHECK_OK(builder.Append(3));
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder.Finish(&arr));
+
+  // TIME64NS columns are stored as INT64 arrays.
+  auto wrapper = std::make_shared<ArrowColumnWrapper>(DataType::TIME64NS, arr);
+  EXPECT_EQ(DataType::TIME64NS, wrapper->data_type());
+  EXPECT_EQ(3, wrapper->Size());
+  EXPECT_EQ(3 * sizeof(int64_t), wrapper->Bytes());
+
+  // Const access reads from the array, without converting it.
+  const ColumnWrapper& const_wrapper = *wrapper;
+  EXPECT_EQ(2, const_wrapper.Get<Time64NSValue>(1));
+  EXPECT_EQ(nullptr, wrapper->Materialized());
+  EXPECT_EQ(arr.get(), wrapper->arrow_array());
+  EXPECT_EQ(arr, wrapper->ConvertToArrow(arrow::default_memory_pool()));
+}
+
+TEST(ArrowColumnWrapperTest, MutableAccess) {
+  arrow::StringBuilder builder;
+  PL_CHECK_OK(builder.Append("abc"));
+  PL_CHECK_OK(builder.Append("de"));
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder.Finish(&arr));
+
+  auto wrapper = std::make_shared<ArrowColumnWrapper>(DataType::STRING, arr);
+  EXPECT_EQ(5, wrapper->Bytes());
+  EXPECT_EQ("de", wrapper->Get<StringValue>(1));
+
+  wrapper->Get<StringValue>(1) = "fgh";
+  wrapper->Append<StringValue>("ij");
+  EXPECT_NE(nullptr, wrapper->Materialized());
+  EXPECT_EQ(nullptr, wrapper->arrow_array());
+  ASSERT_EQ(3, wrapper->Size());
+  EXPECT_EQ(8, wrapper->Bytes());
+
+  arrow::StringBuilder expected_builder;
+  PL_CHECK_OK(expected_builder.Append("abc"));
+  PL_CHECK_OK(expected_builder.Append("fgh"));
+  PL_CHECK_OK(expected_builder.Append("ij"));
+
+  std::shared_ptr<arrow::Array> expected_arr;
+  PL_CHECK_OK(expected_builder.Finish(&expected_arr));
+  EXPECT_TRUE(wrapper->ConvertToArrow(arrow::default_memory_pool())->Equals(expected_arr));
+}
+
+TEST(ArrowColumnWrapperTest, CopyIndexes) {
+  arrow::StringBuilder builder;
+  PL_CHECK_OK(builder.Append("a"));
+  PL_CHECK_OK(builder.Append("bc"));
+  PL_CHECK_OK(builder.Append("def"));
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder.Finish(&arr));
+
+  auto wrapper = std::make_shared<ArrowColumnWrapper>(DataType::STRING, arr);
+  auto new_col = wrapper->CopyIndexes({2, 0, 2});
+  ASSERT_EQ(3, new_col->Size());
+  EXPECT_EQ(DataType::STRING, new_col->data_type());
+  EXPECT_EQ(7, new_col->Bytes());
+
+  const ColumnWrapper& const_col = *new_col;
+  EXPECT_EQ("def", const_col.Get<StringValue>(0));
+  EXPECT_EQ("a", const_col.Get<StringValue>(1));
+  EXPECT_EQ("def", const_col.Get<StringValue>(2));
+
+  // The source is untouched.
+  EXPECT_EQ(arr, wrapper->ConvertToArrow(arrow::default_memory_pool()));
+}
+
 }  // namespace types
 }  // namespace px
@@ -76,7 +76,11 @@ Status StirlingWrapperCallback(uint64_t table_id, TabletID /* tablet_id */,
   auto iter = g_table_info_map.find(table_id);
   CHECK(iter != g_table_info_map.end());
   const InfoClass& table_info = iter->second;
-  CHECK_EQ(table_info.schema().name(), "stack_traces.beta");
+  // The profiler also publishes stack_trace_dictionary.beta, which is only populated
+  // with --stirling_profiler_intern_stack_traces.
+  if (table_info.schema().name() != "stack_traces.beta") {
+    return Status::OK();
+  }
 
   auto& upid_col = (*record_batch)[px::stirling::kStackTraceUPIDIdx];
   auto& stack_trace_str_col = (*record_batch)[px::stirling::kStackTraceStackTraceStrIdx];
@@ -57,7 +57,7 @@ class ConnectorContext {
   /**
    * Return detailed information on UPIDs.
    */
-  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const = 0;
+  virtual const md::PIDInfoMap& GetPIDInfoMap() const = 0;
 
   /**
    * Return K8s information (Pod and container information)
@@ -95,7 +95,7 @@ class AgentContext : public ConnectorContext {
     return agent_metadata_state_->upids();
   }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
+  const md::PIDInfoMap& GetPIDInfoMap() const override {
     return agent_metadata_state_->pids_by_upid();
   }
 
@@ -114,10 +114,11 @@ class AgentContext : public ConnectorContext {
  */
 class StandaloneContext : public ConnectorContext {
  public:
-  StandaloneContext() {
-    // The context consists of all PIDs, but no pods/containers.
-    upids_ = ListUPIDs(system::Config::GetInstance().proc_path(), 0);
+  // The context consists of all PIDs, but no pods/containers.
+  StandaloneContext()
+      : StandaloneContext(ListUPIDs(system::Config::GetInstance().proc_path(), 0)) {}
 
+  explicit StandaloneContext(absl::flat_hash_set<md::UPID> upids) : upids_(std::move(upids)) {
     // Cannot be empty, otherwise stirling will wait indefinitely. Since StandaloneContext is used
     // for local environment, set it such that localhost (127.0.0.1) will be treated as outside of
     // cluster, and --treat_loopback_as_in_cluster in conn_tracker.cc will take effect.
@@ -129,8 +130,8 @@ class StandaloneContext : public ConnectorContext {
 
   const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return upids_; }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
-    static const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr> kEmpty;
+  const md::PIDInfoMap& GetPIDInfoMap() const override {
+    static const md::PIDInfoMap kEmpty;
     return kEmpty;
   }
 
@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,38 +36,92 @@ using types::DataType;
 
 DataTable::DataTable(uint64_t id, const DataTableSchema& schema) : id_(id), table_schema_(schema) {}
 
-void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
-  DCHECK(record_batch_ptr != nullptr);
-  DCHECK(record_batch_ptr->empty());
+void DataTable::InitBuffers(std::vector<std::unique_ptr<arrow::ArrayBuilder>>* columns) {
+  DCHECK(columns != nullptr);
+  DCHECK(columns->empty());
 
   for (const auto& element : table_schema_.elements()) {
-    px::types::DataType type = element.type();
-
-#define TYPE_CASE(_dt_)                           \
-  auto col = types::ColumnWrapper::Make(_dt_, 0); \
-  col->Reserve(kTargetCapacity);                  \
-  record_batch_ptr->push_back(col);
-    PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
-#undef TYPE_CASE
+    auto builder = types::MakeArrowBuilder(element.type(), arrow::default_memory_pool());
+    PL_CHECK_OK(builder->Reserve(kTargetCapacity));
+    columns->push_back(std::move(builder));
   }
 }
 
 Tablet* DataTable::GetTablet(types::TabletIDView tablet_id) {
   auto& tablet = tablets_[tablet_id];
-  if (tablet.records.empty()) {
-    InitBuffers(&tablet.records);
+  if (tablet.columns.empty()) {
+    InitBuffers(&tablet.columns);
   }
   return &tablet;
 }
 
+namespace {
+
+// Returns the records at the given indexes, in that order. The records of a column are split
+// across chunks, and index 0 refers to the first record of the first chunk.
+// Indexes that form an increasing range within a single chunk are sliced out of it, without
+// copying.
+std::shared_ptr<arrow::Array> TakeRecords(DataType type,
+                                          const std::vector<std::shared_ptr<arrow::Array>>& chunks,
+                                          const std::vector<size_t>& indexes) {
+  DCHECK(!indexes.empty());
+
+  if (indexes.back() - indexes.front() + 1 == indexes.size() &&
+      std::is_sorted(indexes.begin(), indexes.end())) {
+    size_t chunk_begin = 0;
+    for (const auto& chunk : chunks) {
+      size_t chunk_end = chunk_begin + chunk->length();
+      if (indexes.front() >= chunk_begin && indexes.back() < chunk_end) {
+        if (indexes.size() == static_cast<size_t>(chunk->length())) {
+          return chunk;
+        }
+        return chunk->Slice(indexes.front() - chunk_begin, indexes.size());
+      }
+      chunk_begin = chunk_end;
+    }
+  }
+
+  auto builder = types::MakeArrowBuilder(type, arrow::default_memory_pool());
+  PL_CHECK_OK(builder->Reserve(indexes.size()));
+
+  // Copy the records over in segments of consecutive indexes that fall into the same chunk.
+  std::vector<size_t> chunk_begins;
+  size_t chunk_begin = 0;
+  for (const auto& chunk : chunks) {
+    chunk_begins.push_back(chunk_begin);
+    chunk_begin += chunk->length();
+  }
+  std::vector<size_t> segment;
+  for (size_t i = 0; i < indexes.size();) {
+    size_t c = std::upper_bound(chunk_begins.begin(), chunk_begins.end(), indexes[i]) -
+               chunk_begins.begin() - 1;
+    size_t begin = chunk_begins[c];
+    size_t end = begin + chunks[c]->length();
+    segment.clear();
+    for (; i < indexes.size() && indexes[i] >= begin && indexes[i] < end; ++i) {
+      segment.push_back(indexes[i] - begin);
+    }
+#define TYPE_CASE(_dt_) \
+  PL_CHECK_OK(types::AppendArrowArrayIndexes<_dt_>(chunks[c].get(), segment, builder.get()));
+    PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder->Finish(&arr));
+  return arr;
+}
+
+}  // namespace
+
 std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
   std::vector<TaggedRecordBatch> tablets_out;
   absl::flat_hash_map<types::TabletID, Tablet> carryover_tablets;
   uint64_t next_start_time = start_time_;
 
   for (auto& [tablet_id, tablet] : tablets_) {
-    // Sort based on times.
-    std::vector<size_t> sort_indexes = utils::SortedIndexes(tablet.times);
+    // Sort based on times, by merging the sorted runs.
+    std::vector<size_t> sort_indexes = utils::MergeSortedRuns(tablet.times, tablet.run_starts);
 
     // End time is cutoff time + 1, so call to SplitSortedVector() produces the following
     // classification: which classified according to:
@@ -91,36 +146,56 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
         "time=$3].",
         num_expired, table_schema_.name(), end_time, tablet.times[sort_indexes[0]]);
 
-    // Case 2: Pushable records. Copy to output.
+    // Finish the builders, after the records carried over from the previous round.
+    // From here on, the records are only read, to be pushed or carried over.
+    std::vector<std::vector<std::shared_ptr<arrow::Array>>> chunks(tablet.columns.size());
+    for (size_t i = 0; i < tablet.columns.size(); ++i) {
+      if (!tablet.carryover.empty()) {
+        chunks[i].push_back(std::move(tablet.carryover[i]));
+      }
+      std::shared_ptr<arrow::Array> arr;
+      PL_CHECK_OK(tablet.columns[i]->Finish(&arr));
+      chunks[i].push_back(std::move(arr));
+    }
+
+    // Case 2: Pushable records. Copy to output, unless they are already in order.
     if (num_pushable > 0) {
       // TODO(oazizi): Consider VectorView to avoid copying.
       std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
                                        sort_indexes.end() - num_carryover);
       types::ColumnWrapperRecordBatch pushable_records;
-      for (auto& col : tablet.records) {
-        pushable_records.push_back(col->MoveIndexes(push_indexes));
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        DataType type = table_schema_.elements()[i].type();
+        pushable_records.push_back(std::make_shared<types::ArrowColumnWrapper>(
+            type, TakeRecords(type, chunks[i], push_indexes)));
       }
       uint64_t last_time = tablet.times[push_indexes.back()];
       next_start_time = std::max(next_start_time, last_time);
       tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
     }
 
-    // Case 3: Carryover records.
+    // Case 3: Carryover records. These are usually the newest records, which are sliced out of
+    // the arrays in place.
     if (num_carryover > 0) {
       // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> carryover_indexes(sort_indexes.begin() + num_pushable,
+      std::vector<size_t> carryover_indexes(sort_indexes.end() - num_carryover,
                                             sort_indexes.end());
-      types::ColumnWrapperRecordBatch carryover_records;
-      for (auto& col : tablet.records) {
-        carryover_records.push_back(col->MoveIndexes(carryover_indexes));
+      Tablet& carryover_tablet = carryover_tablets[tablet_id];
+      carryover_tablet.tablet_id = tablet_id;
+      // The carried over records are in time order, so they form a single run.
+      carryover_tablet.times.reserve(kTargetCapacity);
+      for (size_t idx : carryover_indexes) {
+        carryover_tablet.times.push_back(tablet.times[idx]);
       }
-
-      std::vector<uint64_t> times(carryover_indexes.size());
-      for (size_t i = 0; i < times.size(); ++i) {
-        times[i] = tablet.times[carryover_indexes[i]];
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        carryover_tablet.carryover.push_back(
+            TakeRecords(table_schema_.elements()[i].type(), chunks[i], carryover_indexes));
+      }
+      // The builders were reset by Finish(), so they are reused for the next round.
+      carryover_tablet.columns = std::move(tablet.columns);
+      for (auto& builder : carryover_tablet.columns) {
+        PL_CHECK_OK(builder->Reserve(kTargetCapacity));
       }
-      carryover_tablets[tablet_id] =
-          Tablet{tablet_id, std::move(times), std::move(carryover_records)};
     }
   }
   tablets_ = std::move(carryover_tablets);
@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include <arrow/builder.h>
 #include <absl/container/flat_hash_map.h>
 
 #include "src/common/base/base.h"
@@ -43,9 +44,28 @@ struct TaggedRecordBatch {
 
 struct Tablet {
   types::TabletID tablet_id;
-  // TODO(oazizi): Convert this vector into a heap of {time, index} objects.
+
+  // The time of each record: first the carried over records, then those in the builders.
   std::vector<uint64_t> times;
-  types::ColumnWrapperRecordBatch records;
+
+  // The index at which each sorted run of times begins, after the first run.
+  // Connectors mostly produce records in time order, so there are few runs, and often just one.
+  std::vector<size_t> run_starts;
+
+  // The records carried over from the previous ConsumeRecords(), one array per column.
+  // They stay where they are until they are pushed, instead of being copied back into builders.
+  std::vector<std::shared_ptr<arrow::Array>> carryover;
+
+  // One builder per column. Records are built directly in arrow format, so that the table store
+  // can take them over without converting them.
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> columns;
+
+  void AddTime(uint64_t time) {
+    if (!times.empty() && time < times.back()) {
+      run_starts.push_back(times.size());
+    }
+    times.push_back(time);
+  }
 };
 
 class DataTable : public NotCopyable {
@@ -92,9 +112,7 @@ class DataTable : public NotCopyable {
   size_t Occupancy() const {
     size_t occupancy = 0;
     for (auto& [tablet_id, tablet] : tablets_) {
-      if (!tablet.records.empty()) {
-        occupancy += tablet.records[0]->Size();
-      }
+      occupancy += tablet.times.size();
     }
     return occupancy;
   }
@@ -165,7 +183,7 @@ class DataTable : public NotCopyable {
         }
       }
 
-      tablet_.records[TIndex]->Append(std::move(val));
+      AppendValue(tablet_.columns[TIndex].get(), val);
       DCHECK(!signature_[TIndex]) << absl::Substitute(
           "Attempt to Append() to column $0 (name=$1) multiple times", TIndex,
           schema->ColName(TIndex));
@@ -190,8 +208,8 @@ class DataTable : public NotCopyable {
 
    private:
     void Init(uint64_t time) {
-      DCHECK_EQ(schema->elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      DCHECK_EQ(schema->elements().size(), tablet_.columns.size());
+      tablet_.AddTime(time);
     }
 
     Tablet& tablet_;
@@ -230,7 +248,10 @@ class DataTable : public NotCopyable {
         }
       }
 
-      tablet_.records[col_index]->Append(std::move(val));
+      CHECK_EQ(schema_.elements()[col_index].type(), types::ValueTypeTraits<TValueType>::data_type)
+          << absl::Substitute("Type mismatch on column $0 (name=$1)", col_index,
+                              schema_.ColName(col_index));
+      AppendValue(tablet_.columns[col_index].get(), val);
 
       DCHECK(!signature_[col_index])
           << absl::Substitute("Attempt to Append() to column $0 (name=$1) multiple times",
@@ -246,8 +267,8 @@ class DataTable : public NotCopyable {
 
    private:
     void Init(uint64_t time) {
-      DCHECK_EQ(schema_.elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      DCHECK_EQ(schema_.elements().size(), tablet_.columns.size());
+      tablet_.AddTime(time);
       LOG_IF(DFATAL, schema_.elements().size() > kMaxSupportedColumns) << absl::Substitute(
           "Tables with more than $0 columns are not supported.", kMaxSupportedColumns);
     }
@@ -268,8 +289,20 @@ class DataTable : public NotCopyable {
   // Unique ID set by InfoClassManager.
   const uint64_t id_;
 
-  // Initialize a new Active record batch.
-  void InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr);
+  // Initialize the column builders of a new Tablet.
+  void InitBuffers(std::vector<std::unique_ptr<arrow::ArrayBuilder>>* columns);
+
+  // Appends the value to the arrow builder of its column.
+  template <typename TValueType>
+  static void AppendValue(arrow::ArrayBuilder* builder, const TValueType& val) {
+    auto typed_builder =
+        static_cast<typename types::ValueTypeTraits<TValueType>::arrow_builder_type*>(builder);
+    if constexpr (std::is_same_v<TValueType, types::StringValue>) {
+      PL_CHECK_OK(typed_builder->Append(val));
+    } else {
+      PL_CHECK_OK(typed_builder->Append(val.val));
+    }
+  }
 
   // Get a pointer to the Tablet, for appending. Used by RecordBuilder.
   Tablet* GetTablet(types::TabletIDView tablet_id);
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/stirling/core/data_table.h"
+
+using px::stirling::DataElement;
+using px::stirling::DataTable;
+using px::stirling::DataTableSchema;
+using px::types::DataType;
+using px::types::PatternType;
+using px::types::SemanticType;
+
+namespace {
+
+constexpr DataElement kElements[] = {
+    {"time_", "time", DataType::TIME64NS, SemanticType::ST_NONE, PatternType::METRIC_COUNTER},
+    {"x", "an int value", DataType::INT64, SemanticType::ST_NONE, PatternType::GENERAL},
+    {"s", "a string", DataType::STRING, SemanticType::ST_NONE, PatternType::GENERAL},
+};
+constexpr auto kSchema = DataTableSchema("bm_table", "A table for benchmarking", kElements);
+
+// Returns the times of the records of one round, as interleaved from num_sources sources that are
+// each in time order, the way connections are traced. A value of 0 shuffles the times instead.
+std::vector<uint64_t> RecordTimes(int num_records, int num_sources) {
+  std::vector<uint64_t> times(num_records);
+  for (int i = 0; i < num_records; ++i) {
+    times[i] = i;
+  }
+
+  std::default_random_engine rng(37);
+  if (num_sources == 0) {
+    std::shuffle(times.begin(), times.end(), rng);
+    return times;
+  }
+
+  // Deal out the times to the sources, and then pick the next record from a random source.
+  std::vector<std::vector<uint64_t>> sources(num_sources);
+  for (int i = 0; i < num_records; ++i) {
+    sources[i % num_sources].push_back(times[i]);
+  }
+  std::vector<size_t> next(num_sources, 0);
+  std::uniform_int_distribution<int> source_dist(0, num_sources - 1);
+  for (int i = 0; i < num_records;) {
+    int s = source_dist(rng);
+    if (next[s] < sources[s].size()) {
+      times[i++] = sources[s][next[s]++];
+    }
+  }
+  return times;
+}
+
+}  // namespace
+
+// Appends a round of records, and consumes them, holding back the newest 10% as carryover.
+// Args: number of records per round, and number of sorted sources (0 for random order).
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ConsumeRecords(benchmark::State& state) {
+  int num_records = state.range(0);
+  int num_sources = state.range(1);
+  std::vector<uint64_t> round_times = RecordTimes(num_records, num_sources);
+  std::string str_val(32, 'x');
+
+  DataTable data_table(/*id*/ 0, kSchema);
+  uint64_t start_time = 0;
+  for (auto _ : state) {
+    for (uint64_t t : round_times) {
+      DataTable::RecordBuilder<&kSchema> r(&data_table, start_time + t);
+      r.Append<r.ColIndex("time_")>(start_time + t);
+      r.Append<r.ColIndex("x")>(t);
+      r.Append<r.ColIndex("s")>(str_val);
+    }
+    start_time += num_records;
+    data_table.SetConsumeRecordsCutoffTime(start_time - num_records / 10);
+    benchmark::DoNotOptimize(data_table.ConsumeRecords());
+  }
+  state.SetItemsProcessed(state.iterations() * num_records);
+}
+
+BENCHMARK(BM_ConsumeRecords)
+    ->Args({1024, 1})
+    ->Args({1024, 4})
+    ->Args({1024, 64})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 4})
+    ->Args({16384, 64})
+    ->Args({16384, 0});
@@ -122,6 +122,36 @@ TEST_F(DataTableTest, FixedTimeModeV2) {
   }
 }
 
+// Records that are already in time order are handed over as the arrays they were built into.
+TEST_F(DataTableTest, InOrderRecordsAreArrowArrays) {
+  std::vector<int> time_vals = {0, 10, 20, 30};
+  std::vector<std::string> s_vals = {"a", "b", "c", "d"};
+
+  for (size_t i = 0; i < time_vals.size(); ++i) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), time_vals[i]);
+    r.Append<r.ColIndex("time_")>(time_vals[i]);
+    r.Append<r.ColIndex("x")>(time_vals[i]);
+    r.Append<r.ColIndex("s")>(s_vals[i]);
+  }
+
+  std::vector<TaggedRecordBatch> record_batches = data_table_->ConsumeRecords();
+
+  ASSERT_EQ(record_batches.size(), 1);
+  const types::ColumnWrapperRecordBatch& rb = record_batches[0].records;
+  ASSERT_EQ(rb.size(), 3);
+
+  ASSERT_NE(rb[0]->arrow_array(), nullptr);
+  EXPECT_EQ(rb[0]->data_type(), types::DataType::TIME64NS);
+  EXPECT_EQ(rb[0]->arrow_array()->length(), 4);
+
+  auto arr = rb[2]->ConvertToArrow(arrow::default_memory_pool());
+  ASSERT_EQ(arr->length(), 4);
+  for (size_t i = 0; i < s_vals.size(); ++i) {
+    EXPECT_EQ(types::GetValueFromArrowArray<types::DataType::STRING>(arr.get(), i), s_vals[i]);
+  }
+  EXPECT_EQ(rb[2]->Bytes(), 4);
+}
+
 TEST_F(DataTableTest, Expiry) {
   std::vector<int> time_vals = {0, 10, 40, 20, 30, 50, 90, 70, 60, 80};
   std::vector<int> x_vals = {0, 1, 4, 2, 3, 5, 9, 7, 6, 8};
@@ -201,6 +231,53 @@ TEST_F(DataTableTest, Expiry) {
   }
 }
 
+// Records that are in time order are carried over in place, and then pushed together with the
+// newer records.
+TEST_F(DataTableTest, InOrderCarryover) {
+  for (int i = 0; i < 10; ++i) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), 10 * i);
+    r.Append<r.ColIndex("time_")>(10 * i);
+    r.Append<r.ColIndex("x")>(i);
+    r.Append<r.ColIndex("s")>(std::string(1, 'a' + i));
+  }
+
+  {
+    data_table_->SetConsumeRecordsCutoffTime(40);
+    std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+
+    ASSERT_EQ(tablets.size(), 1);
+    types::ColumnWrapperRecordBatch& rb = tablets[0].records;
+    ASSERT_EQ(rb[0]->Size(), 5);
+    EXPECT_EQ(data_table_->Occupancy(), 5);
+  }
+
+  // Out of order with respect to the carried over records.
+  for (int i = 10; i < 15; ++i) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), 10 * (i - 5) + 5);
+    r.Append<r.ColIndex("time_")>(10 * (i - 5) + 5);
+    r.Append<r.ColIndex("x")>(i);
+    r.Append<r.ColIndex("s")>(std::string(1, 'a' + i));
+  }
+
+  {
+    data_table_->SetConsumeRecordsCutoffTime(1000);
+    std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+
+    ASSERT_EQ(tablets.size(), 1);
+    types::ColumnWrapperRecordBatch& rb = tablets[0].records;
+    ASSERT_EQ(rb[0]->Size(), 10);
+
+    // Times are 50, 55, 60, 65, ..., 95.
+    std::vector<int> expected_x = {5, 10, 6, 11, 7, 12, 8, 13, 9, 14};
+    for (size_t i = 0; i < expected_x.size(); ++i) {
+      EXPECT_EQ(rb[0]->Get<types::Time64NSValue>(i), 50 + 5 * static_cast<int>(i));
+      EXPECT_EQ(rb[1]->Get<types::Int64Value>(i), expected_x[i]);
+      EXPECT_EQ(rb[2]->Get<types::StringValue>(i), std::string(1, 'a' + expected_x[i]));
+    }
+    EXPECT_EQ(data_table_->Occupancy(), 0);
+  }
+}
+
 // This test has scrambled entries, but ConsumeRecords is called with end times
 // that should cause carryover. This test also causes no expirations for simplicity.
 TEST_F(DataTableTest, Carryover) {
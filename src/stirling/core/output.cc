@@ -26,6 +26,7 @@ namespace px {
 namespace stirling {
 
 using px::types::BoolValue;
+using px::types::ColumnWrapper;
 using px::types::ColumnWrapperRecordBatch;
 using px::types::DataType;
 using px::types::Float64Value;
@@ -48,20 +49,20 @@ std::string ToString(const stirlingpb::TableSchema& schema,
 
   std::string out;
   for (int j = 0; j < schema.elements_size(); ++j) {
-    const auto& col = record_batch[j];
+    const ColumnWrapper& col = *record_batch[j];
     const auto& col_schema = schema.elements(j);
 
     absl::StrAppend(&out, " ", col_schema.name(), ":[");
 
     switch (col_schema.type()) {
       case DataType::TIME64NS: {
-        const auto val = col->Get<Time64NSValue>(index).val;
+        const auto val = col.Get<Time64NSValue>(index).val;
         std::time_t time = val / 1000000000UL;
         absl::Time t = absl::FromTimeT(time);
         absl::StrAppend(&out, absl::FormatTime(kTimeFormat, t, kLocalTimeZone));
       } break;
       case DataType::INT64: {
-        const auto val = col->Get<Int64Value>(index).val;
+        const auto val = col.Get<Int64Value>(index).val;
         if (col_schema.stype() == SemanticType::ST_DURATION_NS) {
           const auto secs = std::chrono::duration_cast<std::chrono::duration<double>>(
               std::chrono::nanoseconds(val));
@@ -71,19 +72,19 @@ std::string ToString(const stirlingpb::TableSchema& schema,
         }
       } break;
       case DataType::FLOAT64: {
-        const auto val = col->Get<Float64Value>(index).val;
+        const auto val = col.Get<Float64Value>(index).val;
         absl::StrAppend(&out, val);
       } break;
       case DataType::BOOLEAN: {
-        const auto val = col->Get<BoolValue>(index).val;
+        const auto val = col.Get<BoolValue>(index).val;
         absl::StrAppend(&out, val);
       } break;
       case DataType::STRING: {
-        const auto& val = col->Get<StringValue>(index);
+        const auto& val = col.Get<StringValue>(index);
         absl::StrAppend(&out, val);
       } break;
       case DataType::UINT128: {
-        const auto& val = col->Get<UInt128Value>(index);
+        const auto& val = col.Get<UInt128Value>(index);
         if (col_schema.stype() == SemanticType::ST_UPID) {
           md::UPID upid(val.val);
           absl::StrAppend(&out, absl::Substitute("{$0}", upid.String()));
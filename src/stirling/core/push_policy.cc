@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/push_policy.h"
+
+#include <algorithm>
+
+namespace px {
+namespace stirling {
+
+bool PushPolicy::ShouldPush(size_t occupancy, time_point next_push_time, time_point now) {
+  // A smaller occupancy means the records were pushed since the previous call, so the rate is
+  // only updated while the buffers grow.
+  if (prev_time_.has_value() && now > prev_time_.value() && occupancy >= prev_occupancy_) {
+    double elapsed = std::chrono::duration<double>(now - prev_time_.value()).count();
+    fill_rate_ = (occupancy - prev_occupancy_) / elapsed;
+  }
+  prev_occupancy_ = occupancy;
+  prev_time_ = now;
+
+  if (occupancy > occupancy_threshold_) {
+    return true;
+  }
+
+  // Push early, if the buffers would otherwise grow past the largest threshold before the next
+  // push.
+  double time_until_push =
+      std::max(0.0, std::chrono::duration<double>(next_push_time - now).count());
+  return occupancy + fill_rate_ * time_until_push > kMaxOccupancyThreshold;
+}
+
+void PushPolicy::RecordPush(std::chrono::nanoseconds latency, size_t num_records) {
+  if (num_records == 0) {
+    return;
+  }
+
+  // Exponentially weighted, so that a single slow push doesn't change the threshold.
+  constexpr double kWeight = 0.2;
+  double latency_per_record = std::chrono::duration<double>(latency).count() / num_records;
+  push_latency_per_record_ += kWeight * (latency_per_record - push_latency_per_record_);
+
+  double busy_latency = std::chrono::duration<double>(kBusyPushLatencyPerRecord).count();
+  if (push_latency_per_record_ > busy_latency) {
+    occupancy_threshold_ = std::min(2 * occupancy_threshold_, kMaxOccupancyThreshold);
+  } else if (push_latency_per_record_ < busy_latency / 2) {
+    occupancy_threshold_ = std::max(occupancy_threshold_ / 2, kMinOccupancyThreshold);
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+#include "src/common/system/clock.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * PushPolicy decides when the records buffered by a source connector are pushed to the table
+ * store ahead of its push period, and adapts to how busy the table store is:
+ *  - When pushes are slow (e.g. compaction or queries hold the table locks), the occupancy
+ *    threshold that triggers a push grows, so that small pushes are coalesced into fewer, larger
+ *    ones. It shrinks back when pushes are fast again.
+ *  - When the buffers fill up quickly, the push happens early, before they grow past
+ *    kMaxOccupancyThreshold.
+ */
+class PushPolicy {
+ public:
+  using time_point = px::chrono::coarse_steady_clock::time_point;
+
+  // The occupancy of a data table that triggers a push, when the table store keeps up.
+  static constexpr size_t kMinOccupancyThreshold = 1024;
+
+  // The occupancy threshold never grows beyond this.
+  static constexpr size_t kMaxOccupancyThreshold = 16 * 1024;
+
+  // Pushes that take longer than this per record, on average, mean that the table store is busy.
+  // Normalized per record, so that a large push is not mistaken for a busy table store.
+  static constexpr std::chrono::nanoseconds kBusyPushLatencyPerRecord{1000};
+
+  /**
+   * Returns true if the records should be pushed now.
+   * @param occupancy The largest occupancy among the data tables of the source connector.
+   * @param next_push_time When the records are pushed anyway, at the end of the push period.
+   * @param now The current time.
+   */
+  bool ShouldPush(size_t occupancy, time_point next_push_time, time_point now);
+
+  /**
+   * Records how long the pushes of one push cycle of the source connector took, over all its
+   * tables. Cycles that push no records are ignored.
+   * @param latency The total time spent pushing to the table store.
+   * @param num_records The total number of records pushed.
+   */
+  void RecordPush(std::chrono::nanoseconds latency, size_t num_records);
+
+  size_t occupancy_threshold() const { return occupancy_threshold_; }
+
+ private:
+  size_t occupancy_threshold_ = kMinOccupancyThreshold;
+
+  // Moving average of the push latency per record, in seconds.
+  double push_latency_per_record_ = 0;
+
+  // Records buffered per second, measured between the last two calls to ShouldPush().
+  double fill_rate_ = 0;
+  size_t prev_occupancy_ = 0;
+  std::optional<time_point> prev_time_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/push_policy.h"
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+namespace px {
+namespace stirling {
+
+using std::chrono::milliseconds;
+
+TEST(PushPolicyTest, OccupancyThreshold) {
+  PushPolicy policy;
+  PushPolicy::time_point now;
+  PushPolicy::time_point next_push_time = now + milliseconds(100);
+
+  EXPECT_FALSE(policy.ShouldPush(0, next_push_time, now));
+  EXPECT_FALSE(policy.ShouldPush(PushPolicy::kMinOccupancyThreshold, next_push_time, now));
+  EXPECT_TRUE(policy.ShouldPush(PushPolicy::kMinOccupancyThreshold + 1, next_push_time, now));
+}
+
+TEST(PushPolicyTest, CoalescesWhenTableStoreIsBusy) {
+  PushPolicy policy;
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMinOccupancyThreshold);
+
+  for (int i = 0; i < 20; ++i) {
+    policy.RecordPush(10 * PushPolicy::kBusyPushLatencyPerRecord * 1000, 1000);
+  }
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMaxOccupancyThreshold);
+
+  PushPolicy::time_point now;
+  EXPECT_FALSE(
+      policy.ShouldPush(PushPolicy::kMinOccupancyThreshold + 1, now + milliseconds(100), now));
+
+  for (int i = 0; i < 40; ++i) {
+    policy.RecordPush(std::chrono::microseconds(10), 1000);
+  }
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMinOccupancyThreshold);
+}
+
+TEST(PushPolicyTest, NormalizesLatencyPerRecord) {
+  PushPolicy policy;
+
+  // A long push of many records is not a sign of a busy table store.
+  for (int i = 0; i < 20; ++i) {
+    policy.RecordPush(2 * PushPolicy::kBusyPushLatencyPerRecord, 100);
+  }
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMinOccupancyThreshold);
+
+  // Nor is a cycle with nothing to push.
+  for (int i = 0; i < 20; ++i) {
+    policy.RecordPush(10 * PushPolicy::kBusyPushLatencyPerRecord, 0);
+  }
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMinOccupancyThreshold);
+
+  // A short push of a few records can be.
+  for (int i = 0; i < 20; ++i) {
+    policy.RecordPush(20 * PushPolicy::kBusyPushLatencyPerRecord, 2);
+  }
+  EXPECT_EQ(policy.occupancy_threshold(), PushPolicy::kMaxOccupancyThreshold);
+}
+
+TEST(PushPolicyTest, PushesEarlyWhenBuffersGrowFast) {
+  PushPolicy policy;
+  for (int i = 0; i < 20; ++i) {
+    policy.RecordPush(10 * PushPolicy::kBusyPushLatencyPerRecord * 1000, 1000);
+  }
+
+  PushPolicy::time_point now;
+  PushPolicy::time_point next_push_time = now + milliseconds(1000);
+
+  // 3000 records per 100ms would grow past the maximum threshold before the next push.
+  EXPECT_FALSE(policy.ShouldPush(1000, next_push_time, now));
+  now += milliseconds(100);
+  EXPECT_TRUE(policy.ShouldPush(4000, next_push_time, now));
+
+  // A slower rate is fine.
+  now += milliseconds(100);
+  EXPECT_FALSE(policy.ShouldPush(4010, next_push_time, now));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -56,6 +56,8 @@ using px::types::Time64NSValue;
 using px::ArrayView;
 using px::Status;
 
+DECLARE_int32(stirling_source_connector_threads);
+
 // Test arguments, from the command line
 DEFINE_uint64(kRNGSeed, 377, "Random Seed");
 DEFINE_uint32(kNumSources, 2, "Number of sources");
@@ -316,6 +318,33 @@ TEST_F(StirlingTest, hammer_time_on_stirling_on_the_fly_subs) {
   EXPECT_GT(NumProcessed(), 0);
 }
 
+// Same as above, but with the source connectors running on a pool of threads.
+TEST_F(StirlingTest, hammer_time_on_stirling_source_connector_threads) {
+  FLAGS_stirling_source_connector_threads = 2;
+
+  ASSERT_OK(stirling_->RunAsThread());
+  ASSERT_OK(stirling_->WaitUntilRunning(std::chrono::seconds(5)));
+
+  uint32_t i = 0;
+  while (NumProcessed() < kNumProcessedRequirement || i < kNumIterMin) {
+    std::this_thread::sleep_for(kDurationPerIter);
+
+    i++;
+
+    // In case we have a slow environment, break out of the test after some time.
+    if (i > kNumIterMax) {
+      break;
+    }
+  }
+
+  stirling_->Stop();
+  EXPECT_FALSE(stirling_->IsRunning());
+
+  FLAGS_stirling_source_connector_threads = 0;
+
+  EXPECT_GT(NumProcessed(), 0);
+}
+
 TEST_F(StirlingTest, no_data_callback_defined) {
   stirling_->RegisterDataPushCallback(nullptr);
 
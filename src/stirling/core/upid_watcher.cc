@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/upid_watcher.h"
+
+#include <string>
+#include <utility>
+
+#include "src/common/system/proc_parser.h"
+#include "src/stirling/core/connector_context.h"
+
+namespace px {
+namespace stirling {
+
+UPIDWatcher::UPIDWatcher(std::filesystem::path proc_path, uint32_t asid,
+                         std::unique_ptr<system::ProcEventListener> listener,
+                         std::chrono::milliseconds rescan_period)
+    : proc_path_(std::move(proc_path)),
+      asid_(asid),
+      listener_(std::move(listener)),
+      rescan_period_(rescan_period) {}
+
+void UPIDWatcher::Update() {
+  const auto now = std::chrono::steady_clock::now();
+
+  if (listener_ != nullptr && now < next_rescan_time_) {
+    events_.clear();
+    Status s = listener_->ReadEvents(&events_);
+    if (s.ok()) {
+      ApplyEvents(events_);
+      return;
+    }
+    if (error::IsResourceUnavailable(s)) {
+      VLOG(1) << "Process events were dropped; rescanning /proc.";
+    } else {
+      LOG(WARNING) << absl::Substitute(
+          "Failed to read process events, falling back to scanning /proc. Message=$0", s.msg());
+      listener_.reset();
+    }
+  }
+
+  Rescan();
+  next_rescan_time_ = now + rescan_period_;
+}
+
+void UPIDWatcher::Rescan() {
+  if (listener_ != nullptr) {
+    // Discard the pending events; they predate the scan, and replaying them afterwards could
+    // remove a process whose PID was reused in the meantime.
+    events_.clear();
+    Status s = listener_->ReadEvents(&events_);
+    if (!s.ok() && !error::IsResourceUnavailable(s)) {
+      LOG(WARNING) << absl::Substitute(
+          "Failed to read process events, falling back to scanning /proc. Message=$0", s.msg());
+      listener_.reset();
+    }
+  }
+
+  upids_ = ListUPIDs(proc_path_, asid_);
+  upids_by_pid_.clear();
+  for (const auto& upid : upids_) {
+    upids_by_pid_.emplace(upid.pid(), upid);
+  }
+}
+
+void UPIDWatcher::ApplyEvents(const std::vector<system::ProcEvent>& events) {
+  for (const auto& event : events) {
+    // Events for threads other than the main thread do not create or destroy processes.
+    if (event.pid != event.tid) {
+      continue;
+    }
+
+    switch (event.type) {
+      case system::ProcEvent::Type::kFork: {
+        StatusOr<int64_t> start_time =
+            system::GetPIDStartTimeTicks(proc_path_ / std::to_string(event.pid));
+        if (!start_time.ok()) {
+          // The process already exited. Its exit event follows.
+          continue;
+        }
+        md::UPID upid(asid_, event.pid, start_time.ValueOrDie());
+        auto [iter, inserted] = upids_by_pid_.try_emplace(event.pid, upid);
+        if (!inserted) {
+          // A missed exit of a previous process with the same PID.
+          upids_.erase(iter->second);
+          iter->second = upid;
+        }
+        upids_.insert(upid);
+        break;
+      }
+      case system::ProcEvent::Type::kExit: {
+        auto iter = upids_by_pid_.find(event.pid);
+        if (iter != upids_by_pid_.end()) {
+          upids_.erase(iter->second);
+          upids_by_pid_.erase(iter);
+        }
+        break;
+      }
+      case system::ProcEvent::Type::kExec:
+        // An exec does not change the PID or start time, and thus not the UPID.
+        break;
+    }
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
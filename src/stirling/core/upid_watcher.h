@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+#include "src/common/system/proc_event_listener.h"
+#include "src/shared/upid/upid.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Maintains the set of UPIDs of the processes on the host.
+ *
+ * When given a ProcEventListener, the set is updated incrementally from process fork and exit
+ * events, and /proc is only rescanned once every rescan period, to reconcile any drift.
+ * Without a listener, or if the listener fails, /proc is rescanned on every update; this is the
+ * same as calling ListUPIDs().
+ */
+class UPIDWatcher : public NotCopyMoveable {
+ public:
+  /**
+   * @param proc_path Path to the proc filesystem.
+   * @param asid The ASID of the UPIDs.
+   * @param listener Source of process events. May be nullptr, to always rescan /proc.
+   * @param rescan_period How often to rescan /proc, when events are available.
+   */
+  UPIDWatcher(std::filesystem::path proc_path, uint32_t asid,
+              std::unique_ptr<system::ProcEventListener> listener,
+              std::chrono::milliseconds rescan_period);
+
+  /**
+   * Brings the set of UPIDs up to date.
+   */
+  void Update();
+
+  /**
+   * Applies process events to the set of UPIDs. Called by Update(); public for testing.
+   */
+  void ApplyEvents(const std::vector<system::ProcEvent>& events);
+
+  /**
+   * Returns the set of UPIDs, as of the last call to Update().
+   */
+  const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
+
+  /**
+   * Returns true if the set of UPIDs is maintained from process events.
+   */
+  bool event_driven() const { return listener_ != nullptr; }
+
+ private:
+  void Rescan();
+
+  const std::filesystem::path proc_path_;
+  const uint32_t asid_;
+  std::unique_ptr<system::ProcEventListener> listener_;
+  const std::chrono::milliseconds rescan_period_;
+  std::chrono::steady_clock::time_point next_rescan_time_ = {};
+
+  absl::flat_hash_set<md::UPID> upids_;
+  // Index of upids_, for handling exit events, which only have the PID.
+  absl::flat_hash_map<uint32_t, md::UPID> upids_by_pid_;
+
+  // Reused across calls to Update().
+  std::vector<system::ProcEvent> events_;
+};
+
+}  // namespace stirling
+}  // namespace px
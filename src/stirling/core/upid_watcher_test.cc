@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/upid_watcher.h"
+
+#include <filesystem>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::system::ProcEvent;
+using ::px::testing::TempDir;
+using ::px::testing::TestFilePath;
+using ::testing::UnorderedElementsAre;
+
+class UPIDWatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    AddProcess(123);
+    AddProcess(456);
+  }
+
+  // Copies the stat file of the PID from the test data into the temporary proc directory.
+  void AddProcess(int pid) {
+    const std::filesystem::path testdata_proc_path =
+        TestFilePath("src/common/system/testdata/proc");
+    std::filesystem::create_directory(proc_dir_.path() / std::to_string(pid));
+    std::filesystem::copy_file(testdata_proc_path / std::to_string(pid) / "stat",
+                               proc_dir_.path() / std::to_string(pid) / "stat");
+  }
+
+  TempDir proc_dir_;
+};
+
+TEST_F(UPIDWatcherTest, RescanWithoutListener) {
+  UPIDWatcher watcher(proc_dir_.path(), 1, /*listener*/ nullptr, std::chrono::seconds(60));
+  EXPECT_FALSE(watcher.event_driven());
+
+  watcher.Update();
+  EXPECT_THAT(watcher.upids(),
+              UnorderedElementsAre(md::UPID{1, 123, 14329}, md::UPID{1, 456, 17594622}));
+
+  // Without a listener, every update rescans /proc.
+  AddProcess(789);
+  watcher.Update();
+  EXPECT_THAT(watcher.upids(),
+              UnorderedElementsAre(md::UPID{1, 123, 14329}, md::UPID{1, 456, 17594622},
+                                   md::UPID{1, 789, 46120203}));
+}
+
+TEST_F(UPIDWatcherTest, ApplyEvents) {
+  UPIDWatcher watcher(proc_dir_.path(), 1, /*listener*/ nullptr, std::chrono::seconds(60));
+  watcher.Update();
+
+  AddProcess(789);
+  watcher.ApplyEvents({
+      // New process.
+      {ProcEvent::Type::kFork, 789, 789},
+      // New thread.
+      {ProcEvent::Type::kFork, 456, 457},
+      // Process that is already gone.
+      {ProcEvent::Type::kFork, 999, 999},
+      // Exit of a thread other than the main thread.
+      {ProcEvent::Type::kExit, 456, 457},
+      // Exec does not change the UPID.
+      {ProcEvent::Type::kExec, 789, 789},
+      // Exit of a process.
+      {ProcEvent::Type::kExit, 123, 123},
+  });
+  EXPECT_THAT(watcher.upids(),
+              UnorderedElementsAre(md::UPID{1, 456, 17594622}, md::UPID{1, 789, 46120203}));
+
+  // A fork of a PID that is already tracked replaces its UPID, since its exit must have been
+  // missed. Simulate the PID being reused, by giving 456 the start time of 789.
+  std::filesystem::copy_file(proc_dir_.path() / "789/stat", proc_dir_.path() / "456/stat",
+                             std::filesystem::copy_options::overwrite_existing);
+  watcher.ApplyEvents({{ProcEvent::Type::kFork, 456, 456}});
+  EXPECT_THAT(watcher.upids(),
+              UnorderedElementsAre(md::UPID{1, 456, 46120203}, md::UPID{1, 789, 46120203}));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -19,6 +19,9 @@
 #include "src/stirling/obj_tools/dwarf_reader.h"
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
 
 #include <llvm/DebugInfo/DIContext.h>
 #include <llvm/Object/ObjectFile.h>
@@ -92,16 +95,17 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateWithoutIndexing(
 }
 
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateIndexingAll(
-    const std::filesystem::path& path) {
+    const std::filesystem::path& path, int num_indexing_threads) {
   PL_ASSIGN_OR_RETURN(auto dwarf_reader, CreateWithoutIndexing(path));
-  dwarf_reader->IndexDIEs(std::nullopt);
+  dwarf_reader->IndexDIEs(std::nullopt, num_indexing_threads);
   return dwarf_reader;
 }
 
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateWithSelectiveIndexing(
-    const std::filesystem::path& path, const std::vector<SymbolSearchPattern>& symbol_patterns) {
+    const std::filesystem::path& path, const std::vector<SymbolSearchPattern>& symbol_patterns,
+    int num_indexing_threads) {
   PL_ASSIGN_OR_RETURN(auto dwarf_reader, CreateWithoutIndexing(path));
-  dwarf_reader->IndexDIEs(symbol_patterns);
+  dwarf_reader->IndexDIEs(symbol_patterns, num_indexing_threads);
   return dwarf_reader;
 }
 
@@ -172,71 +176,151 @@ Status DwarfReader::DetectSourceLanguage() {
       "any compilation unit.");
 }
 
-void DwarfReader::IndexDIEs(
-    const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt) {
-  absl::flat_hash_map<const llvm::DWARFDebugInfoEntry*, std::string> dwarf_entry_names;
+namespace {
 
-  // Map from DW_AT_specification to DIE. Only DW_TAG_subprogram can have this attribute.
-  // Also only applies to CPP binaries.
-  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+// Calls fn(i) for every i in [0, n), spreading the calls over up to num_threads threads
+// (including the calling thread). Work is handed out one index at a time, because the sizes of
+// compilation units are very uneven (e.g. the Go runtime package dwarfs most others).
+template <typename TFn>
+void ParallelFor(size_t n, int num_threads, const TFn& fn) {
+  const size_t num_workers = std::min<size_t>(std::max(num_threads, 1), n);
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      fn(i);
+    }
+    return;
+  }
 
-  DWARFContext::unit_iterator_range units = dwarf_context_->normal_units();
-  for (const std::unique_ptr<llvm::DWARFUnit>& unit : units) {
-    for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
-      DWARFDie die = {unit.get(), &entry};
+  std::atomic<size_t> next_idx = 0;
+  auto worker = [&next_idx, n, &fn]() {
+    for (size_t i = next_idx++; i < n; i = next_idx++) {
+      fn(i);
+    }
+  };
 
-      if (die.isSubprogramDIE()) {
-        auto spec_or =
-            AdaptLLVMOptional(llvm::dwarf::toReference(die.find(llvm::dwarf::DW_AT_specification)),
-                              "Could not find attribute DW_AT_specification");
-        if (spec_or.ok()) {
-          fn_spec_offsets[spec_or.ValueOrDie()] = die;
-        }
-      }
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers - 1);
+  for (size_t i = 1; i < num_workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
 
-      // TODO(oazizi/yzhao): Change to use the demangled name of DW_AT_linkage_name as the key to
-      // index the function DIE. That removes the need of using manually-assembled names (through
-      // parent DIE).
+// The indexed DIEs of a single compilation unit, in the order in which they appear.
+struct UnitIndex {
+  std::vector<std::tuple<llvm::dwarf::Tag, std::string, DWARFDie>> dies;
 
-      auto name = std::string(GetShortName(die));
+  // DW_AT_specification offset and the DIE that has it. Only DW_TAG_subprogram can have this
+  // attribute. Also only applies to CPP binaries.
+  std::vector<std::pair<uint64_t, DWARFDie>> fn_specs;
+};
 
-      if (name.empty()) {
-        continue;
-      }
+UnitIndex IndexUnitDIEs(
+    llvm::DWARFUnit* unit,
+    const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt) {
+  UnitIndex unit_index;
+
+  // Parents always belong to the same compilation unit, so the names are tracked per unit.
+  absl::flat_hash_map<const llvm::DWARFDebugInfoEntry*, std::string> dwarf_entry_names;
+
+  for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
+    DWARFDie die = {unit, &entry};
 
-      // Only check matching if patterns are provided.
-      if (symbol_search_patterns_opt.has_value() &&
-          !MatchesSymbolAny(name, symbol_search_patterns_opt.value())) {
-        continue;
+    if (die.isSubprogramDIE()) {
+      auto spec_or =
+          AdaptLLVMOptional(llvm::dwarf::toReference(die.find(llvm::dwarf::DW_AT_specification)),
+                            "Could not find attribute DW_AT_specification");
+      if (spec_or.ok()) {
+        unit_index.fn_specs.emplace_back(spec_or.ValueOrDie(), die);
       }
+    }
+
+    // TODO(oazizi/yzhao): Change to use the demangled name of DW_AT_linkage_name as the key to
+    // index the function DIE. That removes the need of using manually-assembled names (through
+    // parent DIE).
+    auto name = std::string(GetShortName(die));
 
-      llvm::dwarf::Tag tag = die.getTag();
+    if (name.empty()) {
+      continue;
+    }
+
+    // Only check matching if patterns are provided.
+    if (symbol_search_patterns_opt.has_value() &&
+        !MatchesSymbolAny(name, symbol_search_patterns_opt.value())) {
+      continue;
+    }
 
-      if (IsIndexedType(tag) ||
-          // Namespace entry is processed here so that the name components can be generated.
-          IsNamespace(tag)) {
-        llvm::DWARFDie parent_die = die.getParent();
+    llvm::dwarf::Tag tag = die.getTag();
 
-        if (parent_die.isValid()) {
-          const llvm::DWARFDebugInfoEntry* entry = parent_die.getDebugInfoEntry();
+    if (IsIndexedType(tag) ||
+        // Namespace entry is processed here so that the name components can be generated.
+        IsNamespace(tag)) {
+      llvm::DWARFDie parent_die = die.getParent();
 
-          if (entry != nullptr) {
-            auto iter = dwarf_entry_names.find(entry);
-            if (iter != dwarf_entry_names.end()) {
-              std::string_view parent_name = iter->second;
-              name = absl::StrCat(parent_name, "::", name);
-            }
+      if (parent_die.isValid()) {
+        const llvm::DWARFDebugInfoEntry* entry = parent_die.getDebugInfoEntry();
+
+        if (entry != nullptr) {
+          auto iter = dwarf_entry_names.find(entry);
+          if (iter != dwarf_entry_names.end()) {
+            std::string_view parent_name = iter->second;
+            name = absl::StrCat(parent_name, "::", name);
           }
-          dwarf_entry_names[die.getDebugInfoEntry()] = name;
         }
+        dwarf_entry_names[die.getDebugInfoEntry()] = name;
+      }
 
-        if (IsIndexedType(tag)) {
-          InsertToDIEMap(std::move(name), tag, die);
-        }
+      if (IsIndexedType(tag)) {
+        unit_index.dies.emplace_back(tag, std::move(name), die);
       }
     }
   }
 
+  return unit_index;
+}
+
+}  // namespace
+
+void DwarfReader::IndexDIEs(
+    const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt,
+    int num_threads) {
+  // DWARFContext parses the unit headers and the abbreviation tables lazily, which is not
+  // thread-safe, so force that to happen up-front on this thread.
+  std::vector<llvm::DWARFUnit*> units;
+  for (const std::unique_ptr<llvm::DWARFUnit>& unit : dwarf_context_->normal_units()) {
+    unit->getAbbreviations();
+    units.push_back(unit.get());
+  }
+
+  num_threads = std::min<int>(num_threads, std::max(std::thread::hardware_concurrency(), 1u));
+
+  // Extracting the DIEs of a unit only touches that unit. But resolving names may follow
+  // references (e.g. DW_AT_specification) into other units, so all units must be extracted
+  // before any of them is indexed.
+  ParallelFor(units.size(), num_threads, [&units](size_t i) { units[i]->dies(); });
+
+  std::vector<UnitIndex> unit_indexes(units.size());
+  ParallelFor(units.size(), num_threads, [&](size_t i) {
+    unit_indexes[i] = IndexUnitDIEs(units[i], symbol_search_patterns_opt);
+  });
+
+  // Merge in unit order, so that the result is the same as indexing the units sequentially.
+  // Map from DW_AT_specification to DIE.
+  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+  for (UnitIndex& unit_index : unit_indexes) {
+    for (auto& [tag, name, die] : unit_index.dies) {
+      InsertToDIEMap(std::move(name), tag, die);
+    }
+    for (const auto& [spec_offset, die] : unit_index.fn_specs) {
+      fn_spec_offsets[spec_offset] = die;
+    }
+    // Release the memory of the names early, as this can be large for big binaries.
+    unit_index = {};
+  }
+
   auto& fn_dies = die_map_[llvm::dwarf::DW_TAG_subprogram];
 
   for (auto iter = fn_dies.begin(); iter != fn_dies.end(); ++iter) {
@@ -151,15 +151,18 @@ class DwarfReader {
    * Creates a DwarfReader that provides access to DWARF Debugging information entries (DIEs).
    * @param obj_filename The object file from which to read DWARF information.
    * @param index If true, creates an index to speed up accesses when called more than once.
+   * @param num_indexing_threads Number of threads among which the compilation units are divided
+   * when building the index.
    * @return error if file does not exist or is not a valid object file. Otherwise returns
    * a unique pointer to a DwarfReader.
    */
   static StatusOr<std::unique_ptr<DwarfReader>> CreateWithoutIndexing(
       const std::filesystem::path& path);
   static StatusOr<std::unique_ptr<DwarfReader>> CreateIndexingAll(
-      const std::filesystem::path& path);
+      const std::filesystem::path& path, int num_indexing_threads = 1);
   static StatusOr<std::unique_ptr<DwarfReader>> CreateWithSelectiveIndexing(
-      const std::filesystem::path& path, const std::vector<SymbolSearchPattern>& symbol_patterns);
+      const std::filesystem::path& path, const std::vector<SymbolSearchPattern>& symbol_patterns,
+      int num_indexing_threads = 1);
 
   /**
    * Searches the debug information for Debugging information entries (DIEs)
@@ -306,7 +309,12 @@ class DwarfReader {
   //
   // If the search patterns are not provided, all DIEs of the matching tags are indexed.
   // Otherwise, only the ones whose names match are indexed.
-  void IndexDIEs(const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt);
+  //
+  // Compilation units are indexed independently, so they are spread over num_threads threads,
+  // and the per-unit results are then merged in unit order. The resulting index is identical
+  // regardless of the number of threads.
+  void IndexDIEs(const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt,
+                 int num_threads);
 
   // Walks the struct_die for all members, recursively visiting any members which are also structs,
   // to capture information of all base type members of the struct in a flattened form.
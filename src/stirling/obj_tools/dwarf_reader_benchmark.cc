@@ -105,5 +105,23 @@ static void BM_indexed(benchmark::State& state) {
   }
 }
 
+// Measures only the index creation, as a function of the number of indexing threads.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_indexing_threads(benchmark::State& state) {
+  int num_indexing_threads = state.range(0);
+
+  for (auto _ : state) {
+    SymAddrs symaddrs;
+
+    PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader,
+                      DwarfReader::CreateIndexingAll(kBinary, num_indexing_threads));
+
+    GetSymAddrs(dwarf_reader.get(), &symaddrs);
+    benchmark::DoNotOptimize(symaddrs);
+  }
+}
+
 BENCHMARK(BM_noindex)->RangeMultiplier(2)->Range(1, 16);
 BENCHMARK(BM_indexed)->RangeMultiplier(2)->Range(1, 16);
+// Real time, because the work of the indexing threads is not accounted to the benchmark thread.
+BENCHMARK(BM_indexing_threads)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
@@ -48,11 +48,12 @@ using ::px::operator<<;
 
 struct DwarfReaderTestParam {
   bool index;
+  int num_indexing_threads = 1;
 };
 
-auto CreateDwarfReader(const std::filesystem::path& path, bool indexing) {
-  if (indexing) {
-    return DwarfReader::CreateIndexingAll(path);
+auto CreateDwarfReader(const std::filesystem::path& path, const DwarfReaderTestParam& param) {
+  if (param.index) {
+    return DwarfReader::CreateIndexingAll(path, param.num_indexing_threads);
   }
   return DwarfReader::CreateWithoutIndexing(path);
 }
@@ -108,7 +109,7 @@ TEST_F(DwarfReaderTest, SourceLanguage) {
 TEST_P(DwarfReaderTest, GetMatchingDIEsReturnsEmptyVector) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
   ASSERT_OK_AND_THAT(
       dwarf_reader->GetMatchingDIEs("non-existent-name", llvm::dwarf::DW_TAG_structure_type),
       IsEmpty());
@@ -117,7 +118,7 @@ TEST_P(DwarfReaderTest, GetMatchingDIEsReturnsEmptyVector) {
 TEST_P(DwarfReaderTest, CppGetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct32"), 12);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct64"), 24);
@@ -126,7 +127,7 @@ TEST_P(DwarfReaderTest, CppGetStructByteSize) {
 TEST_P(DwarfReaderTest, Go1_16GetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("main.Vertex"), 16);
 }
@@ -134,7 +135,7 @@ TEST_P(DwarfReaderTest, Go1_16GetStructByteSize) {
 TEST_P(DwarfReaderTest, Go1_17GetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("main.Vertex"), 16);
 }
@@ -142,7 +143,7 @@ TEST_P(DwarfReaderTest, Go1_17GetStructByteSize) {
 TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructMemberInfo("ABCStruct32", llvm::dwarf::DW_TAG_structure_type, "b",
@@ -155,7 +156,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
 TEST_P(DwarfReaderTest, Go1_16GetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructMemberInfo("main.Vertex", llvm::dwarf::DW_TAG_structure_type, "Y",
@@ -168,7 +169,7 @@ TEST_P(DwarfReaderTest, Go1_16GetStructMemberInfo) {
 TEST_P(DwarfReaderTest, Go1_17GetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructMemberInfo("main.Vertex", llvm::dwarf::DW_TAG_structure_type, "Y",
@@ -181,7 +182,7 @@ TEST_P(DwarfReaderTest, Go1_17GetStructMemberInfo) {
 TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "a"), 0);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "b"), 4);
@@ -191,7 +192,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, Go1_16GetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("main.Vertex", "Y"), 8);
   EXPECT_NOT_OK(dwarf_reader->GetStructMemberOffset("main.Vertex", "bogus"));
@@ -200,7 +201,7 @@ TEST_P(DwarfReaderTest, Go1_16GetStructMemberOffset) {
 TEST_P(DwarfReaderTest, Go1_17GetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("main.Vertex", "Y"), 8);
   EXPECT_NOT_OK(dwarf_reader->GetStructMemberOffset("main.Vertex", "bogus"));
@@ -210,7 +211,7 @@ TEST_P(DwarfReaderTest, Go1_17GetStructMemberOffset) {
 TEST_P(DwarfReaderTest, GoUnconventionalGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGoBinaryUnconventionalPath, p.index));
+                       CreateDwarfReader(kGoBinaryUnconventionalPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("runtime.g", "goid"), 192);
 }
@@ -218,7 +219,7 @@ TEST_P(DwarfReaderTest, GoUnconventionalGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, CppGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("OuterStruct"),
@@ -263,7 +264,7 @@ TEST_P(DwarfReaderTest, CppGetStructSpec) {
 TEST_P(DwarfReaderTest, GoGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("main.OuterStruct"),
@@ -308,7 +309,7 @@ TEST_P(DwarfReaderTest, GoGetStructSpec) {
 TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("CanYouFindThis", "a"), 4);
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("ABCSum32", "x"), 12);
@@ -319,7 +320,7 @@ TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, Golang1_16ArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   // v is of type *Vertex.
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("main.(*Vertex).Scale", "v"), 8);
@@ -332,7 +333,7 @@ TEST_P(DwarfReaderTest, Golang1_16ArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, Golang1_17ArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   // v is of type *Vertex.
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("main.(*Vertex).Scale", "v"), 8);
@@ -345,7 +346,7 @@ TEST_P(DwarfReaderTest, Golang1_17ArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, CppArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("ABCSum32", "x"),
                    (VarLocation{.loc_type = LocationType::kRegister, .offset = 32}));
@@ -364,7 +365,7 @@ TEST_P(DwarfReaderTest, CppArgumentLocation) {
 TEST_P(DwarfReaderTest, Golang1_16ArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("main.(*Vertex).Scale", "v"),
                    (VarLocation{.loc_type = LocationType::kStack, .offset = 0}));
@@ -383,7 +384,7 @@ TEST_P(DwarfReaderTest, Golang1_16ArgumentLocation) {
 TEST_P(DwarfReaderTest, Golang1_17ArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_17BinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("main.(*Vertex).Scale", "v"),
                    (VarLocation{.loc_type = LocationType::kRegister, .offset = 0}));
@@ -408,7 +409,7 @@ TEST_P(DwarfReaderTest, Golang1_17ArgumentLocation) {
 TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_THAT(
       dwarf_reader->GetFunctionArgInfo("CanYouFindThis"),
@@ -437,7 +438,7 @@ TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
 TEST_P(DwarfReaderTest, CppFunctionRetValInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kCppBinaryPath, p.index));
+                       CreateDwarfReader(kCppBinaryPath, p));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetFunctionRetValInfo("CanYouFindThis"),
                    (RetValInfo{TypeInfo{VarType::kBaseType, "int"}, 4}));
@@ -452,7 +453,7 @@ TEST_P(DwarfReaderTest, Go1_16FunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                         CreateDwarfReader(kGo1_16BinaryPath, p));
 
     EXPECT_OK_AND_THAT(
         dwarf_reader->GetFunctionArgInfo("main.(*Vertex).Scale"),
@@ -501,7 +502,7 @@ TEST_P(DwarfReaderTest, Go1_16FunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         CreateDwarfReader(kGoServerBinaryPath, p.index));
+                         CreateDwarfReader(kGoServerBinaryPath, p));
 
     // func (f *http2Framer) WriteDataPadded(streamID uint32, endStream bool, data, pad []byte)
     // error
@@ -529,7 +530,7 @@ TEST_P(DwarfReaderTest, Go1_17FunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         CreateDwarfReader(kGo1_17BinaryPath, p.index));
+                         CreateDwarfReader(kGo1_17BinaryPath, p));
 
     EXPECT_OK_AND_THAT(
         dwarf_reader->GetFunctionArgInfo("main.(*Vertex).Scale"),
@@ -598,7 +599,7 @@ TEST_P(DwarfReaderTest, GoFunctionVarLocationConsistency) {
   DwarfReaderTestParam p = GetParam();
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       CreateDwarfReader(kGo1_16BinaryPath, p.index));
+                       CreateDwarfReader(kGo1_16BinaryPath, p));
 
   // First run GetFunctionArgInfo to automatically get all arguments.
   ASSERT_OK_AND_ASSIGN(auto function_arg_locations,
@@ -618,6 +619,7 @@ TEST_P(DwarfReaderTest, GoFunctionVarLocationConsistency) {
 
 INSTANTIATE_TEST_SUITE_P(DwarfReaderParameterizedTest, DwarfReaderTest,
                          ::testing::Values(DwarfReaderTestParam{true},
+                                           DwarfReaderTestParam{true, 4},
                                            DwarfReaderTestParam{false}));
 
 }  // namespace obj_tools
@@ -23,14 +23,20 @@
 #include <llvm/MC/MCDisassembler/MCDisassembler.h>
 #include <llvm/Support/TargetSelect.h>
 
-#include <absl/container/flat_hash_set.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <numeric>
 #include <set>
 #include <utility>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/base/byte_utils.h"
 #include "src/common/base/utils.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/stirling/obj_tools/init.h"
+#include "src/stirling/utils/binary_decoder.h"
 
 namespace px {
 namespace stirling {
@@ -367,30 +373,67 @@ StatusOr<std::unique_ptr<ElfReader::Symbolizer>> ElfReader::GetSymbolizer() {
       symbolizer->AddEntry(addr, size, llvm::demangle(name));
     }
   }
+  symbolizer->Finalize();
 
   return symbolizer;
 }
 
-void ElfReader::Symbolizer::AddEntry(size_t addr, size_t size, std::string name) {
-  symbols_.emplace(addr, SymbolAddrInfo{size, std::move(name)});
+void ElfReader::Symbolizer::AddEntry(uintptr_t addr, size_t size, std::string_view name) {
+  if (!addrs_.empty() && addr <= addrs_.back()) {
+    sorted_ = false;
+  }
+  addrs_.push_back(addr);
+  sizes_.push_back(size);
+  names_.append(name);
+  DCHECK_LE(names_.size(), std::numeric_limits<uint32_t>::max());
+  name_offsets_.push_back(names_.size());
+}
+
+void ElfReader::Symbolizer::Finalize() {
+  if (!sorted_) {
+    // Sort an index rather than the columns, then rebuild the columns in address order.
+    // Names are re-packed too, so neighboring symbols also have neighboring names.
+    std::vector<uint32_t> order(addrs_.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Stable, so that the first of several entries with the same address is kept.
+    std::stable_sort(order.begin(), order.end(),
+                     [this](uint32_t a, uint32_t b) { return addrs_[a] < addrs_[b]; });
+
+    Symbolizer sorted;
+    sorted.addrs_.reserve(addrs_.size());
+    sorted.sizes_.reserve(sizes_.size());
+    sorted.name_offsets_.reserve(name_offsets_.size());
+    sorted.names_.reserve(names_.size());
+    for (uint32_t i : order) {
+      if (!sorted.addrs_.empty() && sorted.addrs_.back() == addrs_[i]) {
+        continue;
+      }
+      sorted.AddEntry(addrs_[i], sizes_[i], name(i));
+    }
+    *this = std::move(sorted);
+  }
+
+  addrs_.shrink_to_fit();
+  sizes_.shrink_to_fit();
+  name_offsets_.shrink_to_fit();
+  names_.shrink_to_fit();
 }
 
-std::string_view ElfReader::Symbolizer::Lookup(size_t addr) const {
+std::string_view ElfReader::Symbolizer::Lookup(uintptr_t addr) const {
+  DCHECK(sorted_) << "Finalize() must be called before Lookup().";
+
   static std::string symbol_str;
 
   // Find the first symbol for which the address_range_start > addr.
-  auto iter = symbols_.upper_bound(addr);
-
-  if (iter == symbols_.begin() || symbols_.empty()) {
-    symbol_str = absl::StrFormat("0x%016llx", addr);
-    return symbol_str;
-  }
+  auto iter = std::upper_bound(addrs_.begin(), addrs_.end(), addr);
 
   // std::upper_bound will make us overshoot our potential match,
   // so go back by one, and check if it is indeed a match.
-  --iter;
-  if (addr >= iter->first && addr < iter->first + iter->second.size) {
-    return iter->second.name;
+  if (iter != addrs_.begin()) {
+    const size_t i = std::distance(addrs_.begin(), iter) - 1;
+    if (Contains(i, addr)) {
+      return name(i);
+    }
   }
 
   // Couldn't find the address.
@@ -398,6 +441,229 @@ std::string_view ElfReader::Symbolizer::Lookup(size_t addr) const {
   return symbol_str;
 }
 
+void ElfReader::Symbolizer::LookupSorted(absl::Span<const uintptr_t> addrs,
+                                         std::vector<std::string_view>* symbols) const {
+  DCHECK(sorted_) << "Finalize() must be called before LookupSorted().";
+  DCHECK(std::is_sorted(addrs.begin(), addrs.end()));
+
+  symbols->clear();
+  symbols->reserve(addrs.size());
+
+  // Index of the first symbol that starts after the previous address.
+  size_t pos = 0;
+  for (const uintptr_t addr : addrs) {
+    // Gallop forward from the previous position to bracket the next address,
+    // then binary search within the bracket. Consecutive addresses that are close to each other
+    // only cost a couple of comparisons, and far apart ones cost no more than a binary search.
+    size_t lo = pos;
+    size_t step = 1;
+    while (lo + step < addrs_.size() && addrs_[lo + step] <= addr) {
+      lo += step;
+      step *= 2;
+    }
+    const size_t hi = std::min(lo + step, addrs_.size());
+    pos = std::upper_bound(addrs_.begin() + lo, addrs_.begin() + hi, addr) - addrs_.begin();
+
+    if (pos != 0 && Contains(pos - 1, addr)) {
+      symbols->push_back(name(pos - 1));
+    } else {
+      symbols->push_back({});
+    }
+  }
+}
+
+namespace {
+// Bump the version whenever the serialized format, or the way symbols are collected changes,
+// so that stale persisted symbol tables are ignored.
+constexpr std::string_view kSymbolizerMagic = "pxsym";
+constexpr uint32_t kSymbolizerVersion = 1;
+
+template <typename TIntType>
+void AppendInt(TIntType val, std::string* out) {
+  char bytes[sizeof(TIntType)];
+  utils::IntToLEndianBytes(val, bytes);
+  out->append(bytes, sizeof(TIntType));
+}
+
+template <typename TIntType>
+StatusOr<TIntType> ExtractLEndianInt(BinaryDecoder* decoder) {
+  PL_ASSIGN_OR_RETURN(std::string_view bytes, decoder->ExtractString(sizeof(TIntType)));
+  return utils::LEndianBytesToInt<TIntType>(bytes);
+}
+
+struct ELFNote {
+  uint32_t type;
+  std::string_view name;
+  std::string_view desc;
+};
+
+// Each note is: namesz, descsz, type (32-bit each), followed by the name and the desc,
+// each padded to a 4-byte boundary.
+StatusOr<ELFNote> ExtractELFNote(BinaryDecoder* decoder) {
+  PL_ASSIGN_OR_RETURN(uint32_t name_size, ExtractLEndianInt<uint32_t>(decoder));
+  PL_ASSIGN_OR_RETURN(uint32_t desc_size, ExtractLEndianInt<uint32_t>(decoder));
+  PL_ASSIGN_OR_RETURN(uint32_t type, ExtractLEndianInt<uint32_t>(decoder));
+  PL_ASSIGN_OR_RETURN(std::string_view name,
+                      decoder->ExtractString(SnapUpToMultiple<uint64_t>(name_size, 4)));
+  PL_ASSIGN_OR_RETURN(std::string_view desc,
+                      decoder->ExtractString(SnapUpToMultiple<uint64_t>(desc_size, 4)));
+  return ELFNote{type, name.substr(0, name_size), desc.substr(0, desc_size)};
+}
+}  // namespace
+
+std::string ElfReader::Symbolizer::Serialize() const {
+  std::string out;
+  out.append(kSymbolizerMagic);
+  AppendInt<uint32_t>(kSymbolizerVersion, &out);
+  AppendInt<uint64_t>(addrs_.size(), &out);
+  for (size_t i = 0; i < addrs_.size(); ++i) {
+    AppendInt<uint64_t>(addrs_[i], &out);
+    AppendInt<uint64_t>(sizes_[i], &out);
+    AppendInt<uint32_t>(name(i).size(), &out);
+    out.append(name(i));
+  }
+  return out;
+}
+
+StatusOr<std::unique_ptr<ElfReader::Symbolizer>> ElfReader::Symbolizer::Deserialize(
+    std::string_view data) {
+  BinaryDecoder decoder(data);
+
+  PL_ASSIGN_OR_RETURN(std::string_view magic, decoder.ExtractString(kSymbolizerMagic.size()));
+  if (magic != kSymbolizerMagic) {
+    return error::InvalidArgument("Not a serialized symbol table.");
+  }
+  PL_ASSIGN_OR_RETURN(uint32_t version, ExtractLEndianInt<uint32_t>(&decoder));
+  if (version != kSymbolizerVersion) {
+    return error::InvalidArgument("Unsupported symbol table version $0, expected $1.", version,
+                                  kSymbolizerVersion);
+  }
+  PL_ASSIGN_OR_RETURN(uint64_t num_symbols, ExtractLEndianInt<uint64_t>(&decoder));
+
+  auto symbolizer = std::make_unique<ElfReader::Symbolizer>();
+  for (uint64_t i = 0; i < num_symbols; ++i) {
+    PL_ASSIGN_OR_RETURN(uint64_t addr, ExtractLEndianInt<uint64_t>(&decoder));
+    PL_ASSIGN_OR_RETURN(uint64_t size, ExtractLEndianInt<uint64_t>(&decoder));
+    PL_ASSIGN_OR_RETURN(uint32_t name_size, ExtractLEndianInt<uint32_t>(&decoder));
+    PL_ASSIGN_OR_RETURN(std::string_view name, decoder.ExtractString(name_size));
+    symbolizer->AddEntry(addr, size, name);
+  }
+  if (!decoder.eof()) {
+    return error::InvalidArgument("Trailing bytes after the serialized symbol table.");
+  }
+  // Entries were serialized in address order, so this is cheap unless the data was tampered with.
+  symbolizer->Finalize();
+
+  return symbolizer;
+}
+
+StatusOr<std::string> ReadBuildID(const std::filesystem::path& binary_path) {
+  // Offsets within the ELF64 header and program header.
+  // See https://refspecs.linuxfoundation.org/elf/gabi4+/ch4.eheader.html.
+  constexpr size_t kEhdrSize = 64;
+  constexpr size_t kEIClassOffset = 4;
+  constexpr size_t kEIDataOffset = 5;
+  constexpr char kELFClass64 = 2;
+  constexpr char kELFDataLSB = 1;
+  constexpr size_t kPhoffOffset = 32;
+  constexpr size_t kPhentsizeOffset = 54;
+  constexpr size_t kPhnumOffset = 56;
+  constexpr size_t kPhdrSize = 56;
+  constexpr size_t kPTypeOffset = 0;
+  constexpr size_t kPOffsetOffset = 8;
+  constexpr size_t kPFileszOffset = 32;
+  constexpr uint32_t kPTNote = 4;
+  constexpr uint32_t kNTGNUBuildID = 3;
+  constexpr std::string_view kGNUNoteName("GNU\0", 4);
+  // Written by the Go linker into .note.go.buildid.
+  constexpr uint32_t kNTGoBuildID = 4;
+  constexpr std::string_view kGoNoteName("Go\0\0", 4);
+  // Build-id notes are at most a few tens of bytes; don't read arbitrarily large note segments.
+  constexpr uint64_t kMaxNoteSegmentSize = 64 * 1024;
+
+  std::ifstream ifs(binary_path, std::ios::binary);
+  if (!ifs) {
+    return error::Internal("Failed to open binary=$0", binary_path.string());
+  }
+
+  auto read_at = [&ifs, &binary_path](uint64_t offset, size_t size) -> StatusOr<std::string> {
+    std::string buf(size, '\0');
+    // Clear the state left by an earlier failed read.
+    ifs.clear();
+    if (!ifs.seekg(offset) || !ifs.read(buf.data(), size)) {
+      return error::Internal("Failed to read size=$0 bytes from offset=$1 in binary=$2", size,
+                             offset, binary_path.string());
+    }
+    return buf;
+  };
+
+  PL_ASSIGN_OR_RETURN(std::string ehdr, read_at(0, kEhdrSize));
+  if (ehdr.substr(0, 4) != "\x7f" "ELF") {
+    return error::InvalidArgument("Not an ELF file, binary=$0", binary_path.string());
+  }
+  if (ehdr[kEIClassOffset] != kELFClass64 || ehdr[kEIDataOffset] != kELFDataLSB) {
+    return error::Unimplemented("Only little-endian ELF64 binaries are supported, binary=$0",
+                                binary_path.string());
+  }
+
+  std::string_view ehdr_view(ehdr);
+  const auto phoff = utils::LEndianBytesToInt<uint64_t>(ehdr_view.substr(kPhoffOffset));
+  const auto phentsize = utils::LEndianBytesToInt<uint16_t>(ehdr_view.substr(kPhentsizeOffset));
+  const auto phnum = utils::LEndianBytesToInt<uint16_t>(ehdr_view.substr(kPhnumOffset));
+  if (phentsize < kPhdrSize) {
+    return error::InvalidArgument("Invalid program header size $0, binary=$1", phentsize,
+                                  binary_path.string());
+  }
+
+  PL_ASSIGN_OR_RETURN(std::string phdrs, read_at(phoff, phentsize * phnum));
+  std::string go_build_id;
+  for (size_t i = 0; i < phnum; ++i) {
+    std::string_view phdr = std::string_view(phdrs).substr(i * phentsize, phentsize);
+    if (utils::LEndianBytesToInt<uint32_t>(phdr.substr(kPTypeOffset)) != kPTNote) {
+      continue;
+    }
+    const auto note_offset = utils::LEndianBytesToInt<uint64_t>(phdr.substr(kPOffsetOffset));
+    const auto note_size = utils::LEndianBytesToInt<uint64_t>(phdr.substr(kPFileszOffset));
+    if (note_size > kMaxNoteSegmentSize) {
+      continue;
+    }
+    // A malformed note segment does not rule out a build-id in another one, so skip it.
+    StatusOr<std::string> notes = read_at(note_offset, note_size);
+    if (!notes.ok()) {
+      VLOG(1) << notes.ToString();
+      continue;
+    }
+
+    BinaryDecoder decoder(notes.ValueOrDie());
+    while (!decoder.eof()) {
+      StatusOr<ELFNote> note_status = ExtractELFNote(&decoder);
+      if (!note_status.ok()) {
+        VLOG(1) << absl::Substitute("Skipping malformed note in binary=$0 [error=$1]",
+                                    binary_path.string(), note_status.ToString());
+        break;
+      }
+      const ELFNote& note = note_status.ValueOrDie();
+      if (note.type == kNTGNUBuildID && note.name == kGNUNoteName) {
+        return BytesToString<LowercaseHex>(note.desc);
+      }
+      // Real Go build-ids are slash-separated hashes ("<action id>/<content id>"). Build systems
+      // that want reproducible output (e.g. Bazel's rules_go) replace it with a constant like
+      // "redacted", which does not identify anything.
+      if (note.type == kNTGoBuildID && note.name == kGoNoteName &&
+          note.desc.find('/') != std::string_view::npos) {
+        go_build_id = BytesToString<LowercaseHex>(note.desc);
+      }
+    }
+  }
+
+  // Prefer the GNU build-id, which is also present in Go binaries linked externally.
+  if (!go_build_id.empty()) {
+    return go_build_id;
+  }
+
+  return error::NotFound("No build-id found in binary=$0", binary_path.string());
+}
+
 namespace {
 
 /**
@@ -442,6 +708,8 @@ bool IsRetInst(uint8_t code) {
   return code == kRetn || code == kRetf || code == kRetnImm || code == kRetfImm;
 }
 
+}  // namespace
+
 std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
   if (byte_code.empty()) {
     return {};
@@ -481,8 +749,6 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
   return res;
 }
 
-}  // namespace
-
 StatusOr<std::vector<uint64_t>> ElfReader::FuncRetInstAddrs(const SymbolInfo& func_symbol) {
   constexpr std::string_view kDotText = ".text";
   PL_ASSIGN_OR_RETURN(utils::u8string byte_code, SymbolByteCode(kDotText, func_symbol));
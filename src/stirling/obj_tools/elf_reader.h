@@ -23,8 +23,8 @@
 #include <string>
 #include <vector>
 
-#include <absl/container/btree_map.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/types/span.h>
 
 #include <elfio/elfio.hpp>
 
@@ -116,27 +116,76 @@ class ElfReader {
    */
   StatusOr<std::optional<std::string>> InstrAddrToSymbol(size_t addr);
 
+  /**
+   * A compact symbol table that resolves addresses to function names.
+   *
+   * Symbols are stored as a struct-of-arrays sorted by address, with all names packed into a
+   * single string arena, so that a lookup only touches the address array until the match is found.
+   */
   class Symbolizer {
    public:
     /**
      * Associate the address range [addr, addr+size] with the provided symbol name.
      * No checking is performed for overlapping regions, which will result in undefined behavior.
+     * If multiple symbols have the same address, the first one added is kept.
+     *
+     * Entries can be added in any order, but Finalize() must be called after the last one,
+     * before performing any lookups.
+     */
+    void AddEntry(uintptr_t addr, size_t size, std::string_view name);
+
+    /**
+     * Sorts the entries by address, and releases the spare capacity of the table.
      */
-    void AddEntry(uintptr_t addr, size_t size, std::string name);
+    void Finalize();
 
     /**
      * Lookup the symbol for the specified address.
      */
     std::string_view Lookup(uintptr_t addr) const;
 
+    /**
+     * Looks up the symbols for a batch of addresses, which must be sorted in ascending order.
+     * The table and the addresses are walked in a single merged pass, which is much cheaper than
+     * an independent binary search per address when the addresses are clustered, as is typical
+     * for the addresses in a batch of stack traces.
+     *
+     * @param addrs The addresses to look up, in ascending order.
+     * @param symbols Populated with one symbol per address; empty if the address is unknown.
+     */
+    void LookupSorted(absl::Span<const uintptr_t> addrs,
+                      std::vector<std::string_view>* symbols) const;
+
+    /**
+     * Serializes the symbol table into a compact binary blob, so it can be persisted and later
+     * restored with Deserialize(), without having to re-read the ELF file.
+     */
+    std::string Serialize() const;
+
+    static StatusOr<std::unique_ptr<Symbolizer>> Deserialize(std::string_view data);
+
+    size_t size() const { return addrs_.size(); }
+
    private:
-    struct SymbolAddrInfo {
-      size_t size;
-      std::string name;
-    };
+    std::string_view name(size_t i) const {
+      return std::string_view(names_).substr(name_offsets_[i],
+                                              name_offsets_[i + 1] - name_offsets_[i]);
+    }
+
+    // Returns true if addr falls into the range of the i-th symbol.
+    bool Contains(size_t i, uintptr_t addr) const {
+      return addr >= addrs_[i] && addr < addrs_[i] + sizes_[i];
+    }
 
-    // Key is an address.
-    absl::btree_map<uintptr_t, SymbolAddrInfo> symbols_;
+    // The i-th symbol starts at addrs_[i], has size sizes_[i], and its name is
+    // names_[name_offsets_[i], name_offsets_[i+1]).
+    std::vector<uintptr_t> addrs_;
+    std::vector<uint64_t> sizes_;
+    std::vector<uint32_t> name_offsets_ = {0};
+    std::string names_;
+
+    // Whether addrs_ is strictly increasing, i.e. whether Finalize() has anything to do.
+    bool sorted_ = true;
   };
 
   StatusOr<std::unique_ptr<Symbolizer>> GetSymbolizer();
@@ -178,6 +227,22 @@ class ElfReader {
   ELFIO::elfio elf_reader_;
 };
 
+/**
+ * Returns the offsets of the return instructions in the byte code of an x86-64 function.
+ */
+std::vector<uint64_t> FindRetInsts(px::utils::u8string_view byte_code);
+
+/**
+ * Returns the GNU build-id of the ELF binary, as a lowercase hex string.
+ * For Go binaries linked without one, the Go build-id (also hex encoded) is returned instead,
+ * unless it was replaced by a constant placeholder.
+ * Only the ELF and program headers, and the PT_NOTE segments are read, so this is much cheaper
+ * than creating an ElfReader, and can be used to identify a binary before deciding to analyze it.
+ *
+ * @return NotFound error if the binary has no build-id note.
+ */
+StatusOr<std::string> ReadBuildID(const std::filesystem::path& binary_path);
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+
+#include "src/common/base/base.h"
+#include "src/common/testing/test_environment.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+
+using px::stirling::obj_tools::ElfReader;
+using px::testing::BazelBinTestFilePath;
+
+// NOTE: This benchmark only works with `-c opt`, but that's how we want it to run anyways.
+constexpr std::string_view kBinary =
+    "src/stirling/testing/demo_apps/go_grpc_tls_pl/server/server_/server";
+
+// Builds a symbol table resembling that of a large binary: num_symbols functions, laid out
+// back-to-back, with names of typical demangled C++ length.
+std::unique_ptr<ElfReader::Symbolizer> SyntheticSymbolizer(size_t num_symbols) {
+  std::mt19937 rng(37);
+  std::uniform_int_distribution<size_t> size_dist(16, 1024);
+
+  auto symbolizer = std::make_unique<ElfReader::Symbolizer>();
+  uintptr_t addr = 0x400000;
+  for (size_t i = 0; i < num_symbols; ++i) {
+    const size_t size = size_dist(rng);
+    symbolizer->AddEntry(addr, size,
+                         absl::Substitute("px::stirling::SomeNamespace::SomeClass$0::Method$0("
+                                          "std::string_view, int) const",
+                                          i));
+    addr += size;
+  }
+  symbolizer->Finalize();
+  return symbolizer;
+}
+
+// Addresses as they appear in a batch of stack traces: a working set of hot functions,
+// each sampled at a few different instructions.
+std::vector<uintptr_t> SampleAddrs(size_t num_symbols, size_t num_addrs) {
+  constexpr size_t kHotFunctions = 2000;
+  constexpr size_t kAvgSymbolSize = 520;
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uintptr_t> hot_dist(0, kHotFunctions - 1);
+  std::uniform_int_distribution<uintptr_t> offset_dist(0, kAvgSymbolSize);
+  const uintptr_t stride = num_symbols / kHotFunctions * kAvgSymbolSize;
+
+  std::vector<uintptr_t> addrs;
+  addrs.reserve(num_addrs);
+  for (size_t i = 0; i < num_addrs; ++i) {
+    addrs.push_back(0x400000 + hot_dist(rng) * stride + offset_dist(rng));
+  }
+  return addrs;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_get_symbolizer(benchmark::State& state) {
+  for (auto _ : state) {
+    PL_ASSIGN_OR_EXIT(std::unique_ptr<ElfReader> elf_reader,
+                      ElfReader::Create(BazelBinTestFilePath(kBinary)));
+    PL_ASSIGN_OR_EXIT(std::unique_ptr<ElfReader::Symbolizer> symbolizer,
+                      elf_reader->GetSymbolizer());
+    benchmark::DoNotOptimize(symbolizer);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_lookup(benchmark::State& state) {
+  const size_t num_symbols = state.range(0);
+  const size_t num_addrs = state.range(1);
+  std::unique_ptr<ElfReader::Symbolizer> symbolizer = SyntheticSymbolizer(num_symbols);
+  const std::vector<uintptr_t> addrs = SampleAddrs(num_symbols, num_addrs);
+
+  for (auto _ : state) {
+    for (const uintptr_t addr : addrs) {
+      benchmark::DoNotOptimize(symbolizer->Lookup(addr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_addrs);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_lookup_sorted(benchmark::State& state) {
+  const size_t num_symbols = state.range(0);
+  const size_t num_addrs = state.range(1);
+  std::unique_ptr<ElfReader::Symbolizer> symbolizer = SyntheticSymbolizer(num_symbols);
+  const std::vector<uintptr_t> addrs = SampleAddrs(num_symbols, num_addrs);
+
+  std::vector<uintptr_t> sorted_addrs;
+  std::vector<std::string_view> symbols;
+  for (auto _ : state) {
+    // Sorting is part of the cost of a batch lookup.
+    sorted_addrs = addrs;
+    std::sort(sorted_addrs.begin(), sorted_addrs.end());
+    symbolizer->LookupSorted(sorted_addrs, &symbols);
+    benchmark::DoNotOptimize(symbols);
+  }
+  state.SetItemsProcessed(state.iterations() * num_addrs);
+}
+
+// 200k symbols is typical of a large Go binary; 1M is in the range of Chrome.
+BENCHMARK(BM_get_symbolizer)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_lookup)
+    ->Args({200'000, 1'000})
+    ->Args({200'000, 100'000})
+    ->Args({1'000'000, 1'000})
+    ->Args({1'000'000, 100'000});
+BENCHMARK(BM_lookup_sorted)
+    ->Args({200'000, 1'000})
+    ->Args({200'000, 100'000})
+    ->Args({1'000'000, 1'000})
+    ->Args({1'000'000, 100'000});
@@ -19,6 +19,7 @@
 #include "src/stirling/obj_tools/elf_reader.h"
 
 #include "src/common/exec/exec.h"
+#include "src/common/testing/temp_dir.h"
 #include "src/common/testing/test_environment.h"
 #include "src/common/testing/testing.h"
 #include "src/stirling/obj_tools/testdata/cc/test_exe_fixture.h"
@@ -36,6 +37,7 @@ using ::testing::Field;
 using ::testing::IsEmpty;
 using ::testing::Pair;
 using ::testing::SizeIs;
+using ::testing::StartsWith;
 using ::testing::UnorderedElementsAre;
 
 using ::px::operator<<;
@@ -251,6 +253,113 @@ TEST(ElfReaderTest, GolangAppRuntimeBuildVersion) {
   EXPECT_EQ(symbol.type, ELFIO::STT_OBJECT);
 }
 
+TEST(ElfReaderTest, ReadBuildID) {
+  const std::string stripped_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/stripped_test_exe");
+  EXPECT_OK_AND_EQ(ReadBuildID(stripped_bin), "7deb0e3f89deba61");
+
+  // This binary was linked without a build-id.
+  const std::string prebuilt_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/prebuilt_test_exe");
+  EXPECT_NOT_OK(ReadBuildID(prebuilt_bin));
+
+  // Go binaries carry their own build-id note.
+  const std::string go_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/go/test_go_1_17_binary");
+  ASSERT_OK_AND_ASSIGN(std::string go_build_id, ReadBuildID(go_bin));
+  EXPECT_THAT(go_build_id, StartsWith("7071474a4769735636"));
+
+  EXPECT_NOT_OK(ReadBuildID("/bogus"));
+}
+
+TEST(ElfReaderTest, ReadBuildIDSkipsMalformedNotes) {
+  auto append_int = [](auto val, std::string* out) {
+    char bytes[sizeof(val)];
+    utils::IntToLEndianBytes(val, bytes);
+    out->append(bytes, sizeof(val));
+  };
+  auto append_note_phdr = [&append_int](uint64_t offset, uint64_t size, std::string* out) {
+    append_int(uint32_t{4} /* PT_NOTE */, out);
+    append_int(uint32_t{0}, out);
+    append_int(offset, out);
+    out->append(16, '\0');
+    append_int(size, out);
+    out->append(16, '\0');
+  };
+
+  // A minimal ELF64 file with two note segments. The first one claims a name that is longer
+  // than the segment; the second one holds a GNU build-id.
+  std::string elf("\x7f" "ELF\x02\x01", 6);
+  elf.resize(32, '\0');
+  append_int(uint64_t{64} /* e_phoff */, &elf);
+  elf.resize(54, '\0');
+  append_int(uint16_t{56} /* e_phentsize */, &elf);
+  append_int(uint16_t{2} /* e_phnum */, &elf);
+  elf.resize(64, '\0');
+  append_note_phdr(176, 12, &elf);
+  append_note_phdr(188, 20, &elf);
+  for (uint32_t val : {1000, 4, 3}) {
+    append_int(val, &elf);
+  }
+  for (uint32_t val : {4, 4, 3}) {
+    append_int(val, &elf);
+  }
+  elf.append("GNU\0\xde\xad\xbe\xef", 8);
+
+  px::testing::TempDir tmp_dir;
+  const std::filesystem::path path = tmp_dir.path() / "malformed_note";
+  ASSERT_OK(WriteFileFromString(path, elf));
+  EXPECT_OK_AND_EQ(ReadBuildID(path), "deadbeef");
+}
+
+TEST(ElfReaderTest, SymbolizerLookup) {
+  ElfReader::Symbolizer symbolizer;
+  // Out of order, and with an alias, like a real symbol table.
+  symbolizer.AddEntry(0x2000, 0x10, "bar");
+  symbolizer.AddEntry(0x1000, 0x100, "foo");
+  symbolizer.AddEntry(0x3000, 0x20, "baz");
+  symbolizer.AddEntry(0x2000, 0x10, "bar_alias");
+  symbolizer.Finalize();
+
+  EXPECT_EQ(symbolizer.size(), 3);
+  EXPECT_EQ(symbolizer.Lookup(0x1000), "foo");
+  EXPECT_EQ(symbolizer.Lookup(0x10ff), "foo");
+  EXPECT_EQ(symbolizer.Lookup(0x1100), "0x0000000000001100");
+  EXPECT_EQ(symbolizer.Lookup(0x2008), "bar");
+  EXPECT_EQ(symbolizer.Lookup(0x301f), "baz");
+  EXPECT_EQ(symbolizer.Lookup(0xfff), "0x0000000000000fff");
+
+  const std::vector<uintptr_t> addrs = {0x0,    0x1000, 0x1001, 0x1100,
+                                        0x2000, 0x2000, 0x300f, 0x4000};
+  std::vector<std::string_view> symbols;
+  symbolizer.LookupSorted(addrs, &symbols);
+  EXPECT_THAT(symbols, ElementsAre("", "foo", "foo", "", "bar", "bar", "baz", ""));
+}
+
+TEST(ElfReaderTest, SymbolizerSerializeRoundTrip) {
+  const std::string path =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/prebuilt_test_exe");
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(path));
+  ASSERT_OK_AND_ASSIGN(ElfReader::SymbolInfo symbol,
+                       elf_reader->SearchTheOnlySymbol("CanYouFindThis"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader::Symbolizer> symbolizer,
+                       elf_reader->GetSymbolizer());
+
+  const std::string serialized = symbolizer->Serialize();
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader::Symbolizer> restored,
+                       ElfReader::Symbolizer::Deserialize(serialized));
+
+  EXPECT_EQ(restored->size(), symbolizer->size());
+  EXPECT_EQ(restored->Lookup(symbol.address), "CanYouFindThis");
+  EXPECT_EQ(restored->Lookup(symbol.address + 1), "CanYouFindThis");
+  EXPECT_EQ(restored->Lookup(2), "0x0000000000000002");
+  EXPECT_EQ(restored->Serialize(), serialized);
+
+  // Corrupted or truncated blobs are rejected.
+  EXPECT_NOT_OK(ElfReader::Symbolizer::Deserialize(serialized.substr(0, serialized.size() - 1)));
+  EXPECT_NOT_OK(ElfReader::Symbolizer::Deserialize(absl::StrCat("bogus", serialized.substr(5))));
+}
+
 // Tests that the versioned symbol names always include version strings.
 TEST(ElfReaderTest, VersionedSymbolsInDynamicLibrary) {
   const std::string kPath =
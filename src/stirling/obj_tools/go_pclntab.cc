@@ -0,0 +1,424 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/go_pclntab.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "src/common/base/byte_utils.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+namespace {
+
+// Offsets within the ELF64 header, section header and program header.
+// See https://refspecs.linuxfoundation.org/elf/gabi4+/ch4.eheader.html.
+constexpr size_t kEhdrSize = 64;
+constexpr size_t kEIClassOffset = 4;
+constexpr size_t kEIDataOffset = 5;
+constexpr char kELFClass64 = 2;
+constexpr char kELFDataLSB = 1;
+constexpr size_t kPhoffOffset = 32;
+constexpr size_t kShoffOffset = 40;
+constexpr size_t kPhentsizeOffset = 54;
+constexpr size_t kPhnumOffset = 56;
+constexpr size_t kShentsizeOffset = 58;
+constexpr size_t kShnumOffset = 60;
+constexpr size_t kShstrndxOffset = 62;
+
+constexpr size_t kPhdrSize = 56;
+constexpr size_t kPTypeOffset = 0;
+constexpr size_t kPFlagsOffset = 4;
+constexpr size_t kPOffsetOffset = 8;
+constexpr size_t kPVaddrOffset = 16;
+constexpr size_t kPFileszOffset = 32;
+constexpr uint32_t kPTLoad = 1;
+constexpr uint32_t kPFExec = 1;
+
+constexpr size_t kShdrSize = 64;
+constexpr size_t kShNameOffset = 0;
+constexpr size_t kShAddrOffset = 16;
+constexpr size_t kShOffsetOffset = 24;
+constexpr size_t kShSizeOffset = 32;
+
+// The magic numbers at the start of the pclntab, one per format.
+// See https://github.com/golang/go/blob/master/src/debug/gosym/pclntab.go.
+enum class PCLNTabVersion {
+  kGo12,
+  kGo116,
+  kGo118,
+  kGo120,
+};
+constexpr uint32_t kGo12Magic = 0xfffffffb;
+constexpr uint32_t kGo116Magic = 0xfffffffa;
+constexpr uint32_t kGo118Magic = 0xfffffff0;
+constexpr uint32_t kGo120Magic = 0xfffffff1;
+
+constexpr size_t kPtrSize = 8;
+// The pclntab header is the magic, two zero bytes, the instruction size quantum and the pointer
+// size, followed by pointer-sized fields.
+constexpr size_t kPCLNTabHeaderSize = 8;
+
+// Reads a little-endian integer at the offset, with bounds checking.
+template <typename TIntType>
+StatusOr<TIntType> ReadInt(std::string_view data, uint64_t offset) {
+  if (offset > data.size() || data.size() - offset < sizeof(TIntType)) {
+    return error::InvalidArgument("Cannot read $0 bytes at offset $1 out of $2 bytes.",
+                                  sizeof(TIntType), offset, data.size());
+  }
+  return utils::LEndianBytesToInt<TIntType>(data.substr(offset));
+}
+
+// Returns the NUL-terminated string at the offset.
+StatusOr<std::string_view> ReadCString(std::string_view data, uint64_t offset) {
+  if (offset >= data.size()) {
+    return error::InvalidArgument("String offset $0 is out of $1 bytes.", offset, data.size());
+  }
+  data.remove_prefix(offset);
+  const size_t len = data.find('\0');
+  if (len == std::string_view::npos) {
+    return error::InvalidArgument("String at offset $0 is not terminated.", offset);
+  }
+  return data.substr(0, len);
+}
+
+StatusOr<PCLNTabVersion> ReadPCLNTabVersion(std::string_view pclntab) {
+  PL_ASSIGN_OR_RETURN(uint32_t magic, ReadInt<uint32_t>(pclntab, 0));
+  PL_ASSIGN_OR_RETURN(uint16_t pad, ReadInt<uint16_t>(pclntab, 4));
+  PL_ASSIGN_OR_RETURN(uint8_t quantum, ReadInt<uint8_t>(pclntab, 6));
+  PL_ASSIGN_OR_RETURN(uint8_t ptr_size, ReadInt<uint8_t>(pclntab, 7));
+  if (pad != 0 || (quantum != 1 && quantum != 2 && quantum != 4) || ptr_size != kPtrSize) {
+    return error::InvalidArgument("Unsupported pclntab header.");
+  }
+  switch (magic) {
+    case kGo12Magic:
+      return PCLNTabVersion::kGo12;
+    case kGo116Magic:
+      return PCLNTabVersion::kGo116;
+    case kGo118Magic:
+      return PCLNTabVersion::kGo118;
+    case kGo120Magic:
+      return PCLNTabVersion::kGo120;
+    default:
+      return error::InvalidArgument("Unknown pclntab magic $0.", magic);
+  }
+}
+
+// Returns the pointer-sized field of the pclntab header at the index.
+StatusOr<uint64_t> HeaderField(std::string_view pclntab, int idx) {
+  return ReadInt<uint64_t>(pclntab, kPCLNTabHeaderSize + idx * kPtrSize);
+}
+
+// Returns the pclntab[offset:], with bounds checking.
+StatusOr<std::string_view> SubTable(std::string_view pclntab, uint64_t offset) {
+  if (offset > pclntab.size()) {
+    return error::InvalidArgument("Table offset $0 is out of $1 bytes.", offset, pclntab.size());
+  }
+  return pclntab.substr(offset);
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<GoPCLNTab>> GoPCLNTab::Create(const std::string& binary_path) {
+  auto pclntab = std::unique_ptr<GoPCLNTab>(new GoPCLNTab);
+  pclntab->binary_path_ = binary_path;
+
+  const int fd = open(binary_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open binary=$0 [errno=$1]", binary_path, errno);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kEhdrSize)) {
+    close(fd);
+    return error::InvalidArgument("Not an ELF file, binary=$0", binary_path);
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to mmap binary=$0 [errno=$1]", binary_path, errno);
+  }
+  pclntab->data_ = static_cast<const char*>(data);
+  pclntab->size_ = st.st_size;
+
+  PL_RETURN_IF_ERROR(pclntab->Init());
+  return pclntab;
+}
+
+GoPCLNTab::~GoPCLNTab() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+Status GoPCLNTab::Init() {
+  const std::string_view file(data_, size_);
+
+  if (file.substr(0, 4) != "\x7f" "ELF") {
+    return error::InvalidArgument("Not an ELF file, binary=$0", binary_path_);
+  }
+  if (file[kEIClassOffset] != kELFClass64 || file[kEIDataOffset] != kELFDataLSB) {
+    return error::Unimplemented("Only 64-bit little-endian ELF files are supported, binary=$0",
+                                binary_path_);
+  }
+
+  PL_ASSIGN_OR_RETURN(uint64_t phoff, ReadInt<uint64_t>(file, kPhoffOffset));
+  PL_ASSIGN_OR_RETURN(uint16_t phentsize, ReadInt<uint16_t>(file, kPhentsizeOffset));
+  PL_ASSIGN_OR_RETURN(uint16_t phnum, ReadInt<uint16_t>(file, kPhnumOffset));
+  if (phentsize < kPhdrSize) {
+    return error::InvalidArgument("Unexpected program header size $0, binary=$1", phentsize,
+                                  binary_path_);
+  }
+  std::vector<LoadSegment> read_only_segments;
+  for (uint16_t i = 0; i < phnum; ++i) {
+    const uint64_t phdr = phoff + i * phentsize;
+    PL_ASSIGN_OR_RETURN(uint32_t type, ReadInt<uint32_t>(file, phdr + kPTypeOffset));
+    if (type != kPTLoad) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(uint32_t flags, ReadInt<uint32_t>(file, phdr + kPFlagsOffset));
+    LoadSegment segment;
+    PL_ASSIGN_OR_RETURN(segment.offset, ReadInt<uint64_t>(file, phdr + kPOffsetOffset));
+    PL_ASSIGN_OR_RETURN(segment.vaddr, ReadInt<uint64_t>(file, phdr + kPVaddrOffset));
+    PL_ASSIGN_OR_RETURN(segment.filesz, ReadInt<uint64_t>(file, phdr + kPFileszOffset));
+    if (segment.offset > size_ || size_ - segment.offset < segment.filesz) {
+      return error::InvalidArgument("Segment exceeds the file, binary=$0", binary_path_);
+    }
+    load_segments_.push_back(segment);
+    if ((flags & kPFExec) == 0) {
+      read_only_segments.push_back(segment);
+    }
+  }
+
+  // Look up the .gopclntab and .text sections, if the section headers are present.
+  std::string_view pclntab;
+  uint64_t text_start = 0;
+  PL_ASSIGN_OR_RETURN(uint64_t shoff, ReadInt<uint64_t>(file, kShoffOffset));
+  PL_ASSIGN_OR_RETURN(uint16_t shentsize, ReadInt<uint16_t>(file, kShentsizeOffset));
+  PL_ASSIGN_OR_RETURN(uint16_t shnum, ReadInt<uint16_t>(file, kShnumOffset));
+  PL_ASSIGN_OR_RETURN(uint16_t shstrndx, ReadInt<uint16_t>(file, kShstrndxOffset));
+  if (shoff != 0 && shentsize >= kShdrSize && shstrndx < shnum) {
+    const uint64_t shstrtab_hdr = shoff + shstrndx * shentsize;
+    PL_ASSIGN_OR_RETURN(uint64_t shstrtab_offset,
+                        ReadInt<uint64_t>(file, shstrtab_hdr + kShOffsetOffset));
+    for (uint16_t i = 0; i < shnum; ++i) {
+      const uint64_t shdr = shoff + i * shentsize;
+      PL_ASSIGN_OR_RETURN(uint32_t name_offset, ReadInt<uint32_t>(file, shdr + kShNameOffset));
+      StatusOr<std::string_view> name = ReadCString(file, shstrtab_offset + name_offset);
+      if (!name.ok()) {
+        continue;
+      }
+      if (name.ValueOrDie() == ".gopclntab") {
+        PL_ASSIGN_OR_RETURN(uint64_t offset, ReadInt<uint64_t>(file, shdr + kShOffsetOffset));
+        PL_ASSIGN_OR_RETURN(uint64_t size, ReadInt<uint64_t>(file, shdr + kShSizeOffset));
+        if (offset > size_ || size_ - offset < size) {
+          return error::InvalidArgument(".gopclntab exceeds the file, binary=$0", binary_path_);
+        }
+        pclntab = file.substr(offset, size);
+      } else if (name.ValueOrDie() == ".text") {
+        PL_ASSIGN_OR_RETURN(text_start, ReadInt<uint64_t>(file, shdr + kShAddrOffset));
+      }
+    }
+  }
+
+  if (!pclntab.empty()) {
+    return DecodeFuncTab(pclntab, text_start);
+  }
+
+  // Without section headers, search the read-only data for a pclntab header, as the Go
+  // debug/gosym package does. The candidates are validated by decoding them.
+  for (const auto& segment : read_only_segments) {
+    const std::string_view contents = file.substr(segment.offset, segment.filesz);
+    for (uint32_t magic : {kGo120Magic, kGo118Magic, kGo116Magic, kGo12Magic}) {
+      char magic_bytes[4];
+      utils::IntToLEndianBytes(magic, magic_bytes);
+      const std::string_view needle(magic_bytes, sizeof(magic_bytes));
+      // The pclntab is pointer-aligned.
+      for (size_t pos = contents.find(needle); pos != std::string_view::npos;
+           pos = contents.find(needle, pos + 1)) {
+        if (pos % kPtrSize != 0) {
+          continue;
+        }
+        funcs_.clear();
+        if (DecodeFuncTab(contents.substr(pos), text_start).ok()) {
+          return Status::OK();
+        }
+      }
+    }
+  }
+  funcs_.clear();
+  return error::NotFound("Could not find the pclntab, binary=$0", binary_path_);
+}
+
+Status GoPCLNTab::DecodeFuncTab(std::string_view pclntab, uint64_t text_start) {
+  PL_ASSIGN_OR_RETURN(PCLNTabVersion version, ReadPCLNTabVersion(pclntab));
+  PL_ASSIGN_OR_RETURN(uint64_t nfunc, HeaderField(pclntab, 0));
+
+  // The function table has nfunc (entry, funcoff) pairs, followed by the end of the last function.
+  // Before Go 1.18, the fields are pointer-sized, and the entries are absolute addresses.
+  // From Go 1.18, the fields are 32-bit, and the entries are offsets from the start of the text.
+  std::string_view funcnametab;
+  std::string_view functab;
+  std::string_view funcdata;
+  size_t field_size = kPtrSize;
+  switch (version) {
+    case PCLNTabVersion::kGo12: {
+      funcnametab = pclntab;
+      PL_ASSIGN_OR_RETURN(functab, SubTable(pclntab, kPCLNTabHeaderSize + kPtrSize));
+      funcdata = pclntab;
+      break;
+    }
+    case PCLNTabVersion::kGo116: {
+      PL_ASSIGN_OR_RETURN(uint64_t funcname_offset, HeaderField(pclntab, 2));
+      PL_ASSIGN_OR_RETURN(uint64_t pcln_offset, HeaderField(pclntab, 6));
+      PL_ASSIGN_OR_RETURN(funcnametab, SubTable(pclntab, funcname_offset));
+      PL_ASSIGN_OR_RETURN(functab, SubTable(pclntab, pcln_offset));
+      funcdata = functab;
+      break;
+    }
+    case PCLNTabVersion::kGo118:
+    case PCLNTabVersion::kGo120: {
+      // The text start in the header may be left for the loader to relocate (e.g. in PIE
+      // binaries), so prefer the address of the .text section.
+      if (text_start == 0) {
+        PL_ASSIGN_OR_RETURN(text_start, HeaderField(pclntab, 2));
+      }
+      if (text_start == 0) {
+        return error::InvalidArgument("Unknown text start address, binary=$0", binary_path_);
+      }
+      PL_ASSIGN_OR_RETURN(uint64_t funcname_offset, HeaderField(pclntab, 3));
+      PL_ASSIGN_OR_RETURN(uint64_t pcln_offset, HeaderField(pclntab, 7));
+      PL_ASSIGN_OR_RETURN(funcnametab, SubTable(pclntab, funcname_offset));
+      PL_ASSIGN_OR_RETURN(functab, SubTable(pclntab, pcln_offset));
+      funcdata = functab;
+      field_size = sizeof(uint32_t);
+      break;
+    }
+  }
+
+  if (nfunc > functab.size() / (2 * field_size)) {
+    return error::InvalidArgument("Function count $0 exceeds the function table, binary=$1",
+                                  nfunc, binary_path_);
+  }
+
+  auto read_field = [&functab, field_size](uint64_t offset) -> StatusOr<uint64_t> {
+    if (field_size == sizeof(uint32_t)) {
+      return ReadInt<uint32_t>(functab, offset);
+    }
+    return ReadInt<uint64_t>(functab, offset);
+  };
+  // Before Go 1.18 entries are absolute, so relocating them is a no-op.
+  const uint64_t entry_base = field_size == sizeof(uint32_t) ? text_start : 0;
+
+  funcs_.clear();
+  funcs_.reserve(nfunc);
+  PL_ASSIGN_OR_RETURN(uint64_t entry, read_field(0));
+  for (uint64_t i = 0; i < nfunc; ++i) {
+    PL_ASSIGN_OR_RETURN(uint64_t funcoff, read_field((2 * i + 1) * field_size));
+    PL_ASSIGN_OR_RETURN(uint64_t next_entry, read_field((2 * i + 2) * field_size));
+    // The func struct starts with the entry, followed by the 32-bit offset of the name.
+    PL_ASSIGN_OR_RETURN(uint32_t name_offset, ReadInt<uint32_t>(funcdata, funcoff + field_size));
+    PL_ASSIGN_OR_RETURN(std::string_view name, ReadCString(funcnametab, name_offset));
+    if (next_entry < entry) {
+      return error::InvalidArgument("Function table is not sorted, binary=$0", binary_path_);
+    }
+    funcs_.push_back({name, entry_base + entry, entry_base + next_entry});
+    entry = next_entry;
+  }
+
+  func_index_.clear();
+  func_index_.reserve(funcs_.size());
+  for (size_t i = 0; i < funcs_.size(); ++i) {
+    func_index_.emplace(funcs_[i].name, i);
+  }
+  return Status::OK();
+}
+
+const GoPCLNTab::FuncInfo* GoPCLNTab::FindFunc(std::string_view name) const {
+  auto iter = func_index_.find(name);
+  if (iter == func_index_.end()) {
+    return nullptr;
+  }
+  return &funcs_[iter->second];
+}
+
+StatusOr<std::vector<ElfReader::SymbolInfo>> GoPCLNTab::ListFuncSymbols(
+    std::string_view search_symbol, SymbolMatchType match_type) const {
+  auto to_symbol_info = [](const FuncInfo& func) {
+    ElfReader::SymbolInfo symbol_info;
+    symbol_info.name = std::string(func.name);
+    symbol_info.type = ELFIO::STT_FUNC;
+    symbol_info.address = func.entry;
+    symbol_info.size = func.end - func.entry;
+    return symbol_info;
+  };
+
+  std::vector<ElfReader::SymbolInfo> symbol_infos;
+  if (match_type == SymbolMatchType::kExact) {
+    const FuncInfo* func = FindFunc(search_symbol);
+    if (func != nullptr) {
+      symbol_infos.push_back(to_symbol_info(*func));
+    }
+    return symbol_infos;
+  }
+
+  const SymbolSearchPattern pattern = {match_type, search_symbol};
+  for (const auto& func : funcs_) {
+    if (MatchesSymbol(func.name, pattern)) {
+      symbol_infos.push_back(to_symbol_info(func));
+    }
+  }
+  return symbol_infos;
+}
+
+std::string_view GoPCLNTab::VirtualAddrData(uint64_t addr, uint64_t size) const {
+  for (const auto& segment : load_segments_) {
+    if (addr >= segment.vaddr && addr - segment.vaddr <= segment.filesz &&
+        segment.filesz - (addr - segment.vaddr) >= size) {
+      return std::string_view(data_ + segment.offset + (addr - segment.vaddr), size);
+    }
+  }
+  return {};
+}
+
+StatusOr<std::vector<uint64_t>> GoPCLNTab::FuncRetInstAddrs(
+    const ElfReader::SymbolInfo& func_symbol) const {
+  const std::string_view byte_code = VirtualAddrData(func_symbol.address, func_symbol.size);
+  if (byte_code.empty()) {
+    return error::NotFound("Function $0 at address $1 is not in the file, binary=$2",
+                           func_symbol.name, func_symbol.address, binary_path_);
+  }
+  std::vector<uint64_t> addrs = FindRetInsts(utils::u8string_view(
+      reinterpret_cast<const uint8_t*>(byte_code.data()), byte_code.size()));
+  for (auto& offset : addrs) {
+    offset += func_symbol.address;
+  }
+  return addrs;
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+/**
+ * GoPCLNTab reads the function table of a Go binary from its pclntab, the table that the Go
+ * runtime itself uses to produce stack traces. It is a lightweight alternative to ElfReader for
+ * the function queries needed by the Go uprobes:
+ *  - The binary is memory-mapped, and only the function table is decoded. Function names point
+ *    into the mapping, so nothing is copied.
+ *  - The pclntab survives stripping (e.g. go build -ldflags="-s -w"), unlike the ELF symbol
+ *    table.
+ *
+ * Supports the pclntab formats of Go 1.2 and later, on 64-bit little-endian binaries.
+ * Only Go functions are listed; C functions linked in through cgo are not in the pclntab.
+ */
+class GoPCLNTab : public NotCopyMoveable {
+ public:
+  /**
+   * Memory-maps the binary, and decodes its function table.
+   * @return error if the binary is not a Go binary, or its pclntab cannot be decoded.
+   */
+  static StatusOr<std::unique_ptr<GoPCLNTab>> Create(const std::string& binary_path);
+
+  ~GoPCLNTab();
+
+  struct FuncInfo {
+    // Points into the memory-mapped binary.
+    std::string_view name;
+    uint64_t entry;
+    // The entry of the next function, which includes any padding after the function.
+    uint64_t end;
+  };
+
+  /**
+   * Returns the functions whose names match the search criteria, in the same form as
+   * ElfReader::ListFuncSymbols(), so the two can be used interchangeably for Go binaries.
+   */
+  StatusOr<std::vector<ElfReader::SymbolInfo>> ListFuncSymbols(std::string_view search_symbol,
+                                                               SymbolMatchType match_type) const;
+
+  /**
+   * Returns the function with the exact name, if any.
+   */
+  const FuncInfo* FindFunc(std::string_view name) const;
+
+  /**
+   * Returns the address of the return instructions of the function.
+   * The byte code is read straight out of the mapping.
+   */
+  StatusOr<std::vector<uint64_t>> FuncRetInstAddrs(const ElfReader::SymbolInfo& func_symbol) const;
+
+  const std::vector<FuncInfo>& funcs() const { return funcs_; }
+
+ private:
+  GoPCLNTab() = default;
+
+  // Locates the pclntab, and decodes the function table out of it.
+  Status Init();
+  Status DecodeFuncTab(std::string_view pclntab, uint64_t text_start);
+
+  // Returns the contents of the file at the virtual address, or an empty view if it is not
+  // backed by the file.
+  std::string_view VirtualAddrData(uint64_t addr, uint64_t size) const;
+
+  std::string binary_path_;
+
+  // The memory-mapped binary.
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+
+  struct LoadSegment {
+    uint64_t vaddr;
+    uint64_t offset;
+    uint64_t filesz;
+  };
+  std::vector<LoadSegment> load_segments_;
+
+  // Sorted by entry.
+  std::vector<FuncInfo> funcs_;
+  absl::flat_hash_map<std::string_view, size_t> func_index_;
+};
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "src/common/base/base.h"
+#include "src/common/testing/test_environment.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/obj_tools/go_pclntab.h"
+
+using px::stirling::obj_tools::ElfReader;
+using px::stirling::obj_tools::GoPCLNTab;
+using px::stirling::obj_tools::SymbolMatchType;
+using px::testing::BazelBinTestFilePath;
+
+// NOTE: This benchmark only works with `-c opt`, but that's how we want it to run anyways.
+constexpr std::string_view kBinary =
+    "src/stirling/testing/demo_apps/go_grpc_tls_pl/server/server_/server";
+
+// The lookups done to attach the GoTLS uprobes: a suffix match per function, followed by the
+// return instructions of the matches.
+constexpr std::string_view kGoTLSFuncs[] = {"crypto/tls.(*Conn).Write", "crypto/tls.(*Conn).Read"};
+
+template <typename TSymbolReader>
+void FindGoTLSProbeAddrs(TSymbolReader* reader) {
+  for (std::string_view func : kGoTLSFuncs) {
+    PL_ASSIGN_OR_EXIT(std::vector<ElfReader::SymbolInfo> symbol_infos,
+                      reader->ListFuncSymbols(func, SymbolMatchType::kSuffix));
+    for (const auto& symbol_info : symbol_infos) {
+      PL_ASSIGN_OR_EXIT(std::vector<uint64_t> addrs, reader->FuncRetInstAddrs(symbol_info));
+      benchmark::DoNotOptimize(addrs);
+    }
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_elf_reader_create(benchmark::State& state) {
+  for (auto _ : state) {
+    PL_ASSIGN_OR_EXIT(std::unique_ptr<ElfReader> elf_reader,
+                      ElfReader::Create(BazelBinTestFilePath(kBinary)));
+    benchmark::DoNotOptimize(elf_reader);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_pclntab_create(benchmark::State& state) {
+  for (auto _ : state) {
+    PL_ASSIGN_OR_EXIT(std::unique_ptr<GoPCLNTab> pclntab,
+                      GoPCLNTab::Create(BazelBinTestFilePath(kBinary)));
+    benchmark::DoNotOptimize(pclntab);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_elf_reader_go_tls_probes(benchmark::State& state) {
+  PL_ASSIGN_OR_EXIT(std::unique_ptr<ElfReader> elf_reader,
+                    ElfReader::Create(BazelBinTestFilePath(kBinary)));
+  for (auto _ : state) {
+    FindGoTLSProbeAddrs(elf_reader.get());
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_pclntab_go_tls_probes(benchmark::State& state) {
+  PL_ASSIGN_OR_EXIT(std::unique_ptr<GoPCLNTab> pclntab,
+                    GoPCLNTab::Create(BazelBinTestFilePath(kBinary)));
+  for (auto _ : state) {
+    FindGoTLSProbeAddrs(pclntab.get());
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_elf_reader_exact_lookup(benchmark::State& state) {
+  PL_ASSIGN_OR_EXIT(std::unique_ptr<ElfReader> elf_reader,
+                    ElfReader::Create(BazelBinTestFilePath(kBinary)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        elf_reader->ListFuncSymbols("crypto/tls.(*Conn).Write", SymbolMatchType::kExact));
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_pclntab_exact_lookup(benchmark::State& state) {
+  PL_ASSIGN_OR_EXIT(std::unique_ptr<GoPCLNTab> pclntab,
+                    GoPCLNTab::Create(BazelBinTestFilePath(kBinary)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        pclntab->ListFuncSymbols("crypto/tls.(*Conn).Write", SymbolMatchType::kExact));
+  }
+}
+
+BENCHMARK(BM_elf_reader_create)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_pclntab_create)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_elf_reader_go_tls_probes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pclntab_go_tls_probes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_elf_reader_exact_lookup)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pclntab_exact_lookup)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/go_pclntab.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+class GoPCLNTabTest : public ::testing::TestWithParam<std::string_view> {};
+
+// The function table must agree with the ELF symbol table for Go functions.
+TEST_P(GoPCLNTabTest, MatchesElfSymbols) {
+  const std::string path = px::testing::TestFilePath(GetParam());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<GoPCLNTab> pclntab, GoPCLNTab::Create(path));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(path));
+
+  EXPECT_THAT(pclntab->funcs(), Not(IsEmpty()));
+
+  for (const auto& [symbol, match_type] :
+       std::vector<std::pair<std::string_view, SymbolMatchType>>{
+           {"main.main", SymbolMatchType::kExact},
+           {"main.(*Vertex).Scale", SymbolMatchType::kExact},
+           {"Hex", SymbolMatchType::kSuffix},
+           {"main.", SymbolMatchType::kPrefix},
+       }) {
+    ASSERT_OK_AND_ASSIGN(std::vector<ElfReader::SymbolInfo> expected,
+                         elf_reader->ListFuncSymbols(symbol, match_type));
+    ASSERT_OK_AND_ASSIGN(std::vector<ElfReader::SymbolInfo> symbol_infos,
+                         pclntab->ListFuncSymbols(symbol, match_type));
+    ASSERT_THAT(symbol_infos, SizeIs(expected.size())) << symbol;
+
+    std::sort(expected.begin(), expected.end(),
+              [](const auto& a, const auto& b) { return a.address < b.address; });
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(symbol_infos[i].name, expected[i].name);
+      EXPECT_EQ(symbol_infos[i].address, expected[i].address);
+      EXPECT_EQ(symbol_infos[i].type, ELFIO::STT_FUNC);
+      EXPECT_GE(symbol_infos[i].size, expected[i].size);
+
+      // The size from the pclntab also covers the padding after the function, which has no
+      // return instructions.
+      ASSERT_OK_AND_ASSIGN(std::vector<uint64_t> expected_ret_addrs,
+                           elf_reader->FuncRetInstAddrs(expected[i]));
+      EXPECT_OK_AND_EQ(pclntab->FuncRetInstAddrs(symbol_infos[i]), expected_ret_addrs);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    GoVersions, GoPCLNTabTest,
+    ::testing::Values("src/stirling/obj_tools/testdata/go/test_go_1_16_binary",
+                      "src/stirling/obj_tools/testdata/go/test_go_1_17_binary"));
+
+TEST(GoPCLNTabTest, FindFunc) {
+  const std::string path =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/go/test_go_1_17_binary");
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<GoPCLNTab> pclntab, GoPCLNTab::Create(path));
+
+  const GoPCLNTab::FuncInfo* func = pclntab->FindFunc("main.main");
+  ASSERT_NE(func, nullptr);
+  EXPECT_EQ(func->entry, 0x47f940);
+  EXPECT_EQ(func->end, 0x480b00);
+
+  EXPECT_EQ(pclntab->FindFunc("main.NoSuchFunc"), nullptr);
+  ASSERT_OK_AND_THAT(pclntab->ListFuncSymbols("main.NoSuchFunc", SymbolMatchType::kExact),
+                     IsEmpty());
+}
+
+TEST(GoPCLNTabTest, NonGoBinary) {
+  const std::string path =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/prebuilt_test_exe");
+  EXPECT_NOT_OK(GoPCLNTab::Create(path));
+  EXPECT_NOT_OK(GoPCLNTab::Create("/bogus"));
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
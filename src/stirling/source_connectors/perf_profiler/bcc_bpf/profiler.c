@@ -32,6 +32,8 @@
 // 2. histogram: a map from stack-trace-id to observation count.
 // The higher a count, the more we have observed a particular stack-trace,
 // and the more likely something in that stack-trace is a potential perf. issue.
+// Counts are aggregated here, in the histogram map, so user space reads each distinct
+// stack trace once per transfer period, rather than once per sample.
 
 // To keep the stack-trace profiler "always on", we use a double buffering
 // scheme wherein we allocate two of each data structure. Therefore,
@@ -80,8 +82,8 @@ static const uint32_t kNumMapEntries = 4 * kExpectedStackTraces;
 // but it should be lower than kNumMapEntries.
 static const uint32_t kSampleThreshold = 2 * kExpectedStackTraces;
 
-BPF_PERF_OUTPUT(histogram_a);
-BPF_PERF_OUTPUT(histogram_b);
+BPF_HASH(histogram_a, struct stack_trace_key_t, uint64_t, kNumMapEntries);
+BPF_HASH(histogram_b, struct stack_trace_key_t, uint64_t, kNumMapEntries);
 BPF_STACK_TRACE(stack_traces_a, kNumMapEntries);
 BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 
@@ -90,16 +92,26 @@ BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 BPF_ARRAY(profiler_state, uint64_t, kProfilerStateVectorSize);
 
 int sample_call_stack(struct bpf_perf_event_data* ctx) {
+  const uint64_t start_ns = bpf_ktime_get_ns();
+
   int transfer_count_idx = kTransferCountIdx;
   int sample_count_a_idx = kSampleCountAIdx;
-  int sample_count_b_idx = kSampleCountAIdx;
+  int sample_count_b_idx = kSampleCountBIdx;
   int error_status_idx = kErrorStatusIdx;
+  int sample_decimation_a_idx = kSampleDecimationAIdx;
+  int sample_decimation_b_idx = kSampleDecimationBIdx;
+  int bpf_time_ns_idx = kBPFTimeNSIdx;
 
   uint64_t* transfer_count_ptr = profiler_state.lookup(&transfer_count_idx);
   uint64_t* sample_count_a_ptr = profiler_state.lookup(&sample_count_a_idx);
   uint64_t* sample_count_b_ptr = profiler_state.lookup(&sample_count_b_idx);
+  uint64_t* sample_decimation_a_ptr = profiler_state.lookup(&sample_decimation_a_idx);
+  uint64_t* sample_decimation_b_ptr = profiler_state.lookup(&sample_decimation_b_idx);
+  uint64_t* bpf_time_ns_ptr = profiler_state.lookup(&bpf_time_ns_idx);
 
-  if (transfer_count_ptr == NULL || sample_count_a_ptr == NULL || sample_count_b_ptr == NULL) {
+  if (transfer_count_ptr == NULL || sample_count_a_ptr == NULL || sample_count_b_ptr == NULL ||
+      sample_decimation_a_ptr == NULL || sample_decimation_b_ptr == NULL ||
+      bpf_time_ns_ptr == NULL) {
     // One of the map lookups failed.
     // Set the appropriate error bit in the error bitfield:
     uint64_t rd_fail_status_code = kMapReadFailureError;
@@ -109,6 +121,17 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
 
   uint64_t transfer_count = *transfer_count_ptr;
 
+  // User space lowers the effective sampling rate by asking us to keep only 1 out of N samples.
+  // Samples are dropped at random, rather than every N-th, to avoid aliasing with periodic work.
+  // Dropping happens before the expensive stack walk, which is the bulk of the cost.
+  // Each map set has its own decimation, which user space only changes while we write to the
+  // other set, so that all the samples of a set are kept with the same decimation.
+  uint32_t sample_decimation =
+      transfer_count % 2 == 0 ? *sample_decimation_a_ptr : *sample_decimation_b_ptr;
+  if (sample_decimation > 1 && bpf_get_prandom_u32() % sample_decimation != 0) {
+    return 0;
+  }
+
   // Create map key.
   struct stack_trace_key_t key = {};
   key.upid.tgid = bpf_get_current_pid_tgid() >> 32;
@@ -120,7 +143,7 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
     // map set A branch:
     key.user_stack_id = stack_traces_a.get_stackid(&ctx->regs, BPF_F_USER_STACK);
     key.kernel_stack_id = stack_traces_a.get_stackid(&ctx->regs, 0);
-    histogram_a.perf_submit(ctx, &key, sizeof(key));
+    histogram_a.increment(key);
 
     sample_count = *sample_count_a_ptr;
     *sample_count_a_ptr += 1;
@@ -128,7 +151,7 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
     // map set B branch:
     key.user_stack_id = stack_traces_b.get_stackid(&ctx->regs, BPF_F_USER_STACK);
     key.kernel_stack_id = stack_traces_b.get_stackid(&ctx->regs, 0);
-    histogram_b.perf_submit(ctx, &key, sizeof(key));
+    histogram_b.increment(key);
 
     sample_count = *sample_count_b_ptr;
     *sample_count_b_ptr += 1;
@@ -140,8 +163,10 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
   if (sample_count >= kSampleThreshold) {
     uint64_t overflow_status_code = kOverflowError;
     profiler_state.update(&error_status_idx, &overflow_status_code);
-    return 0;
   }
 
+  // Account for the time spent here, so user space can keep the profiler within its budget.
+  lock_xadd(bpf_time_ns_ptr, bpf_ktime_get_ns() - start_ns);
+
   return 0;
 }
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/build_id_symbolizer_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/file.h"
+#include "src/common/fs/fs_wrapper.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::obj_tools::ElfReader;
+
+BuildIDSymbolizerCache::BuildIDSymbolizerCache(std::filesystem::path cache_dir,
+                                               uint64_t max_cache_dir_bytes)
+    : cache_dir_(std::move(cache_dir)), max_cache_dir_bytes_(max_cache_dir_bytes) {
+  if (cache_dir_.empty()) {
+    return;
+  }
+  Status s = fs::CreateDirectories(cache_dir_);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+      "Could not create symbol cache directory $0, symbols will not be persisted [error=$1]",
+      cache_dir_.string(), s.ToString());
+}
+
+StatusOr<std::string> BuildIDSymbolizerCache::BinaryKey(const std::filesystem::path& binary_path) {
+  StatusOr<std::string> build_id = obj_tools::ReadBuildID(binary_path);
+  if (build_id.ok()) {
+    return absl::StrCat("buildid-", build_id.ValueOrDie());
+  }
+
+  struct stat st;
+  if (stat(binary_path.c_str(), &st) != 0) {
+    return error::Internal("Could not stat binary=$0 [errno=$1]", binary_path.string(), errno);
+  }
+  const FileVersion file_version = {st.st_dev, st.st_ino, st.st_size, st.st_mtime};
+  auto iter = content_hash_keys_.find(file_version);
+  if (iter != content_hash_keys_.end()) {
+    return iter->second;
+  }
+
+  PL_ASSIGN_OR_RETURN(uint64_t hash, HashFileContents(binary_path.string()));
+  std::string key = absl::StrFormat("hash-%016x", hash);
+  content_hash_keys_[file_version] = key;
+  content_hash_file_versions_[key].push_back(file_version);
+  return key;
+}
+
+std::filesystem::path BuildIDSymbolizerCache::CacheFilePath(std::string_view key) const {
+  return cache_dir_ / absl::StrCat(key, ".sym");
+}
+
+StatusOr<std::unique_ptr<ElfReader::Symbolizer>> BuildIDSymbolizerCache::LoadSymbolizer(
+    std::string_view key) {
+  const std::filesystem::path path = CacheFilePath(key);
+  PL_RETURN_IF_ERROR(fs::Exists(path));
+  PL_ASSIGN_OR_RETURN(std::string contents,
+                      ReadFileToString(path, std::ios::in | std::ios::binary));
+  StatusOr<std::unique_ptr<ElfReader::Symbolizer>> symbolizer =
+      ElfReader::Symbolizer::Deserialize(contents);
+  if (!symbolizer.ok()) {
+    // Most likely written by a different version; it gets overwritten once re-created.
+    VLOG(1) << absl::Substitute("Ignoring unreadable symbol cache file $0 [error=$1]",
+                                path.string(), symbolizer.ToString());
+    return symbolizer;
+  }
+
+  // The modification time orders the files for eviction, so mark the file as recently used.
+  std::error_code ec;
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+  return symbolizer;
+}
+
+Status BuildIDSymbolizerCache::SaveSymbolizer(std::string_view key,
+                                              const ElfReader::Symbolizer& symbolizer) {
+  // Write to a temporary file first, and then rename it into place, so that concurrent readers
+  // never observe a partially written file.
+  const std::filesystem::path path = CacheFilePath(key);
+  const std::filesystem::path tmp_path = absl::StrCat(path.string(), ".tmp.", getpid());
+  PL_RETURN_IF_ERROR(WriteFileFromString(tmp_path, symbolizer.Serialize(),
+                                         std::ios::out | std::ios::binary));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return error::Internal("Failed to move $0 to $1 [error=$2]", tmp_path.string(), path.string(),
+                           ec.message());
+  }
+  return Status::OK();
+}
+
+void BuildIDSymbolizerCache::EvictFromCacheDir() {
+  if (max_cache_dir_bytes_ == 0) {
+    return;
+  }
+
+  struct CacheFile {
+    std::filesystem::file_time_type last_used;
+    std::filesystem::path path;
+    uint64_t size;
+  };
+  std::vector<CacheFile> files;
+  uint64_t total_bytes = 0;
+
+  std::error_code ec;
+  for (std::filesystem::directory_iterator iter(cache_dir_, ec), end; !ec && iter != end;
+       iter.increment(ec)) {
+    if (iter->path().extension() != ".sym") {
+      continue;
+    }
+    std::error_code file_ec;
+    const std::filesystem::file_time_type last_used = iter->last_write_time(file_ec);
+    if (file_ec) {
+      continue;
+    }
+    const uint64_t size = iter->file_size(file_ec);
+    if (file_ec) {
+      continue;
+    }
+    total_bytes += size;
+    files.push_back({last_used, iter->path(), size});
+  }
+  if (total_bytes <= max_cache_dir_bytes_) {
+    return;
+  }
+
+  // Delete the least recently used files first.
+  std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+    return a.last_used < b.last_used;
+  });
+  for (const CacheFile& file : files) {
+    if (total_bytes <= max_cache_dir_bytes_) {
+      break;
+    }
+    if (std::filesystem::remove(file.path, ec)) {
+      total_bytes -= file.size;
+      ++stat_disk_evictions_;
+    }
+  }
+}
+
+StatusOr<std::shared_ptr<const ElfReader::Symbolizer>> BuildIDSymbolizerCache::GetSymbolizer(
+    const std::filesystem::path& binary_path) {
+  PL_ASSIGN_OR_RETURN(std::string key, BinaryKey(binary_path));
+  return GetSymbolizer(key, binary_path);
+}
+
+StatusOr<std::shared_ptr<const ElfReader::Symbolizer>> BuildIDSymbolizerCache::GetSymbolizer(
+    const std::string& key, const std::filesystem::path& binary_path) {
+  std::weak_ptr<const ElfReader::Symbolizer>& entry = symbolizers_[key];
+  if (std::shared_ptr<const ElfReader::Symbolizer> symbolizer = entry.lock()) {
+    ++stat_shared_hits_;
+    return symbolizer;
+  }
+
+  std::unique_ptr<ElfReader::Symbolizer> symbolizer;
+  if (!cache_dir_.empty()) {
+    StatusOr<std::unique_ptr<ElfReader::Symbolizer>> symbolizer_status = LoadSymbolizer(key);
+    if (symbolizer_status.ok()) {
+      ++stat_disk_hits_;
+      symbolizer = symbolizer_status.ConsumeValueOrDie();
+    }
+  }
+
+  if (symbolizer == nullptr) {
+    ++stat_elf_reads_;
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader,
+                        ElfReader::Create(binary_path.string()));
+    PL_ASSIGN_OR_RETURN(symbolizer, elf_reader->GetSymbolizer());
+
+    if (!cache_dir_.empty()) {
+      Status s = SaveSymbolizer(key, *symbolizer);
+      LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to persist symbols of $0 [error=$1]",
+                                                   binary_path.string(), s.ToString());
+      EvictFromCacheDir();
+    }
+  }
+
+  std::shared_ptr<const ElfReader::Symbolizer> shared_symbolizer = std::move(symbolizer);
+  entry = shared_symbolizer;
+  return shared_symbolizer;
+}
+
+void BuildIDSymbolizerCache::RemoveExpired() {
+  for (auto iter = symbolizers_.begin(); iter != symbolizers_.end();) {
+    if (iter->second.expired()) {
+      symbolizers_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+
+  // A binary that is not in use anymore is probably gone, or replaced by a new version.
+  for (auto iter = content_hash_file_versions_.begin();
+       iter != content_hash_file_versions_.end();) {
+    if (!symbolizers_.contains(iter->first)) {
+      for (const FileVersion& file_version : iter->second) {
+        content_hash_keys_.erase(file_version);
+      }
+      content_hash_file_versions_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void BuildIDSymbolizerCache::RemoveExpired(const std::string& key) {
+  auto iter = symbolizers_.find(key);
+  if (iter == symbolizers_.end() || !iter->second.expired()) {
+    return;
+  }
+  symbolizers_.erase(iter);
+
+  auto versions_iter = content_hash_file_versions_.find(key);
+  if (versions_iter == content_hash_file_versions_.end()) {
+    return;
+  }
+  for (const FileVersion& file_version : versions_iter->second) {
+    content_hash_keys_.erase(file_version);
+  }
+  content_hash_file_versions_.erase(versions_iter);
+}
+
+}  // namespace stirling
+}  // namespace px
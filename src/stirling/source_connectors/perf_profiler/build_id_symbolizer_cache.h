@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * BuildIDSymbolizerCache shares ElfReader::Symbolizers among all processes running the same binary.
+ *
+ * Binaries are identified by their build-id, or by a hash of their contents when they were
+ * linked without one, so replicas of the same container image share one symbol table no matter
+ * which path (or mount namespace) the binary is found under. Optionally, symbol tables are
+ * persisted in a local directory, keyed the same way, so that a restarted agent does not need
+ * to re-read and re-demangle the symbols of binaries it has already seen.
+ */
+class BuildIDSymbolizerCache : public NotCopyMoveable {
+ public:
+  /**
+   * @param cache_dir Directory in which symbol tables are persisted. Empty disables persistence.
+   * @param max_cache_dir_bytes Once the persisted symbol tables take more than this, the least
+   *                            recently used ones are deleted. 0 means no limit.
+   */
+  explicit BuildIDSymbolizerCache(std::filesystem::path cache_dir = {},
+                                  uint64_t max_cache_dir_bytes = 0);
+
+  /**
+   * Returns the symbolizer for the binary. The symbolizer is shared with all other callers that
+   * asked for the same binary, and stays in memory for as long as any of them holds on to it.
+   */
+  StatusOr<std::shared_ptr<const obj_tools::ElfReader::Symbolizer>> GetSymbolizer(
+      const std::filesystem::path& binary_path);
+
+  /**
+   * Same as above, for a binary whose key, see BinaryKey(), is already known.
+   */
+  StatusOr<std::shared_ptr<const obj_tools::ElfReader::Symbolizer>> GetSymbolizer(
+      const std::string& key, const std::filesystem::path& binary_path);
+
+  /**
+   * Returns the key under which the symbols of the binary are cached.
+   */
+  StatusOr<std::string> BinaryKey(const std::filesystem::path& binary_path);
+
+  /**
+   * Drops the entries of symbolizers that are no longer referenced, along with the content hashes
+   * of the binaries that they were read from.
+   */
+  void RemoveExpired();
+
+  /**
+   * Same as RemoveExpired(), for the entry of a single binary key.
+   */
+  void RemoveExpired(const std::string& key);
+
+  size_t size() const { return symbolizers_.size(); }
+
+  int64_t stat_shared_hits() const { return stat_shared_hits_; }
+  int64_t stat_disk_hits() const { return stat_disk_hits_; }
+  int64_t stat_elf_reads() const { return stat_elf_reads_; }
+  int64_t stat_disk_evictions() const { return stat_disk_evictions_; }
+
+ private:
+  std::filesystem::path CacheFilePath(std::string_view key) const;
+  StatusOr<std::unique_ptr<obj_tools::ElfReader::Symbolizer>> LoadSymbolizer(std::string_view key);
+  Status SaveSymbolizer(std::string_view key, const obj_tools::ElfReader::Symbolizer& symbolizer);
+  void EvictFromCacheDir();
+
+  const std::filesystem::path cache_dir_;
+  const uint64_t max_cache_dir_bytes_;
+
+  // Key is the binary key, see BinaryKey().
+  absl::flat_hash_map<std::string, std::weak_ptr<const obj_tools::ElfReader::Symbolizer>>
+      symbolizers_;
+
+  // Hashing the contents of a binary without a build-id is expensive, so remember the result.
+  // Key is {device, inode, size, modification time}, which identifies the version of the file.
+  using FileVersion = std::tuple<dev_t, ino_t, off_t, int64_t>;
+  absl::flat_hash_map<FileVersion, std::string> content_hash_keys_;
+  // The reverse of content_hash_keys_, so that the hashes of a binary can be dropped along with it.
+  absl::flat_hash_map<std::string, std::vector<FileVersion>> content_hash_file_versions_;
+
+  int64_t stat_shared_hits_ = 0;
+  int64_t stat_disk_hits_ = 0;
+  int64_t stat_elf_reads_ = 0;
+  int64_t stat_disk_evictions_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
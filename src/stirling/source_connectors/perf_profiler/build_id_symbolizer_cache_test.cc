@@ -0,0 +1,172 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/build_id_symbolizer_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::obj_tools::ElfReader;
+using ::px::testing::TempDir;
+
+// Has no build-id, so it's keyed by a hash of its contents.
+constexpr std::string_view kPrebuiltExePath =
+    "src/stirling/obj_tools/testdata/cc/prebuilt_test_exe";
+// Has a build-id.
+constexpr std::string_view kTestExePath = "src/stirling/obj_tools/testdata/cc/test_exe";
+
+TEST(BuildIDSymbolizerCacheTest, BinaryKey) {
+  BuildIDSymbolizerCache cache;
+
+  ASSERT_OK_AND_ASSIGN(std::string test_exe_key,
+                       cache.BinaryKey(px::testing::BazelBinTestFilePath(kTestExePath)));
+  EXPECT_TRUE(absl::StartsWith(test_exe_key, "buildid-"));
+
+  ASSERT_OK_AND_ASSIGN(std::string prebuilt_key,
+                       cache.BinaryKey(px::testing::TestFilePath(kPrebuiltExePath)));
+  EXPECT_TRUE(absl::StartsWith(prebuilt_key, "hash-"));
+
+  // A copy of a binary, e.g. in the file system of another container, has the same key.
+  TempDir tmp_dir;
+  const std::filesystem::path copy_path = tmp_dir.path() / "copy_of_prebuilt_test_exe";
+  std::filesystem::copy_file(px::testing::TestFilePath(kPrebuiltExePath), copy_path);
+  EXPECT_OK_AND_EQ(cache.BinaryKey(copy_path), prebuilt_key);
+
+  EXPECT_NOT_OK(cache.BinaryKey("/bogus"));
+}
+
+TEST(BuildIDSymbolizerCacheTest, SharedAcrossBinaryCopies) {
+  const std::filesystem::path path = px::testing::TestFilePath(kPrebuiltExePath);
+  TempDir tmp_dir;
+  const std::filesystem::path copy_path = tmp_dir.path() / "copy_of_prebuilt_test_exe";
+  std::filesystem::copy_file(path, copy_path);
+
+  BuildIDSymbolizerCache cache;
+
+  ASSERT_OK_AND_ASSIGN(auto symbolizer1, cache.GetSymbolizer(path));
+  ASSERT_OK_AND_ASSIGN(auto symbolizer2, cache.GetSymbolizer(copy_path));
+  EXPECT_EQ(symbolizer1, symbolizer2);
+  EXPECT_EQ(cache.stat_elf_reads(), 1);
+  EXPECT_EQ(cache.stat_shared_hits(), 1);
+
+  // Once all users are gone, the symbols are freed and re-read on the next request.
+  symbolizer1.reset();
+  symbolizer2.reset();
+  cache.RemoveExpired();
+  EXPECT_EQ(cache.size(), 0);
+
+  ASSERT_OK_AND_ASSIGN(auto symbolizer3, cache.GetSymbolizer(path));
+  EXPECT_EQ(cache.stat_elf_reads(), 2);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(BuildIDSymbolizerCacheTest, RemoveExpiredKey) {
+  const std::filesystem::path path = px::testing::TestFilePath(kPrebuiltExePath);
+
+  BuildIDSymbolizerCache cache;
+
+  ASSERT_OK_AND_ASSIGN(std::string key, cache.BinaryKey(path));
+  ASSERT_OK_AND_ASSIGN(auto symbolizer, cache.GetSymbolizer(key, path));
+  EXPECT_EQ(cache.size(), 1);
+
+  // The entry is kept for as long as the symbolizer is in use.
+  cache.RemoveExpired(key);
+  EXPECT_EQ(cache.size(), 1);
+
+  symbolizer.reset();
+  cache.RemoveExpired(key);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(BuildIDSymbolizerCacheTest, Persistence) {
+  const std::filesystem::path path = px::testing::TestFilePath(kPrebuiltExePath);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(path.string()));
+  ASSERT_OK_AND_ASSIGN(ElfReader::SymbolInfo symbol,
+                       elf_reader->SearchTheOnlySymbol("CanYouFindThis"));
+
+  TempDir cache_dir;
+
+  {
+    BuildIDSymbolizerCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(auto symbolizer, cache.GetSymbolizer(path));
+    EXPECT_EQ(symbolizer->Lookup(symbol.address), "CanYouFindThis");
+    EXPECT_EQ(cache.stat_elf_reads(), 1);
+    EXPECT_EQ(cache.stat_disk_hits(), 0);
+  }
+
+  // A new cache, as after a restart, loads the symbols from disk instead of the binary.
+  {
+    BuildIDSymbolizerCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(auto symbolizer, cache.GetSymbolizer(path));
+    EXPECT_EQ(symbolizer->Lookup(symbol.address), "CanYouFindThis");
+    EXPECT_EQ(cache.stat_elf_reads(), 0);
+    EXPECT_EQ(cache.stat_disk_hits(), 1);
+  }
+
+  // Corrupted cache files are ignored, and replaced.
+  {
+    BuildIDSymbolizerCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(std::string key, cache.BinaryKey(path));
+    ASSERT_OK(WriteFileFromString(cache_dir.path() / absl::StrCat(key, ".sym"), "garbage"));
+
+    ASSERT_OK_AND_ASSIGN(auto symbolizer, cache.GetSymbolizer(path));
+    EXPECT_EQ(symbolizer->Lookup(symbol.address), "CanYouFindThis");
+    EXPECT_EQ(cache.stat_elf_reads(), 1);
+    EXPECT_EQ(cache.stat_disk_hits(), 0);
+  }
+  {
+    BuildIDSymbolizerCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(auto symbolizer, cache.GetSymbolizer(path));
+    EXPECT_EQ(cache.stat_disk_hits(), 1);
+  }
+}
+
+TEST(BuildIDSymbolizerCacheTest, CacheDirEviction) {
+  const std::filesystem::path prebuilt_path = px::testing::TestFilePath(kPrebuiltExePath);
+  const std::filesystem::path test_exe_path = px::testing::BazelBinTestFilePath(kTestExePath);
+  TempDir cache_dir;
+
+  std::filesystem::path prebuilt_cache_file;
+  uint64_t prebuilt_cache_file_size = 0;
+  {
+    BuildIDSymbolizerCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(std::string key, cache.BinaryKey(prebuilt_path));
+    ASSERT_OK(cache.GetSymbolizer(prebuilt_path));
+    prebuilt_cache_file = cache_dir.path() / absl::StrCat(key, ".sym");
+    prebuilt_cache_file_size = std::filesystem::file_size(prebuilt_cache_file);
+    // Make it the least recently used file.
+    std::filesystem::last_write_time(
+        prebuilt_cache_file, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+  }
+
+  // There is only room for one of the files, so the older one is deleted.
+  BuildIDSymbolizerCache cache(cache_dir.path(), prebuilt_cache_file_size);
+  ASSERT_OK(cache.GetSymbolizer(test_exe_path));
+  EXPECT_GE(cache.stat_disk_evictions(), 1);
+  EXPECT_FALSE(std::filesystem::exists(prebuilt_cache_file));
+}
+
+}  // namespace stirling
+}  // namespace px
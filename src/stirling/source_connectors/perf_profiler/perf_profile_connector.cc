@@ -20,11 +20,13 @@
 
 #include <sys/sysinfo.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "src/common/perf/elapsed_timer.h"
 #include "src/stirling/bpf_tools/macros.h"
 
 BPF_SRC_STRVIEW(profiler_bcc_script, profiler);
@@ -33,6 +35,27 @@ DEFINE_string(stirling_profiler_symbolizer, "bcc",
               "Choice of which symbolizer to use. Options: bcc, elf");
 DEFINE_bool(stirling_profiler_cache_symbols, true, "Whether to cache symbols");
 
+DEFINE_uint32(stirling_profiler_stack_trace_sample_period_ms,
+              px::stirling::PerfProfileConnector::kBPFSamplingPeriod.count(),
+              "Time interval in between stack trace samples, per CPU.");
+DEFINE_uint32(stirling_profiler_table_update_period_seconds,
+              std::chrono::duration_cast<std::chrono::seconds>(
+                  px::stirling::PerfProfileConnector::kSamplingPeriod)
+                  .count(),
+              "Time interval in between reads of the sampled stack traces; "
+              "each read produces one batch of stack trace records.");
+DEFINE_bool(stirling_profiler_intern_stack_traces, false,
+            "If true, stack_traces.beta records hold only the stack trace ID, and each stack "
+            "trace string is recorded in stack_trace_dictionary.beta when it first appears, "
+            "and then once per ID cache generation while it remains in use.");
+DEFINE_bool(stirling_profiler_adaptive_sampling, false,
+            "If true, the stack trace sampling rate is lowered when the profiler exceeds "
+            "--stirling_profiler_overhead_budget_percent, and raised back when it is well below.");
+DEFINE_double(stirling_profiler_overhead_budget_percent, 1.0,
+              "CPU budget of the profiler in adaptive mode, as a percentage of each CPU, ie. of "
+              "the CPU time of the whole node. Includes the CPU time spent sampling in BPF, "
+              "and processing samples in user space.");
+
 DEFINE_uint32(stirling_perf_profiler_stats_logging_ratio,
               std::chrono::minutes(10) / px::stirling::PerfProfileConnector::kSamplingPeriod,
               "Sets the frequency of printing perf profiler stats.");
@@ -40,33 +63,59 @@ DEFINE_uint32(stirling_perf_profiler_stats_logging_ratio,
 namespace px {
 namespace stirling {
 
+namespace {
+
+// The start time of the agent, in seconds, tells apart its stack trace IDs from those of
+// earlier runs.
+uint32_t StackTraceIDInstance() {
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(now).count());
+}
+
+}  // namespace
+
 PerfProfileConnector::PerfProfileConnector(std::string_view source_name)
-    : SourceConnector(source_name, kTables) {}
+    : SourceConnector(source_name, kTables), stack_trace_ids_(StackTraceIDInstance()) {}
 
 Status PerfProfileConnector::InitImpl() {
-  sampling_freq_mgr_.set_period(kSamplingPeriod);
-  push_freq_mgr_.set_period(kPushPeriod);
+  if (FLAGS_stirling_profiler_stack_trace_sample_period_ms == 0 ||
+      FLAGS_stirling_profiler_table_update_period_seconds == 0) {
+    return error::InvalidArgument("Profiler sampling periods must be non-zero.");
+  }
+  bpf_sampling_period_ =
+      std::chrono::milliseconds{FLAGS_stirling_profiler_stack_trace_sample_period_ms};
+  sampling_period_ = std::chrono::seconds{FLAGS_stirling_profiler_table_update_period_seconds};
 
-  const size_t ncpus = get_nprocs_conf();
-  VLOG(1) << "PerfProfiler: get_nprocs_conf(): " << ncpus;
+  sampling_freq_mgr_.set_period(sampling_period_);
+  push_freq_mgr_.set_period(sampling_period_ / 2);
+
+  ncpus_ = get_nprocs_conf();
+  VLOG(1) << "PerfProfiler: get_nprocs_conf(): " << ncpus_;
 
   const std::vector<std::string> defines = {
-      absl::Substitute("-DNCPUS=$0", ncpus),
-      absl::Substitute("-DTRANSFER_PERIOD=$0", kSamplingPeriod.count()),
-      absl::Substitute("-DSAMPLE_PERIOD=$0", kBPFSamplingPeriod.count())};
+      absl::Substitute("-DNCPUS=$0", ncpus_),
+      absl::Substitute("-DTRANSFER_PERIOD=$0", sampling_period_.count()),
+      absl::Substitute("-DSAMPLE_PERIOD=$0", bpf_sampling_period_.count())};
+
+  const auto probe_specs = MakeArray<bpf_tools::SamplingProbeSpec>(
+      {"sample_call_stack", static_cast<uint64_t>(bpf_sampling_period_.count())});
 
   PL_RETURN_IF_ERROR(InitBPFProgram(profiler_bcc_script, defines));
-  PL_RETURN_IF_ERROR(AttachSamplingProbes(kProbeSpecs));
-  PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
+  PL_RETURN_IF_ERROR(AttachSamplingProbes(probe_specs));
 
   stack_traces_a_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_a"));
   stack_traces_b_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_b"));
 
-  histogram_a_perf_buffer_ = GetPerfBuffer("histogram_a");
-  histogram_b_perf_buffer_ = GetPerfBuffer("histogram_b");
+  histogram_a_ = std::make_unique<BPFStackTraceHisto>(
+      GetHashTable<stack_trace_key_t, uint64_t>("histogram_a"));
+  histogram_b_ = std::make_unique<BPFStackTraceHisto>(
+      GetHashTable<stack_trace_key_t, uint64_t>("histogram_b"));
 
   profiler_state_ =
       std::make_unique<ebpf::BPFArrayTable<uint64_t>>(GetArrayTable<uint64_t>("profiler_state"));
+  profiler_state_->update_value(kSampleDecimationAIdx, sample_decimation_);
+  profiler_state_->update_value(kSampleDecimationBIdx, sample_decimation_);
+  prev_decimation_update_time_ = std::chrono::steady_clock::now();
 
   LOG(INFO) << "PerfProfiler: Stack trace profiling sampling probe successfully deployed.";
 
@@ -100,23 +149,6 @@ Status PerfProfileConnector::StopImpl() {
   return Status::OK();
 }
 
-void PerfProfileConnector::AcceptStackTraceKey(stack_trace_key_t* data) {
-  raw_histo_data_.push_back(*data);
-}
-
-void PerfProfileConnector::HandleHistoEvent(void* cb_cookie, void* data, int /*data_size*/) {
-  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
-  auto* histo_key_ptr = static_cast<stack_trace_key_t*>(data);
-  connector->AcceptStackTraceKey(histo_key_ptr);
-}
-
-void PerfProfileConnector::HandleHistoLoss(void* cb_cookie, uint64_t lost) {
-  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
-  connector->stats_.Increment(StatKey::kLossHistoEvent, lost);
-}
-
 void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID>& deleted_upids) {
   for (const auto& md_upid : deleted_upids) {
     // Clean-up caches.
@@ -139,10 +171,17 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
 }
 
 PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces(
-    ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces) {
+    ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces, BPFStackTraceHisto* histo,
+    uint64_t count_multiplier) {
+  // Move the stack trace histogram out of the BPF shared map into our local map.
+  // BPF has already switched over to the other map set, so the map can be cleared as it is read.
   // TODO(jps): switch from using get_table_offline() to directly stepping through
   // the histogram data structure. Inline populating our own data structures with this.
   // Avoid an unnecessary copy of the information in local stack_trace_keys_and_counts.
+  constexpr bool kClearTable = true;
+  const std::vector<std::pair<stack_trace_key_t, uint64_t>> stack_trace_keys_and_counts =
+      histo->get_table_offline(kClearTable);
+
   StackTraceHisto symbolic_histogram;
   uint64_t cum_sum_count = 0;
 
@@ -152,9 +191,20 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
   // Create a new stringifier for this iteration of the continuous perf profiler.
   Stringifier stringifier(u_symbolizer_.get(), k_symbolizer_.get(), stack_traces);
 
+  // Symbolize the user stack traces of all processes up front, which walks the symbol table of
+  // each process once, instead of searching it once per stack frame.
+  std::vector<stack_trace_key_t> keys_to_symbolize;
+  for (const auto& [stack_trace_key, count] : stack_trace_keys_and_counts) {
+    const md::UPID upid(asid, stack_trace_key.upid.pid, stack_trace_key.upid.start_time_ticks);
+    if (upids_for_symbolization.contains(upid)) {
+      keys_to_symbolize.push_back(stack_trace_key);
+    }
+  }
+  stringifier.BuildUserStackTraceStrings(keys_to_symbolize);
+
   absl::flat_hash_set<int> k_stack_ids_to_remove;
 
-  for (const auto& stack_trace_key : raw_histo_data_) {
+  for (const auto& [stack_trace_key, count] : stack_trace_keys_and_counts) {
     std::string stack_trace_str;
 
     const md::UPID upid(asid, stack_trace_key.upid.pid, stack_trace_key.upid.start_time_ticks);
@@ -184,8 +234,8 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 
     SymbolicStackTrace symbolic_stack_trace = {upid, std::move(stack_trace_str)};
 
-    ++symbolic_histogram[symbolic_stack_trace];
-    ++cum_sum_count;
+    symbolic_histogram[symbolic_stack_trace] += count * count_multiplier;
+    cum_sum_count += count;
 
     // TODO(jps): If we see a perf. issue with having two maps keyed by symbolic-stack-trace,
     // refactor such that creating/finding symoblic-stack-trace-id and count aggregation
@@ -205,15 +255,15 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
     stack_traces->clear_stack_id(k_stack_id);
   }
 
-  raw_histo_data_.clear();
-
   VLOG(1) << "PerfProfileConnector::AggregateStackTraces(): cum_sum_count: " << cum_sum_count;
   stats_.Increment(StatKey::kCumulativeSumOfAllStackTraces, cum_sum_count);
   return symbolic_histogram;
 }
 
-void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                                         DataTable* data_table) {
+void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces,
+                                         BPFStackTraceHisto* histo, uint64_t count_multiplier,
+                                         ConnectorContext* ctx, DataTable* data_table,
+                                         DataTable* dictionary_table) {
   constexpr size_t kMaxSymbolSize = 512;
   constexpr size_t kMaxStackDepth = 64;
   constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
@@ -226,35 +276,100 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, Conn
   // p0, p1, p2 => main;qux;baz   # both p2 & p3 point into baz.
   // p0, p1, p3 => main;qux;baz
 
-  StackTraceHisto stack_trace_histogram = AggregateStackTraces(ctx, stack_traces);
+  StackTraceHisto stack_trace_histogram =
+      AggregateStackTraces(ctx, stack_traces, histo, count_multiplier);
 
   constexpr auto age_tick_period = std::chrono::minutes(5);
-  if (sampling_freq_mgr_.count() % (age_tick_period / kSamplingPeriod) == 0) {
+  const int64_t age_tick_ratio = std::max<int64_t>(1, age_tick_period / sampling_period_);
+  if (sampling_freq_mgr_.count() % age_tick_ratio == 0) {
     stack_trace_ids_.AgeTick();
   }
 
   for (const auto& [key, count] : stack_trace_histogram) {
+    const StackTraceIDCache::InternResult stack_trace_id = stack_trace_ids_.Intern(key);
+
+    if (dictionary_table != nullptr && stack_trace_id.first_in_generation) {
+      DataTable::RecordBuilder<&kStackTraceDictionaryTable> r(dictionary_table, timestamp_ns);
+
+      r.Append<r.ColIndex("time_")>(timestamp_ns);
+      r.Append<r.ColIndex("upid")>(key.upid.value());
+      r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id.stack_trace_id);
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    }
+
     DataTable::RecordBuilder<&kStackTraceTable> r(data_table, timestamp_ns);
 
     r.Append<r.ColIndex("time_")>(timestamp_ns);
     r.Append<r.ColIndex("upid")>(key.upid.value());
-    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_ids_.Lookup(key));
-    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id.stack_trace_id);
+    if (dictionary_table != nullptr) {
+      r.Append<r.ColIndex("stack_trace")>("");
+    } else {
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    }
     r.Append<r.ColIndex("count")>(count);
   }
 }
 
-void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table) {
+void PerfProfileConnector::UpdateSampleDecimation(uint32_t next_sample_decimation_idx) {
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = now - prev_decimation_update_time_;
+
+  uint64_t bpf_time_ns = 0;
+  const ebpf::StatusTuple get_status = profiler_state_->get_value(kBPFTimeNSIdx, bpf_time_ns);
+  LOG_IF(ERROR, !get_status.ok()) << "Error reading BPF time.";
+
+  // BPF time is summed over all CPUs, so the overhead is relative to the CPU time of all CPUs.
+  const auto bpf_time = std::chrono::nanoseconds{bpf_time_ns - prev_bpf_time_ns_};
+  const double overhead_percent =
+      100.0 * static_cast<double>((bpf_time + user_time_).count()) /
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+      static_cast<double>(ncpus_);
+
+  prev_bpf_time_ns_ = bpf_time_ns;
+  prev_decimation_update_time_ = now;
+  user_time_ = std::chrono::nanoseconds{0};
+
+  if (!FLAGS_stirling_profiler_adaptive_sampling) {
+    return;
+  }
+
+  // Halve or double the sampling rate. Only go back up when well below the budget,
+  // so that the rate does not oscillate around the budget.
+  const double budget_percent = FLAGS_stirling_profiler_overhead_budget_percent;
+  const uint32_t prev_sample_decimation = sample_decimation_;
+  if (overhead_percent > budget_percent && sample_decimation_ < kMaxSampleDecimation) {
+    sample_decimation_ *= 2;
+    stats_.Increment(StatKey::kSampleDecimationIncrease);
+  } else if (overhead_percent < budget_percent / 4 && sample_decimation_ > 1) {
+    sample_decimation_ /= 2;
+    stats_.Increment(StatKey::kSampleDecimationDecrease);
+  }
+
+  VLOG_IF(1, sample_decimation_ != prev_sample_decimation) << absl::Substitute(
+      "PerfProfiler: overhead $0% (budget $1%), sampling 1 out of $2 stack traces.",
+      overhead_percent, budget_percent, sample_decimation_);
+
+  // Written on every transfer, since the next map set may still hold the decimation from two
+  // transfers ago.
+  const ebpf::StatusTuple update_status =
+      profiler_state_->update_value(next_sample_decimation_idx, sample_decimation_);
+  LOG_IF(ERROR, !update_status.ok()) << "Error writing sample decimation.";
+}
+
+void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                                                 DataTable* dictionary_table) {
   // Choose the maps to consume.
   const bool using_map_set_a = transfer_count_ % 2 == 0;
   auto& stack_traces = using_map_set_a ? stack_traces_a_ : stack_traces_b_;
-  auto& histo_perf_buf = using_map_set_a ? histogram_a_perf_buffer_ : histogram_b_perf_buffer_;
+  auto& histo = using_map_set_a ? histogram_a_ : histogram_b_;
   const uint32_t sample_count_idx = using_map_set_a ? kSampleCountAIdx : kSampleCountBIdx;
 
-  // Read out the perf buffer that contains the histogram for this iteration.
-  // TODO(jps): change PollPerfBuffer() to use std::chrono.
-  constexpr int kPollTimeoutMS = 0;
-  histo_perf_buf->poll(kPollTimeoutMS);
+  // The decimation that was in effect while BPF wrote to the map set being consumed.
+  // Each map set has its own decimation, which is only written right before BPF switches to it,
+  // so it applies to the whole set.
+  const uint64_t count_multiplier = sample_decimation_;
+  UpdateSampleDecimation(using_map_set_a ? kSampleDecimationBIdx : kSampleDecimationAIdx);
 
   ++transfer_count_;
 
@@ -263,7 +378,8 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
   LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
   // Read BPF stack traces & histogram, build records, incorporate records to data table.
-  CreateRecords(stack_traces.get(), ctx, data_table);
+  CreateRecords(stack_traces.get(), histo.get(), count_multiplier, ctx, data_table,
+                dictionary_table);
 
   // Now that we've consumed the data, reset the sample count in BPF.
   profiler_state_->update_value(sample_count_idx, 0);
@@ -271,20 +387,29 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
 
 void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
                                             const std::vector<DataTable*>& data_tables) {
-  DCHECK_EQ(data_tables.size(), 1);
+  DCHECK_EQ(data_tables.size(), kTables.size());
 
-  auto* data_table = data_tables[0];
+  auto* data_table = data_tables[kPerfProfileTableNum];
 
   if (data_table == nullptr) {
     return;
   }
 
-  ProcessBPFStackTraces(ctx, data_table);
+  // Without a dictionary table to hold them, stack traces are recorded in line, as usual.
+  DataTable* dictionary_table = FLAGS_stirling_profiler_intern_stack_traces
+                                    ? data_tables[kStackTraceDictionaryTableNum]
+                                    : nullptr;
+
+  const auto start = ThreadCPUClock::now();
+
+  ProcessBPFStackTraces(ctx, data_table, dictionary_table);
 
   // Cleanup the symbolizer so we don't leak memory.
   proc_tracker_.Update(ctx->GetUPIDs());
   CleanupSymbolizers(proc_tracker_.deleted_upids());
 
+  user_time_ += ThreadCPUClock::now() - start;
+
   stats_.Increment(StatKey::kBPFMapSwitchoverEvent, 1);
 
   if (sampling_freq_mgr_.count() % FLAGS_stirling_perf_profiler_stats_logging_ratio == 0) {
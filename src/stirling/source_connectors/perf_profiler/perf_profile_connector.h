@@ -46,18 +46,26 @@ static constexpr std::string_view kNotSymbolizedMessage = "<not symbolized>";
 class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "perf_profiler";
-  static constexpr auto kTables = MakeArray(kStackTraceTable);
+  static constexpr auto kTables = MakeArray(kStackTraceTable, kStackTraceDictionaryTable);
   static constexpr uint32_t kPerfProfileTableNum = TableNum(kTables, kStackTraceTable);
+  static constexpr uint32_t kStackTraceDictionaryTableNum =
+      TableNum(kTables, kStackTraceDictionaryTable);
 
-  // kBPFSamplingPeriod: the time interval in between stack trace samples.
+  // kBPFSamplingPeriod: the default time interval in between stack trace samples.
+  // Configurable with --stirling_profiler_stack_trace_sample_period_ms.
   static constexpr auto kBPFSamplingPeriod = std::chrono::milliseconds{11};
 
   // Push period is set to 1/2 of the sample period such that we push each new
   // sample when it becomes available. This is a UX decision so that the user
   // gets fresh profiler data every 30 seconds (or worst case w/in 45 seconds).
+  // The sampling period is configurable with --stirling_profiler_table_update_period_seconds,
+  // and the push period follows it.
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{30000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{15000};
 
+  // In adaptive mode, the effective sampling rate is lowered by up to this factor.
+  static constexpr uint32_t kMaxSampleDecimation = 64;
+
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new PerfProfileConnector(name));
   }
@@ -70,36 +78,60 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // StackTraceHisto: SymbolicStackTrace => observation-count
   using StackTraceHisto = absl::flat_hash_map<SymbolicStackTrace, uint64_t>;
 
-  // RawHistoData: a list of stack trace keys that will need to be histogrammed.
-  using RawHistoData = std::vector<stack_trace_key_t>;
+  // BPF histogram of stack trace keys: stack_trace_key_t => observation-count.
+  using BPFStackTraceHisto = ebpf::BPFHashTable<stack_trace_key_t, uint64_t>;
 
   explicit PerfProfileConnector(std::string_view source_name);
 
-  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table);
+  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                             DataTable* dictionary_table);
 
   // Read BPF data structures, build & incorporate records to the table.
-  void CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                     DataTable* data_table);
+  // Counts are multiplied by count_multiplier, to compensate for decimated samples.
+  // If dictionary_table is not null, stack traces are interned: records only hold the
+  // stack trace ID, and the stack trace string is recorded in dictionary_table.
+  void CreateRecords(ebpf::BPFStackTable* stack_traces, BPFStackTraceHisto* histo,
+                     uint64_t count_multiplier, ConnectorContext* ctx, DataTable* data_table,
+                     DataTable* dictionary_table);
+
+  StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces,
+                                       BPFStackTraceHisto* histo, uint64_t count_multiplier);
 
-  StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces);
+  // In adaptive mode, adjusts the sample decimation so the profiler stays within its CPU budget.
+  // The decimation is written to next_sample_decimation_idx, that of the map set BPF switches to.
+  void UpdateSampleDecimation(uint32_t next_sample_decimation_idx);
 
   void CleanupSymbolizers(const absl::flat_hash_set<md::UPID>& deleted_upids);
 
+  // Time interval in between stack trace samples, and in between reads of the BPF maps.
+  std::chrono::milliseconds bpf_sampling_period_ = kBPFSamplingPeriod;
+  std::chrono::milliseconds sampling_period_ = kSamplingPeriod;
+
   // data structures shared with BPF:
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_a_;
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_b_;
 
+  std::unique_ptr<BPFStackTraceHisto> histogram_a_;
+  std::unique_ptr<BPFStackTraceHisto> histogram_b_;
+
   std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> profiler_state_;
 
   // Number of iterations, where each iteration is drains the information collectid in BPF.
   uint64_t transfer_count_ = 0;
 
+  // BPF keeps 1 out of sample_decimation_ samples. Only ever above 1 in adaptive mode.
+  uint32_t sample_decimation_ = 1;
+
+  // Inputs for the profiler overhead computation in UpdateSampleDecimation().
+  // user_time_ is the CPU time spent in TransferDataImpl().
+  size_t ncpus_ = 1;
+  uint64_t prev_bpf_time_ns_ = 0;
+  std::chrono::nanoseconds user_time_ = std::chrono::nanoseconds{0};
+  std::chrono::steady_clock::time_point prev_decimation_update_time_;
+
   // Tracks unique stack trace ids, for the lifetime of Stirling:
   StackTraceIDCache stack_trace_ids_;
 
-  // The raw histogram from BPF; it is populated on each iteration by a call to PollPerfBuffer().
-  RawHistoData raw_histo_data_;
-
   // For converting stack trace addresses to symbols.
   std::unique_ptr<Symbolizer> k_symbolizer_;
   std::unique_ptr<Symbolizer> u_symbolizer_;
@@ -108,34 +140,11 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // TODO(oazizi): Investigate ways of sharing across source_connectors.
   ProcTracker proc_tracker_;
 
-  static constexpr auto kProbeSpecs =
-      MakeArray<bpf_tools::SamplingProbeSpec>({"sample_call_stack", kBPFSamplingPeriod.count()});
-
-  static const uint32_t kExpectedStackTracesPerCPU =
-      IntRoundUpDivide(kSamplingPeriod.count(), kBPFSamplingPeriod.count());
-  static const uint32_t kMaxNCPUs = 128;
-  static const uint32_t kExpectedStackTraces = kMaxNCPUs * kExpectedStackTracesPerCPU;
-
-  // Overprovision:
-  static const uint32_t kNumPerfBufferEntries = 4 * kExpectedStackTraces;
-
-  static void HandleHistoEvent(void* cb_cookie, void* data, int /*data_size*/);
-  static void HandleHistoLoss(void* cb_cookie, uint64_t lost);
-
-  // Called by HandleHistoEvent() to add the stack-trace-key to raw_histo_data_.
-  void AcceptStackTraceKey(stack_trace_key_t* data);
-
-  inline static const auto kPerfBufferSpecs = MakeArray<bpf_tools::PerfBufferSpec>(
-      {{"histogram_a", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries},
-       {"histogram_b", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries}});
-
-  ebpf::BPFPerfBuffer* histogram_a_perf_buffer_;
-  ebpf::BPFPerfBuffer* histogram_b_perf_buffer_;
-
   enum class StatKey {
     kBPFMapSwitchoverEvent,
     kCumulativeSumOfAllStackTraces,
-    kLossHistoEvent,
+    kSampleDecimationIncrease,
+    kSampleDecimationDecrease,
   };
 
   utils::StatCounter<StatKey> stats_;
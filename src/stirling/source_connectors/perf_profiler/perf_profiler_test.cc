@@ -56,7 +56,9 @@ class CPUPinnedBinaryRunner {
 
 class PerfProfileBPFTest : public ::testing::Test {
  public:
-  PerfProfileBPFTest() : data_table_(/*id*/ 0, kStackTraceTable) {}
+  PerfProfileBPFTest()
+      : data_table_(/*id*/ 0, kStackTraceTable),
+        dictionary_table_(/*id*/ 1, kStackTraceDictionaryTable) {}
 
  protected:
   void SetUp() override {
@@ -230,7 +232,8 @@ class PerfProfileBPFTest : public ::testing::Test {
   std::unique_ptr<SourceConnector> source_;
   std::unique_ptr<StandaloneContext> ctx_;
   DataTable data_table_;
-  const std::vector<DataTable*> data_tables_{&data_table_};
+  DataTable dictionary_table_;
+  const std::vector<DataTable*> data_tables_{&data_table_, &dictionary_table_};
 
   bool column_ptrs_populated_ = false;
   std::shared_ptr<types::ColumnWrapper> trace_ids_column_;
@@ -23,12 +23,12 @@
 namespace px {
 namespace stirling {
 
-uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace) {
+StackTraceIDCache::InternResult StackTraceIDCache::Intern(const SymbolicStackTrace& stack_trace) {
   // Case 1: Stack trace ID is in the current set. Just return it.
   const auto it = stack_trace_ids_.find(stack_trace);
   if (it != stack_trace_ids_.end()) {
     const uint64_t stack_trace_id = it->second;
-    return stack_trace_id;
+    return {stack_trace_id, false};
   }
 
   // Case 2: Stack trace ID is in the previous set. Copy it to current set, and return it.
@@ -36,13 +36,13 @@ uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace) {
   if (it2 != prev_stack_trace_ids_.end()) {
     const uint64_t stack_trace_id = it2->second;
     stack_trace_ids_[stack_trace] = stack_trace_id;
-    return stack_trace_id;
+    return {stack_trace_id, true};
   }
 
   // Case 3: Stack trace ID is not in the current nor the previous set. Create a new ID.
   const uint64_t stack_trace_id = ++next_stack_trace_id_;
   stack_trace_ids_[stack_trace] = stack_trace_id;
-  return stack_trace_id;
+  return {stack_trace_id, true};
 }
 
 void StackTraceIDCache::AgeTick() {
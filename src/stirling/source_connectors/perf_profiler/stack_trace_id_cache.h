@@ -44,9 +44,27 @@ namespace stirling {
 //
 // For cases where the same stack trace ID shows up with different IDs,
 // the UI will aggregate the identical stack traces for us in the visualization.
+//
+// The upper 32 bits of the IDs hold an instance ID, so that the IDs of a restarted agent do not
+// collide with the IDs that the previous run assigned to other stack traces of the same UPID.
 class StackTraceIDCache {
  public:
-  uint64_t Lookup(const SymbolicStackTrace& stack_trace);
+  explicit StackTraceIDCache(uint32_t instance_id = 0)
+      : next_stack_trace_id_(static_cast<uint64_t>(instance_id) << 32) {}
+
+  struct InternResult {
+    uint64_t stack_trace_id;
+
+    // True if this is the first lookup of the stack trace in the current generation.
+    // Every stack trace that stays in use is reported once per generation, so consumers that
+    // publish the ID => stack trace mapping can periodically refresh it.
+    bool first_in_generation;
+  };
+
+  InternResult Intern(const SymbolicStackTrace& stack_trace);
+  uint64_t Lookup(const SymbolicStackTrace& stack_trace) {
+    return Intern(stack_trace).stack_trace_id;
+  }
   void AgeTick();
 
  private:
@@ -55,7 +73,7 @@ class StackTraceIDCache {
 
   // Tracks the next stack-trace-id to be assigned;
   // incremented by 1 for each such assignment.
-  uint64_t next_stack_trace_id_ = 0;
+  uint64_t next_stack_trace_id_;
 };
 
 }  // namespace stirling
@@ -51,5 +51,45 @@ TEST(StackTraceIDCache, Basic) {
   EXPECT_NE(stack_trace_ids.Lookup(kStackTrace2), id2);
 }
 
+TEST(StackTraceIDCache, Intern) {
+  StackTraceIDCache stack_trace_ids;
+
+  const md::UPID kUPID(1, 1, 1);
+  const SymbolicStackTrace kStackTrace1{kUPID, "a();b();c();"};
+
+  StackTraceIDCache::InternResult result = stack_trace_ids.Intern(kStackTrace1);
+  const uint64_t id1 = result.stack_trace_id;
+  EXPECT_TRUE(result.first_in_generation);
+
+  result = stack_trace_ids.Intern(kStackTrace1);
+  EXPECT_EQ(result.stack_trace_id, id1);
+  EXPECT_FALSE(result.first_in_generation);
+
+  // A stack trace that survives into the next generation keeps its ID,
+  // but is reported as new once, in each generation.
+  stack_trace_ids.AgeTick();
+  result = stack_trace_ids.Intern(kStackTrace1);
+  EXPECT_EQ(result.stack_trace_id, id1);
+  EXPECT_TRUE(result.first_in_generation);
+
+  result = stack_trace_ids.Intern(kStackTrace1);
+  EXPECT_EQ(result.stack_trace_id, id1);
+  EXPECT_FALSE(result.first_in_generation);
+}
+
+TEST(StackTraceIDCache, InstanceID) {
+  const md::UPID kUPID(1, 1, 1);
+  const SymbolicStackTrace kStackTrace1{kUPID, "a();b();c();"};
+
+  // The IDs of different instances, eg. before and after an agent restart, don't collide.
+  StackTraceIDCache stack_trace_ids1(1);
+  StackTraceIDCache stack_trace_ids2(2);
+  const uint64_t id1 = stack_trace_ids1.Lookup(kStackTrace1);
+  const uint64_t id2 = stack_trace_ids2.Lookup(kStackTrace1);
+  EXPECT_NE(id1, id2);
+  EXPECT_EQ(id1 >> 32, 1);
+  EXPECT_EQ(id2 >> 32, 2);
+}
+
 }  // namespace stirling
 }  // namespace px
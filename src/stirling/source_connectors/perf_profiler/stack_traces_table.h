@@ -32,12 +32,14 @@ static constexpr DataElement kElements[] = {
     canonical_data_elements::kUPID,
     {"stack_trace_id",
      "A unique identifier of the stack trace, for script-writing convenience. "
-     "String representation is in the `stack_trace` column.",
+     "String representation is in the `stack_trace` column, or in the "
+     "stack_trace_dictionary.beta table if stack traces are interned.",
      types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"stack_trace",
      "A stack trace within the sampled process, in folded format. "
      "The call stack symbols are separated by semicolons. "
-     "If symbols cannot be resolved, addresses are populated instead.",
+     "If symbols cannot be resolved, addresses are populated instead. "
+     "Empty if stack traces are interned.",
      types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"count",
      "Number of times the stack trace has been sampled.",
@@ -53,11 +55,43 @@ constexpr auto kStackTraceTable = DataTableSchema(
 // clang-format on
 DEFINE_PRINT_TABLE(StackTrace)
 
+// clang-format off
+static constexpr DataElement kDictionaryElements[] = {
+    canonical_data_elements::kTime,
+    canonical_data_elements::kUPID,
+    {"stack_trace_id",
+     "A unique identifier of the stack trace, "
+     "matching the `stack_trace_id` column of the stack_traces.beta table.",
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"stack_trace",
+     "A stack trace within the sampled process, in folded format. "
+     "The call stack symbols are separated by semicolons. "
+     "If symbols cannot be resolved, addresses are populated instead.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+};
+
+constexpr auto kStackTraceDictionaryTable = DataTableSchema(
+        "stack_trace_dictionary.beta",
+        "Folded stack traces of the stack_traces.beta table, keyed by upid and stack_trace_id. "
+        "Only populated when stack traces are interned, in which case a stack trace is recorded "
+        "here when it first appears, and periodically while it remains in use, "
+        "instead of in every stack_traces.beta record.",
+        kDictionaryElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(StackTraceDictionary)
+
 constexpr int kStackTraceTimeIdx = kStackTraceTable.ColIndex("time_");
 constexpr int kStackTraceUPIDIdx = kStackTraceTable.ColIndex("upid");
 constexpr int kStackTraceStackTraceIDIdx = kStackTraceTable.ColIndex("stack_trace_id");
 constexpr int kStackTraceStackTraceStrIdx = kStackTraceTable.ColIndex("stack_trace");
 constexpr int kStackTraceCountIdx = kStackTraceTable.ColIndex("count");
 
+constexpr int kStackTraceDictionaryUPIDIdx = kStackTraceDictionaryTable.ColIndex("upid");
+constexpr int kStackTraceDictionaryStackTraceIDIdx =
+    kStackTraceDictionaryTable.ColIndex("stack_trace_id");
+constexpr int kStackTraceDictionaryStackTraceStrIdx =
+    kStackTraceDictionaryTable.ColIndex("stack_trace");
+
 }  // namespace stirling
 }  // namespace px
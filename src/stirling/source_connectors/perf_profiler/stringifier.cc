@@ -19,6 +19,8 @@
 #include "src/stirling/source_connectors/perf_profiler/stringifier.h"
 #include <stdint.h>
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 namespace px {
@@ -80,6 +82,53 @@ std::string Stringifier::FindOrBuildStackTraceString(const int stack_id, Symboli
   return iter->second;
 }
 
+void Stringifier::BuildUserStackTraceStrings(absl::Span<const stack_trace_key_t> keys) {
+  constexpr bool kClearStackId = true;
+
+  struct UserStackTrace {
+    int stack_id;
+    struct upid_t upid;
+    std::vector<uintptr_t> addrs;
+  };
+  std::vector<UserStackTrace> user_stack_traces;
+
+  // Read each stack trace once, and gather the addresses of each process.
+  absl::flat_hash_map<struct upid_t, std::vector<uintptr_t>> upid_addrs;
+  for (const stack_trace_key_t& key : keys) {
+    if (key.user_stack_id < 0) {
+      continue;
+    }
+    // Claim the stack-id, so that it is read only once; the string is filled in below.
+    if (!stack_trace_strs_.try_emplace(key.user_stack_id, "").second) {
+      continue;
+    }
+    std::vector<uintptr_t> addrs = stack_traces_->get_stack_addr(key.user_stack_id, kClearStackId);
+    VLOG_IF(1, addrs.empty()) << absl::Substitute("[empty_stack_trace] stack_id: $0",
+                                                  key.user_stack_id);
+    std::vector<uintptr_t>& all_addrs = upid_addrs[key.upid];
+    all_addrs.insert(all_addrs.end(), addrs.begin(), addrs.end());
+    user_stack_traces.push_back({key.user_stack_id, key.upid, std::move(addrs)});
+  }
+
+  absl::flat_hash_map<struct upid_t, std::vector<std::string>> upid_symbols;
+  for (auto& [upid, addrs] : upid_addrs) {
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+    u_symbolizer_->SymbolizeSorted(upid, addrs, &upid_symbols[upid]);
+  }
+
+  for (const UserStackTrace& stack_trace : user_stack_traces) {
+    const std::vector<uintptr_t>& addrs = upid_addrs[stack_trace.upid];
+    const std::vector<std::string>& symbols = upid_symbols[stack_trace.upid];
+    auto symbolize_fn = [&addrs, &symbols](const uintptr_t addr) -> std::string_view {
+      const auto iter = std::lower_bound(addrs.begin(), addrs.end(), addr);
+      return symbols[iter - addrs.begin()];
+    };
+    stack_trace_strs_[stack_trace.stack_id] =
+        BuildStackTraceString(stack_trace.addrs, symbolize_fn, stringifier::kUserSuffix);
+  }
+}
+
 std::string Stringifier::FoldedStackTraceString(const stack_trace_key_t& key) {
   using stringifier::kKernSuffix;
   using stringifier::kUserSuffix;
@@ -21,6 +21,8 @@
 #include <string>
 #include <vector>
 
+#include <absl/types/span.h>
+
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
@@ -80,6 +82,13 @@ class Stringifier {
   // passed into FindOrBuildStackTraceString().
   std::string FoldedStackTraceString(const stack_trace_key_t& key);
 
+  /**
+   * Builds the user stack trace strings of a batch of keys up front, with one call to
+   * Symbolizer::SymbolizeSorted() per process, instead of one symbol lookup per stack frame.
+   * FoldedStackTraceString() then finds the user stack trace strings of these keys memoized.
+   */
+  void BuildUserStackTraceStrings(absl::Span<const stack_trace_key_t> keys);
+
  private:
   std::string BuildStackTraceString(const std::vector<uintptr_t>& addrs, SymbolizerFn symbolize_fn,
                                     const std::string_view& suffix);
@@ -291,6 +291,50 @@ TEST_F(StringifierTest, MemoizationTest) {
   }
 }
 
+TEST_F(StringifierTest, BuildUserStackTraceStrings) {
+  const uint64_t foo_addr = reinterpret_cast<uint64_t>(&::test::Foo);
+  const uint64_t bar_addr = reinterpret_cast<uint64_t>(&::test::Bar);
+  const std::filesystem::path self_path = GetSelfPath().ValueOrDie();
+
+  for (const uint64_t addr : {foo_addr, bar_addr}) {
+    const bpf_tools::UProbeSpec uprobe{.binary_path = self_path,
+                                       .symbol = {},
+                                       .address = addr,
+                                       .attach_type = bpf_tools::BPFProbeAttachType::kEntry,
+                                       .probe_fn = "stack_trace_sampler"};
+    ASSERT_OK(bcc_wrapper_.AttachUProbe(uprobe));
+  }
+
+  const uint32_t pid = ::test::Foo();
+  ::test::Bar();
+  bcc_wrapper_.Close();
+
+  constexpr bool kClearTable = true;
+  constexpr bool kNoClearStackId = false;
+  const auto histo = histogram_->get_table_offline(kClearTable);
+
+  std::vector<Key> keys;
+  for (const auto& [key, count] : histo) {
+    if (key.upid.pid == pid && key.user_stack_id >= 0) {
+      keys.push_back(MakeUserStackTraceKey(pid, key.user_stack_id));
+    }
+  }
+  ASSERT_FALSE(keys.empty());
+
+  // The batch reads, and clears, all the user stack traces at once.
+  stringifier_->BuildUserStackTraceStrings(keys);
+  for (const Key& key : keys) {
+    EXPECT_TRUE(stack_traces_->get_stack_addr(key.user_stack_id, kNoClearStackId).empty());
+  }
+
+  // The stack trace strings are the same as when they are built one at a time.
+  for (const Key& key : keys) {
+    const StringVec symbols =
+        absl::StrSplit(stringifier_->FoldedStackTraceString(key), stringifier::kSeparator);
+    EXPECT_THAT(symbols.back(), AnyOfArray(kPossibleUSyms));
+  }
+}
+
 TEST_F(StringifierTest, KernelDropMessageTest) {
   const pid_t pid = getpid();
 
@@ -43,6 +43,28 @@ SymbolCache::LookupResult SymbolCache::Lookup(const uintptr_t addr) {
   return SymbolCache::LookupResult{iter->second.symbol_, !inserted};
 }
 
+const std::string* SymbolCache::Find(const uintptr_t addr) {
+  const auto iter = cache_.find(addr);
+  if (iter != cache_.end()) {
+    return &iter->second.symbol_;
+  }
+
+  // Move a hit in the old cache to the new cache, like Lookup() does.
+  const auto prev_cache_iter = prev_cache_.find(addr);
+  if (prev_cache_iter == prev_cache_.end()) {
+    return nullptr;
+  }
+  auto [curr_cache_iter, inserted] =
+      cache_.try_emplace(addr, std::move(prev_cache_iter->second.symbol_));
+  DCHECK(inserted);
+  prev_cache_.erase(prev_cache_iter);
+  return &curr_cache_iter->second.symbol_;
+}
+
+void SymbolCache::Insert(const uintptr_t addr, std::string symbol) {
+  cache_.try_emplace(addr, std::move(symbol));
+}
+
 size_t SymbolCache::PerformEvictions() {
   size_t evict_count = prev_cache_.size();
   prev_cache_ = std::move(cache_);
@@ -40,6 +40,17 @@ class SymbolCache {
 
   LookupResult Lookup(const uintptr_t addr);
 
+  /**
+   * Returns the cached symbol of the address, or nullptr if it is not cached. Unlike Lookup(),
+   * this does not symbolize the address on a miss.
+   */
+  const std::string* Find(const uintptr_t addr);
+
+  /**
+   * Caches a symbol that was looked up by the caller, e.g. as part of a batch.
+   */
+  void Insert(const uintptr_t addr, std::string symbol);
+
   size_t PerformEvictions();
 
   size_t active_entries() const { return cache_.size(); }
@@ -16,7 +16,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
@@ -26,10 +28,26 @@ using ::px::stirling::obj_tools::ElfReader;
 DEFINE_uint64(
     stirling_profiler_cache_eviction_threshold, 0,
     "Number of symbols in the current generation of the cache that triggers an eviction.");
+DEFINE_string(stirling_profiler_symbol_cache_dir, "",
+              "Directory in which the ELF symbolizer persists symbol tables, keyed by build-id, "
+              "so they can be reused after a restart. Empty disables persistence.");
+DEFINE_uint64(stirling_profiler_symbol_cache_max_bytes, 256 * 1024 * 1024,
+              "Once the symbol tables in --stirling_profiler_symbol_cache_dir take more than this, "
+              "the least recently used ones are deleted. 0 means no limit.");
 
 namespace px {
 namespace stirling {
 
+void Symbolizer::SymbolizeSorted(const struct upid_t& upid, absl::Span<const uintptr_t> addrs,
+                                 std::vector<std::string>* symbols) {
+  SymbolizerFn symbolize_fn = GetSymbolizerFn(upid);
+  symbols->clear();
+  symbols->reserve(addrs.size());
+  for (const uintptr_t addr : addrs) {
+    symbols->emplace_back(symbolize_fn(addr));
+  }
+}
+
 StatusOr<std::unique_ptr<Symbolizer>> BCCSymbolizer::Create() {
   return std::unique_ptr<Symbolizer>(new BCCSymbolizer());
 }
@@ -54,15 +72,28 @@ SymbolizerFn BCCSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
   return fn;
 }
 
-StatusOr<std::unique_ptr<Symbolizer>> ElfSymbolizer::Create() {
-  ElfSymbolizer* elf_symbolizer = new ElfSymbolizer();
+StatusOr<std::unique_ptr<Symbolizer>> ElfSymbolizer::Create(
+    std::filesystem::path symbol_cache_dir, uint64_t max_symbol_cache_bytes) {
+  ElfSymbolizer* elf_symbolizer =
+      new ElfSymbolizer(std::move(symbol_cache_dir), max_symbol_cache_bytes);
   auto symbolizer = std::unique_ptr<Symbolizer>(elf_symbolizer);
   return symbolizer;
 }
 
-void ElfSymbolizer::DeleteUPID(const struct upid_t& upid) { symbolizers_.erase(upid); }
+void ElfSymbolizer::DeleteUPID(const struct upid_t& upid) {
+  auto iter = symbolizers_.find(upid);
+  if (iter == symbolizers_.end()) {
+    return;
+  }
+  const std::string binary_key = std::move(iter->second.binary_key);
+  symbolizers_.erase(iter);
 
-StatusOr<std::unique_ptr<ElfReader::Symbolizer>> CreateUPIDSymbolizer(const struct upid_t& upid) {
+  // The symbol table is freed along with its last user; also drop its entry from the cache.
+  symbolizer_cache_.RemoveExpired(binary_key);
+}
+
+Status ElfSymbolizer::CreateUPIDSymbolizer(const struct upid_t& upid,
+                                           UPIDSymbolizer* upid_symbolizer) {
   PL_ASSIGN_OR_RETURN(std::unique_ptr<FilePathResolver> fp_resolver,
                       FilePathResolver::Create(upid.pid));
   // TODO(yzhao): Might need to check the start time.
@@ -70,10 +101,11 @@ StatusOr<std::unique_ptr<ElfReader::Symbolizer>> CreateUPIDSymbolizer(const stru
                       system::ProcParser(system::Config::GetInstance()).GetExePath(upid.pid));
   PL_ASSIGN_OR_RETURN(std::filesystem::path host_proc_exe, fp_resolver->ResolvePath(proc_exe));
   host_proc_exe = system::Config::GetInstance().ToHostPath(host_proc_exe);
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(host_proc_exe));
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader::Symbolizer> upid_symbolizer,
-                      elf_reader->GetSymbolizer());
-  return upid_symbolizer;
+  PL_ASSIGN_OR_RETURN(std::string binary_key, symbolizer_cache_.BinaryKey(host_proc_exe));
+  PL_ASSIGN_OR_RETURN(upid_symbolizer->symbolizer,
+                      symbolizer_cache_.GetSymbolizer(binary_key, host_proc_exe));
+  upid_symbolizer->binary_key = std::move(binary_key);
+  return Status::OK();
 }
 
 std::string_view EmptySymbolizerFn(const uintptr_t addr) {
@@ -84,26 +116,58 @@ std::string_view EmptySymbolizerFn(const uintptr_t addr) {
 
 std::string_view BogusKernelSymbolizerFn(const uintptr_t) { return "<kernel symbol>"; }
 
+namespace {
+constexpr uint32_t kKernelPID = static_cast<uint32_t>(-1);
+}  // namespace
+
+const ElfReader::Symbolizer* ElfSymbolizer::GetUPIDSymbolizer(const struct upid_t& upid) {
+  UPIDSymbolizer& upid_symbolizer = symbolizers_[upid];
+  if (upid_symbolizer.symbolizer == nullptr) {
+    Status s = CreateUPIDSymbolizer(upid, &upid_symbolizer);
+    if (!s.ok()) {
+      VLOG(1) << absl::Substitute("Failed to create Symbolizer function for $0 [error=$1]",
+                                  upid.pid, s.ToString());
+      return nullptr;
+    }
+  }
+  return upid_symbolizer.symbolizer.get();
+}
+
 SymbolizerFn ElfSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
-  constexpr uint32_t kKernelPID = static_cast<uint32_t>(-1);
   if (upid.pid == kKernelPID) {
     return SymbolizerFn(&(BogusKernelSymbolizerFn));
   }
 
-  std::unique_ptr<ElfReader::Symbolizer>& upid_symbolizer = symbolizers_[upid];
+  const ElfReader::Symbolizer* upid_symbolizer = GetUPIDSymbolizer(upid);
   if (upid_symbolizer == nullptr) {
-    StatusOr<std::unique_ptr<ElfReader::Symbolizer>> upid_symbolizer_status =
-        CreateUPIDSymbolizer(upid);
-    if (!upid_symbolizer_status.ok()) {
-      VLOG(1) << absl::Substitute("Failed to create Symbolizer function for $0 [error=$1]",
-                                  upid.pid, upid_symbolizer_status.ToString());
-      return SymbolizerFn(&(EmptySymbolizerFn));
-    }
+    return SymbolizerFn(&(EmptySymbolizerFn));
+  }
+
+  return std::bind(&ElfReader::Symbolizer::Lookup, upid_symbolizer, std::placeholders::_1);
+}
 
-    upid_symbolizer = upid_symbolizer_status.ConsumeValueOrDie();
+void ElfSymbolizer::SymbolizeSorted(const struct upid_t& upid, absl::Span<const uintptr_t> addrs,
+                                    std::vector<std::string>* symbols) {
+  const ElfReader::Symbolizer* upid_symbolizer =
+      upid.pid == kKernelPID ? nullptr : GetUPIDSymbolizer(upid);
+  if (upid_symbolizer == nullptr) {
+    Symbolizer::SymbolizeSorted(upid, addrs, symbols);
+    return;
   }
 
-  return std::bind(&ElfReader::Symbolizer::Lookup, upid_symbolizer.get(), std::placeholders::_1);
+  std::vector<std::string_view> found_symbols;
+  upid_symbolizer->LookupSorted(addrs, &found_symbols);
+
+  symbols->clear();
+  symbols->reserve(addrs.size());
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    if (found_symbols[i].empty()) {
+      // Unknown addresses are printed like ElfReader::Symbolizer::Lookup() does.
+      symbols->emplace_back(EmptySymbolizerFn(addrs[i]));
+    } else {
+      symbols->emplace_back(found_symbols[i]);
+    }
+  }
 }
 
 StatusOr<std::unique_ptr<Symbolizer>> CachingSymbolizer::Create(
@@ -114,17 +178,54 @@ StatusOr<std::unique_ptr<Symbolizer>> CachingSymbolizer::Create(
   return uptr;
 }
 
-SymbolizerFn CachingSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
-  using std::placeholders::_1;
+SymbolCache* CachingSymbolizer::GetSymbolCache(const struct upid_t& upid) {
   const auto [iter, inserted] = symbol_caches_.try_emplace(upid, nullptr);
   if (inserted) {
     iter->second = std::make_unique<SymbolCache>(symbolizer_->GetSymbolizerFn(upid));
   }
-  auto& cache = iter->second;
-  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, cache.get(), _1);
+  return iter->second.get();
+}
+
+SymbolizerFn CachingSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
+  using std::placeholders::_1;
+  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, GetSymbolCache(upid), _1);
   return fn;
 }
 
+void CachingSymbolizer::SymbolizeSorted(const struct upid_t& upid,
+                                        absl::Span<const uintptr_t> addrs,
+                                        std::vector<std::string>* symbols) {
+  SymbolCache* symbol_cache = GetSymbolCache(upid);
+
+  symbols->clear();
+  symbols->resize(addrs.size());
+
+  // The addresses that miss stay in order, so they can be symbolized as a batch.
+  std::vector<uintptr_t> miss_addrs;
+  std::vector<size_t> miss_positions;
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    ++stat_accesses_;
+    const std::string* symbol = symbol_cache->Find(addrs[i]);
+    if (symbol != nullptr) {
+      ++stat_hits_;
+      (*symbols)[i] = *symbol;
+    } else {
+      miss_addrs.push_back(addrs[i]);
+      miss_positions.push_back(i);
+    }
+  }
+  if (miss_addrs.empty()) {
+    return;
+  }
+
+  std::vector<std::string> miss_symbols;
+  symbolizer_->SymbolizeSorted(upid, miss_addrs, &miss_symbols);
+  for (size_t i = 0; i < miss_addrs.size(); ++i) {
+    (*symbols)[miss_positions[i]] = miss_symbols[i];
+    symbol_cache->Insert(miss_addrs[i], std::move(miss_symbols[i]));
+  }
+}
+
 void CachingSymbolizer::DeleteUPID(const struct upid_t& upid) {
   // The inner map is owned by a unique_ptr; this will free the memory.
   symbol_caches_.erase(upid);
@@ -21,15 +21,21 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <absl/types/span.h>
 
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/source_connectors/perf_profiler/build_id_symbolizer_cache.h"
 #include "src/stirling/source_connectors/perf_profiler/symbol_cache.h"
 #include "src/stirling/source_connectors/perf_profiler/types.h"
 
 DECLARE_uint64(stirling_profiler_cache_eviction_threshold);
+DECLARE_string(stirling_profiler_symbol_cache_dir);
+DECLARE_uint64(stirling_profiler_symbol_cache_max_bytes);
 
 namespace px {
 namespace stirling {
@@ -60,6 +66,18 @@ class Symbolizer {
    * Delete the state associated with a symbolizer created by a previous call to GetSymbolizerFn
    */
   virtual void DeleteUPID(const struct upid_t& upid) = 0;
+
+  /**
+   * Converts a batch of addresses of the process to symbols, with the same results as the
+   * symbolizer function. Symbolizers that can walk their symbol table in address order override
+   * this; by default, each address is looked up on its own.
+   *
+   * @param upid The process of the addresses.
+   * @param addrs The addresses, in ascending order.
+   * @param symbols Populated with one symbol per address.
+   */
+  virtual void SymbolizeSorted(const struct upid_t& upid, absl::Span<const uintptr_t> addrs,
+                               std::vector<std::string>* symbols);
 };
 
 /**
@@ -81,21 +99,46 @@ class BCCSymbolizer : public Symbolizer, public NotCopyMoveable {
 
 /**
  * A Symbolizer using the ElfReader symbolization core.
+ * Processes that run the same binary share a single symbol table.
  */
 class ElfSymbolizer : public Symbolizer, public NotCopyMoveable {
  public:
-  static StatusOr<std::unique_ptr<Symbolizer>> Create();
+  /**
+   * @param symbol_cache_dir Directory in which symbol tables are persisted across restarts.
+   *                         Empty disables persistence.
+   * @param max_symbol_cache_bytes Limit on the size of symbol_cache_dir. 0 means no limit.
+   */
+  static StatusOr<std::unique_ptr<Symbolizer>> Create(
+      std::filesystem::path symbol_cache_dir = FLAGS_stirling_profiler_symbol_cache_dir,
+      uint64_t max_symbol_cache_bytes = FLAGS_stirling_profiler_symbol_cache_max_bytes);
 
   SymbolizerFn GetSymbolizerFn(const struct upid_t& upid) override;
   void DeleteUPID(const struct upid_t& upid) override;
+  void SymbolizeSorted(const struct upid_t& upid, absl::Span<const uintptr_t> addrs,
+                       std::vector<std::string>* symbols) override;
+
+  const BuildIDSymbolizerCache& symbolizer_cache() const { return symbolizer_cache_; }
 
  private:
-  ElfSymbolizer() = default;
+  ElfSymbolizer(std::filesystem::path symbol_cache_dir, uint64_t max_symbol_cache_bytes)
+      : symbolizer_cache_(std::move(symbol_cache_dir), max_symbol_cache_bytes) {}
 
-  // A symbolizer per UPID.
-  absl::flat_hash_map<struct upid_t,
-                      std::unique_ptr<px::stirling::obj_tools::ElfReader::Symbolizer>>
-      symbolizers_;
+  struct UPIDSymbolizer {
+    // The key of the binary in symbolizer_cache_.
+    std::string binary_key;
+    std::shared_ptr<const obj_tools::ElfReader::Symbolizer> symbolizer;
+  };
+
+  Status CreateUPIDSymbolizer(const struct upid_t& upid, UPIDSymbolizer* upid_symbolizer);
+  // Returns nullptr if the binary of the UPID could not be read.
+  const obj_tools::ElfReader::Symbolizer* GetUPIDSymbolizer(const struct upid_t& upid);
+
+  // Finds the symbol table of a binary, keyed by build-id. It only holds weak references; the
+  // tables are owned by the UPID symbolizers below.
+  BuildIDSymbolizerCache symbolizer_cache_;
+
+  // A symbolizer per UPID. UPIDs running the same binary point to the same symbolizer.
+  absl::flat_hash_map<struct upid_t, UPIDSymbolizer> symbolizers_;
 };
 
 /**
@@ -108,6 +151,13 @@ class CachingSymbolizer : public Symbolizer {
   SymbolizerFn GetSymbolizerFn(const struct upid_t& upid) override;
 
   void DeleteUPID(const struct upid_t& upid) override;
+
+  /**
+   * Symbols that are not cached yet are converted by the underlying symbolizer in a single batch.
+   */
+  void SymbolizeSorted(const struct upid_t& upid, absl::Span<const uintptr_t> addrs,
+                       std::vector<std::string>* symbols) override;
+
   size_t PerformEvictions();
 
   int64_t stat_accesses() const { return stat_accesses_; }
@@ -116,6 +166,7 @@ class CachingSymbolizer : public Symbolizer {
  private:
   CachingSymbolizer() = default;
 
+  SymbolCache* GetSymbolCache(const struct upid_t& upid);
   std::string_view Symbolize(SymbolCache* symbol_cache, const uintptr_t addr);
 
   std::unique_ptr<Symbolizer> symbolizer_;
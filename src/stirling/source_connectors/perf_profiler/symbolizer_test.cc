@@ -18,7 +18,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <set>
+#include <string>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
@@ -65,6 +68,53 @@ TYPED_TEST(SymbolizerTest, UserSymbols) {
   EXPECT_EQ(symbolize(2), std::string("0x0000000000000002"));
 }
 
+TYPED_TEST(SymbolizerTest, SymbolizeSorted) {
+  const struct upid_t this_upid = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 0};
+
+  std::vector<uintptr_t> addrs = {2, kFooAddr, kBarAddr};
+  std::sort(addrs.begin(), addrs.end());
+
+  std::vector<std::string> symbols;
+  this->symbolizer_->SymbolizeSorted(this_upid, addrs, &symbols);
+
+  // The same symbols as looking up the addresses one at a time.
+  auto symbolize = this->symbolizer_->GetSymbolizerFn(this_upid);
+  ASSERT_EQ(symbols.size(), addrs.size());
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    EXPECT_EQ(symbols[i], symbolize(addrs[i]));
+  }
+  EXPECT_THAT(symbols, ::testing::Contains("test::foo()"));
+  EXPECT_THAT(symbols, ::testing::Contains("0x0000000000000002"));
+}
+
+TEST_F(ElfSymbolizerTest, CachingSymbolizeSorted) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Symbolizer> symbolizer_uptr,
+                       CachingSymbolizer::Create(std::move(symbolizer_)));
+  CachingSymbolizer& symbolizer = *static_cast<CachingSymbolizer*>(symbolizer_uptr.get());
+
+  const struct upid_t this_upid = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 0};
+  std::vector<std::string> symbols;
+
+  // Only foo() is cached before the batch; bar() is a miss that is symbolized in the batch.
+  {
+    auto symbolize = symbolizer.GetSymbolizerFn(this_upid);
+    EXPECT_EQ(symbolize(kFooAddr), "test::foo()");
+  }
+  const std::vector<uintptr_t> addrs = {std::min(kFooAddr, kBarAddr), std::max(kFooAddr, kBarAddr)};
+  symbolizer.SymbolizeSorted(this_upid, addrs, &symbols);
+  EXPECT_EQ(symbolizer.stat_accesses(), 3);
+  EXPECT_EQ(symbolizer.stat_hits(), 1);
+  EXPECT_THAT(symbols, ::testing::UnorderedElementsAre("test::foo()", "test::bar()"));
+
+  // The batch filled the cache.
+  {
+    auto symbolize = symbolizer.GetSymbolizerFn(this_upid);
+    EXPECT_EQ(symbolize(kBarAddr), "test::bar()");
+    EXPECT_EQ(symbolizer.stat_accesses(), 4);
+    EXPECT_EQ(symbolizer.stat_hits(), 2);
+  }
+}
+
 TEST_F(BCCSymbolizerTest, KernelSymbols) {
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<Symbolizer> symbolizer, BCCSymbolizer::Create());
 
@@ -42,7 +42,7 @@ Status ProcessStatsConnector::StopImpl() { return Status::OK(); }
 
 void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
                                                       DataTable* data_table) {
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
+  const md::PIDInfoMap& pid_info_by_upid = ctx->GetPIDInfoMap();
 
   int64_t timestamp = AdjustedSteadyClockNowNS();
 
@@ -57,14 +57,25 @@ void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
     int32_t pid = upid.pid();
     // TODO(zasgar): We should double check the process start time to make sure it still the same
     // PID.
-    auto s1 = proc_parser_->ParseProcPIDStat(pid, &stats);
+    // Open the PID directory once, so the files below are resolved relative to it, instead of
+    // walking the full path each time. It is closed again at the end of the iteration, so that
+    // the number of open files does not scale with the number of processes.
+    StatusOr<ProcParser::PIDDir> pid_dir_or = proc_parser_->OpenPIDDir(pid);
+    if (!pid_dir_or.ok()) {
+      VLOG(1) << absl::Substitute("Failed to open proc dir for PID ($0). Error=\"$1\" skipping.",
+                                  pid, pid_dir_or.msg());
+      continue;
+    }
+    const ProcParser::PIDDir& pid_dir = pid_dir_or.ValueOrDie();
+
+    auto s1 = proc_parser_->ParseProcPIDStat(pid_dir, &stats);
     if (!s1.ok()) {
       VLOG(1) << absl::Substitute(
           "Failed to fetch cpu stat info for PID ($0). Error=\"$1\" skipping.", pid, s1.msg());
       continue;
     }
 
-    auto s2 = proc_parser_->ParseProcPIDStatIO(pid, &stats);
+    auto s2 = proc_parser_->ParseProcPIDStatIO(pid_dir, &stats);
     if (!s2.ok()) {
       VLOG(1) << absl::Substitute(
           "Failed to fetch IO stat info for PID ($0). Error=\"$1\" skipping.", pid, s2.msg());
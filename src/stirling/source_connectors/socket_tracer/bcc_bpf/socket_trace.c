@@ -105,6 +105,23 @@ BPF_HASH(active_sendfile_args_map, uint64_t, struct sendfile_args_t);
 BPF_PERCPU_ARRAY(socket_data_event_buffer_heap, struct socket_data_event_t, 1);
 BPF_PERCPU_ARRAY(conn_stats_event_buffer_heap, struct conn_stats_event_t, 1);
 
+// Per-protocol policies that control how much data is sent to user-space.
+// Indexed by traffic_protocol_t. This map is only written from user-space.
+BPF_ARRAY(protocol_trace_policy_map, struct trace_policy_t, kNumProtocols);
+
+// Per-endpoint overrides of protocol_trace_policy_map.
+// This map is only written from user-space.
+// Key is {tgid, remote port}, where either field may be zero to act as a wildcard.
+// The local port is not tracked, so port policies only match the client side of connections;
+// on the server side, the remote port is ephemeral.
+BPF_HASH(endpoint_trace_policy_map, struct trace_policy_key_t, struct trace_policy_t,
+         MAX_ENDPOINT_TRACE_POLICIES);
+
+// Per-protocol count of data events that could not be submitted to socket_data_events,
+// typically because the perf buffer was full. Indexed by traffic_protocol_t.
+// This map is only read from user-space.
+BPF_PERCPU_ARRAY(data_event_loss_map, uint64_t, kNumProtocols);
+
 // This array records singular values that are used by probes. We group them together to reduce the
 // number of arrays with only 1 element.
 BPF_PERCPU_ARRAY(control_values, int64_t, kNumControlValues);
@@ -113,6 +130,15 @@ BPF_PERCPU_ARRAY(control_values, int64_t, kNumControlValues);
  * General helper functions
  ***********************************************************/
 
+// Counts a data event that failed to be submitted against the event's protocol.
+static __inline void count_data_event_loss(const struct socket_data_event_t* event) {
+  int protocol = event->attr.protocol;
+  uint64_t* count = data_event_loss_map.lookup(&protocol);
+  if (count != NULL) {
+    ++(*count);
+  }
+}
+
 static __inline uint64_t gen_tgid_fd(uint32_t tgid, int fd) {
   return ((uint64_t)tgid << 32) | (uint32_t)fd;
 }
@@ -219,6 +245,60 @@ static __inline bool should_trace_protocol_data(const struct conn_info_t* conn_i
   return control & conn_info->role;
 }
 
+// Returns the trace policy of the connection, with the following order of precedence:
+//   {tgid, port} > {tgid, *} > {*, port} > protocol.
+// The port is that of the remote endpoint, so port policies only apply to client-side connections.
+// Returns NULL if no policy applies.
+static __inline const struct trace_policy_t* get_trace_policy(
+    const struct conn_info_t* conn_info) {
+  struct trace_policy_key_t key = {};
+  key.tgid = conn_info->conn_id.upid.tgid;
+  // sin_port and sin6_port are at the same offset, and are left as zero for unknown families.
+  key.port = conn_info->addr.in4.sin_port;
+
+  struct trace_policy_t* policy = endpoint_trace_policy_map.lookup(&key);
+  if (policy != NULL) {
+    return policy;
+  }
+
+  uint32_t port = key.port;
+  key.port = 0;
+  policy = endpoint_trace_policy_map.lookup(&key);
+  if (policy != NULL) {
+    return policy;
+  }
+
+  key.tgid = 0;
+  key.port = port;
+  policy = endpoint_trace_policy_map.lookup(&key);
+  if (policy != NULL) {
+    return policy;
+  }
+
+  int protocol = conn_info->protocol;
+  return protocol_trace_policy_map.lookup(&protocol);
+}
+
+static __inline bool is_sampled_conn(const struct trace_policy_t* policy,
+                                     const struct conn_info_t* conn_info) {
+  if (policy == NULL || policy->sample_ratio <= 1) {
+    return true;
+  }
+
+  // The TSID is a timestamp, which may have coarse granularity on some clocks,
+  // so scramble it before bucketing.
+  uint64_t hash = conn_info->conn_id.tsid * 0x9E3779B97F4A7C15ULL;
+  return (hash >> 32) % policy->sample_ratio == 0;
+}
+
+static __inline size_t get_max_submit_bytes(const struct trace_policy_t* policy,
+                                            size_t buf_size) {
+  if (policy == NULL || policy->max_bytes == 0 || policy->max_bytes > buf_size) {
+    return buf_size;
+  }
+  return policy->max_bytes;
+}
+
 static __inline bool is_stirling_tgid(const uint32_t tgid) {
   int idx = kStirlingTGIDIndex;
   int64_t* stirling_tgid = control_values.lookup(&idx);
@@ -434,20 +514,39 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_dir
   // If-statement is redundant, but is required to keep the 4.14 verifier happy.
   if (amount_copied > 0) {
     event->attr.msg_buf_size = amount_copied;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + amount_copied);
+    if (socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + amount_copied) != 0) {
+      count_data_event_loss(event);
+    }
   }
 }
 
+// Reports bytes that were not copied to user-space with a data-less event,
+// so that user-space still accounts for their positions in the stream.
+static __inline void perf_submit_filler(struct pt_regs* ctx, size_t filler_size,
+                                        struct socket_data_event_t* event) {
+  if (filler_size == 0) {
+    return;
+  }
+
+  event->attr.msg_size = filler_size;
+  event->attr.msg_buf_size = 0;
+  if (socket_data_events.perf_submit(ctx, event, sizeof(event->attr)) != 0) {
+    count_data_event_loss(event);
+  }
+}
+
+// Submits up to submit_size bytes of buf, and reports the rest of buf as a filler event.
 static __inline void perf_submit_wrapper(struct pt_regs* ctx,
                                          const enum traffic_direction_t direction, const char* buf,
-                                         const size_t buf_size, struct conn_info_t* conn_info,
+                                         const size_t buf_size, const size_t submit_size,
+                                         struct conn_info_t* conn_info,
                                          struct socket_data_event_t* event) {
   int bytes_sent = 0;
   unsigned int i;
 
 #pragma unroll
   for (i = 0; i < CHUNK_LIMIT; ++i) {
-    const int bytes_remaining = buf_size - bytes_sent;
+    const int bytes_remaining = submit_size - bytes_sent;
     const size_t current_size =
         (bytes_remaining > MAX_MSG_SIZE && (i != CHUNK_LIMIT - 1)) ? MAX_MSG_SIZE : bytes_remaining;
     perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, conn_info, event);
@@ -456,12 +555,17 @@ static __inline void perf_submit_wrapper(struct pt_regs* ctx,
     // Move the position for the next event.
     event->attr.pos += current_size;
   }
+
+  if (bytes_sent < buf_size) {
+    perf_submit_filler(ctx, buf_size - bytes_sent, event);
+  }
 }
 
 static __inline void perf_submit_iovecs(struct pt_regs* ctx,
                                         const enum traffic_direction_t direction,
                                         const struct iovec* iov, const size_t iovlen,
-                                        const size_t total_size, struct conn_info_t* conn_info,
+                                        const size_t total_size, const size_t submit_size,
+                                        struct conn_info_t* conn_info,
                                         struct socket_data_event_t* event) {
   // NOTE: The syscalls for scatter buffers, {send,recv}msg()/{write,read}v(), access buffers in
   // array order. That means they read or fill iov[0], then iov[1], and so on. They return the total
@@ -469,11 +573,11 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
   // buffers and the total size need to be checked. More details can be found on their man pages.
   int bytes_sent = 0;
 #pragma unroll
-  for (int i = 0; i < LOOP_LIMIT && i < iovlen && bytes_sent < total_size; ++i) {
+  for (int i = 0; i < LOOP_LIMIT && i < iovlen && bytes_sent < submit_size; ++i) {
     struct iovec iov_cpy;
     bpf_probe_read(&iov_cpy, sizeof(struct iovec), &iov[i]);
 
-    const int bytes_remaining = total_size - bytes_sent;
+    const int bytes_remaining = submit_size - bytes_sent;
     const size_t iov_size = iov_cpy.iov_len < bytes_remaining ? iov_cpy.iov_len : bytes_remaining;
 
     // TODO(oazizi/yzhao): Should switch this to go through perf_submit_wrapper.
@@ -485,8 +589,11 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
     event->attr.pos += iov_size;
   }
 
-  // TODO(oazizi): If there is data left after the loop limit, we should still report the remainder
-  //               with a data-less event.
+  // Data truncated by the trace policy, or left after the loop limit,
+  // is reported as a data-less event.
+  if (bytes_sent < total_size) {
+    perf_submit_filler(ctx, total_size - bytes_sent, event);
+  }
 }
 
 /***********************************************************
@@ -732,21 +839,29 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
     }
 
     if (should_send_data(tgid, conn_disabled_tsid, force_trace_tgid, conn_info)) {
-      struct socket_data_event_t* event =
-          fill_socket_data_event(args->source_fn, direction, conn_info);
-      if (event == NULL) {
-        // event == NULL not expected to ever happen.
-        return;
-      }
-
-      // TODO(yzhao): Same TODO for split the interface.
-      if (!vecs) {
-        perf_submit_wrapper(ctx, direction, args->buf, bytes_count, conn_info, event);
-      } else {
-        // TODO(yzhao): iov[0] is copied twice, once in calling update_traffic_class(), and here.
-        // This happens to the write probes as well, but the calls are placed in the entry and
-        // return probes respectively. Consider remove one copy.
-        perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, conn_info, event);
+      // Only looked up once the data is known to be sent, since it costs up to 4 map lookups.
+      const struct trace_policy_t* policy = get_trace_policy(conn_info);
+      if (is_sampled_conn(policy, conn_info)) {
+        struct socket_data_event_t* event =
+            fill_socket_data_event(args->source_fn, direction, conn_info);
+        if (event == NULL) {
+          // event == NULL not expected to ever happen.
+          return;
+        }
+
+        const size_t submit_size = get_max_submit_bytes(policy, bytes_count);
+
+        // TODO(yzhao): Same TODO for split the interface.
+        if (!vecs) {
+          perf_submit_wrapper(ctx, direction, args->buf, bytes_count, submit_size, conn_info,
+                              event);
+        } else {
+          // TODO(yzhao): iov[0] is copied twice, once in calling update_traffic_class(), and here.
+          // This happens to the write probes as well, but the calls are placed in the entry and
+          // return probes respectively. Consider remove one copy.
+          perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, submit_size,
+                             conn_info, event);
+        }
       }
     }
   }
@@ -829,7 +944,9 @@ static __inline void process_syscall_sendfile(struct pt_regs* ctx, uint64_t id,
     event->attr.pos = conn_info->wr_bytes;
     event->attr.msg_size = bytes_count;
     event->attr.msg_buf_size = 0;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr));
+    if (socket_data_events.perf_submit(ctx, event, sizeof(event->attr)) != 0) {
+      count_data_event_loss(event);
+    }
   }
 
   update_conn_stats(ctx, conn_info, kEgress, bytes_count);
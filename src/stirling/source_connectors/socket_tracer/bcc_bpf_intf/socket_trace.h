@@ -31,6 +31,34 @@ const uint64_t kSocketTraceNothing = 0;
 
 const int64_t kTraceAllTGIDs = -1;
 const char kControlValuesArrayName[] = "control_values";
+const char kProtocolTracePolicyMapName[] = "protocol_trace_policy_map";
+const char kEndpointTracePolicyMapName[] = "endpoint_trace_policy_map";
+const char kDataEventLossMapName[] = "data_event_loss_map";
+
+// Controls how much of the data on a connection is sent from BPF to user-space.
+// These policies are applied before any data is copied into the perf buffer,
+// so data that is filtered out by a policy does not consume perf buffer bandwidth.
+struct trace_policy_t {
+  // Trace the data of one out of every sample_ratio connections.
+  // Sampling is per connection, so a sampled connection is traced in its entirety.
+  // A value of 0 or 1 means all connections are traced.
+  uint32_t sample_ratio;
+
+  // The maximum number of bytes of each data event that are sent to user-space.
+  // The remainder of the event is reported as a data-less filler event.
+  // A value of 0 means no limit beyond the inherent MAX_MSG_SIZE * CHUNK_LIMIT.
+  uint32_t max_bytes;
+};
+
+// Key of the per-endpoint trace policies, which take precedence over the per-protocol policies.
+// A value of 0 for either field acts as a wildcard.
+struct trace_policy_key_t {
+  uint32_t tgid;
+  // The port of the remote endpoint, in network byte order.
+  uint32_t port;
+};
+
+#define MAX_ENDPOINT_TRACE_POLICIES 1024
 
 // Note: A value of 100 results in >4096 BPF instructions, which is too much for older kernels.
 #define CONN_CLEANUP_ITERS 90
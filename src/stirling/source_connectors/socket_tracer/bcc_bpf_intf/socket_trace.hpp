@@ -69,25 +69,9 @@ struct SocketDataEvent {
     // Use attr.msg_buf_size to only copy the data included in the buffer.
     // msg_buf_size may differ from msg_size when the message has been truncated or
     // when only metadata is being sent (e.g. unknown protocols or disabled trackers).
+    // The bytes that were not transferred are filled in by DataStream.
     msg.append(static_cast<const char*>(data) + offsetof(socket_data_event_t, msg),
                attr.msg_buf_size);
-
-    // Hack: Create a filler event for sendfile data.
-    // We need a better long-term solution for this,
-    // since we aren't able to directly trace the data.
-    if (attr.msg_buf_size != attr.msg_size) {
-      DCHECK_GT(attr.msg_size, attr.msg_buf_size);
-      VLOG(1) << "Adding filler to event";
-
-      // Limit the size so we don't have huge allocations.
-      constexpr uint32_t kMaxFilledSizeBytes = 1 * 1024 * 1024;
-
-      size_t filled_size = std::min(attr.msg_size, kMaxFilledSizeBytes);
-      msg.resize(filled_size, 0);
-      if (attr.msg_size > kMaxFilledSizeBytes) {
-        VLOG(1) << absl::Substitute("Event too large: $0", attr.msg_size);
-      }
-    }
   }
 
   std::string ToString() const {
@@ -349,14 +349,25 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
 
 template <>
 std::vector<protocols::http2::Record>
-ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>() {
+ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>(
+    ProtocolProcessingStats* processing_stats) {
   protocols::RecordsWithErrorCount<protocols::http2::Record> result;
 
+  // HTTP2 frames are parsed by the uprobes, so there is only the stitching cost to account for.
+  auto stitch_start = std::chrono::steady_clock::now();
+
   protocols::http2::ProcessHTTP2Streams(&http2_client_streams_, IsZombie(), &result);
   protocols::http2::ProcessHTTP2Streams(&http2_server_streams_, IsZombie(), &result);
 
   UpdateResultStats(result);
 
+  if (processing_stats != nullptr) {
+    auto stitch_end = std::chrono::steady_clock::now();
+    processing_stats->stitch_ns += (stitch_end - stitch_start) / std::chrono::nanoseconds(1);
+    processing_stats->valid_records += result.records.size();
+    processing_stats->invalid_records += result.error_count;
+  }
+
   return std::move(result.records);
 }
 
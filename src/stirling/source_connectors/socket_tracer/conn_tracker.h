@@ -19,6 +19,7 @@
 #pragma once
 
 #include <any>
+#include <chrono>
 #include <deque>
 #include <list>
 #include <map>
@@ -57,6 +58,22 @@ namespace stirling {
 // Forward declaration to avoid circular include and conn_tracker.h.
 class ConnTrackersManager;
 
+/**
+ * The cost of turning raw data events into records, accumulated across all ConnTrackers of a
+ * protocol. Used for the socket tracer's self-telemetry.
+ */
+struct ProtocolProcessingStats {
+  // Bytes consumed from the raw data buffers, including bytes that were discarded as unparseable.
+  uint64_t bytes_processed = 0;
+  uint64_t valid_frames = 0;
+  uint64_t invalid_frames = 0;
+  uint64_t valid_records = 0;
+  uint64_t invalid_records = 0;
+  // Time spent in ProcessBytesToFrames() and StitchFrames() respectively.
+  uint64_t parse_ns = 0;
+  uint64_t stitch_ns = 0;
+};
+
 /**
  * Describes a connection from user space. This corresponds to struct conn_info_t in
  * src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.h.
@@ -241,17 +258,21 @@ class ConnTracker : NotCopyMoveable {
    * and frames into record.
    *
    * @tparam TRecordType the type of the entries to be parsed.
+   * @param processing_stats If not null, the cost of the processing is added to it.
    * @return Vector of processed entries.
    */
   template <typename TProtocolTraits>
-  std::vector<typename TProtocolTraits::record_type> ProcessToRecords() {
+  std::vector<typename TProtocolTraits::record_type> ProcessToRecords(
+      ProtocolProcessingStats* processing_stats = nullptr) {
     using TRecordType = typename TProtocolTraits::record_type;
     using TFrameType = typename TProtocolTraits::frame_type;
     using TStateType = typename TProtocolTraits::state_type;
 
     InitProtocolState<TStateType>();
 
-    DataStreamsToFrames<TFrameType, TStateType>();
+    auto parse_start = std::chrono::steady_clock::now();
+    DataStreamsToFrames<TFrameType, TStateType>(processing_stats);
+    auto parse_end = std::chrono::steady_clock::now();
 
     auto& req_frames = req_data()->Frames<TFrameType>();
     auto& resp_frames = resp_data()->Frames<TFrameType>();
@@ -268,6 +289,14 @@ class ConnTracker : NotCopyMoveable {
 
     UpdateResultStats(result);
 
+    if (processing_stats != nullptr) {
+      auto stitch_end = std::chrono::steady_clock::now();
+      processing_stats->parse_ns += (parse_end - parse_start) / std::chrono::nanoseconds(1);
+      processing_stats->stitch_ns += (stitch_end - parse_end) / std::chrono::nanoseconds(1);
+      processing_stats->valid_records += result.records.size();
+      processing_stats->invalid_records += result.error_count;
+    }
+
     return result.records;
   }
 
@@ -599,18 +628,34 @@ class ConnTracker : NotCopyMoveable {
   void UpdateDataStats(const SocketDataEvent& event);
 
   template <typename TFrameType, typename TStateType>
-  void DataStreamsToFrames() {
+  void DataStreamsToFrames(ProtocolProcessingStats* processing_stats) {
     auto state_ptr = protocol_state<TStateType>();
 
     DataStream* req_data_ptr = req_data();
     DCHECK_NE(req_data_ptr, nullptr);
-    req_data_ptr->template ProcessBytesToFrames<TFrameType, TStateType>(message_type_t::kRequest,
-                                                                        state_ptr);
-
     DataStream* resp_data_ptr = resp_data();
     DCHECK_NE(resp_data_ptr, nullptr);
+
+    const size_t orig_req_pos = req_data_ptr->data_buffer().position();
+    const size_t orig_resp_pos = resp_data_ptr->data_buffer().position();
+    const int orig_valid_frames =
+        req_data_ptr->stat_valid_frames() + resp_data_ptr->stat_valid_frames();
+    const int orig_invalid_frames =
+        req_data_ptr->stat_invalid_frames() + resp_data_ptr->stat_invalid_frames();
+
+    req_data_ptr->template ProcessBytesToFrames<TFrameType, TStateType>(message_type_t::kRequest,
+                                                                        state_ptr);
     resp_data_ptr->template ProcessBytesToFrames<TFrameType, TStateType>(message_type_t::kResponse,
                                                                          state_ptr);
+
+    if (processing_stats != nullptr) {
+      processing_stats->bytes_processed += (req_data_ptr->data_buffer().position() - orig_req_pos) +
+                                           (resp_data_ptr->data_buffer().position() - orig_resp_pos);
+      processing_stats->valid_frames +=
+          req_data_ptr->stat_valid_frames() + resp_data_ptr->stat_valid_frames() - orig_valid_frames;
+      processing_stats->invalid_frames += req_data_ptr->stat_invalid_frames() +
+                                          resp_data_ptr->stat_invalid_frames() - orig_invalid_frames;
+    }
   }
 
   template <typename TRecordType>
@@ -708,7 +753,8 @@ class ConnTracker : NotCopyMoveable {
 // See https://en.cppreference.com/w/cpp/language/member_template
 template <>
 std::vector<protocols::http2::Record>
-ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>();
+ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>(
+    ProtocolProcessingStats* processing_stats);
 
 template <typename TProtocolTraits>
 std::string DebugString(const ConnTracker& c, std::string_view prefix) {
@@ -131,6 +131,57 @@ TEST_F(ConnTrackerTest, ReqRespMatchingSimple) {
   EXPECT_EQ(records[2].resp.body, "bar");
 }
 
+// Tests that a request and response whose bodies were truncated in BPF still produce a record,
+// and that the parser resumes at the next message.
+TEST_F(ConnTrackerTest, ReqRespMatchingTruncated) {
+  constexpr std::string_view kReq =
+      "POST /upload HTTP/1.1\r\n"
+      "Content-Length: 10\r\n"
+      "\r\n"
+      "0123456789";
+  constexpr std::string_view kResp =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 10\r\n"
+      "\r\n"
+      "abcdefghij";
+  constexpr size_t kTruncatedBytes = 6;
+
+  testing::EventGenerator event_gen(&real_clock_);
+  struct socket_control_event_t conn = event_gen.InitConn();
+  std::unique_ptr<SocketDataEvent> req0 = event_gen.InitSendEvent<kProtocolHTTP>(kReq);
+  std::unique_ptr<SocketDataEvent> resp0 = event_gen.InitRecvEvent<kProtocolHTTP>(kResp);
+  std::unique_ptr<SocketDataEvent> req1 = event_gen.InitSendEvent<kProtocolHTTP>(kHTTPReq1);
+  std::unique_ptr<SocketDataEvent> resp1 = event_gen.InitRecvEvent<kProtocolHTTP>(kHTTPResp1);
+  struct socket_control_event_t close_event = event_gen.InitClose();
+
+  // Drop the tail of the bodies, as BPF does when it transfers only a prefix of the message.
+  for (auto* event : {req0.get(), resp0.get()}) {
+    event->msg.resize(event->msg.size() - kTruncatedBytes);
+    event->attr.msg_buf_size = event->msg.size();
+  }
+
+  ConnTracker tracker;
+  tracker.AddControlEvent(conn);
+  tracker.AddDataEvent(std::move(req0));
+  tracker.AddDataEvent(std::move(resp0));
+  tracker.AddDataEvent(std::move(req1));
+  tracker.AddDataEvent(std::move(resp1));
+  tracker.AddControlEvent(close_event);
+
+  std::vector<http::Record> records = tracker.ProcessToRecords<http::ProtocolTraits>();
+
+  ASSERT_EQ(2, records.size());
+
+  EXPECT_EQ(records[0].req.req_method, "POST");
+  EXPECT_EQ(records[0].req.req_path, "/upload");
+  EXPECT_EQ(records[0].req.BodySize(), 10);
+  EXPECT_EQ(records[0].resp.resp_status, 200);
+  EXPECT_EQ(records[0].resp.BodySize(), 10);
+
+  EXPECT_EQ(records[1].req.req_path, "/foo.html");
+  EXPECT_EQ(records[1].resp.body, "foo");
+}
+
 TEST_F(ConnTrackerTest, DISABLED_ReqRespMatchingPipelined) {
   testing::EventGenerator event_gen(&real_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
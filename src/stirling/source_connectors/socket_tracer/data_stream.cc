@@ -33,11 +33,16 @@ namespace px {
 namespace stirling {
 
 void DataStream::AddData(std::unique_ptr<SocketDataEvent> event) {
-  LOG_IF(WARNING, event->attr.msg_size > event->msg.size() && !event->msg.empty())
-      << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
-                          event->attr.msg_size, event->msg.size());
+  // The bytes that were not transferred, eg. for sendfile or messages truncated by the trace
+  // policy, are filled in, so that the parser can still consume the message.
+  size_t filler_size = 0;
+  if (event->attr.msg_size > event->attr.msg_buf_size) {
+    filler_size = event->attr.msg_size - event->attr.msg_buf_size;
+    VLOG(1) << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
+                                event->attr.msg_size, event->attr.msg_buf_size);
+  }
 
-  data_buffer_.Add(event->attr.pos, event->msg, event->attr.timestamp_ns);
+  data_buffer_.Add(event->attr.pos, event->msg, filler_size, event->attr.timestamp_ns);
 
   has_new_events_ = true;
 }
@@ -0,0 +1,293 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/go_symaddrs_cache.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <absl/strings/match.h>
+
+#include "src/common/base/byte_utils.h"
+#include "src/common/base/file.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/stirling/obj_tools/dwarf_reader.h"
+#include "src/stirling/source_connectors/socket_tracer/uprobe_symaddrs.h"
+#include "src/stirling/utils/binary_decoder.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::obj_tools::DwarfReader;
+using ::px::stirling::obj_tools::ElfReader;
+
+namespace {
+
+constexpr std::string_view kSymAddrsMagic = "pxgosymaddrs";
+// The files of each build of the agent are kept apart, which already catches layout changes.
+// The version and the struct sizes are a second line of defense.
+constexpr uint32_t kSymAddrsVersion = 1;
+
+// Each struct is written as its size (zero if absent), followed by its raw bytes.
+// The files are only ever read back by the same agent build on the same host (see
+// GoSymAddrsCache::AgentID()), so the in-memory representation is good enough.
+template <typename TSymAddrs>
+void AppendSymAddrs(const std::optional<TSymAddrs>& symaddrs, std::string* out) {
+  static_assert(std::is_trivially_copyable_v<TSymAddrs>);
+  char size_bytes[sizeof(uint32_t)];
+  utils::IntToLEndianBytes(symaddrs.has_value() ? sizeof(TSymAddrs) : 0, size_bytes);
+  out->append(size_bytes, sizeof(size_bytes));
+  if (symaddrs.has_value()) {
+    out->append(reinterpret_cast<const char*>(&symaddrs.value()), sizeof(TSymAddrs));
+  }
+}
+
+template <typename TSymAddrs>
+StatusOr<std::optional<TSymAddrs>> ExtractSymAddrs(BinaryDecoder* decoder) {
+  PL_ASSIGN_OR_RETURN(std::string_view size_bytes, decoder->ExtractString(sizeof(uint32_t)));
+  const auto size = utils::LEndianBytesToInt<uint32_t>(size_bytes);
+  if (size == 0) {
+    return std::optional<TSymAddrs>();
+  }
+  if (size != sizeof(TSymAddrs)) {
+    return error::InvalidArgument("Unexpected symaddrs size $0, expected $1.", size,
+                                  sizeof(TSymAddrs));
+  }
+  PL_ASSIGN_OR_RETURN(std::string_view bytes, decoder->ExtractString(size));
+  TSymAddrs symaddrs;
+  std::memcpy(&symaddrs, bytes.data(), sizeof(TSymAddrs));
+  return std::optional<TSymAddrs>(symaddrs);
+}
+
+template <typename TSymAddrs>
+std::optional<TSymAddrs> OptionalFromStatusOr(StatusOr<TSymAddrs> symaddrs) {
+  if (!symaddrs.ok()) {
+    return std::nullopt;
+  }
+  return symaddrs.ConsumeValueOrDie();
+}
+
+// Whether the path is a file written by GoSymAddrsCache, or a directory of only such files.
+// Anything else in the cache directory is left alone.
+bool IsSymAddrsFileOrDir(const std::filesystem::path& path) {
+  std::error_code ec;
+  if (!std::filesystem::is_directory(path, ec)) {
+    return absl::StrContains(path.filename().string(), ".gosymaddrs");
+  }
+  for (std::filesystem::directory_iterator iter(path, ec), end; iter != end; iter.increment(ec)) {
+    if (ec || std::filesystem::is_directory(iter->path(), ec) ||
+        !absl::StrContains(iter->path().filename().string(), ".gosymaddrs")) {
+      return false;
+    }
+  }
+  return !ec;
+}
+
+}  // namespace
+
+std::string GoSymAddrsCache::AgentID() {
+  constexpr char kSelfExe[] = "/proc/self/exe";
+  StatusOr<std::string> build_id = obj_tools::ReadBuildID(kSelfExe);
+  if (build_id.ok()) {
+    return build_id.ConsumeValueOrDie();
+  }
+  StatusOr<uint64_t> hash = HashFileContents(kSelfExe);
+  if (hash.ok()) {
+    return absl::StrFormat("hash-%016x", hash.ValueOrDie());
+  }
+  LOG(WARNING) << absl::Substitute("Could not identify the agent binary [error=$0]",
+                                   hash.ToString());
+  return "";
+}
+
+GoSymAddrsCache::GoSymAddrsCache(std::filesystem::path cache_dir, int num_indexing_threads,
+                                 std::optional<std::string> agent_id)
+    : num_indexing_threads_(num_indexing_threads) {
+  if (cache_dir.empty()) {
+    return;
+  }
+  const std::string id = agent_id.has_value() ? agent_id.value() : AgentID();
+  if (id.empty()) {
+    LOG(WARNING) << "Unknown agent build, symaddrs will not be persisted";
+    return;
+  }
+
+  // Files written by other builds of the agent are never read again.
+  std::error_code ec;
+  for (std::filesystem::directory_iterator iter(cache_dir, ec), end; !ec && iter != end;
+       iter.increment(ec)) {
+    if (iter->path().filename() != id && IsSymAddrsFileOrDir(iter->path())) {
+      std::error_code remove_ec;
+      std::filesystem::remove_all(iter->path(), remove_ec);
+    }
+  }
+
+  cache_dir /= id;
+  Status s = fs::CreateDirectories(cache_dir);
+  if (!s.ok()) {
+    LOG(WARNING) << absl::Substitute(
+        "Could not create symaddrs cache directory $0, symaddrs will not be persisted [error=$1]",
+        cache_dir.string(), s.ToString());
+    return;
+  }
+  cache_dir_ = std::move(cache_dir);
+}
+
+std::string GoSymAddrsCache::Serialize(const GoSymAddrs& symaddrs) {
+  std::string out;
+  out.append(kSymAddrsMagic);
+  char version_bytes[sizeof(uint32_t)];
+  utils::IntToLEndianBytes(kSymAddrsVersion, version_bytes);
+  out.append(version_bytes, sizeof(version_bytes));
+  AppendSymAddrs(symaddrs.common, &out);
+  AppendSymAddrs(symaddrs.http2, &out);
+  AppendSymAddrs(symaddrs.tls, &out);
+  return out;
+}
+
+StatusOr<GoSymAddrs> GoSymAddrsCache::Deserialize(std::string_view data) {
+  BinaryDecoder decoder(data);
+
+  PL_ASSIGN_OR_RETURN(std::string_view magic, decoder.ExtractString(kSymAddrsMagic.size()));
+  if (magic != kSymAddrsMagic) {
+    return error::InvalidArgument("Not serialized Go symaddrs.");
+  }
+  PL_ASSIGN_OR_RETURN(std::string_view version_bytes, decoder.ExtractString(sizeof(uint32_t)));
+  const auto version = utils::LEndianBytesToInt<uint32_t>(version_bytes);
+  if (version != kSymAddrsVersion) {
+    return error::InvalidArgument("Unsupported Go symaddrs version $0, expected $1.", version,
+                                  kSymAddrsVersion);
+  }
+
+  GoSymAddrs symaddrs;
+  PL_ASSIGN_OR_RETURN(symaddrs.common, ExtractSymAddrs<struct go_common_symaddrs_t>(&decoder));
+  PL_ASSIGN_OR_RETURN(symaddrs.http2, ExtractSymAddrs<struct go_http2_symaddrs_t>(&decoder));
+  PL_ASSIGN_OR_RETURN(symaddrs.tls, ExtractSymAddrs<struct go_tls_symaddrs_t>(&decoder));
+  if (!decoder.eof()) {
+    return error::InvalidArgument("$0 unexpected trailing bytes.", decoder.BufSize());
+  }
+  return symaddrs;
+}
+
+std::filesystem::path GoSymAddrsCache::CacheFilePath(std::string_view build_id) const {
+  return cache_dir_ / absl::StrCat(build_id, ".gosymaddrs");
+}
+
+StatusOr<GoSymAddrs> GoSymAddrsCache::LoadSymAddrs(std::string_view build_id) {
+  if (!persistent()) {
+    return error::NotFound("Symaddrs are not persisted.");
+  }
+  const std::filesystem::path path = CacheFilePath(build_id);
+  PL_RETURN_IF_ERROR(fs::Exists(path));
+  PL_ASSIGN_OR_RETURN(std::string contents,
+                      ReadFileToString(path, std::ios::in | std::ios::binary));
+  StatusOr<GoSymAddrs> symaddrs = Deserialize(contents);
+  if (!symaddrs.ok()) {
+    // Most likely written by a different version; it gets overwritten once re-computed.
+    VLOG(1) << absl::Substitute("Ignoring unreadable symaddrs cache file $0 [error=$1]",
+                                path.string(), symaddrs.ToString());
+  }
+  return symaddrs;
+}
+
+Status GoSymAddrsCache::SaveSymAddrs(std::string_view build_id, const GoSymAddrs& symaddrs) {
+  // Write to a temporary file first, and then rename it into place, so that concurrent readers
+  // never observe a partially written file.
+  const std::filesystem::path path = CacheFilePath(build_id);
+  const std::filesystem::path tmp_path = absl::StrCat(path.string(), ".tmp.", getpid());
+  PL_RETURN_IF_ERROR(
+      WriteFileFromString(tmp_path, Serialize(symaddrs), std::ios::out | std::ios::binary));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return error::Internal("Failed to move $0 to $1 [error=$2]", tmp_path.string(), path.string(),
+                           ec.message());
+  }
+  return Status::OK();
+}
+
+StatusOr<GoSymAddrs> GoSymAddrsCache::GetSymAddrs(const std::filesystem::path& binary,
+                                                  ElfReader* elf_reader) {
+  // Binaries without a build-id are still served, just not cached.
+  StatusOr<std::string> build_id_status = obj_tools::ReadBuildID(binary);
+  const std::string build_id = build_id_status.ok() ? build_id_status.ConsumeValueOrDie() : "";
+
+  if (build_id.empty()) {
+    ++stat_dwarf_reads_;
+    return ComputeSymAddrs(binary, elf_reader);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Copies of the same binary (e.g. replicas of the same container) are often analyzed at the
+    // same time. Wait for the first one, instead of parsing the same DWARF info again.
+    pending_cv_.wait(lock, [this, &build_id]() { return !pending_build_ids_.contains(build_id); });
+
+    auto iter = symaddrs_.find(build_id);
+    if (iter != symaddrs_.end()) {
+      ++stat_memory_hits_;
+      return iter->second;
+    }
+    pending_build_ids_.insert(build_id);
+  }
+
+  StatusOr<GoSymAddrs> symaddrs_status = LoadSymAddrs(build_id);
+  if (symaddrs_status.ok()) {
+    ++stat_disk_hits_;
+  } else {
+    ++stat_dwarf_reads_;
+    symaddrs_status = ComputeSymAddrs(binary, elf_reader);
+    if (symaddrs_status.ok() && persistent()) {
+      Status s = SaveSymAddrs(build_id, symaddrs_status.ValueOrDie());
+      LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to persist symaddrs of $0 [error=$1]",
+                                                   binary.string(), s.ToString());
+    }
+  }
+
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    pending_build_ids_.erase(build_id);
+    if (symaddrs_status.ok()) {
+      symaddrs_[build_id] = symaddrs_status.ValueOrDie();
+    }
+  }
+  pending_cv_.notify_all();
+  return symaddrs_status;
+}
+
+StatusOr<GoSymAddrs> GoSymAddrsCache::ComputeSymAddrs(const std::filesystem::path& binary,
+                                                      ElfReader* elf_reader) {
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<DwarfReader> dwarf_reader,
+                      DwarfReader::CreateIndexingAll(binary, num_indexing_threads_));
+
+  GoSymAddrs symaddrs;
+  symaddrs.common = OptionalFromStatusOr(GoCommonSymAddrs(elf_reader, dwarf_reader.get()));
+  // The other uprobes are only deployed on top of the common ones.
+  if (symaddrs.common.has_value()) {
+    symaddrs.http2 = OptionalFromStatusOr(GoHTTP2SymAddrs(elf_reader, dwarf_reader.get()));
+    symaddrs.tls = OptionalFromStatusOr(GoTLSSymAddrs(elf_reader, dwarf_reader.get()));
+  }
+  return symaddrs;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * The symbol addresses of a Go binary that the Go uprobes need. A missing member means the binary
+ * does not have the corresponding symbols, so the corresponding uprobes do not apply to it.
+ */
+struct GoSymAddrs {
+  std::optional<struct go_common_symaddrs_t> common;
+  std::optional<struct go_http2_symaddrs_t> http2;
+  std::optional<struct go_tls_symaddrs_t> tls;
+};
+
+/**
+ * GoSymAddrsCache computes the GoSymAddrs of Go binaries from their DWARF info, and remembers them
+ * by build-id, so that other copies of the same binary (e.g. replicas of the same container image)
+ * do not need their DWARF info parsed again. Optionally, the symaddrs are also persisted in a local
+ * directory, so that the binaries that a restarted agent has seen before skip DWARF parsing
+ * entirely.
+ *
+ * GetSymAddrs() is thread-safe, so that different binaries can be analyzed in parallel.
+ */
+class GoSymAddrsCache : public NotCopyMoveable {
+ public:
+  /**
+   * @param cache_dir Directory in which symaddrs are persisted. Empty disables persistence.
+   * @param num_indexing_threads Number of threads used to index the DWARF info of new binaries.
+   * @param agent_id Identifies the build of the agent; defaults to AgentID(). Persisted symaddrs
+   *                 are only read back by the same build.
+   */
+  explicit GoSymAddrsCache(std::filesystem::path cache_dir = {}, int num_indexing_threads = 1,
+                           std::optional<std::string> agent_id = std::nullopt);
+
+  /**
+   * Returns the build-id of the running binary, or a hash of its contents if it has none.
+   * Returns an empty string if the binary cannot be read.
+   * The persisted symaddrs are raw copies of structs whose layout can change with every build,
+   * so only the build that wrote them can read them back.
+   */
+  static std::string AgentID();
+
+  /**
+   * Returns the symaddrs of the binary. The elf_reader must be for the same binary.
+   * Returns an error if the binary has no usable DWARF info.
+   * Thread-safe. Concurrent calls for copies of the same binary parse its DWARF info only once.
+   */
+  StatusOr<GoSymAddrs> GetSymAddrs(const std::filesystem::path& binary,
+                                   obj_tools::ElfReader* elf_reader);
+
+  static std::string Serialize(const GoSymAddrs& symaddrs);
+  static StatusOr<GoSymAddrs> Deserialize(std::string_view data);
+
+  int64_t stat_memory_hits() const { return stat_memory_hits_; }
+  int64_t stat_disk_hits() const { return stat_disk_hits_; }
+  int64_t stat_dwarf_reads() const { return stat_dwarf_reads_; }
+
+ private:
+  std::filesystem::path CacheFilePath(std::string_view build_id) const;
+  StatusOr<GoSymAddrs> ComputeSymAddrs(const std::filesystem::path& binary,
+                                       obj_tools::ElfReader* elf_reader);
+  StatusOr<GoSymAddrs> LoadSymAddrs(std::string_view build_id);
+  Status SaveSymAddrs(std::string_view build_id, const GoSymAddrs& symaddrs);
+
+  bool persistent() const { return !cache_dir_.empty(); }
+
+  // The directory of this build of the agent, within the cache directory given to the
+  // constructor. Empty if persistence is disabled.
+  std::filesystem::path cache_dir_;
+  const int num_indexing_threads_;
+
+  // Protects symaddrs_ and pending_build_ids_.
+  std::mutex mutex_;
+  std::condition_variable pending_cv_;
+
+  // Key is the build-id of the binary.
+  // The values are small and only created for Go binaries, so they are not evicted.
+  absl::flat_hash_map<std::string, GoSymAddrs> symaddrs_;
+
+  // The build-ids whose symaddrs are being computed by some thread.
+  absl::flat_hash_set<std::string> pending_build_ids_;
+
+  std::atomic<int64_t> stat_memory_hits_ = 0;
+  std::atomic<int64_t> stat_disk_hits_ = 0;
+  std::atomic<int64_t> stat_dwarf_reads_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
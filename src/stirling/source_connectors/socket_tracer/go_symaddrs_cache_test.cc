@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/go_symaddrs_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/base/file.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::obj_tools::ElfReader;
+using ::px::testing::TempDir;
+
+// Has a Go build-id.
+constexpr std::string_view kGoBinary = "src/stirling/obj_tools/testdata/go/test_go_1_17_binary";
+
+TEST(GoSymAddrsCacheTest, SerializeRoundTrip) {
+  GoSymAddrs symaddrs;
+  symaddrs.common = go_common_symaddrs_t{};
+  symaddrs.common->net_TCPConn = 0x1234;
+  symaddrs.common->FD_Sysfd_offset = 16;
+  symaddrs.tls = go_tls_symaddrs_t{};
+  symaddrs.tls->Write_b_loc = location_t{.type = kLocationTypeStack, .offset = 16};
+
+  ASSERT_OK_AND_ASSIGN(GoSymAddrs deserialized,
+                       GoSymAddrsCache::Deserialize(GoSymAddrsCache::Serialize(symaddrs)));
+  ASSERT_TRUE(deserialized.common.has_value());
+  EXPECT_EQ(deserialized.common->net_TCPConn, 0x1234);
+  EXPECT_EQ(deserialized.common->FD_Sysfd_offset, 16);
+  EXPECT_FALSE(deserialized.http2.has_value());
+  ASSERT_TRUE(deserialized.tls.has_value());
+  EXPECT_EQ(deserialized.tls->Write_b_loc, (location_t{.type = kLocationTypeStack, .offset = 16}));
+
+  EXPECT_NOT_OK(GoSymAddrsCache::Deserialize("garbage"));
+  std::string truncated = GoSymAddrsCache::Serialize(symaddrs);
+  truncated.pop_back();
+  EXPECT_NOT_OK(GoSymAddrsCache::Deserialize(truncated));
+}
+
+TEST(GoSymAddrsCacheTest, SharedAcrossBinaryCopies) {
+  const std::filesystem::path path = px::testing::TestFilePath(kGoBinary);
+  TempDir tmp_dir;
+  const std::filesystem::path copy_path = tmp_dir.path() / "copy_of_go_binary";
+  std::filesystem::copy_file(path, copy_path);
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(path.string()));
+
+  GoSymAddrsCache cache;
+  ASSERT_OK(cache.GetSymAddrs(path, elf_reader.get()));
+  ASSERT_OK(cache.GetSymAddrs(copy_path, elf_reader.get()));
+  EXPECT_EQ(cache.stat_dwarf_reads(), 1);
+  EXPECT_EQ(cache.stat_memory_hits(), 1);
+
+  EXPECT_NOT_OK(cache.GetSymAddrs("/bogus", elf_reader.get()));
+}
+
+TEST(GoSymAddrsCacheTest, ConcurrentCopiesParsedOnce) {
+  const std::filesystem::path path = px::testing::TestFilePath(kGoBinary);
+  TempDir tmp_dir;
+
+  constexpr int kNumCopies = 4;
+  std::vector<std::filesystem::path> copy_paths;
+  for (int i = 0; i < kNumCopies; ++i) {
+    copy_paths.push_back(tmp_dir.path() / absl::StrCat("copy_of_go_binary_", i));
+    std::filesystem::copy_file(path, copy_paths.back());
+  }
+
+  GoSymAddrsCache cache;
+  std::vector<Status> statuses(kNumCopies);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumCopies; ++i) {
+    threads.emplace_back([&cache, &copy_paths, &statuses, i]() {
+      StatusOr<std::unique_ptr<ElfReader>> elf_reader = ElfReader::Create(copy_paths[i].string());
+      statuses[i] = elf_reader.ok()
+                        ? cache.GetSymAddrs(copy_paths[i], elf_reader.ValueOrDie().get()).status()
+                        : elf_reader.status();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& s : statuses) {
+    EXPECT_OK(s);
+  }
+  EXPECT_EQ(cache.stat_dwarf_reads(), 1);
+  EXPECT_EQ(cache.stat_memory_hits(), kNumCopies - 1);
+}
+
+TEST(GoSymAddrsCacheTest, Persistence) {
+  const std::filesystem::path path = px::testing::TestFilePath(kGoBinary);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(path.string()));
+
+  TempDir cache_dir;
+  const std::string agent_id = GoSymAddrsCache::AgentID();
+  ASSERT_FALSE(agent_id.empty());
+
+  std::string serialized;
+  {
+    GoSymAddrsCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(GoSymAddrs symaddrs, cache.GetSymAddrs(path, elf_reader.get()));
+    serialized = GoSymAddrsCache::Serialize(symaddrs);
+    EXPECT_EQ(cache.stat_dwarf_reads(), 1);
+    EXPECT_EQ(cache.stat_disk_hits(), 0);
+  }
+
+  // A new cache, as after a restart, loads the symaddrs from disk instead of the DWARF info.
+  {
+    GoSymAddrsCache cache(cache_dir.path());
+    ASSERT_OK_AND_ASSIGN(GoSymAddrs symaddrs, cache.GetSymAddrs(path, elf_reader.get()));
+    EXPECT_EQ(GoSymAddrsCache::Serialize(symaddrs), serialized);
+    EXPECT_EQ(cache.stat_dwarf_reads(), 0);
+    EXPECT_EQ(cache.stat_disk_hits(), 1);
+  }
+
+  // Corrupted cache files are ignored, and replaced.
+  {
+    ASSERT_OK_AND_ASSIGN(std::string build_id, obj_tools::ReadBuildID(path));
+    ASSERT_OK(WriteFileFromString(
+        cache_dir.path() / agent_id / absl::StrCat(build_id, ".gosymaddrs"), "garbage"));
+
+    GoSymAddrsCache cache(cache_dir.path());
+    ASSERT_OK(cache.GetSymAddrs(path, elf_reader.get()));
+    EXPECT_EQ(cache.stat_dwarf_reads(), 1);
+    EXPECT_EQ(cache.stat_disk_hits(), 0);
+  }
+  {
+    GoSymAddrsCache cache(cache_dir.path());
+    ASSERT_OK(cache.GetSymAddrs(path, elf_reader.get()));
+    EXPECT_EQ(cache.stat_disk_hits(), 1);
+  }
+
+  // Another build of the agent does not read the files of this one, and deletes them.
+  {
+    GoSymAddrsCache cache(cache_dir.path(), /*num_indexing_threads*/ 1, "other_agent_build");
+    ASSERT_OK(cache.GetSymAddrs(path, elf_reader.get()));
+    EXPECT_EQ(cache.stat_dwarf_reads(), 1);
+    EXPECT_EQ(cache.stat_disk_hits(), 0);
+    EXPECT_FALSE(std::filesystem::exists(cache_dir.path() / agent_id));
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
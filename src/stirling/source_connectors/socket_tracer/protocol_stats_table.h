@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "src/stirling/core/types.h"
+#include "src/stirling/source_connectors/socket_tracer/canonical_types.h"
+
+namespace px {
+namespace stirling {
+
+// clang-format off
+constexpr DataElement kProtocolStatsElements[] = {
+        canonical_data_elements::kTime,
+        {"protocol", "The protocol that the stats are for.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM,
+         &kTrafficProtocolDecoder},
+        {"bytes_processed", "The number of raw bytes consumed by the protocol parser since the "
+         "beginning of tracing, including bytes that were discarded as unparseable.",
+         types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_COUNTER},
+        {"valid_frames", "The number of frames parsed since the beginning of tracing.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"invalid_frames", "The number of frames that failed to parse since the beginning of "
+         "tracing.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"valid_records", "The number of records produced since the beginning of tracing.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"invalid_records", "The number of frames that could not be stitched into records since "
+         "the beginning of tracing.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"parse_time", "The time spent parsing raw bytes into frames since the beginning of "
+         "tracing.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_COUNTER},
+        {"stitch_time", "The time spent stitching frames into records since the beginning of "
+         "tracing.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_COUNTER},
+        {"data_events_lost", "The number of data events that BPF failed to submit to the perf "
+         "buffer since the beginning of tracing.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+};
+// clang-format on
+
+constexpr DataTableSchema kProtocolStatsTable(
+    "socket_tracer_protocol_stats",
+    "Per-protocol cost of the socket tracer itself. This table reports how much data of each "
+    "protocol was processed, how long it took, and how much data was lost before reaching "
+    "user-space.",
+    kProtocolStatsElements);
+DEFINE_PRINT_TABLE(ProtocolStats)
+
+namespace protocol_stats_idx {
+
+constexpr int kTime = kProtocolStatsTable.ColIndex("time_");
+constexpr int kProtocol = kProtocolStatsTable.ColIndex("protocol");
+constexpr int kBytesProcessed = kProtocolStatsTable.ColIndex("bytes_processed");
+constexpr int kValidFrames = kProtocolStatsTable.ColIndex("valid_frames");
+constexpr int kInvalidFrames = kProtocolStatsTable.ColIndex("invalid_frames");
+constexpr int kValidRecords = kProtocolStatsTable.ColIndex("valid_records");
+constexpr int kInvalidRecords = kProtocolStatsTable.ColIndex("invalid_records");
+constexpr int kParseTime = kProtocolStatsTable.ColIndex("parse_time");
+constexpr int kStitchTime = kProtocolStatsTable.ColIndex("stitch_time");
+constexpr int kDataEventsLost = kProtocolStatsTable.ColIndex("data_events_lost");
+
+}  // namespace protocol_stats_idx
+
+}  // namespace stirling
+}  // namespace px
@@ -106,16 +106,21 @@ void DataStreamBuffer::AddNewTimestamp(size_t pos, uint64_t timestamp) {
   timestamps_[pos] = timestamp;
 }
 
-void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp) {
+void DataStreamBuffer::Add(size_t pos, std::string_view data, size_t filler_size,
+                           uint64_t timestamp) {
+  if (data.size() + filler_size > capacity_) {
+    filler_size = 0;
+  }
   if (data.size() > capacity_) {
     size_t oversize_amount = data.size() - capacity_;
     data.remove_prefix(oversize_amount);
     pos += oversize_amount;
   }
+  size_t size = data.size() + filler_size;
 
   // Calculate physical positions (ppos) where the data would live in the physical buffer.
   ssize_t ppos_front = pos - position_;
-  ssize_t ppos_back = pos + data.size() - position_;
+  ssize_t ppos_back = pos + size - position_;
 
   if (ppos_back < 0) {
     // Case 1: Data being added is too far back. Just ignore it.
@@ -133,12 +138,18 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     VLOG(1) << absl::Substitute(
         "Event is partially too far in the past [event pos=$0, current pos=$1].", pos, position_);
 
-    ssize_t prefix = 0 - ppos_front;
-    data.remove_prefix(prefix);
+    size_t prefix = 0 - ppos_front;
+    size_t data_prefix = std::min(prefix, data.size());
+    data.remove_prefix(data_prefix);
+    filler_size -= prefix - data_prefix;
+    size -= prefix;
     pos += prefix;
     ppos_front = 0;
-  } else if (ppos_back > static_cast<ssize_t>(buffer_.size())) {
+  }
+
+  if (ppos_back > static_cast<ssize_t>(buffer_.size())) {
     // Case 3: Data being added extends the buffer. Resize the buffer.
+    // This also applies to data that straddles the front-side, if it is longer than the buffer.
 
     if (pos > position_ + capacity_) {
       // This has been observed to happen a lot on initial deployment,
@@ -148,7 +159,7 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
                                   position_);
     }
 
-    ssize_t logical_size = pos + data.size() - position_;
+    ssize_t logical_size = pos + size - position_;
     if (logical_size > static_cast<ssize_t>(capacity_)) {
       // The movement of the buffer position will cause some bytes to "fall off",
       // remove those now.
@@ -180,11 +191,12 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     // No adjustments required.
   }
 
-  // Now copy the data into the buffer.
+  // Now copy the data into the buffer, followed by the filler.
   memcpy(buffer_.data() + ppos_front, data.data(), data.size());
+  memset(buffer_.data() + ppos_front + data.size(), 0, filler_size);
 
   // Update the metadata.
-  AddNewChunk(pos, data.size());
+  AddNewChunk(pos, size);
   AddNewTimestamp(pos, timestamp);
 }
 
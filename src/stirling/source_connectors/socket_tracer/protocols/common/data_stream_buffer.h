@@ -56,7 +56,23 @@ class DataStreamBuffer {
    * @param data The data to insert.
    * @param timestamp Timestamp to associate with the data.
    */
-  void Add(size_t pos, std::string_view data, uint64_t timestamp);
+  void Add(size_t pos, std::string_view data, uint64_t timestamp) {
+    Add(pos, data, /* filler_size */ 0, timestamp);
+  }
+
+  /**
+   * Adds data to the buffer like the above, followed by filler_size zero bytes that stand in for
+   * data that was not transferred from BPF, eg. because the trace policy truncated the message.
+   * The filler keeps the message contiguous, so that the parser can still consume it and resume
+   * at the next message. A filler that doesn't fit in the buffer along with its data is left out,
+   * as a gap, since it would otherwise push its own message out of the buffer.
+   *
+   * @param pos Position at which to insert the data.
+   * @param data The data to insert.
+   * @param filler_size The number of bytes that follow data in the stream but were not captured.
+   * @param timestamp Timestamp to associate with the data.
+   */
+  void Add(size_t pos, std::string_view data, size_t filler_size, uint64_t timestamp);
 
   /**
    * Get all the contiguous data at the specified position of the buffer.
@@ -291,6 +291,30 @@ TEST(DataStreamTest, SizeAndGetPos) {
   EXPECT_FALSE(stream_buffer.empty());
 }
 
+TEST(DataStreamTest, AddWithFiller) {
+  DataStreamBuffer stream_buffer(15);
+
+  // The filler stands in for the bytes that weren't transferred, so the next event is contiguous.
+  stream_buffer.Add(0, "0123", /* filler_size */ 3, 0);
+  stream_buffer.Add(7, "789", 7);
+  EXPECT_EQ(stream_buffer.Head(), ConstStringView("0123\0\0\0789"));
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(5), 0);
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(8), 7);
+
+  // A filler-only event, as for sendfile.
+  stream_buffer.Add(10, "", /* filler_size */ 2, 10);
+  EXPECT_EQ(stream_buffer.Get(10), ConstStringView("\0\0"));
+  EXPECT_EQ(stream_buffer.size(), 12);
+
+  // A filler that doesn't fit in the buffer is left out, leaving a gap.
+  stream_buffer.Add(12, "cd", /* filler_size */ 20, 12);
+  EXPECT_EQ(stream_buffer.Get(12), "cd");
+  EXPECT_EQ(stream_buffer.size(), 14);
+  stream_buffer.Add(34, "yz", 34);
+  EXPECT_EQ(stream_buffer.Head(), "");
+  EXPECT_EQ(stream_buffer.Get(34), "yz");
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
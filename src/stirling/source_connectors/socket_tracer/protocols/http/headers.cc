@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/headers.h"
+
+#include <algorithm>
+
+#include <absl/strings/match.h>
+
+#include "src/common/base/utils.h"
+#include "src/common/json/json.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http {
+
+HeadersMap::HeadersMap(std::initializer_list<value_type> headers) {
+  size_t num_bytes = 0;
+  for (const auto& [name, value] : headers) {
+    num_bytes += name.size() + value.size();
+  }
+  reserve(headers.size(), num_bytes);
+
+  for (const auto& header : headers) {
+    insert(header);
+  }
+}
+
+void HeadersMap::insert(std::string_view name, std::string_view value) {
+  Entry& e = entries_.emplace_back();
+  e.name_pos = buf_.size();
+  e.name_len = name.size();
+  buf_.append(name);
+  e.value_pos = buf_.size();
+  e.value_len = value.size();
+  buf_.append(value);
+}
+
+HeadersMap::const_iterator HeadersMap::find(std::string_view name) const {
+  // Messages rarely have more than a few dozen headers, for which a linear scan is faster than
+  // an ordered or hashed index.
+  for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+    if (iter->name_len == name.size() && absl::EqualsIgnoreCase(Get(*iter).first, name)) {
+      return const_iterator(this, iter);
+    }
+  }
+  return end();
+}
+
+std::string HeadersMap::ToJSONString() const {
+  utils::JSONObjectBuilder builder;
+  for (const Entry& e : entries_) {
+    auto [name, value] = Get(e);
+    builder.WriteKV(name, value);
+  }
+  return builder.GetString();
+}
+
+std::vector<HeadersMap::value_type> HeadersMap::SortedByName() const {
+  std::vector<value_type> headers(begin(), end());
+  std::stable_sort(headers.begin(), headers.end(), [](const value_type& a, const value_type& b) {
+    return CaseInsensitiveLess()(a.first, b.first);
+  });
+  return headers;
+}
+
+bool HeadersMap::operator==(const HeadersMap& other) const {
+  if (size() != other.size()) {
+    return false;
+  }
+  return SortedByName() == other.SortedByName();
+}
+
+}  // namespace http
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
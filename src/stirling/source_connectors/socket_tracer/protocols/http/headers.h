@@ -0,0 +1,161 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http {
+
+/**
+ * A flat multimap of HTTP headers, with case-insensitive look-up of field names.
+ * HTTP1.x headers can have multiple values for the same name, and field names are case-insensitive:
+ * https://www.w3.org/Protocols/rfc2616/rfc2616-sec4.html#sec4.2
+ *
+ * All names and values are stored back-to-back in a single string buffer and referenced by
+ * offsets, so a parsed message costs a constant number of allocations, instead of two strings
+ * and a tree node per header. Entries are kept in insertion (i.e. wire) order.
+ */
+class HeadersMap {
+ public:
+  using value_type = std::pair<std::string_view, std::string_view>;
+
+ private:
+  struct Entry {
+    uint32_t name_pos;
+    uint32_t name_len;
+    uint32_t value_pos;
+    uint32_t value_len;
+  };
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = HeadersMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return value_; }
+    pointer operator->() const { return &value_; }
+
+    const_iterator& operator++() {
+      ++entry_;
+      Load();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const const_iterator& other) const { return entry_ == other.entry_; }
+    bool operator!=(const const_iterator& other) const { return entry_ != other.entry_; }
+
+   private:
+    friend class HeadersMap;
+
+    const_iterator(const HeadersMap* map, std::vector<Entry>::const_iterator entry)
+        : map_(map), entry_(entry) {
+      Load();
+    }
+
+    void Load() {
+      if (entry_ != map_->entries_.end()) {
+        value_ = map_->Get(*entry_);
+      }
+    }
+
+    const HeadersMap* map_ = nullptr;
+    std::vector<Entry>::const_iterator entry_;
+    value_type value_;
+  };
+
+  using iterator = const_iterator;
+
+  HeadersMap() = default;
+  HeadersMap(std::initializer_list<value_type> headers);
+
+  /**
+   * Reserves space for the given number of headers, and their total size of names and values.
+   */
+  void reserve(size_t num_headers, size_t num_bytes) {
+    entries_.reserve(num_headers);
+    buf_.reserve(num_bytes);
+  }
+
+  void insert(const value_type& header) { insert(header.first, header.second); }
+  void insert(std::string_view name, std::string_view value);
+
+  /**
+   * Returns the first header with the given name, compared case-insensitively,
+   * or end() if there is none.
+   */
+  const_iterator find(std::string_view name) const;
+
+  const_iterator begin() const { return const_iterator(this, entries_.begin()); }
+  const_iterator end() const { return const_iterator(this, entries_.end()); }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  void clear() {
+    entries_.clear();
+    buf_.clear();
+  }
+
+  /**
+   * Serializes the headers as a JSON object, without building an intermediate JSON document.
+   */
+  std::string ToJSONString() const;
+
+  // Equality follows std::multimap semantics: the order of different field names is irrelevant,
+  // but the relative order of values with the same field name is significant.
+  bool operator==(const HeadersMap& other) const;
+  bool operator!=(const HeadersMap& other) const { return !(*this == other); }
+
+ private:
+  value_type Get(const Entry& e) const {
+    std::string_view buf(buf_);
+    return {buf.substr(e.name_pos, e.name_len), buf.substr(e.value_pos, e.value_len)};
+  }
+
+  std::vector<value_type> SortedByName() const;
+
+  std::string buf_;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace http
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/headers.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+TEST(HeadersMapTest, KeepsInsertionOrderAndDuplicates) {
+  HeadersMap headers = {{"Host", "pixielabs.ai"}, {"Accept", "*/*"}};
+  headers.insert({"accept", "text/html"});
+
+  EXPECT_EQ(headers.size(), 3);
+  EXPECT_THAT(headers, ElementsAre(Pair("Host", "pixielabs.ai"), Pair("Accept", "*/*"),
+                                   Pair("accept", "text/html")));
+}
+
+TEST(HeadersMapTest, FindIsCaseInsensitive) {
+  const HeadersMap headers = {{"Accept", "*/*"}, {"accept", "text/html"}};
+
+  auto iter = headers.find("ACCEPT");
+  ASSERT_NE(iter, headers.end());
+  EXPECT_EQ(iter->second, "*/*");
+
+  EXPECT_EQ(headers.find("Accept-Encoding"), headers.end());
+}
+
+TEST(HeadersMapTest, Equality) {
+  const HeadersMap headers = {{"Host", "a"}, {"Accept", "b"}, {"Accept", "c"}};
+
+  // Different field names can appear in any order.
+  EXPECT_EQ(headers, (HeadersMap{{"Accept", "b"}, {"Accept", "c"}, {"Host", "a"}}));
+  // Values with the same field name must be in the same order.
+  EXPECT_NE(headers, (HeadersMap{{"Host", "a"}, {"Accept", "c"}, {"Accept", "b"}}));
+  EXPECT_NE(headers, (HeadersMap{{"Host", "a"}, {"Accept", "b"}}));
+}
+
+TEST(HeadersMapTest, ToJSONString) {
+  EXPECT_EQ(HeadersMap().ToJSONString(), "{}");
+
+  const HeadersMap headers = {{"Host", "pixielabs.ai"}, {"Quote", R"("hi")"}};
+  EXPECT_EQ(headers.ToJSONString(), R"({"Host":"pixielabs.ai","Quote":"\"hi\""})");
+}
+
+TEST(HeadersMapTest, CopyIsIndependent) {
+  HeadersMap headers = {{"Host", "pixielabs.ai"}};
+  HeadersMap copy = headers;
+  headers.clear();
+
+  EXPECT_TRUE(headers.empty());
+  EXPECT_THAT(copy, ElementsAre(Pair("Host", "pixielabs.ai")));
+}
+
+}  // namespace http
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -32,11 +32,19 @@ namespace http {
 namespace {
 
 HeadersMap GetHTTPHeadersMap(const phr_header* headers, size_t num_headers) {
+  size_t num_bytes = 0;
+  for (size_t i = 0; i < num_headers; i++) {
+    num_bytes += headers[i].name_len + headers[i].value_len;
+  }
+
   HeadersMap result;
+  result.reserve(num_headers, num_bytes);
   for (size_t i = 0; i < num_headers; i++) {
-    std::string name(headers[i].name, headers[i].name_len);
-    std::string value(headers[i].value, headers[i].value_len);
-    result.insert({name, value});
+    // Pico sets name to nullptr for multi-line header continuations.
+    std::string_view name = headers[i].name == nullptr
+                                ? std::string_view()
+                                : std::string_view(headers[i].name, headers[i].name_len);
+    result.insert(name, std::string_view(headers[i].value, headers[i].value_len));
   }
   return result;
 }
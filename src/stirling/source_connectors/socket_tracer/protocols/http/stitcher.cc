@@ -43,6 +43,52 @@ namespace stirling {
 namespace protocols {
 namespace http {
 
+namespace {
+
+// Decompresses only as much of the body as is kept in the table, plus one byte so that the
+// record still gets marked as truncated when appended.
+constexpr size_t kMaxDecodedBodyBytes = kMaxBodyBytes + 1;
+
+// Whether the parser delimited the body, so that it holds the complete content. Otherwise, the
+// body is whatever arrived before the connection closed, and may be cut short.
+bool BodyIsComplete(const Message& message) {
+  if (message.headers.find(kContentLength) != message.headers.end()) {
+    return true;
+  }
+  auto transfer_encoding_iter = message.headers.find(kTransferEncoding);
+  return transfer_encoding_iter != message.headers.end() &&
+         transfer_encoding_iter->second == "chunked";
+}
+
+void DecodeBody(zlib::Format format, Message* message) {
+  StatusOr<std::string> decoded = zlib::InflatePrefix(message->body, kMaxDecodedBodyBytes, format);
+  if (!decoded.ok() && format == zlib::Format::kZlib) {
+    // Some servers send raw deflate data without the zlib header.
+    decoded = zlib::InflatePrefix(message->body, kMaxDecodedBodyBytes, zlib::Format::kRawDeflate);
+  }
+  if (!decoded.ok()) {
+    LOG(WARNING) << absl::Substitute("Unable to decompress HTTP body: $0", decoded.msg());
+    message->body = "<Failed to decompress body>";
+    return;
+  }
+
+  if (decoded.ValueOrDie().size() == kMaxDecodedBodyBytes && format == zlib::Format::kGzip &&
+      BodyIsComplete(*message)) {
+    // The body was not decompressed completely, but the gzip trailer records the full size.
+    // The trailer is only there if the body is complete, and a size smaller than what was
+    // already decoded means that it is not a real trailer.
+    StatusOr<size_t> full_size = zlib::GzipDecompressedSize(message->body);
+    if (full_size.ok() && full_size.ValueOrDie() >= kMaxDecodedBodyBytes) {
+      message->full_body_size = full_size.ValueOrDie();
+    }
+  }
+  // Otherwise, the full size is unknown, and the size of the decoded prefix is reported as a
+  // lower bound.
+  message->body = decoded.ConsumeValueOrDie();
+}
+
+}  // namespace
+
 void PreProcessMessage(Message* message) {
   // Parse the flags on the first time only.
   static const HTTPHeaderFilter kHTTPResponseHeaderFilter =
@@ -66,16 +112,16 @@ void PreProcessMessage(Message* message) {
   }
 
   auto content_encoding_iter = message->headers.find(kContentEncoding);
+  if (content_encoding_iter == message->headers.end()) {
+    return;
+  }
+
   // Replace body with decompressed version, if required.
-  if (content_encoding_iter != message->headers.end() && content_encoding_iter->second == "gzip") {
-    std::string_view body_strview(message->body);
-    auto bodyOrErr = px::zlib::Inflate(body_strview);
-    if (!bodyOrErr.ok()) {
-      LOG(WARNING) << "Unable to gunzip HTTP body.";
-      message->body = "<Failed to gunzip body>";
-    } else {
-      message->body = bodyOrErr.ValueOrDie();
-    }
+  std::string_view content_encoding = content_encoding_iter->second;
+  if (content_encoding == "gzip" || content_encoding == "x-gzip") {
+    DecodeBody(zlib::Format::kGzip, message);
+  } else if (content_encoding == "deflate") {
+    DecodeBody(zlib::Format::kZlib, message);
   }
 }
 
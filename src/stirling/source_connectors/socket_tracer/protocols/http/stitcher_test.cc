@@ -19,6 +19,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
+
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
 namespace px {
@@ -44,6 +47,72 @@ TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressed) {
   EXPECT_EQ("This is a test\n", message.body);
 }
 
+TEST(PreProcessRecordTest, DeflateCompressedContentIsDecompressed) {
+  // Content-Encoding: deflate is zlib-wrapped data, but some servers send raw deflate data.
+  const uint8_t zlib_bytes[] = {0x78, 0x9c, 0x0b, 0xc9, 0xc8, 0x2c, 0x56, 0x00, 0xa2, 0x44, 0x85,
+                                0x92, 0xd4, 0xe2, 0x12, 0x2e, 0x00, 0x29, 0x73, 0x05, 0x00};
+  const uint8_t raw_deflate_bytes[] = {0x0b, 0xc9, 0xc8, 0x2c, 0x56, 0x00, 0xa2, 0x44,
+                                       0x85, 0x92, 0xd4, 0xe2, 0x12, 0x2e, 0x00};
+
+  for (std::string_view body :
+       {std::string_view(reinterpret_cast<const char*>(zlib_bytes), sizeof(zlib_bytes)),
+        std::string_view(reinterpret_cast<const char*>(raw_deflate_bytes),
+                         sizeof(raw_deflate_bytes))}) {
+    Message message;
+    message.type = message_type_t::kResponse;
+    message.headers.insert({kContentEncoding, "deflate"});
+    message.headers.insert({kContentType, "json"});
+    message.body = body;
+    PreProcessMessage(&message);
+    EXPECT_EQ("This is a test\n", message.body);
+    EXPECT_EQ(message.BodySize(), 15);
+  }
+}
+
+TEST(PreProcessRecordTest, LargeCompressedContentIsOnlyPartiallyDecompressed) {
+  Message message;
+  message.type = message_type_t::kResponse;
+  message.headers.insert({kContentEncoding, "gzip"});
+  message.headers.insert({kContentType, "json"});
+  message.headers.insert({kContentLength, "35"});
+  // 2000 'a' characters, gzipped.
+  const uint8_t compressed_bytes[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+                                      0x03, 0x4b, 0x4c, 0x1c, 0x05, 0xa3, 0x60, 0x14, 0x8c,
+                                      0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x50, 0x07, 0x00,
+                                      0x39, 0x3e, 0x13, 0xa8, 0xd0, 0x07, 0x00, 0x00};
+  message.body.assign(reinterpret_cast<const char*>(compressed_bytes), sizeof(compressed_bytes));
+  PreProcessMessage(&message);
+  // One more byte than is kept, so that the body is still marked as truncated.
+  EXPECT_EQ(message.body, std::string(kMaxBodyBytes + 1, 'a'));
+  EXPECT_EQ(message.BodySize(), 2000);
+}
+
+TEST(PreProcessRecordTest, FullSizeOfIncompleteCompressedContentIsNotTrusted) {
+  // 2000 'a' characters, gzipped, cut short in the middle of the trailer.
+  const uint8_t compressed_bytes[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+                                      0x03, 0x4b, 0x4c, 0x1c, 0x05, 0xa3, 0x60, 0x14, 0x8c,
+                                      0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x50, 0x07, 0x00,
+                                      0x39, 0x3e, 0x13};
+
+  for (std::string_view encoding : {"gzip", "deflate"}) {
+    Message message;
+    message.type = message_type_t::kResponse;
+    message.headers.insert({kContentEncoding, std::string(encoding)});
+    message.headers.insert({kContentType, "json"});
+    // No Content-Length, so the body is whatever arrived before the connection closed.
+    message.body.assign(reinterpret_cast<const char*>(compressed_bytes),
+                        sizeof(compressed_bytes));
+    if (encoding == "deflate") {
+      // Strip the gzip header to leave raw deflate data.
+      message.body.erase(0, 10);
+    }
+    PreProcessMessage(&message);
+    EXPECT_EQ(message.body, std::string(kMaxBodyBytes + 1, 'a'));
+    // The size of the decoded prefix is the only known bound.
+    EXPECT_EQ(message.BodySize(), kMaxBodyBytes + 1);
+  }
+}
+
 TEST(PreProcessRecordTest, ContentHeaderIsNotAdded) {
   Message message;
   message.type = message_type_t::kResponse;
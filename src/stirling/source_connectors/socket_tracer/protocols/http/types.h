@@ -19,10 +19,12 @@
 #pragma once
 
 #include <chrono>
+#include <optional>
 #include <string>
 
 #include "src/common/base/utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/headers.h"
 
 namespace px {
 namespace stirling {
@@ -36,10 +38,6 @@ using ::px::operator<<;
 // HTTP Message
 //-----------------------------------------------------------------------------
 
-// HTTP1.x headers can have multiple values for the same name, and field names are case-insensitive:
-// https://www.w3.org/Protocols/rfc2616/rfc2616-sec4.html#sec4.2
-using HeadersMap = std::multimap<std::string, std::string, CaseInsensitiveLess>;
-
 inline constexpr char kContentEncoding[] = "Content-Encoding";
 inline constexpr char kContentLength[] = "Content-Length";
 inline constexpr char kContentType[] = "Content-Type";
@@ -60,6 +58,12 @@ struct Message : public FrameBase {
 
   std::string body = "-";
 
+  // The size of the body before any truncation, if body holds only a prefix of it.
+  // For example, PreProcessMessage() only decompresses the part of the body that is kept.
+  std::optional<size_t> full_body_size;
+
+  size_t BodySize() const { return full_body_size.value_or(body.size()); }
+
   // The number of bytes in the HTTP header, used in ByteSize(),
   // as an approximation of the size of the non-body fields.
   size_t headers_byte_size = 0;
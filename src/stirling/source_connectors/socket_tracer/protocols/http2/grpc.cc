@@ -18,46 +18,26 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
 
-#include <utility>
-
-#include <google/protobuf/empty.pb.h>
-#include <google/protobuf/text_format.h>
+#include <algorithm>
 
 #include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/pb_wire_printer.h"
 #include "src/stirling/utils/binary_decoder.h"
 
 namespace px {
 namespace stirling {
 namespace grpc {
 
-using ::google::protobuf::Empty;
-using ::google::protobuf::Message;
-using ::google::protobuf::TextFormat;
-
 namespace {
 
-// Text format protobuf are not valid JSON. One obvious issue is that TextFormat uses unquoted
-// field numbers as key: {1: "some string"}, which is not allowed in JSON.
-Status PBWireToText(std::string_view message, TextFormat::Printer* pb_printer, std::string* text) {
-  Empty empty_pb;
-  const bool parse_succeeded = empty_pb.ParsePartialFromArray(message.data(), message.size());
-  // Proceed to print text format protobuf even if the parse failed. This allows producing partial
-  // message.
-  const bool print_succeeded = pb_printer->PrintToString(empty_pb, text);
-  if (!parse_succeeded) {
-    return error::InvalidArgument("Failed to parse the serialized protobuf message");
-  }
-  if (!print_succeeded) {
-    return error::InvalidArgument("Failed to print protobuf message to text format");
-  }
-  return Status::OK();
-}
-
 // Parses the gRPC payload into text format protobuf. In addition to parsing protobuf messages, this
 // function extracts compression and length field, and also handles multiple concatenated payloads
 // as well.
-Status GRPCPBWireToText(std::string_view message, std::string* text,
-                        std::optional<int> str_truncation_len) {
+//
+// Text format protobuf are not valid JSON. One obvious issue is that TextFormat uses unquoted
+// field numbers as key: {1: "some string"}, which is not allowed in JSON.
+Status GRPCPBWireToText(std::string_view message, const PBWirePrinterOptions& opts,
+                        std::string* text) {
   if (message.size() < kGRPCMessageHeaderSizeInBytes) {
     return error::InvalidArgument(
         "The gRPC message does not have enough data. "
@@ -67,12 +47,9 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
 
   BinaryDecoder decoder(message);
 
-  TextFormat::Printer pb_printer;
-  pb_printer.SetTruncateStringFieldLongerThan(str_truncation_len.value_or(0));
-
   Status status;
 
-  while (!decoder.eof()) {
+  while (!decoder.eof() && text->size() <= opts.max_output_bytes) {
     PL_ASSIGN_OR_RETURN(uint8_t compressed_flag, decoder.ExtractInt<uint8_t>());
     if (compressed_flag == 1) {
       return error::Unimplemented("Compressed data is not implemented");
@@ -82,11 +59,8 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
     PL_ASSIGN_OR_RETURN(std::string_view data, decoder.ExtractString<char>(std::min(
                                                    static_cast<size_t>(len), decoder.BufSize())));
 
-    std::string pb_str;
     // Include the most recent status.
-    status = PBWireToText(data, &pb_printer, &pb_str);
-
-    text->append(pb_str);
+    status = PrintPBWire(data, opts, text);
   }
   return status;
 }
@@ -94,9 +68,16 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
 }  // namespace
 
 // TODO(yzhao): Support reflection to get message types instead of empty message.
-std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len) {
+std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len,
+                    std::optional<size_t> max_output_bytes) {
+  PBWirePrinterOptions opts;
+  opts.str_truncation_len = str_truncation_len.value_or(0);
+  if (max_output_bytes.has_value()) {
+    opts.max_output_bytes = max_output_bytes.value();
+  }
+
   std::string text;
-  Status s = GRPCPBWireToText(str, &text, str_truncation_len);
+  Status s = GRPCPBWireToText(str, opts, &text);
   absl::StripTrailingAsciiWhitespace(&text);
   if (!s.ok() && text.empty()) {
     return "<Failed to parse protobuf>";
@@ -32,14 +32,17 @@ constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
 
 /**
  * Parses the input str as the provided protobuf message type.
- * Essentially a wrapper around PBWireToText that is easier to use.
+ * Essentially a wrapper around PrintPBWire() that is easier to use.
  *
  * @param str The raw message as a string.
  * @param str_truncation_len The string length of any string/bytes fields beyond which truncation
  *        applies, if specified.
+ * @param max_output_bytes If specified, stops printing once the output exceeds this size.
+ *        To have the output marked as truncated by DataTable, pass one more than its size limit.
  * @return The parsed message.
  */
-std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len = std::nullopt);
+std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len = std::nullopt,
+                    std::optional<size_t> max_output_bytes = std::nullopt);
 
 }  // namespace grpc
 }  // namespace stirling
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <google/protobuf/empty.pb.h>
+#include <google/protobuf/text_format.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/testing/proto/multi_fields.pb.h"
+
+using ::google::protobuf::Empty;
+using ::google::protobuf::TextFormat;
+using ::px::stirling::protocols::http2::testing::MultiFieldsMessage;
+
+namespace {
+
+constexpr int kStrTruncationLen = 64;
+constexpr size_t kMaxTextBytes = 1024;
+
+// Returns a gRPC payload of roughly the given size, made of nested messages.
+std::string GRPCPayload(size_t size) {
+  MultiFieldsMessage msg;
+  msg.set_b(true);
+  msg.set_i32(100);
+  msg.set_i64(200);
+  msg.set_f(1.2345);
+  msg.set_str("a string field");
+  while (msg.ByteSizeLong() < size) {
+    MultiFieldsMessage outer;
+    outer.set_i64(msg.ByteSizeLong());
+    outer.set_str("another string field");
+    outer.set_bs(msg.SerializeAsString());
+    msg = std::move(outer);
+  }
+
+  std::string serialized = msg.SerializeAsString();
+  std::string payload(1, '\x00');
+  uint32_t size_be = htonl(serialized.size());
+  payload.append(reinterpret_cast<const char*>(&size_be), sizeof(size_be));
+  payload.append(serialized);
+  return payload;
+}
+
+}  // namespace
+
+// The previous implementation: parse into unknown fields of an empty message, print the whole
+// message, then truncate.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TextFormatPrinter(benchmark::State& state) {
+  std::string payload = GRPCPayload(state.range(0));
+  std::string_view wire = std::string_view(payload).substr(5);
+
+  TextFormat::Printer printer;
+  printer.SetTruncateStringFieldLongerThan(kStrTruncationLen);
+  for (auto _ : state) {
+    Empty empty_pb;
+    empty_pb.ParsePartialFromArray(wire.data(), wire.size());
+    std::string text;
+    printer.PrintToString(empty_pb, &text);
+    text.resize(std::min(text.size(), kMaxTextBytes + 1));
+    benchmark::DoNotOptimize(text);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ParsePB(benchmark::State& state) {
+  std::string payload = GRPCPayload(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        px::stirling::grpc::ParsePB(payload, kStrTruncationLen, kMaxTextBytes + 1));
+  }
+}
+
+BENCHMARK(BM_TextFormatPrinter)->RangeMultiplier(4)->Range(64, 64 << 10);
+BENCHMARK(BM_ParsePB)->RangeMultiplier(4)->Range(64, 64 << 10);
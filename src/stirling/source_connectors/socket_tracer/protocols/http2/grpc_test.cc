@@ -97,6 +97,8 @@ TEST(ParsePB, LongStringTruncation) {
 }
 
 // Tests that ParsePB() can parse partial serialized message, and produces partial text format.
+// Fields that were cut off are only printed if they are strings or messages, because the value of
+// a partial number is meaningless.
 TEST(ParsePb, ParsingPartialMessage) {
   const std::string program_protobuf = R"proto(
                                        b: true
@@ -121,8 +123,19 @@ TEST(ParsePb, ParsingPartialMessage) {
 
   EXPECT_THAT(ParsePB(message), StrEq(R"(1: 1
 2: 100
-3: 200
-4: 0x00000419)"));
+3: 200)"));
+}
+
+TEST(ParsePB, OutputTruncation) {
+  std::string_view data = CreateStringView<char>(
+      "\x00\x00\x00\x00\x0D\x0A\x0B\x48\x65\x6C\x6C\x6F\x20\x77\x6F\x72\x6C\x64"
+      "\x00\x00\x00\x00\x0D\x0A\x0B\x48\x65\x6C\x6C\x6F\x20\x77\x6F\x72\x6C\x64"
+      "\x00\x00\x00\x00\x0D\x0A\x0B\x48\x65\x6C\x6C\x6F\x20\x77\x6F\x72\x6C\x64");
+  // Printing stops at the first field past the limit.
+  EXPECT_THAT(ParsePB(data, std::nullopt, 10), StrEq(R"(1: "Hello world")"));
+  EXPECT_THAT(ParsePB(data, std::nullopt, 20), StrEq(R"(1: "Hello world")"
+                                                     "\n"
+                                                     R"(1: "Hello world")"));
 }
 
 }  // namespace grpc
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/pb_wire_printer.h"
+
+#include <absl/strings/str_cat.h>
+
+namespace px {
+namespace stirling {
+namespace grpc {
+
+namespace {
+
+enum class WireType : uint8_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kStartGroup = 3,
+  kEndGroup = 4,
+  kFixed32 = 5,
+};
+
+// Same as the recursion limit of google::protobuf::io::CodedInputStream, which TextFormat uses as
+// the budget for printing nested unknown fields.
+constexpr int kRecursionBudget = 100;
+
+constexpr std::string_view kTruncatedStringSuffix = "...<truncated>...";
+
+struct Field {
+  uint32_t number = 0;
+  WireType type = WireType::kVarint;
+  // The value of varint and fixed-width fields.
+  uint64_t value = 0;
+  // The payload of length-delimited fields, and the body of groups.
+  std::string_view data;
+};
+
+enum class ReadResult {
+  kComplete,
+  // The buffer ended in the middle of the field. Only the data of length-delimited fields and
+  // groups is set, to whatever was available.
+  kTruncated,
+  kInvalid,
+};
+
+ReadResult ReadVarint(std::string_view* buf, uint64_t* value) {
+  constexpr size_t kMaxVarintBytes = 10;
+  uint64_t result = 0;
+  for (size_t i = 0; i < kMaxVarintBytes; ++i) {
+    if (i == buf->size()) {
+      return ReadResult::kTruncated;
+    }
+    uint8_t byte = static_cast<uint8_t>((*buf)[i]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      buf->remove_prefix(i + 1);
+      *value = result;
+      return ReadResult::kComplete;
+    }
+  }
+  return ReadResult::kInvalid;
+}
+
+template <typename TUIntType>
+ReadResult ReadFixed(std::string_view* buf, uint64_t* value) {
+  if (buf->size() < sizeof(TUIntType)) {
+    return ReadResult::kTruncated;
+  }
+  // The wire format is little-endian.
+  uint64_t result = 0;
+  for (size_t i = 0; i < sizeof(TUIntType); ++i) {
+    result |= static_cast<uint64_t>(static_cast<uint8_t>((*buf)[i])) << (8 * i);
+  }
+  buf->remove_prefix(sizeof(TUIntType));
+  *value = result;
+  return ReadResult::kComplete;
+}
+
+ReadResult ReadTag(std::string_view* buf, uint32_t* number, WireType* type) {
+  uint64_t tag;
+  ReadResult result = ReadVarint(buf, &tag);
+  if (result != ReadResult::kComplete) {
+    return result;
+  }
+  // Like protobuf, only keep the low 32 bits of overlong tags.
+  *number = static_cast<uint32_t>(tag) >> 3;
+  uint8_t wire_type = tag & 0x7;
+  if (*number == 0 || wire_type > static_cast<uint8_t>(WireType::kFixed32)) {
+    return ReadResult::kInvalid;
+  }
+  *type = static_cast<WireType>(wire_type);
+  return ReadResult::kComplete;
+}
+
+// Reads the field at the head of buf. An end-group tag is invalid here; ReadGroupBody()
+// consumes those.
+ReadResult ReadField(std::string_view* buf, int budget, Field* field);
+
+// Advances buf past the end-group tag that matches group_number, and sets body to the fields
+// in between.
+ReadResult ReadGroupBody(std::string_view* buf, uint32_t group_number, int budget,
+                         std::string_view* body) {
+  if (budget <= 0) {
+    return ReadResult::kInvalid;
+  }
+  const char* body_start = buf->data();
+  while (true) {
+    std::string_view field_start = *buf;
+    uint32_t number;
+    WireType type;
+    ReadResult result = buf->empty() ? ReadResult::kTruncated : ReadTag(buf, &number, &type);
+    if (result == ReadResult::kComplete && type == WireType::kEndGroup) {
+      if (number != group_number) {
+        return ReadResult::kInvalid;
+      }
+      *body = std::string_view(body_start, field_start.data() - body_start);
+      return ReadResult::kComplete;
+    }
+    if (result == ReadResult::kComplete) {
+      *buf = field_start;
+      Field field;
+      result = ReadField(buf, budget - 1, &field);
+    }
+    if (result == ReadResult::kTruncated) {
+      *body = std::string_view(body_start, buf->data() + buf->size() - body_start);
+    }
+    if (result != ReadResult::kComplete) {
+      return result;
+    }
+  }
+}
+
+ReadResult ReadField(std::string_view* buf, int budget, Field* field) {
+  ReadResult result = ReadTag(buf, &field->number, &field->type);
+  if (result != ReadResult::kComplete) {
+    return result;
+  }
+  switch (field->type) {
+    case WireType::kVarint:
+      return ReadVarint(buf, &field->value);
+    case WireType::kFixed64:
+      return ReadFixed<uint64_t>(buf, &field->value);
+    case WireType::kFixed32:
+      return ReadFixed<uint32_t>(buf, &field->value);
+    case WireType::kLengthDelimited: {
+      uint64_t len;
+      result = ReadVarint(buf, &len);
+      if (result != ReadResult::kComplete) {
+        return result;
+      }
+      if (len > buf->size()) {
+        field->data = *buf;
+        buf->remove_prefix(buf->size());
+        return ReadResult::kTruncated;
+      }
+      field->data = buf->substr(0, len);
+      buf->remove_prefix(len);
+      return ReadResult::kComplete;
+    }
+    case WireType::kStartGroup:
+      return ReadGroupBody(buf, field->number, budget, &field->data);
+    case WireType::kEndGroup:
+      return ReadResult::kInvalid;
+  }
+  return ReadResult::kInvalid;
+}
+
+// Returns true if data parses as a message in its entirety. If data may be truncated,
+// the last field is allowed to be incomplete.
+bool IsMessage(std::string_view data, int budget, bool may_be_truncated) {
+  while (!data.empty()) {
+    Field field;
+    switch (ReadField(&data, budget, &field)) {
+      case ReadResult::kComplete:
+        break;
+      case ReadResult::kTruncated:
+        return may_be_truncated;
+      case ReadResult::kInvalid:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Appends the string as an escaped C string literal, the same way as protobuf's CEscape().
+void AppendEscaped(std::string_view str, std::string* out) {
+  constexpr char kOctalDigits[] = "01234567";
+  for (char c : str) {
+    switch (c) {
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      case '\"':
+        out->append("\\\"");
+        break;
+      case '\'':
+        out->append("\\\'");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      default: {
+        uint8_t byte = static_cast<uint8_t>(c);
+        if (byte < 0x20 || byte >= 0x7f) {
+          const char octal[] = {'\\', kOctalDigits[byte >> 6], kOctalDigits[(byte >> 3) & 0x7],
+                                kOctalDigits[byte & 0x7]};
+          out->append(octal, sizeof(octal));
+        } else {
+          out->push_back(c);
+        }
+      }
+    }
+  }
+}
+
+class PBWirePrinter {
+ public:
+  PBWirePrinter(const PBWirePrinterOptions& opts, std::string* out) : opts_(opts), out_(out) {}
+
+  // Prints the fields of the message. If the message was cut off, which is common for captured
+  // traffic, the available part of the last field is printed if it is a message or a string.
+  Status PrintMessage(std::string_view data, int indent, int budget) {
+    while (!data.empty()) {
+      if (out_->size() > opts_.max_output_bytes) {
+        return Status::OK();
+      }
+
+      Field field;
+      switch (ReadField(&data, budget, &field)) {
+        case ReadResult::kComplete:
+          PrintField(field, indent, budget, /*truncated*/ false);
+          break;
+        case ReadResult::kTruncated:
+          PrintField(field, indent, budget, /*truncated*/ true);
+          return error::InvalidArgument("The serialized protobuf message is truncated");
+        case ReadResult::kInvalid:
+          return error::InvalidArgument("Failed to parse the serialized protobuf message");
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  void PrintField(const Field& field, int indent, int budget, bool truncated) {
+    if (truncated && field.type != WireType::kLengthDelimited &&
+        field.type != WireType::kStartGroup) {
+      // There is no value to print.
+      return;
+    }
+
+    out_->append(2 * indent, ' ');
+    absl::StrAppend(out_, field.number);
+
+    switch (field.type) {
+      case WireType::kVarint:
+        absl::StrAppend(out_, ": ", field.value, "\n");
+        break;
+      case WireType::kFixed32:
+        absl::StrAppend(out_, ": 0x", absl::Hex(field.value, absl::kZeroPad8), "\n");
+        break;
+      case WireType::kFixed64:
+        absl::StrAppend(out_, ": 0x", absl::Hex(field.value, absl::kZeroPad16), "\n");
+        break;
+      case WireType::kLengthDelimited:
+        // Without a schema, a length-delimited field is printed as a message whenever it parses
+        // as one, and as a string otherwise.
+        if (!field.data.empty() && budget > 0 && IsMessage(field.data, budget, truncated)) {
+          PrintNested(field.data, indent, budget);
+        } else {
+          PrintString(field.data);
+        }
+        break;
+      case WireType::kStartGroup:
+        PrintNested(field.data, indent, budget);
+        break;
+      case WireType::kEndGroup:
+        DCHECK(false) << "ReadField() never returns end-group fields.";
+        break;
+    }
+  }
+
+  void PrintNested(std::string_view data, int indent, int budget) {
+    out_->append(" {\n");
+    // Nested messages were validated by the caller, so the only possible error is truncation,
+    // which is reported by the top-level message.
+    PL_UNUSED(PrintMessage(data, indent + 1, budget - 1));
+    out_->append(2 * indent, ' ');
+    out_->append("}\n");
+  }
+
+  void PrintString(std::string_view str) {
+    bool truncated = opts_.str_truncation_len > 0 && str.size() > opts_.str_truncation_len;
+    if (truncated) {
+      str = str.substr(0, opts_.str_truncation_len);
+    }
+    out_->append(": \"");
+    AppendEscaped(str, out_);
+    if (truncated) {
+      out_->append(kTruncatedStringSuffix);
+    }
+    out_->append("\"\n");
+  }
+
+  const PBWirePrinterOptions& opts_;
+  std::string* out_;
+};
+
+}  // namespace
+
+Status PrintPBWire(std::string_view wire, const PBWirePrinterOptions& opts, std::string* out) {
+  PBWirePrinter printer(opts, out);
+  return printer.PrintMessage(wire, /*indent*/ 0, kRecursionBudget);
+}
+
+}  // namespace grpc
+}  // namespace stirling
+}  // namespace px
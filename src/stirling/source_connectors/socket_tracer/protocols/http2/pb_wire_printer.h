@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace grpc {
+
+struct PBWirePrinterOptions {
+  // String/bytes fields longer than this are truncated. 0 means no truncation.
+  size_t str_truncation_len = 0;
+
+  // Printing stops once the output exceeds this size, which happens at a field boundary.
+  size_t max_output_bytes = std::numeric_limits<size_t>::max();
+};
+
+/**
+ * Prints a serialized protobuf message in text format, without knowing its schema.
+ *
+ * The output is the same as parsing the message into google::protobuf::Empty, and printing its
+ * unknown fields with TextFormat::Printer. But the message is printed in a single pass over the
+ * wire format, directly into the output, without building an intermediate message.
+ *
+ * @param wire The serialized protobuf message.
+ * @param opts Controls truncation of the output.
+ * @param out The string to which the text is appended.
+ * @return error::InvalidArgument if the message is malformed. The fields before the malformed
+ *         data are still printed.
+ */
+Status PrintPBWire(std::string_view wire, const PBWirePrinterOptions& opts, std::string* out);
+
+}  // namespace grpc
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/pb_wire_printer.h"
+
+#include <google/protobuf/empty.pb.h>
+#include <google/protobuf/text_format.h>
+
+#include <string>
+
+#include "src/common/base/base.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/testing/proto/multi_fields.pb.h"
+
+namespace px {
+namespace stirling {
+namespace grpc {
+
+using ::google::protobuf::Empty;
+using ::google::protobuf::TextFormat;
+using ::px::stirling::protocols::http2::testing::MultiFieldsMessage;
+using ::testing::StrEq;
+
+// Prints the message the way PrintPBWire() is meant to replicate.
+std::string PrintWithTextFormat(std::string_view wire) {
+  Empty empty_pb;
+  EXPECT_TRUE(empty_pb.ParseFromArray(wire.data(), wire.size()));
+  std::string text;
+  EXPECT_TRUE(TextFormat::PrintToString(empty_pb, &text));
+  return text;
+}
+
+TEST(PrintPBWireTest, MatchesTextFormat) {
+  MultiFieldsMessage inner;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"proto(
+                                          b: true
+                                          i32: -1
+                                          i64: 200
+                                          f: 1.2345
+                                          bs: "\001\002\n\t\"'\\"
+                                          str: "string"
+                                          )proto",
+                                          &inner));
+  // Nest a message inside the bytes field, so that it is printed as a sub-message.
+  MultiFieldsMessage outer = inner;
+  outer.set_bs(inner.SerializeAsString());
+  std::string wire = outer.SerializeAsString();
+
+  std::string text;
+  ASSERT_OK(PrintPBWire(wire, PBWirePrinterOptions(), &text));
+  EXPECT_EQ(text, PrintWithTextFormat(wire));
+}
+
+TEST(PrintPBWireTest, Groups) {
+  // Field 1 is a group containing a varint field 2, followed by a fixed64 field 3.
+  std::string_view wire = CreateStringView<char>(
+      "\x0b\x10\x05\x0c"
+      "\x19\x01\x00\x00\x00\x00\x00\x00\x00");
+
+  std::string text;
+  ASSERT_OK(PrintPBWire(wire, PBWirePrinterOptions(), &text));
+  EXPECT_THAT(text, StrEq("1 {\n  2: 5\n}\n3: 0x0000000000000001\n"));
+  EXPECT_EQ(text, PrintWithTextFormat(wire));
+}
+
+TEST(PrintPBWireTest, InvalidMessage) {
+  std::string text;
+  // An end-group tag without a start-group tag.
+  EXPECT_NOT_OK(PrintPBWire("\x08\x01\x0c", PBWirePrinterOptions(), &text));
+  EXPECT_THAT(text, StrEq("1: 1\n"));
+}
+
+// Captured messages are often cut off. The parts of strings and messages that are available
+// are still printed.
+TEST(PrintPBWireTest, TruncatedMessage) {
+  // Field 1 is a message of 32 bytes, with strings "hello" and "world is big", cut off at 23.
+  std::string_view wire = CreateStringView<char>("\x0a\x20\x0a\x05hello\x12\x10world is big");
+
+  std::string text;
+  EXPECT_NOT_OK(PrintPBWire(wire, PBWirePrinterOptions(), &text));
+  EXPECT_THAT(text, StrEq("1 {\n  1: \"hello\"\n  2: \"world is big\"\n}\n"));
+}
+
+TEST(PrintPBWireTest, StringTruncation) {
+  PBWirePrinterOptions opts;
+  opts.str_truncation_len = 5;
+
+  std::string text;
+  ASSERT_OK(PrintPBWire("\x0a\x0bHello world", opts, &text));
+  EXPECT_THAT(text, StrEq("1: \"Hello...<truncated>...\"\n"));
+}
+
+TEST(PrintPBWireTest, OutputTruncation) {
+  PBWirePrinterOptions opts;
+  opts.max_output_bytes = 6;
+
+  std::string text;
+  ASSERT_OK(PrintPBWire("\x08\x01\x08\x02\x08\x03\x08\x04", opts, &text));
+  // Printing stops at the first field that goes past the limit.
+  EXPECT_THAT(text, StrEq("1: 1\n1: 2\n"));
+}
+
+}  // namespace grpc
+}  // namespace stirling
+}  // namespace px
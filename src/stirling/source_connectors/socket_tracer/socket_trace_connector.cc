@@ -22,6 +22,8 @@
 #include <unistd.h>
 
 #include <filesystem>
+#include <optional>
+#include <string>
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
@@ -55,6 +57,12 @@ DEFINE_uint32(
     std::chrono::minutes(10) / px::stirling::SocketTraceConnector::kSamplingPeriod,
     "Ratio of how frequently conn_stats_table is populated relative to the base sampling period");
 
+DEFINE_uint32(stirling_protocol_stats_sampling_ratio,
+              px::stirling::SocketTraceConnector::kPushPeriod /
+                  px::stirling::SocketTraceConnector::kSamplingPeriod,
+              "Ratio of how frequently socket_tracer_protocol_stats is populated relative to the "
+              "base sampling period");
+
 DEFINE_bool(stirling_enable_periodic_bpf_map_cleanup, true,
             "Disable periodic BPF map cleanup (for testing)");
 
@@ -90,6 +98,11 @@ DEFINE_bool(stirling_enable_kafka_tracing, true,
 DEFINE_bool(stirling_disable_self_tracing, true,
             "If true, stirling will not trace and process syscalls made by itself.");
 
+DEFINE_uint32(stirling_socket_info_cache_ttl_ms, 10 * 1000,
+              "How long the sockets of a network namespace, which are used to infer the endpoints "
+              "of connections, are cached before being probed again. Lookups of unknown sockets "
+              "still probe again, at most once per iteration.");
+
 DEFINE_uint32(messages_expiration_duration_secs, 10 * 60,
               "The duration for which a cached message to be erased.");
 DEFINE_uint32(messages_size_limit_bytes, 1024 * 1024,
@@ -97,6 +110,21 @@ DEFINE_uint32(messages_size_limit_bytes, 1024 * 1024,
               "for each direction, of each connection tracker. "
               "All cached messages are erased if this limit is breached.");
 
+DEFINE_string(stirling_protocol_trace_policies, "",
+              "Comma-separated list of <protocol>:<sample_ratio>:<max_bytes> policies, applied in "
+              "BPF before data is sent to user-space. Traces one out of every sample_ratio "
+              "connections, and at most max_bytes of each data event (0 means no limit). "
+              "Example: 'http:10:4096,kafka:1:1024'.");
+DEFINE_string(stirling_endpoint_trace_policies, "",
+              "Comma-separated list of <pid>:<remote_port>:<sample_ratio>:<max_bytes> policies, "
+              "which override the protocol trace policies. A pid or port of 0 matches any value. "
+              "Since the remote port is matched, port policies only apply to client-side "
+              "connections. Example: '0:8080:100:0,1234:0:1:512'.");
+
+DEFINE_uint32(stirling_grpc_body_text_limit_bytes, 1024,
+              "gRPC bodies are only printed as text format protobuf until the text exceeds this "
+              "size, and are then marked as truncated. 0 means no limit.");
+
 BPF_SRC_STRVIEW(socket_trace_bcc_script, socket_trace);
 
 namespace px {
@@ -213,6 +241,17 @@ Status SocketTraceConnector::InitImpl() {
     }
   }
 
+  PL_ASSIGN_OR_RETURN(std::vector<ProtocolTracePolicy> protocol_policies,
+                      ParseProtocolTracePolicies(FLAGS_stirling_protocol_trace_policies));
+  for (const auto& p : protocol_policies) {
+    PL_RETURN_IF_ERROR(UpdateBPFProtocolTracePolicy(p.protocol, p.policy));
+  }
+  PL_ASSIGN_OR_RETURN(std::vector<EndpointTracePolicy> endpoint_policies,
+                      ParseEndpointTracePolicies(FLAGS_stirling_endpoint_trace_policies));
+  for (const auto& p : endpoint_policies) {
+    PL_RETURN_IF_ERROR(UpdateBPFEndpointTracePolicy(p));
+  }
+
   PL_RETURN_IF_ERROR(TestOnlySetTargetPID(FLAGS_test_only_socket_trace_target_pid));
   if (FLAGS_stirling_disable_self_tracing) {
     PL_RETURN_IF_ERROR(DisableSelfTracing());
@@ -222,8 +261,10 @@ Status SocketTraceConnector::InitImpl() {
   }
 
   StatusOr<std::unique_ptr<system::SocketInfoManager>> s =
-      system::SocketInfoManager::Create(system::Config::GetInstance().proc_path(),
-                                        system::kTCPEstablishedState | system::kTCPListeningState);
+      system::SocketInfoManager::Create(
+          system::Config::GetInstance().proc_path(),
+          system::kTCPEstablishedState | system::kTCPListeningState,
+          std::chrono::milliseconds(FLAGS_stirling_socket_info_cache_ttl_ms));
   if (!s.ok()) {
     LOG(WARNING) << absl::Substitute("Failed to set up socket prober manager. Message: $0",
                                      s.msg());
@@ -232,6 +273,8 @@ Status SocketTraceConnector::InitImpl() {
   }
 
   conn_info_map_mgr_ = std::make_shared<ConnInfoMapManager>(this);
+  data_event_loss_map_ = std::make_unique<ebpf::BPFPercpuArrayTable<uint64_t>>(
+      GetPerCPUArrayTable<uint64_t>(kDataEventLossMapName));
   ConnTracker::SetConnInfoMapManager(conn_info_map_mgr_);
 
   uprobe_mgr_.Init(protocol_transfer_specs_[kProtocolHTTP2].enabled,
@@ -389,6 +432,12 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     TransferConnStats(ctx, conn_stats_table);
   }
 
+  DataTable* protocol_stats_table = data_tables[kProtocolStatsTableNum];
+  if (protocol_stats_table != nullptr &&
+      sampling_freq_mgr_.count() % FLAGS_stirling_protocol_stats_sampling_ratio == 0) {
+    TransferProtocolStats(protocol_stats_table);
+  }
+
   if ((sampling_freq_mgr_.count() + 1) % FLAGS_stirling_socket_tracer_stats_logging_ratio == 0) {
     conn_trackers_mgr_.ComputeProtocolStats();
     LOG(INFO) << "ConnTracker statistics: " << conn_trackers_mgr_.StatsString();
@@ -409,9 +458,9 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     DataTable* data_table = data_tables[i];
 
     // Ensure records are within the time window, in order to ensure the order between record
-    // batches. Exception: conn_stats table does not need cutoff time, because its timestamps
-    // are assigned artificially.
-    if (i != kConnStatsTableNum && data_table != nullptr) {
+    // batches. Exception: conn_stats and protocol_stats tables do not need cutoff time, because
+    // their timestamps are assigned artificially.
+    if (i != kConnStatsTableNum && i != kProtocolStatsTableNum && data_table != nullptr) {
       data_table->SetConsumeRecordsCutoffTime(perf_buffer_drain_time_);
     }
   }
@@ -451,6 +500,44 @@ Status SocketTraceConnector::UpdateBPFProtocolTraceRole(traffic_protocol_t proto
   return UpdatePerCPUArrayValue(static_cast<int>(protocol), role_mask, &control_map_handle);
 }
 
+Status SocketTraceConnector::UpdateBPFProtocolTracePolicy(traffic_protocol_t protocol,
+                                                          const struct trace_policy_t& policy) {
+  auto policy_map_handle = GetArrayTable<struct trace_policy_t>(kProtocolTracePolicyMapName);
+  auto update_res = policy_map_handle.update_value(static_cast<int>(protocol), policy);
+  if (!update_res.ok()) {
+    return error::Internal(absl::Substitute("Failed to set trace policy for protocol $0: $1",
+                                            magic_enum::enum_name(protocol), update_res.msg()));
+  }
+  LOG(INFO) << absl::Substitute("Trace policy for protocol $0: $1",
+                                magic_enum::enum_name(protocol), ToString(policy));
+  return Status::OK();
+}
+
+Status SocketTraceConnector::UpdateBPFEndpointTracePolicy(const EndpointTracePolicy& policy) {
+  auto policy_map_handle = GetHashTable<struct trace_policy_key_t, struct trace_policy_t>(
+      kEndpointTracePolicyMapName);
+  auto update_res = policy_map_handle.update_value(policy.BPFKey(), policy.policy);
+  if (!update_res.ok()) {
+    return error::Internal(absl::Substitute("Failed to set trace policy for pid=$0 port=$1: $2",
+                                            policy.tgid, policy.port, update_res.msg()));
+  }
+  LOG(INFO) << absl::Substitute("Trace policy for pid=$0 port=$1: $2", policy.tgid, policy.port,
+                                ToString(policy.policy));
+  return Status::OK();
+}
+
+Status SocketTraceConnector::RemoveBPFEndpointTracePolicy(uint32_t tgid, uint16_t port) {
+  auto policy_map_handle = GetHashTable<struct trace_policy_key_t, struct trace_policy_t>(
+      kEndpointTracePolicyMapName);
+  EndpointTracePolicy policy{.tgid = tgid, .port = port};
+  auto remove_res = policy_map_handle.remove_value(policy.BPFKey());
+  if (!remove_res.ok()) {
+    return error::NotFound(absl::Substitute("Failed to remove trace policy for pid=$0 port=$1: $2",
+                                            tgid, port, remove_res.msg()));
+  }
+  return Status::OK();
+}
+
 Status SocketTraceConnector::TestOnlySetTargetPID(int64_t pid) {
   auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
   return UpdatePerCPUArrayValue(kTargetTGIDIndex, pid, &control_map_handle);
@@ -644,15 +731,15 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("major_version")>(1);
   r.Append<r.ColIndex("minor_version")>(resp_message.minor_version);
   r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(content_type));
-  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_message.headers));
+  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(req_message.headers.ToJSONString());
   r.Append<r.ColIndex("req_method")>(std::move(req_message.req_method));
   r.Append<r.ColIndex("req_path")>(std::move(req_message.req_path));
-  r.Append<r.ColIndex("req_body_size")>(req_message.body.size());
+  r.Append<r.ColIndex("req_body_size")>(req_message.BodySize());
   r.Append<r.ColIndex("req_body"), kMaxBodyBytes>(std::move(req_message.body));
-  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
+  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(resp_message.headers.ToJSONString());
   r.Append<r.ColIndex("resp_status")>(resp_message.resp_status);
   r.Append<r.ColIndex("resp_message")>(std::move(resp_message.resp_message));
-  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size());
+  r.Append<r.ColIndex("resp_body_size")>(resp_message.BodySize());
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(resp_message.body));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_message.timestamp_ns, resp_message.timestamp_ns));
@@ -698,12 +785,21 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   size_t resp_data_size = resp_stream->original_data_size();
   if (record.HasGRPCContentType()) {
     content_type = HTTPContentType::kGRPC;
-    req_data = ParsePB(req_data, kMaxPBStringLen);
-    if (req_stream->data_truncated()) {
+    std::optional<size_t> max_text_bytes;
+    if (FLAGS_stirling_grpc_body_text_limit_bytes > 0) {
+      max_text_bytes = FLAGS_stirling_grpc_body_text_limit_bytes;
+    }
+    // Printing stops at the first field boundary past the limit, so text that is longer than the
+    // limit may have been cut short.
+    auto text_truncated = [&max_text_bytes](const std::string& text) {
+      return max_text_bytes.has_value() && text.size() > max_text_bytes.value();
+    };
+    req_data = ParsePB(req_data, kMaxPBStringLen, max_text_bytes);
+    if (req_stream->data_truncated() || text_truncated(req_data)) {
       req_data.append(DataTable::kTruncatedMsg);
     }
-    resp_data = ParsePB(resp_data, kMaxPBStringLen);
-    if (resp_stream->data_truncated()) {
+    resp_data = ParsePB(resp_data, kMaxPBStringLen, max_text_bytes);
+    if (resp_stream->data_truncated() || text_truncated(resp_data)) {
       resp_data.append(DataTable::kTruncatedMsg);
     }
   }
@@ -989,7 +1085,8 @@ void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tr
   if (tracker->state() == ConnTracker::State::kTransferring) {
     // ProcessToRecords() parses raw events and produces messages in format that are expected by
     // table store. But those messages are not cached inside ConnTracker.
-    auto records = tracker->ProcessToRecords<TProtocolTraits>();
+    auto records = tracker->ProcessToRecords<TProtocolTraits>(
+        &protocol_processing_stats_[tracker->protocol()]);
     for (auto& record : records) {
       TProtocolTraits::ConvertTimestamps(
           &record, [&](uint64_t mono_time) { return ConvertToRealTime(mono_time); });
@@ -1064,5 +1161,44 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
   }
 }
 
+void SocketTraceConnector::TransferProtocolStats(DataTable* data_table) {
+  namespace idx = ::px::stirling::protocol_stats_idx;
+
+  uint64_t time = AdjustedSteadyClockNowNS();
+
+  std::vector<uint64_t> per_cpu_losses;
+  for (size_t i = 0; i < protocol_transfer_specs_.size(); ++i) {
+    if (!protocol_transfer_specs_[i].enabled) {
+      continue;
+    }
+
+    int64_t data_events_lost = 0;
+    if (data_event_loss_map_ != nullptr) {
+      auto s = data_event_loss_map_->get_value(i, per_cpu_losses);
+      LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+          "Failed to read data event losses for protocol $0: $1",
+          magic_enum::enum_name(static_cast<traffic_protocol_t>(i)), s.msg());
+      for (uint64_t lost : per_cpu_losses) {
+        data_events_lost += lost;
+      }
+      per_cpu_losses.clear();
+    }
+
+    const ProtocolProcessingStats& stats = protocol_processing_stats_[i];
+
+    DataTable::RecordBuilder<&kProtocolStatsTable> r(data_table, time);
+    r.Append<idx::kTime>(time);
+    r.Append<idx::kProtocol>(static_cast<int64_t>(i));
+    r.Append<idx::kBytesProcessed>(stats.bytes_processed);
+    r.Append<idx::kValidFrames>(stats.valid_frames);
+    r.Append<idx::kInvalidFrames>(stats.invalid_frames);
+    r.Append<idx::kValidRecords>(stats.valid_records);
+    r.Append<idx::kInvalidRecords>(stats.invalid_records);
+    r.Append<idx::kParseTime>(stats.parse_ns);
+    r.Append<idx::kStitchTime>(stats.stitch_ns);
+    r.Append<idx::kDataEventsLost>(data_events_lost);
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <array>
 #include <fstream>
 #include <list>
 #include <map>
@@ -43,11 +44,13 @@
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_tables.h"
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
 
 DECLARE_uint32(stirling_conn_stats_sampling_ratio);
+DECLARE_uint32(stirling_protocol_stats_sampling_ratio);
 DECLARE_bool(stirling_enable_periodic_bpf_map_cleanup);
 DECLARE_string(perf_buffer_events_output_path);
 DECLARE_bool(stirling_enable_http_tracing);
@@ -60,6 +63,9 @@ DECLARE_bool(stirling_enable_nats_tracing);
 DECLARE_bool(stirling_enable_kafka_tracing);
 DECLARE_bool(stirling_disable_self_tracing);
 DECLARE_string(stirling_role_to_trace);
+DECLARE_string(stirling_protocol_trace_policies);
+DECLARE_string(stirling_endpoint_trace_policies);
+DECLARE_uint32(stirling_grpc_body_text_limit_bytes);
 
 DECLARE_uint32(messages_expiration_duration_secs);
 DECLARE_uint32(messages_size_limit_bytes);
@@ -72,7 +78,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr std::string_view kName = "socket_tracer";
   static constexpr auto kTables =
       MakeArray(kConnStatsTable, kHTTPTable, kMySQLTable, kCQLTable, kPGSQLTable, kDNSTable,
-                kRedisTable, kNATSTable, kKafkaTable);
+                kRedisTable, kNATSTable, kKafkaTable, kProtocolStatsTable);
 
   static constexpr uint32_t kConnStatsTableNum = TableNum(kTables, kConnStatsTable);
   static constexpr uint32_t kHTTPTableNum = TableNum(kTables, kHTTPTable);
@@ -83,6 +89,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr uint32_t kRedisTableNum = TableNum(kTables, kRedisTable);
   static constexpr uint32_t kNATSTableNum = TableNum(kTables, kNATSTable);
   static constexpr uint32_t kKafkaTableNum = TableNum(kTables, kKafkaTable);
+  static constexpr uint32_t kProtocolStatsTableNum = TableNum(kTables, kProtocolStatsTable);
 
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{200};
   // TODO(yzhao): This is not used right now. Eventually use this to control data push frequency.
@@ -110,6 +117,15 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Role_mask a bit mask, and represents the endpoint_role_t roles that are allowed to transfer
   // data from inside BPF to user-space.
   Status UpdateBPFProtocolTraceRole(traffic_protocol_t protocol, uint64_t role_mask);
+
+  // Updates the policy that controls how much data of the given protocol BPF sends to user-space.
+  Status UpdateBPFProtocolTracePolicy(traffic_protocol_t protocol,
+                                      const struct trace_policy_t& policy);
+
+  // Adds or updates a per-endpoint policy, which takes precedence over the protocol's policy.
+  Status UpdateBPFEndpointTracePolicy(const EndpointTracePolicy& policy);
+  Status RemoveBPFEndpointTracePolicy(uint32_t tgid, uint16_t port);
+
   Status TestOnlySetTargetPID(int64_t pid);
   Status DisableSelfTracing();
 
@@ -243,6 +259,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Transfer of messages to the data table.
   void TransferStreams(ConnectorContext* ctx, uint32_t table_num, DataTable* data_table);
   void TransferConnStats(ConnectorContext* ctx, DataTable* data_table);
+  void TransferProtocolStats(DataTable* data_table);
 
   template <typename TProtocolTraits>
   void TransferStream(ConnectorContext* ctx, ConnTracker* tracker, DataTable* data_table);
@@ -271,6 +288,12 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   ConnStats conn_stats_;
 
+  // The cost of processing each protocol's data, indexed by traffic_protocol_t.
+  std::array<ProtocolProcessingStats, kNumProtocols> protocol_processing_stats_ = {};
+
+  // Per-protocol counts of data events that BPF failed to submit. Only set after InitImpl().
+  std::unique_ptr<ebpf::BPFPercpuArrayTable<uint64_t>> data_event_loss_map_;
+
   absl::flat_hash_set<int> pids_to_trace_disable_;
 
   struct TransferSpec {
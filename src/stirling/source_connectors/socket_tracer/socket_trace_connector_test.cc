@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 
 #include <sys/socket.h>
+#include <algorithm>
 #include <memory>
 
 #include "src/shared/metadata/metadata.h"
@@ -258,6 +259,47 @@ TEST_F(SocketTraceConnectorTest, HTTPBasic) {
   EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre("foo"));
 }
 
+TEST_F(SocketTraceConnectorTest, ProtocolStats) {
+  FLAGS_stirling_protocol_stats_sampling_ratio = 1;
+
+  testing::EventGenerator event_gen(&mock_clock_);
+  struct socket_control_event_t conn = event_gen.InitConn();
+  std::unique_ptr<SocketDataEvent> event0_req = event_gen.InitSendEvent<kProtocolHTTP>(kReq3);
+  std::unique_ptr<SocketDataEvent> event0_resp_json =
+      event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp);
+  const size_t num_bytes = event0_req->msg.size() + event0_resp_json->msg.size();
+  struct socket_control_event_t close_event = event_gen.InitClose();
+
+  source_->AcceptControlEvent(conn);
+  source_->AcceptDataEvent(std::move(event0_req));
+  source_->AcceptDataEvent(std::move(event0_resp_json));
+  source_->AcceptControlEvent(close_event);
+
+  // The stats are reported before the data of the iteration is processed,
+  // so it takes a second iteration for the processing to be reflected in the stats.
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  DataTable* protocol_stats_table = (*data_tables_)[SocketTraceConnector::kProtocolStatsTableNum];
+  std::vector<TaggedRecordBatch> tablets = protocol_stats_table->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+
+  namespace idx = ::px::stirling::protocol_stats_idx;
+  std::vector<int64_t> protocols = ToIntVector<types::Int64Value>(record_batch[idx::kProtocol]);
+  auto iter = std::find(protocols.rbegin(), protocols.rend(), kProtocolHTTP);
+  ASSERT_NE(iter, protocols.rend());
+  size_t row = protocols.size() - 1 - std::distance(protocols.rbegin(), iter);
+
+  EXPECT_EQ(record_batch[idx::kBytesProcessed]->Get<types::Int64Value>(row).val,
+            static_cast<int64_t>(num_bytes));
+  EXPECT_EQ(record_batch[idx::kValidFrames]->Get<types::Int64Value>(row).val, 2);
+  EXPECT_EQ(record_batch[idx::kInvalidFrames]->Get<types::Int64Value>(row).val, 0);
+  EXPECT_EQ(record_batch[idx::kValidRecords]->Get<types::Int64Value>(row).val, 1);
+  EXPECT_EQ(record_batch[idx::kInvalidRecords]->Get<types::Int64Value>(row).val, 0);
+  EXPECT_GT(record_batch[idx::kParseTime]->Get<types::Int64Value>(row).val, 0);
+}
+
 TEST_F(SocketTraceConnectorTest, HTTPContentType) {
   testing::EventGenerator event_gen(&mock_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
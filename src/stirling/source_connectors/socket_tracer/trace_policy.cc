@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
+
+#include <arpa/inet.h>
+
+#include <limits>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <magic_enum.hpp>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+constexpr std::string_view kProtocolEnumPrefix = "kProtocol";
+
+StatusOr<traffic_protocol_t> ParseProtocolName(std::string_view name) {
+  for (traffic_protocol_t protocol : TrafficProtocolEnumValues()) {
+    std::string_view enum_name = magic_enum::enum_name(protocol);
+    enum_name.remove_prefix(kProtocolEnumPrefix.size());
+    if (absl::EqualsIgnoreCase(enum_name, name)) {
+      return protocol;
+    }
+  }
+  return error::InvalidArgument("Unknown protocol '$0'", name);
+}
+
+template <typename TIntType>
+StatusOr<TIntType> ParseUInt(std::string_view field, std::string_view entry) {
+  uint64_t val;
+  if (!absl::SimpleAtoi(field, &val) || val > std::numeric_limits<TIntType>::max()) {
+    return error::InvalidArgument("Invalid value '$0' in trace policy '$1'", field, entry);
+  }
+  return static_cast<TIntType>(val);
+}
+
+StatusOr<struct trace_policy_t> ParsePolicy(std::string_view sample_ratio,
+                                            std::string_view max_bytes, std::string_view entry) {
+  struct trace_policy_t policy = {};
+  PL_ASSIGN_OR_RETURN(policy.sample_ratio, ParseUInt<uint32_t>(sample_ratio, entry));
+  PL_ASSIGN_OR_RETURN(policy.max_bytes, ParseUInt<uint32_t>(max_bytes, entry));
+  return policy;
+}
+
+}  // namespace
+
+struct trace_policy_key_t EndpointTracePolicy::BPFKey() const {
+  struct trace_policy_key_t key = {};
+  key.tgid = tgid;
+  key.port = htons(port);
+  return key;
+}
+
+StatusOr<std::vector<ProtocolTracePolicy>> ParseProtocolTracePolicies(std::string_view spec) {
+  std::vector<ProtocolTracePolicy> policies;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    entry = absl::StripAsciiWhitespace(entry);
+    std::vector<std::string_view> fields = absl::StrSplit(entry, ':');
+    if (fields.size() != 3) {
+      return error::InvalidArgument(
+          "Protocol trace policy '$0' is not of the form <protocol>:<sample_ratio>:<max_bytes>",
+          entry);
+    }
+
+    ProtocolTracePolicy& p = policies.emplace_back();
+    PL_ASSIGN_OR_RETURN(p.protocol, ParseProtocolName(fields[0]));
+    PL_ASSIGN_OR_RETURN(p.policy, ParsePolicy(fields[1], fields[2], entry));
+  }
+  return policies;
+}
+
+StatusOr<std::vector<EndpointTracePolicy>> ParseEndpointTracePolicies(std::string_view spec) {
+  std::vector<EndpointTracePolicy> policies;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    entry = absl::StripAsciiWhitespace(entry);
+    std::vector<std::string_view> fields = absl::StrSplit(entry, ':');
+    if (fields.size() != 4) {
+      return error::InvalidArgument(
+          "Endpoint trace policy '$0' is not of the form <tgid>:<port>:<sample_ratio>:<max_bytes>",
+          entry);
+    }
+
+    EndpointTracePolicy& p = policies.emplace_back();
+    PL_ASSIGN_OR_RETURN(p.tgid, ParseUInt<uint32_t>(fields[0], entry));
+    PL_ASSIGN_OR_RETURN(p.port, ParseUInt<uint16_t>(fields[1], entry));
+    PL_ASSIGN_OR_RETURN(p.policy, ParsePolicy(fields[2], fields[3], entry));
+  }
+  return policies;
+}
+
+std::string ToString(const struct trace_policy_t& policy) {
+  return absl::Substitute("[sample_ratio=$0 max_bytes=$1]", policy.sample_ratio,
+                          policy.max_bytes);
+}
+
+}  // namespace stirling
+}  // namespace px
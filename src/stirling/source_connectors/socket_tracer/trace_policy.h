@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+
+namespace px {
+namespace stirling {
+
+// A trace policy applied to all connections of a protocol.
+struct ProtocolTracePolicy {
+  traffic_protocol_t protocol = kProtocolUnknown;
+  struct trace_policy_t policy = {};
+};
+
+// A trace policy applied to connections of a process and/or remote port.
+// A value of 0 for tgid or port acts as a wildcard.
+// Only the remote port is known in BPF, so a non-zero port only matches client-side connections,
+// eg. calls to a service at that port; server-side connections have an ephemeral remote port.
+struct EndpointTracePolicy {
+  uint32_t tgid = 0;
+  // Port in host byte order.
+  uint16_t port = 0;
+  struct trace_policy_t policy = {};
+
+  struct trace_policy_key_t BPFKey() const;
+};
+
+/**
+ * Parses a comma-separated list of <protocol>:<sample_ratio>:<max_bytes> entries.
+ * The protocol name is case-insensitive, and matches traffic_protocol_t without the kProtocol
+ * prefix. Example: "http:10:4096,kafka:1:1024".
+ */
+StatusOr<std::vector<ProtocolTracePolicy>> ParseProtocolTracePolicies(std::string_view spec);
+
+/**
+ * Parses a comma-separated list of <tgid>:<port>:<sample_ratio>:<max_bytes> entries.
+ * Example: "0:8080:100:0,1234:0:1:512".
+ */
+StatusOr<std::vector<EndpointTracePolicy>> ParseEndpointTracePolicies(std::string_view spec);
+
+std::string ToString(const struct trace_policy_t& policy);
+
+}  // namespace stirling
+}  // namespace px
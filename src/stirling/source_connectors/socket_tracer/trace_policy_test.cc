@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
+
+#include <arpa/inet.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+TEST(ParseProtocolTracePoliciesTest, Basic) {
+  ASSERT_OK_AND_ASSIGN(std::vector<ProtocolTracePolicy> policies,
+                       ParseProtocolTracePolicies("http:10:4096, KAFKA:1:0"));
+  ASSERT_EQ(policies.size(), 2);
+  EXPECT_EQ(policies[0].protocol, kProtocolHTTP);
+  EXPECT_EQ(policies[0].policy.sample_ratio, 10);
+  EXPECT_EQ(policies[0].policy.max_bytes, 4096);
+  EXPECT_EQ(policies[1].protocol, kProtocolKafka);
+  EXPECT_EQ(policies[1].policy.sample_ratio, 1);
+  EXPECT_EQ(policies[1].policy.max_bytes, 0);
+}
+
+TEST(ParseProtocolTracePoliciesTest, Empty) {
+  ASSERT_OK_AND_ASSIGN(std::vector<ProtocolTracePolicy> policies, ParseProtocolTracePolicies(""));
+  EXPECT_TRUE(policies.empty());
+}
+
+TEST(ParseProtocolTracePoliciesTest, Invalid) {
+  EXPECT_NOT_OK(ParseProtocolTracePolicies("http:10"));
+  EXPECT_NOT_OK(ParseProtocolTracePolicies("foo:10:100"));
+  EXPECT_NOT_OK(ParseProtocolTracePolicies("http:-1:100"));
+  EXPECT_NOT_OK(ParseProtocolTracePolicies("http:1:abc"));
+}
+
+TEST(ParseEndpointTracePoliciesTest, Basic) {
+  ASSERT_OK_AND_ASSIGN(std::vector<EndpointTracePolicy> policies,
+                       ParseEndpointTracePolicies("0:8080:100:0,1234:0:1:512"));
+  ASSERT_EQ(policies.size(), 2);
+  EXPECT_EQ(policies[0].tgid, 0);
+  EXPECT_EQ(policies[0].port, 8080);
+  EXPECT_EQ(policies[0].policy.sample_ratio, 100);
+  EXPECT_EQ(policies[0].policy.max_bytes, 0);
+  EXPECT_EQ(policies[1].tgid, 1234);
+  EXPECT_EQ(policies[1].port, 0);
+  EXPECT_EQ(policies[1].policy.sample_ratio, 1);
+  EXPECT_EQ(policies[1].policy.max_bytes, 512);
+
+  // BPF keys use network byte order for the port, to match sockaddr.
+  EXPECT_EQ(policies[0].BPFKey().port, htons(8080));
+  EXPECT_EQ(policies[1].BPFKey().tgid, 1234);
+}
+
+TEST(ParseEndpointTracePoliciesTest, Invalid) {
+  EXPECT_NOT_OK(ParseEndpointTracePolicies("0:8080:100"));
+  EXPECT_NOT_OK(ParseEndpointTracePolicies("0:70000:1:0"));
+}
+
+}  // namespace stirling
+}  // namespace px
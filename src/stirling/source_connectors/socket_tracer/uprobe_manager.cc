@@ -19,18 +19,24 @@
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <filesystem>
 #include <map>
 
+#include <prometheus/histogram.h>
+
 #include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/common/metrics/metrics.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/obj_tools/dwarf_reader.h"
+#include "src/stirling/obj_tools/go_pclntab.h"
 #include "src/stirling/obj_tools/go_syms.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_symaddrs.h"
@@ -42,14 +48,53 @@ DEFINE_bool(stirling_rescan_for_dlopen, false,
 DEFINE_double(stirling_rescan_exp_backoff_factor, 2.0,
               "Exponential backoff factor used in decided how often to rescan binaries for "
               "dynamically loaded libraries");
+DEFINE_string(stirling_go_symaddrs_cache_dir, "",
+              "If set, the symbol addresses computed from the DWARF info of Go binaries are "
+              "persisted in this directory, keyed by build-id, so that binaries seen before an "
+              "agent restart need not be parsed again. Each build of the agent uses its own "
+              "subdirectory, and deletes those of other builds.");
+DEFINE_int32(stirling_dwarf_indexing_threads, 4,
+             "Number of threads used to index the DWARF info of newly seen Go binaries.");
+DEFINE_int32(stirling_uprobe_analysis_threads, 4,
+             "Number of newly seen binaries that are analyzed in parallel for uprobe deployment. "
+             "Each of them may use up to stirling_dwarf_indexing_threads threads of its own.");
 
 namespace px {
 namespace stirling {
 
-using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
+using ::px::stirling::obj_tools::GoPCLNTab;
+
+namespace {
+
+prometheus::Histogram& BuildUProbeHistogram(std::string_view name, std::string_view help,
+                                            std::string_view probe_type) {
+  // Seconds. Spans from processes that are caught right away, to those that wait behind the
+  // DWARF parsing of large binaries.
+  static const auto kBuckets =
+      prometheus::Histogram::BucketBoundaries{0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300};
+  return prometheus::BuildHistogram()
+      .Name(std::string(name))
+      .Help(std::string(help))
+      .Register(GetMetricsRegistry())
+      .Add({{"probe_type", std::string(probe_type)}}, kBuckets);
+}
 
-UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc) : bcc_(bcc) {
+constexpr std::string_view kDeployLatencyName = "stirling_uprobe_deploy_latency_seconds";
+constexpr std::string_view kDeployLatencyHelp =
+    "Time from the start of a process until the uprobe deployment for it completed";
+
+}  // namespace
+
+UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc)
+    : bcc_(bcc),
+      go_symaddrs_cache_(FLAGS_stirling_go_symaddrs_cache_dir,
+                         FLAGS_stirling_dwarf_indexing_threads),
+      openssl_deploy_latency_(
+          BuildUProbeHistogram(kDeployLatencyName, kDeployLatencyHelp, "openssl")),
+      go_deploy_latency_(BuildUProbeHistogram(kDeployLatencyName, kDeployLatencyHelp, "go")),
+      go_analysis_time_(BuildUProbeHistogram("stirling_uprobe_binary_analysis_seconds",
+                                             "Time spent analyzing a binary for uprobes", "go")) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
 }
 
@@ -74,7 +119,8 @@ void UProbeManager::NotifyMMapEvent(upid_t upid) { upids_with_mmap_.insert(upid)
 
 StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
                                               const std::string& binary,
-                                              obj_tools::ElfReader* elf_reader) {
+                                              obj_tools::ElfReader* elf_reader,
+                                              const obj_tools::GoPCLNTab* go_pclntab) {
   using bpf_tools::BPFProbeAttachType;
 
   int uprobe_count = 0;
@@ -85,7 +131,8 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
                                   tmpl.attach_type, std::string(tmpl.probe_fn)};
 
     StatusOr<std::vector<ElfReader::SymbolInfo>> symbol_infos_status =
-        elf_reader->ListFuncSymbols(tmpl.symbol, tmpl.match_type);
+        go_pclntab != nullptr ? go_pclntab->ListFuncSymbols(tmpl.symbol, tmpl.match_type)
+                              : elf_reader->ListFuncSymbols(tmpl.symbol, tmpl.match_type);
     if (!symbol_infos_status.ok()) {
       VLOG(1) << absl::Substitute("Could not list symbols [error=$0]",
                                   symbol_infos_status.ToString());
@@ -112,7 +159,8 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
           // [1] https://llvm.org/doxygen/BinaryFormat_2ELF_8h_source.html
           // [2] https://github.com/eth-sri/debin/blob/master/cpp/elfio/elf_types.hpp
           PL_ASSIGN_OR_RETURN(std::vector<uint64_t> ret_inst_addrs,
-                              elf_reader->FuncRetInstAddrs(symbol_info));
+                              go_pclntab != nullptr ? go_pclntab->FuncRetInstAddrs(symbol_info)
+                                                    : elf_reader->FuncRetInstAddrs(symbol_info));
           for (const uint64_t& addr : ret_inst_addrs) {
             spec.attach_type = BPFProbeAttachType::kEntry;
             spec.address = addr;
@@ -137,36 +185,40 @@ Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path
   return Status::OK();
 }
 
-Status UProbeManager::UpdateGoCommonSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
+Status UProbeManager::UpdateGoCommonSymAddrs(const GoSymAddrs& symaddrs,
                                              const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_common_symaddrs_t symaddrs,
-                      GoCommonSymAddrs(elf_reader, dwarf_reader));
+  if (!symaddrs.common.has_value()) {
+    return error::NotFound("Binary does not have the Go common symbols.");
+  }
 
   for (auto& pid : pids) {
-    go_common_symaddrs_map_->UpdateValue(pid, symaddrs);
+    go_common_symaddrs_map_->UpdateValue(pid, symaddrs.common.value());
   }
 
   return Status::OK();
 }
 
-Status UProbeManager::UpdateGoHTTP2SymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
+Status UProbeManager::UpdateGoHTTP2SymAddrs(const GoSymAddrs& symaddrs,
                                             const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_http2_symaddrs_t symaddrs,
-                      GoHTTP2SymAddrs(elf_reader, dwarf_reader));
+  if (!symaddrs.http2.has_value()) {
+    return error::NotFound("Binary does not have the Go HTTP2 symbols.");
+  }
 
   for (auto& pid : pids) {
-    go_http2_symaddrs_map_->UpdateValue(pid, symaddrs);
+    go_http2_symaddrs_map_->UpdateValue(pid, symaddrs.http2.value());
   }
 
   return Status::OK();
 }
 
-Status UProbeManager::UpdateGoTLSSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
+Status UProbeManager::UpdateGoTLSSymAddrs(const GoSymAddrs& symaddrs,
                                           const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_tls_symaddrs_t symaddrs, GoTLSSymAddrs(elf_reader, dwarf_reader));
+  if (!symaddrs.tls.has_value()) {
+    return error::NotFound("Binary does not have the Go TLS symbols.");
+  }
 
   for (auto& pid : pids) {
-    go_tls_symaddrs_map_->UpdateValue(pid, symaddrs);
+    go_tls_symaddrs_map_->UpdateValue(pid, symaddrs.tls.value());
   }
 
   return Status::OK();
@@ -361,10 +413,11 @@ StatusOr<int> UProbeManager::AttachNodeJsOpenSSLUprobes(uint32_t pid) {
 
 StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
                                                 obj_tools::ElfReader* elf_reader,
-                                                obj_tools::DwarfReader* dwarf_reader,
+                                                const obj_tools::GoPCLNTab* go_pclntab,
+                                                const GoSymAddrs& symaddrs,
                                                 const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symbols_map on all new PIDs.
-  Status s = UpdateGoTLSSymAddrs(elf_reader, dwarf_reader, pids);
+  Status s = UpdateGoTLSSymAddrs(symaddrs, pids);
   if (!s.ok()) {
     // Doesn't appear to be a binary with the mandatory symbols.
     // Might not even be a golang binary.
@@ -378,7 +431,7 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader);
+  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader, go_pclntab);
 }
 
 // TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
@@ -387,10 +440,11 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
 // because of the mixed & duplicate data events from these 2 sources.
 StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
                                                  obj_tools::ElfReader* elf_reader,
-                                                 obj_tools::DwarfReader* dwarf_reader,
+                                                 const obj_tools::GoPCLNTab* go_pclntab,
+                                                 const GoSymAddrs& symaddrs,
                                                  const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symaddrs for this binary.
-  Status s = UpdateGoHTTP2SymAddrs(elf_reader, dwarf_reader, pids);
+  Status s = UpdateGoHTTP2SymAddrs(symaddrs, pids);
   if (!s.ok()) {
     return 0;
   }
@@ -401,19 +455,19 @@ StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader);
+  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader, go_pclntab);
 }
 
 namespace {
 
-// Convert PID list from list of UPIDs to a map with key=binary name, value=PIDs
-std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
+// Convert PID list from list of UPIDs to a map with key=binary name, value=UPIDs
+std::map<std::string, std::vector<md::UPID>> ConvertPIDsListToMap(
     const absl::flat_hash_set<md::UPID>& upids, LazyLoadedFPResolver* fp_resolver) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const system::ProcParser proc_parser(sysconfig);
 
   // Convert to a map of binaries, with the upids that are instances of that binary.
-  std::map<std::string, std::vector<int32_t>> pids;
+  std::map<std::string, std::vector<md::UPID>> pids;
 
   for (const auto& upid : upids) {
     // TODO(yzhao): Might need to check the start time.
@@ -431,7 +485,7 @@ std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
     if (!fs::Exists(host_exe_path).ok()) {
       continue;
     }
-    pids[host_exe_path.string()].push_back(upid.pid());
+    pids[host_exe_path.string()].push_back(upid);
   }
 
   VLOG(1) << absl::Substitute("New PIDs count = $0", pids.size());
@@ -439,6 +493,83 @@ std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
   return pids;
 }
 
+// The result of analyzing a binary, which is everything needed to attach the Go uprobes to it.
+struct GoBinaryAnalysis {
+  std::string binary;
+  std::vector<md::UPID> upids;
+
+  // Only set if the binary is a Go binary with known symaddrs.
+  std::unique_ptr<ElfReader> elf_reader;
+  // Optional. Answers the function queries of the uprobes faster than the ElfReader.
+  std::unique_ptr<GoPCLNTab> go_pclntab;
+  GoSymAddrs symaddrs;
+
+  std::chrono::steady_clock::duration analysis_time = {};
+};
+
+// Reads the symbols of the binary, and computes its symaddrs.
+// Runs on the analysis threads, so it must not touch any state but the symaddrs cache.
+void AnalyzeGoBinary(GoSymAddrsCache* go_symaddrs_cache, GoBinaryAnalysis* analysis) {
+  const auto start_time = std::chrono::steady_clock::now();
+  const std::string& binary = analysis->binary;
+
+  // Read binary's symbols.
+  StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
+  if (!elf_reader_status.ok()) {
+    LOG(WARNING) << absl::Substitute(
+        "Cannot analyze binary $0 for uprobe deployment. "
+        "If file is under /var/lib, container may have terminated. "
+        "Message = $1",
+        binary, elf_reader_status.msg());
+    return;
+  }
+  std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+
+  // The pclntab is only found in Go binaries, but unlike runtime.buildVersion, it survives the
+  // stripping of the symbol table.
+  StatusOr<std::unique_ptr<GoPCLNTab>> go_pclntab_status = GoPCLNTab::Create(binary);
+
+  // Avoid going passed this point if not a golang program.
+  // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
+  if (!go_pclntab_status.ok() && !IsGoExecutable(elf_reader.get())) {
+    return;
+  }
+  VLOG_IF(1, !go_pclntab_status.ok()) << absl::Substitute(
+      "Could not read the pclntab of Go binary $0, falling back to its symbol table. Message = $1",
+      binary, go_pclntab_status.msg());
+
+  // Binaries seen before (possibly at another path, or before a restart) skip DWARF parsing.
+  StatusOr<GoSymAddrs> symaddrs_status = go_symaddrs_cache->GetSymAddrs(binary, elf_reader.get());
+  if (!symaddrs_status.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
+        "Message = $1",
+        binary, symaddrs_status.msg());
+    return;
+  }
+
+  analysis->elf_reader = std::move(elf_reader);
+  if (go_pclntab_status.ok()) {
+    analysis->go_pclntab = go_pclntab_status.ConsumeValueOrDie();
+  }
+  analysis->symaddrs = symaddrs_status.ConsumeValueOrDie();
+  analysis->analysis_time = std::chrono::steady_clock::now() - start_time;
+}
+
+// Records the time since the start of each of the processes, whose start times are in clock ticks
+// since boot.
+void ObserveDeployLatency(const std::vector<md::UPID>& upids, prometheus::Histogram* histogram) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0) {
+    return;
+  }
+  const double now_secs = ts.tv_sec + ts.tv_nsec * 1e-9;
+  const double ticks_per_sec = system::Config::GetInstance().KernelTicksPerSecond();
+  for (const auto& upid : upids) {
+    histogram->Observe(std::max(now_secs - upid.start_ts() / ticks_per_sec, 0.0));
+  }
+}
+
 }  // namespace
 
 std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids) {
@@ -496,17 +627,61 @@ int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pid
           "PID $0: $1",
           pid.pid(), count_or.ToString());
     }
+
+    // Rescans of old processes would skew the latency.
+    if (proc_tracker_.new_upids().contains(pid)) {
+      ObserveDeployLatency({pid}, &openssl_deploy_latency_);
+    }
   }
 
   return uprobe_count;
 }
 
-int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+int UProbeManager::AttachGoUProbes(const std::string& binary, ElfReader* elf_reader,
+                                   const GoPCLNTab* go_pclntab, const GoSymAddrs& symaddrs,
+                                   const std::vector<int32_t>& pids) {
+  Status s = UpdateGoCommonSymAddrs(symaddrs, pids);
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+    return 0;
+  }
+
   int uprobe_count = 0;
 
+  // GoTLS Probes.
+  {
+    StatusOr<int> attach_status =
+        AttachGoTLSUProbes(binary, elf_reader, go_pclntab, symaddrs, pids);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
+  }
+
+  // Go HTTP2 Probes.
+  if (cfg_enable_http2_tracing_) {
+    StatusOr<int> attach_status =
+        AttachGoHTTP2Probes(binary, elf_reader, go_pclntab, symaddrs, pids);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
+  }
+
+  return uprobe_count;
+}
+
+int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
   static int32_t kPID = getpid();
 
-  for (const auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
+  // Stage 1: Group the processes by binary, so that each binary is analyzed once.
+  std::vector<GoBinaryAnalysis> analyses;
+  for (auto& [binary, upids] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
     // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
     if (!scanned_binaries_.insert(binary).second) {
       continue;
@@ -515,72 +690,80 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
     if (cfg_disable_self_probing_) {
       // Don't try to attach uprobes to self.
       // This speeds up stirling_wrapper initialization significantly.
-      if (pid_vec.size() == 1 && pid_vec[0] == kPID) {
+      if (upids.size() == 1 && upids[0].pid() == static_cast<uint32_t>(kPID)) {
         continue;
       }
     }
 
-    // Read binary's symbols.
-    StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
-    if (!elf_reader_status.ok()) {
-      LOG(WARNING) << absl::Substitute(
-          "Cannot analyze binary $0 for uprobe deployment. "
-          "If file is under /var/lib, container may have terminated. "
-          "Message = $1",
-          binary, elf_reader_status.msg());
-      continue;
-    }
-    std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+    analyses.push_back({binary, std::move(upids)});
+  }
 
-    // Avoid going passed this point if not a golang program.
-    // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
-    if (!IsGoExecutable(elf_reader.get())) {
-      continue;
-    }
+  if (analyses.empty()) {
+    return 0;
+  }
 
-    StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status =
-        DwarfReader::CreateIndexingAll(binary);
-    if (!dwarf_reader_status.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
-          "Message = $1",
-          binary, dwarf_reader_status.msg());
-      continue;
+  // Stage 2: Analyze the binaries on a bounded pool of threads, so that the DWARF parsing of
+  // one large binary does not hold up the uprobes of all other binaries.
+  std::mutex analyzed_mutex;
+  std::condition_variable analyzed_cv;
+  std::vector<GoBinaryAnalysis*> analyzed;
+
+  std::atomic<size_t> next_idx = 0;
+  auto analyze = [this, &analyses, &next_idx, &analyzed_mutex, &analyzed_cv, &analyzed]() {
+    for (size_t i = next_idx++; i < analyses.size(); i = next_idx++) {
+      AnalyzeGoBinary(&go_symaddrs_cache_, &analyses[i]);
+      {
+        const std::lock_guard<std::mutex> lock(analyzed_mutex);
+        analyzed.push_back(&analyses[i]);
+      }
+      analyzed_cv.notify_one();
     }
-    std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+  };
 
-    Status s = UpdateGoCommonSymAddrs(elf_reader.get(), dwarf_reader.get(), pid_vec);
-    if (!s.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
-      continue;
-    }
+  const size_t num_threads =
+      std::min<size_t>(std::max(FLAGS_stirling_uprobe_analysis_threads, 1), analyses.size());
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(analyze);
+  }
 
-    // GoTLS Probes.
+  // Stage 3: Attach the uprobes in batches, each of the binaries analyzed since the last batch.
+  // BCC is not thread-safe, so all attaching happens on this thread.
+  int uprobe_count = 0;
+  std::vector<GoBinaryAnalysis*> batch;
+  for (size_t num_attached = 0; num_attached < analyses.size(); num_attached += batch.size()) {
+    batch.clear();
     {
-      StatusOr<int> attach_status =
-          AttachGoTLSUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
-      }
+      std::unique_lock<std::mutex> lock(analyzed_mutex);
+      analyzed_cv.wait(lock, [&analyzed]() { return !analyzed.empty(); });
+      batch.swap(analyzed);
     }
 
-    // Go HTTP2 Probes.
-    if (cfg_enable_http2_tracing_) {
-      StatusOr<int> attach_status =
-          AttachGoHTTP2Probes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    for (GoBinaryAnalysis* analysis : batch) {
+      if (analysis->elf_reader == nullptr) {
+        continue;
+      }
+      go_analysis_time_.Observe(std::chrono::duration<double>(analysis->analysis_time).count());
+      std::vector<int32_t> pid_vec;
+      pid_vec.reserve(analysis->upids.size());
+      for (const auto& upid : analysis->upids) {
+        pid_vec.push_back(upid.pid());
       }
+      uprobe_count +=
+          AttachGoUProbes(analysis->binary, analysis->elf_reader.get(),
+                          analysis->go_pclntab.get(), analysis->symaddrs, pid_vec);
+      ObserveDeployLatency(analysis->upids, &go_deploy_latency_);
+      // The ElfReader can be large, and is not needed anymore.
+      analysis->elf_reader.reset();
+      analysis->go_pclntab.reset();
     }
   }
 
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
   return uprobe_count;
 }
 
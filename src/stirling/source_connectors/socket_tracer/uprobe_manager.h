@@ -25,13 +25,16 @@
 #include <vector>
 
 #include <absl/synchronization/mutex.h>
+#include <prometheus/histogram.h>
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/dwarf_reader.h"
 #include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/obj_tools/go_pclntab.h"
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/source_connectors/socket_tracer/go_symaddrs_cache.h"
 
 #include "src/stirling/utils/detect_application.h"
 #include "src/stirling/utils/proc_path_tools.h"
@@ -39,6 +42,9 @@
 
 DECLARE_bool(stirling_rescan_for_dlopen);
 DECLARE_double(stirling_rescan_exp_backoff_factor);
+DECLARE_string(stirling_go_symaddrs_cache_dir);
+DECLARE_int32(stirling_dwarf_indexing_threads);
+DECLARE_int32(stirling_uprobe_analysis_threads);
 
 namespace px {
 namespace stirling {
@@ -352,18 +358,29 @@ class UProbeManager {
 
   /**
    * Deploys all Go uprobes on new processes.
+   * The binaries of the processes are analyzed in parallel, and the uprobes of each binary are
+   * attached as soon as its analysis completes, so small binaries need not wait for large ones.
    * @param pids The list of pids to analyze and instrument with Go uprobes, if appropriate.
    * @return Number of uprobes deployed.
    */
   int DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids);
 
+  /**
+   * Attaches the Go uprobes to an analyzed Go binary, and sets the symaddrs of its processes.
+   * @return Number of uprobes deployed.
+   */
+  int AttachGoUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
+                      const obj_tools::GoPCLNTab* go_pclntab, const GoSymAddrs& symaddrs,
+                      const std::vector<int32_t>& pids);
+
   /**
    * Attaches the required probes for Go HTTP2 tracing to the specified binary, if it is a
    * compatible Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
    * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param go_pclntab Function table of the binary. Optional; used instead of elf_reader if set.
+   * @param symaddrs Symbol addresses of the binary, computed from its DWARF info.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not considered an error if the binary
@@ -371,8 +388,8 @@ class UProbeManager {
    *         zero.
    */
   StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                    obj_tools::DwarfReader* dwarf_reader,
-                                    const std::vector<int32_t>& pids);
+                                    const obj_tools::GoPCLNTab* go_pclntab,
+                                    const GoSymAddrs& symaddrs, const std::vector<int32_t>& pids);
 
   /**
    * Attaches the required probes for GoTLS tracing to the specified binary, if it is a compatible
@@ -380,14 +397,16 @@ class UProbeManager {
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
    * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param go_pclntab Function table of the binary. Optional; used instead of elf_reader if set.
+   * @param symaddrs Symbol addresses of the binary, computed from its DWARF info.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not an error if the binary
    *         is not a Go binary or doesn't use Go TLS; instead the return value will be zero.
    */
   StatusOr<int> AttachGoTLSUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                   obj_tools::DwarfReader* dwarf_reader,
+                                   const obj_tools::GoPCLNTab* go_pclntab,
+                                   const GoSymAddrs& symaddrs,
                                    const std::vector<int32_t>& new_pids);
 
   /**
@@ -418,24 +437,22 @@ class UProbeManager {
    * @param probe_tmpls Array of probe templates to process.
    * @param binary The binary to uprobe.
    * @param elf_reader Pointer to an elf reader for the binary. Used to find symbol matches.
+   * @param go_pclntab Function table of a Go binary. If set, it is used to find symbol matches
+   *                   instead of elf_reader, which is much faster.
    * @return Number of uprobes deployed, or error if uprobes failed to deploy. Zero uprobes
    *         deploying because there are no symbol matches is not considered an error.
    */
   StatusOr<int> AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                 const std::string& binary, obj_tools::ElfReader* elf_reader);
+                                 const std::string& binary, obj_tools::ElfReader* elf_reader,
+                                 const obj_tools::GoPCLNTab* go_pclntab = nullptr);
 
   // Returns set of PIDs that have had mmap called on them since the last call.
   absl::flat_hash_set<md::UPID> PIDsToRescanForUProbes();
 
   Status UpdateOpenSSLSymAddrs(std::filesystem::path container_lib, uint32_t pid);
-  Status UpdateGoCommonSymAddrs(obj_tools::ElfReader* elf_reader,
-                                obj_tools::DwarfReader* dwarf_reader,
-                                const std::vector<int32_t>& pids);
-  Status UpdateGoHTTP2SymAddrs(obj_tools::ElfReader* elf_reader,
-                               obj_tools::DwarfReader* dwarf_reader,
-                               const std::vector<int32_t>& pids);
-  Status UpdateGoTLSSymAddrs(obj_tools::ElfReader* elf_reader, obj_tools::DwarfReader* dwarf_reader,
-                             const std::vector<int32_t>& pids);
+  Status UpdateGoCommonSymAddrs(const GoSymAddrs& symaddrs, const std::vector<int32_t>& pids);
+  Status UpdateGoHTTP2SymAddrs(const GoSymAddrs& symaddrs, const std::vector<int32_t>& pids);
+  Status UpdateGoTLSSymAddrs(const GoSymAddrs& symaddrs, const std::vector<int32_t>& pids);
   Status UpdateNodeTLSWrapSymAddrs(int32_t pid, const std::filesystem::path& node_exe,
                                    const SemVer& ver);
 
@@ -479,6 +496,16 @@ class UProbeManager {
   absl::flat_hash_set<std::string> go_tls_probed_binaries_;
   absl::flat_hash_set<std::string> nodejs_binaries_;
 
+  // Symbol addresses of Go binaries, so that copies of known binaries skip DWARF parsing.
+  // Shared by the threads that analyze binaries in DeployGoUProbes().
+  GoSymAddrsCache go_symaddrs_cache_;
+
+  // Time from the start of processes until their uprobe deployment completed.
+  prometheus::Histogram& openssl_deploy_latency_;
+  prometheus::Histogram& go_deploy_latency_;
+  // Time to analyze a new Go binary, mostly spent parsing DWARF info.
+  prometheus::Histogram& go_analysis_time_;
+
   // BPF maps through which the addresses of symbols for a given pid are communicated to uprobes.
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct openssl_symaddrs_t>>
       openssl_symaddrs_map_;
@@ -29,16 +29,23 @@
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+#include <prometheus/family.h>
+#include <prometheus/histogram.h>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/perf/elapsed_timer.h"
 #include "src/common/system/system_info.h"
 
 #include "src/stirling/bpf_tools/probe_cleaner.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/pub_sub_manager.h"
+#include "src/stirling/core/push_policy.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/core/source_registry.h"
+#include "src/stirling/core/upid_watcher.h"
 #include "src/stirling/proto/stirling.pb.h"
 
 #include "src/stirling/source_connectors/dynamic_bpftrace/dynamic_bpftrace_connector.h"
@@ -55,6 +62,20 @@
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
+DEFINE_bool(stirling_proc_events, true,
+            "When Stirling runs standalone, keep track of processes with netlink proc connector "
+            "events instead of scanning /proc on every iteration. Falls back to scanning if the "
+            "proc connector is not available.");
+DEFINE_int32(stirling_proc_rescan_period_secs, 60,
+             "When tracking processes with proc connector events, how often to rescan /proc to "
+             "reconcile any missed events.");
+DEFINE_int32(stirling_source_connector_threads, 0,
+             "The number of threads that run the source connectors. With 0, all source connectors "
+             "run one after the other on the main Stirling thread. Otherwise, they run on a pool "
+             "of threads, earliest deadline first, so that a slow source connector does not delay "
+             "the others. Each source connector runs on one thread at a time, so there is no "
+             "point in more threads than source connectors.");
+
 namespace px {
 namespace stirling {
 
@@ -139,10 +160,32 @@ std::unique_ptr<SourceRegistry> CreateProdSourceRegistry() {
       .ConsumeValueOrDie();
 }
 
+// Per source connector metrics.
+struct SourceMetrics {
+  // How long each iteration of TransferData() and PushData() takes.
+  prometheus::Histogram* iteration_time = nullptr;
+  // How late each iteration starts, after the sampling or push period has expired.
+  prometheus::Histogram* lateness = nullptr;
+  // How long each push to the table store takes, and how many records it has.
+  prometheus::Histogram* push_latency = nullptr;
+  prometheus::Histogram* push_records = nullptr;
+};
+
 // Holds InfoClassManager and DataTable.
 struct SourceOutput {
   std::vector<InfoClassManager*> info_class_mgrs;
   std::vector<DataTable*> data_tables;
+  SourceMetrics metrics;
+  // Decides when to push ahead of the push period. On the heap, for the same reason as run_lock.
+  std::unique_ptr<PushPolicy> push_policy = std::make_unique<PushPolicy>();
+  // Held while the source connector runs on the thread pool (see
+  // --stirling_source_connector_threads). Only acquired with info_class_mgrs_lock_ held, so that
+  // holding info_class_mgrs_lock_ prevents a source connector from starting to run.
+  // On the heap, because SourceOutput objects are moved around by the map that holds them.
+  std::unique_ptr<absl::Mutex> run_lock = std::make_unique<absl::Mutex>();
+  // Set by RemoveSource() before it waits for run_lock. A removed source connector is not run
+  // again, and is erased from the map once RemoveSource() is done waiting.
+  bool removed = false;
 };
 
 class StirlingImpl final : public Stirling {
@@ -202,6 +245,17 @@ class StirlingImpl final : public Stirling {
   // Main run implementation.
   void RunCore();
 
+  // Runs the source connectors on a thread of the pool, until Stirling is stopped.
+  void RunSourceConnectorWorker();
+
+  // Calls fn on each source connector, while holding its run_lock, so that fn does not race with
+  // the source connector running on the thread pool.
+  void ForEachSourceWithRunLock(const std::function<void(SourceConnector*)>& fn);
+
+  // Samples the source and pushes its data, if it is time to.
+  void RunSource(SourceConnector* source, const std::vector<DataTable*>& data_tables,
+                 const SourceMetrics& metrics, PushPolicy* push_policy, ConnectorContext* ctx);
+
   // Wait for Stirling to stop its main loop.
   void WaitForStop();
 
@@ -231,9 +285,18 @@ class StirlingImpl final : public Stirling {
    */
   DataPushCallback data_push_callback_ = nullptr;
 
+  // Serializes the calls to data_push_callback_, which is not required to be thread-safe, when
+  // the source connectors run on the thread pool.
+  absl::Mutex data_push_lock_;
+
   AgentMetadataCallback agent_metadata_callback_ = nullptr;
   AgentMetadataType agent_metadata_;
 
+  // Tracks the processes for StandaloneContext, when there is no agent metadata.
+  // GetContext() is called from both the main loop and RegisterTracepoint().
+  absl::Mutex upid_watcher_lock_;
+  std::unique_ptr<UPIDWatcher> upid_watcher_ ABSL_GUARDED_BY(upid_watcher_lock_);
+
   absl::base_internal::SpinLock dynamic_trace_status_map_lock_;
   absl::flat_hash_map<sole::uuid, StatusOr<stirlingpb::Publish>> dynamic_trace_status_map_
       ABSL_GUARDED_BY(dynamic_trace_status_map_lock_);
@@ -365,11 +428,86 @@ std::unique_ptr<ConnectorContext> StirlingImpl::GetContext() {
   if (agent_metadata_callback_ != nullptr) {
     return std::unique_ptr<ConnectorContext>(new AgentContext(agent_metadata_callback_()));
   }
-  return std::unique_ptr<ConnectorContext>(new StandaloneContext());
+
+  absl::MutexLock lock(&upid_watcher_lock_);
+  if (upid_watcher_ == nullptr) {
+    std::unique_ptr<system::ProcEventListener> listener;
+    if (FLAGS_stirling_proc_events) {
+      StatusOr<std::unique_ptr<system::ProcEventListener>> listener_or =
+          system::ProcEventListener::Create();
+      if (listener_or.ok()) {
+        listener = listener_or.ConsumeValueOrDie();
+      } else {
+        LOG(WARNING) << absl::Substitute(
+            "Proc connector is not available, falling back to scanning /proc. Message=$0",
+            listener_or.msg());
+      }
+    }
+    upid_watcher_ = std::make_unique<UPIDWatcher>(
+        system::Config::GetInstance().proc_path(), /*asid*/ 0, std::move(listener),
+        std::chrono::seconds(FLAGS_stirling_proc_rescan_period_secs));
+  }
+  upid_watcher_->Update();
+  return std::unique_ptr<ConnectorContext>(new StandaloneContext(upid_watcher_->upids()));
 }
 
 namespace {
 
+prometheus::Family<prometheus::Histogram>& SourceIterationTimeFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("stirling_source_connector_iteration_seconds")
+                            .Help("Time taken by an iteration of a source connector, to sample "
+                                  "its data and push it")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Histogram>& SourcePushLatencyFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("stirling_source_connector_push_latency_seconds")
+                            .Help("Time taken to push a record batch to the table store")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Histogram>& SourcePushRecordsFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("stirling_source_connector_push_records")
+                            .Help("Number of records in a record batch pushed to the table store")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Histogram>& SourceLatenessFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("stirling_source_connector_lateness_seconds")
+                            .Help("How late an iteration of a source connector starts, after it "
+                                  "is due to sample or push its data")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+SourceMetrics BuildSourceMetrics(std::string_view source_name) {
+  // Seconds. Spans from the quick iterations of most source connectors, to bursts of work like
+  // the symbolization of the perf profiler.
+  static const auto kBuckets = prometheus::Histogram::BucketBoundaries{
+      0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5};
+  static const auto kRecordsBuckets =
+      prometheus::Histogram::BucketBoundaries{16, 64, 256, 1024, 4096, 16384, 65536};
+  prometheus::Labels labels = {{"source", std::string(source_name)}};
+  return {&SourceIterationTimeFamily().Add(labels, kBuckets),
+          &SourceLatenessFamily().Add(labels, kBuckets),
+          &SourcePushLatencyFamily().Add(labels, kBuckets),
+          &SourcePushRecordsFamily().Add(labels, kRecordsBuckets)};
+}
+
+void RemoveSourceMetrics(const SourceMetrics& metrics) {
+  SourceIterationTimeFamily().Remove(metrics.iteration_time);
+  SourceLatenessFamily().Remove(metrics.lateness);
+  SourcePushLatencyFamily().Remove(metrics.push_latency);
+  SourcePushRecordsFamily().Remove(metrics.push_records);
+}
+
 std::vector<DataTable*> GetDataTables(const std::vector<InfoClassManager*>& info_class_mgrs) {
   std::vector<DataTable*> data_tables;
   data_tables.reserve(info_class_mgrs.size());
@@ -400,38 +538,62 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
 
   std::vector<DataTable*> data_tables = GetDataTables(mgrs);
 
-  source_output_map_[source.get()] = {std::move(mgrs),
-                                      // DataTable objects are created after subscribing.
-                                      std::move(data_tables)};
+  SourceOutput& output = source_output_map_[source.get()];
+  output.info_class_mgrs = std::move(mgrs);
+  // DataTable objects are created after subscribing.
+  output.data_tables = std::move(data_tables);
+  output.metrics = BuildSourceMetrics(source->name());
   sources_.push_back(std::move(source));
 
   return Status::OK();
 }
 
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  SourceConnector* source = nullptr;
+  absl::Mutex* run_lock = nullptr;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+
+    // Find the source.
+    for (const auto& s : sources_) {
+      if (s->name() == source_name && !source_output_map_[s.get()].removed) {
+        source = s.get();
+        break;
+      }
+    }
+    if (source == nullptr) {
+      return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
+    }
 
-  // Find the source.
-  auto source_iter = std::find_if(sources_.begin(), sources_.end(),
-                                  [&source_name](const std::unique_ptr<SourceConnector>& s) {
-                                    return s->name() == source_name;
-                                  });
-  if (source_iter == sources_.end()) {
-    return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
+    // Stop the source from being picked up again, by the main loop or the thread pool.
+    SourceOutput& output = source_output_map_[source];
+    output.removed = true;
+    run_lock = output.run_lock.get();
   }
-  std::unique_ptr<SourceConnector>& source = *source_iter;
+
+  // Wait for the source to finish running on the thread pool, if it is. This is done without
+  // holding info_class_mgrs_lock_, which the other source connectors need to get scheduled.
+  // run_lock outlives the wait, since only this function erases the source.
+  run_lock->Lock();
+  run_lock->Unlock();
+
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   // Remove all info class managers that point back to the source.
   info_class_mgrs_.erase(std::remove_if(info_class_mgrs_.begin(), info_class_mgrs_.end(),
-                                        [&source](std::unique_ptr<InfoClassManager>& mgr) {
-                                          return mgr->source() == source.get();
+                                        [source](std::unique_ptr<InfoClassManager>& mgr) {
+                                          return mgr->source() == source;
                                         }),
                          info_class_mgrs_.end());
 
   // Now perform the removal.
   PL_RETURN_IF_ERROR(source->Stop());
-  source_output_map_.erase(source.get());
-  sources_.erase(source_iter);
+  RemoveSourceMetrics(source_output_map_[source].metrics);
+  source_output_map_.erase(source);
+  sources_.erase(std::find_if(sources_.begin(), sources_.end(),
+                              [source](const std::unique_ptr<SourceConnector>& s) {
+                                return s.get() == source;
+                              }));
 
   return Status::OK();
 }
@@ -700,26 +862,115 @@ void SleepForDuration(std::chrono::milliseconds sleep_duration) {
   }
 }
 
-// Returns true if any of the input tables are beyond the threshold.
-bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
-  // Data push threshold, based on percentage of buffer that is filled.
-  constexpr uint32_t kDefaultOccupancyPctThreshold = 100;
+// Returns the largest occupancy among the input tables.
+size_t MaxOccupancy(const std::vector<DataTable*>& data_tables) {
+  size_t occupancy = 0;
+  for (const auto* data_table : data_tables) {
+    occupancy = std::max(occupancy, data_table->Occupancy());
+  }
+  return occupancy;
+}
 
-  // Data push threshold, based number of records after which a push.
-  constexpr uint32_t kDefaultOccupancyThreshold = 1024;
+}  // namespace
 
-  for (const auto* data_table : data_tables) {
-    if (static_cast<uint32_t>(100 * data_table->OccupancyPct()) > kDefaultOccupancyPctThreshold) {
-      return true;
-    }
-    if (data_table->Occupancy() > kDefaultOccupancyThreshold) {
-      return true;
+void StirlingImpl::RunSource(SourceConnector* source, const std::vector<DataTable*>& data_tables,
+                             const SourceMetrics& metrics, PushPolicy* push_policy,
+                             ConnectorContext* ctx) {
+  auto start_time = std::chrono::steady_clock::now();
+  auto now = px::chrono::coarse_steady_clock::now();
+  auto due_time = std::min(source->sampling_freq_mgr().next(), source->push_freq_mgr().next());
+  bool ran = false;
+
+  // Phase 1: Probe each source for its data.
+  if (source->sampling_freq_mgr().Expired()) {
+    source->TransferData(ctx, data_tables);
+    ran = true;
+  }
+  // Phase 2: Push Data upstream.
+  // The push policy is always consulted, so that it keeps track of how fast the tables fill up.
+  bool push_early = push_policy->ShouldPush(MaxOccupancy(data_tables),
+                                            source->push_freq_mgr().next(),
+                                            px::chrono::coarse_steady_clock::now());
+  if (source->push_freq_mgr().Expired() || push_early) {
+    // The push policy looks at the whole push cycle, over all the tables of the source connector.
+    std::chrono::nanoseconds cycle_push_latency{0};
+    size_t cycle_num_records = 0;
+    auto timed_push_callback = [this, &metrics, &cycle_push_latency, &cycle_num_records](
+                                   uint32_t table_id, types::TabletID tablet_id,
+                                   std::unique_ptr<types::ColumnWrapperRecordBatch> records) {
+      size_t num_records = records->empty() ? 0 : records->front()->Size();
+      absl::MutexLock push_lock(&data_push_lock_);
+      auto push_start_time = std::chrono::steady_clock::now();
+      Status s = data_push_callback_(table_id, std::move(tablet_id), std::move(records));
+      auto push_latency = std::chrono::steady_clock::now() - push_start_time;
+      cycle_push_latency += push_latency;
+      cycle_num_records += num_records;
+      metrics.push_latency->Observe(std::chrono::duration<double>(push_latency).count());
+      metrics.push_records->Observe(num_records);
+      return s;
+    };
+    source->PushData(timed_push_callback, data_tables);
+    push_policy->RecordPush(cycle_push_latency, cycle_num_records);
+    ran = true;
+  }
+
+  if (ran) {
+    if (now >= due_time) {
+      metrics.lateness->Observe(std::chrono::duration<double>(now - due_time).count());
     }
+    metrics.iteration_time->Observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
   }
-  return false;
 }
 
-}  // namespace
+void StirlingImpl::RunSourceConnectorWorker() {
+  while (run_enable_) {
+    auto now = px::chrono::coarse_steady_clock::now();
+    auto wakeup_time = now + kMaxSleepDuration;
+
+    // Pick the source connector that has been due for the longest time, among those that are not
+    // already running on another thread. A source connector's state is only read while holding
+    // its run_lock.
+    SourceConnector* source = nullptr;
+    std::vector<DataTable*> data_tables;
+    SourceMetrics metrics;
+    PushPolicy* push_policy = nullptr;
+    absl::Mutex* run_lock = nullptr;
+    {
+      absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+      auto source_due_time = wakeup_time;
+      for (auto& [s, output] : source_output_map_) {
+        if (output.removed || !output.run_lock->TryLock()) {
+          continue;
+        }
+        auto due_time = std::min(s->sampling_freq_mgr().next(), s->push_freq_mgr().next());
+        if (due_time <= now && (source == nullptr || due_time < source_due_time)) {
+          if (run_lock != nullptr) {
+            run_lock->Unlock();
+          }
+          source = s;
+          source_due_time = due_time;
+          data_tables = output.data_tables;
+          metrics = output.metrics;
+          push_policy = output.push_policy.get();
+          run_lock = output.run_lock.get();
+        } else {
+          wakeup_time = std::min(wakeup_time, due_time);
+          output.run_lock->Unlock();
+        }
+      }
+    }
+
+    if (source == nullptr) {
+      SleepForDuration(std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now));
+      continue;
+    }
+
+    std::unique_ptr<ConnectorContext> ctx = GetContext();
+    RunSource(source, data_tables, metrics, push_policy, ctx.get());
+    run_lock->Unlock();
+  }
+}
 
 // Main Data Collector loop.
 // Poll on Data Source Through connectors, when appropriate, then go to sleep.
@@ -737,14 +988,25 @@ void StirlingImpl::RunCore() {
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
+  if (FLAGS_stirling_source_connector_threads > 0) {
+    std::vector<std::thread> workers;
+    for (int i = 0; i < FLAGS_stirling_source_connector_threads; ++i) {
+      workers.emplace_back(&StirlingImpl::RunSourceConnectorWorker, this);
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    running_ = false;
+    return;
+  }
+
   while (run_enable_) {
     auto sleep_duration = std::chrono::milliseconds::zero();
 
     // Update the context/state on each iteration.
     // Note that if no changes are present, the same pointer will be returned back.
-    // TODO(oazizi): If context constructor does a lot of work (e.g. ListUPIDs()),
-    //               then there might be an inefficiency here, since we don't know if
-    //               mgr->SamplingRequired() will be true for any manager.
+    // When standalone, the UPIDs are updated from process events where possible (see
+    // UPIDWatcher), so this does not rescan /proc on every iteration.
     std::unique_ptr<ConnectorContext> ctx = GetContext();
 
     {
@@ -754,14 +1016,11 @@ void StirlingImpl::RunCore() {
 
       // Run through every SourceConnector and InfoClassManager being managed.
       for (auto& [source, output] : source_output_map_) {
-        // Phase 1: Probe each source for its data.
-        if (source->sampling_freq_mgr().Expired()) {
-          source->TransferData(ctx.get(), output.data_tables);
-        }
-        // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables)) {
-          source->PushData(data_push_callback_, output.data_tables);
+        if (output.removed) {
+          continue;
         }
+        RunSource(source, output.data_tables, output.metrics, output.push_policy.get(),
+                  ctx.get());
       }
 
       // Figure out how long to sleep.
@@ -804,26 +1063,44 @@ void StirlingImpl::Stop() {
   }
 }
 
-void StirlingImpl::SetDebugLevel(int level) {
-  // Lock not really required, but compiler is making sure we're safe.
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->SetDebugLevel(level);
+void StirlingImpl::ForEachSourceWithRunLock(const std::function<void(SourceConnector*)>& fn) {
+  // A run_lock is never waited on while holding info_class_mgrs_lock_, so the source connectors
+  // that are running are skipped, and retried after they are done.
+  absl::flat_hash_set<SourceConnector*> done;
+  bool pending = true;
+  while (pending) {
+    pending = false;
+    {
+      absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+      for (auto& [source, output] : source_output_map_) {
+        if (output.removed || done.contains(source)) {
+          continue;
+        }
+        if (!output.run_lock->TryLock()) {
+          pending = true;
+          continue;
+        }
+        fn(source);
+        output.run_lock->Unlock();
+        done.insert(source);
+      }
+    }
+    if (pending) {
+      std::this_thread::sleep_for(kMinSleepDuration);
+    }
   }
 }
 
+void StirlingImpl::SetDebugLevel(int level) {
+  ForEachSourceWithRunLock([level](SourceConnector* s) { s->SetDebugLevel(level); });
+}
+
 void StirlingImpl::EnablePIDTrace(int pid) {
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->EnablePIDTrace(pid);
-  }
+  ForEachSourceWithRunLock([pid](SourceConnector* s) { s->EnablePIDTrace(pid); });
 }
 
 void StirlingImpl::DisablePIDTrace(int pid) {
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->DisablePIDTrace(pid);
-  }
+  ForEachSourceWithRunLock([pid](SourceConnector* s) { s->DisablePIDTrace(pid); });
 }
 
 std::unique_ptr<Stirling> Stirling::Create(std::unique_ptr<SourceRegistry> registry) {
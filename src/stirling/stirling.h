@@ -138,6 +138,10 @@ class Stirling : public NotCopyable {
    * Function signature is:
    *   uint64_t table_id
    *   std::unique_ptr<ColumnWrapperRecordBatch> data
+   *
+   * The callback is called from the Stirling thread, or, with --stirling_source_connector_threads,
+   * from any thread of the pool. The calls are serialized, so the callback does not need to be
+   * thread-safe with respect to itself, but must not block on another Stirling call.
    */
   virtual void RegisterDataPushCallback(DataPushCallback f) = 0;
 
@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <iterator>
 #include <vector>
 
 namespace px {
@@ -45,6 +48,68 @@ std::vector<size_t> SortedIndexes(const std::vector<T>& v) {
   return idx;
 }
 
+// Computes the same reorder vector as SortedIndexes(), for a vector made of sorted runs.
+// run_starts holds the index at which each run after the first one begins, in increasing order.
+// The runs are merged with a min-heap in O(n log k) for k runs, instead of sorting the whole
+// vector. Ties are broken by index, so the result is identical to that of SortedIndexes().
+// When there is a single run, the result is the identity, and no comparisons are made.
+template <typename T>
+std::vector<size_t> MergeSortedRuns(const std::vector<T>& v,
+                                    const std::vector<size_t>& run_starts) {
+  std::vector<size_t> idx;
+  idx.reserve(v.size());
+
+  // The next position to merge from each run, and the end of that run.
+  struct Cursor {
+    size_t pos;
+    size_t end;
+  };
+  std::vector<Cursor> heap;
+  heap.reserve(run_starts.size() + 1);
+  size_t run_begin = 0;
+  for (size_t run_start : run_starts) {
+    if (run_start > run_begin) {
+      heap.push_back({run_begin, run_start});
+    }
+    run_begin = run_start;
+  }
+  if (v.size() > run_begin) {
+    heap.push_back({run_begin, v.size()});
+  }
+
+  // std::make_heap() builds a max-heap, so this orders by descending {value, index}.
+  auto cmp = [&v](const Cursor& a, const Cursor& b) {
+    if (v[a.pos] < v[b.pos]) {
+      return false;
+    }
+    if (v[b.pos] < v[a.pos]) {
+      return true;
+    }
+    return a.pos > b.pos;
+  };
+  std::make_heap(heap.begin(), heap.end(), cmp);
+
+  while (heap.size() > 1) {
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    Cursor& cursor = heap.back();
+    idx.push_back(cursor.pos++);
+    if (cursor.pos == cursor.end) {
+      heap.pop_back();
+    } else {
+      std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+  }
+
+  // The last run is copied out as it is.
+  if (!heap.empty()) {
+    for (size_t i = heap.front().pos; i < heap.front().end; ++i) {
+      idx.push_back(i);
+    }
+  }
+
+  return idx;
+}
+
 // An iterator that walks over a vector according to provided indexes.
 // Used in conjunction with SortedIndexes to iterate through an unsorted vector in sorted order.
 template <typename T>
@@ -97,7 +162,7 @@ class IndexedVectorIterator {
 // Uses std::lower_bound, which is a binary search for efficiency.
 template <size_t N, typename T>
 std::array<size_t, N> SplitSortedVector(const std::vector<T>& vec,
-                                        const std::vector<size_t> sort_indexes,
+                                        const std::vector<size_t>& sort_indexes,
                                         std::array<T, N> split_vals) {
   std::array<size_t, N> out;
 
@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include <limits>
+#include <random>
 
 #include "src/stirling/utils/index_sorted_vector.h"
 
@@ -33,6 +34,41 @@ TEST(SortedIndexes, Basic) {
   EXPECT_EQ(sort_indexes, (std::vector<size_t>{1, 0, 2, 5, 4, 3}));
 }
 
+TEST(MergeSortedRuns, Basic) {
+  std::vector<int> data = {2, 4, 10, 0, 6, 8, 4};
+  EXPECT_EQ(MergeSortedRuns(data, {3, 6}), (std::vector<size_t>{3, 0, 1, 6, 4, 5, 2}));
+  EXPECT_EQ(MergeSortedRuns(data, {3, 6}), SortedIndexes(data));
+}
+
+TEST(MergeSortedRuns, SingleRun) {
+  std::vector<int> data = {0, 1, 1, 5};
+  EXPECT_EQ(MergeSortedRuns(data, {}), (std::vector<size_t>{0, 1, 2, 3}));
+  EXPECT_EQ(MergeSortedRuns(std::vector<int>{}, {}), (std::vector<size_t>{}));
+}
+
+TEST(MergeSortedRuns, MatchesSortedIndexes) {
+  std::default_random_engine rng(37);
+  // Mostly increasing values, with repeats to check that ties are broken the same way.
+  std::uniform_int_distribution<int> step_dist(-3, 3);
+  std::uniform_int_distribution<int> split_dist(0, 9);
+
+  for (int iter = 0; iter < 100; ++iter) {
+    std::vector<int> data = {0};
+    for (int i = 1; i < 50; ++i) {
+      data.push_back(data.back() + step_dist(rng));
+    }
+
+    // A run must end where the values decrease, and may also end anywhere else.
+    std::vector<size_t> run_starts;
+    for (size_t i = 1; i < data.size(); ++i) {
+      if (data[i] < data[i - 1] || split_dist(rng) == 0) {
+        run_starts.push_back(i);
+      }
+    }
+    EXPECT_EQ(MergeSortedRuns(data, run_starts), SortedIndexes(data));
+  }
+}
+
 TEST(SplitSortedVector, Basic) {
   // Corresponds to {0, 2, 4, 6, 8, 10} after applying sort_indexes
   std::vector<int> data = {2, 0, 4, 10, 8, 6};
@@ -18,12 +18,15 @@
 
 #include <arrow/array.h>
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
 #include "src/common/base/base.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/row_batch.h"
@@ -158,11 +161,276 @@ Status CopyFromInputPB(std::shared_ptr<arrow::Array>* output_column,
   return Status::OK();
 }
 
-Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
+// Columnar format. See ColumnBuffers in schema.proto.
+
+template <DataType T>
+void CopyIntoColumnBuffers(table_store::schemapb::ColumnBuffers* output_column,
+                           const arrow::Array* input_column) {
+  using native_type = typename types::DataTypeTraits<T>::native_type;
+  int64_t col_length = input_column->length();
+  std::string* values = output_column->mutable_values();
+  values->resize(col_length * sizeof(native_type));
+  char* dst = values->data();
+  for (int64_t i = 0; i < col_length; ++i) {
+    native_type value = types::GetValueFromArrowArray<T>(input_column, i);
+    std::memcpy(dst + i * sizeof(native_type), &value, sizeof(native_type));
+  }
+}
+
+template <typename TInt>
+void AppendInt(std::string* buf, TInt value) {
+  buf->append(reinterpret_cast<const char*>(&value), sizeof(TInt));
+}
+
+template <>
+void CopyIntoColumnBuffers<DataType::STRING>(table_store::schemapb::ColumnBuffers* output_column,
+                                             const arrow::Array* input_column) {
+  auto str_arr = static_cast<const arrow::StringArray*>(input_column);
+  int64_t col_length = str_arr->length();
+  output_column->mutable_offsets()->reserve((col_length + 1) * sizeof(int32_t));
+  AppendInt<int32_t>(output_column->mutable_offsets(), 0);
+  if (col_length == 0) {
+    return;
+  }
+  // The strings are back to back in the array, so they are copied out at once.
+  int32_t length;
+  const uint8_t* data = str_arr->GetValue(0, &length);
+  int32_t base = str_arr->value_offset(0);
+  output_column->mutable_values()->assign(reinterpret_cast<const char*>(data),
+                                          str_arr->value_offset(col_length) - base);
+  for (int64_t i = 1; i <= col_length; ++i) {
+    AppendInt<int32_t>(output_column->mutable_offsets(), str_arr->value_offset(i) - base);
+  }
+}
+
+// Dictionary encodes the strings of the column, unless too few of them repeat for it to pay off.
+// Returns whether the column was encoded.
+bool DictionaryEncodeIntoColumnBuffers(table_store::schemapb::ColumnBuffers* output_column,
+                                       const arrow::Array* input_column) {
+  auto str_arr = static_cast<const arrow::StringArray*>(input_column);
+  int64_t col_length = str_arr->length();
+
+  absl::flat_hash_map<std::string_view, int32_t> dictionary;
+  std::vector<std::string_view> distinct_values;
+  std::string indices(col_length * sizeof(int32_t), '\0');
+  for (int64_t i = 0; i < col_length; ++i) {
+    int32_t length;
+    const uint8_t* data = str_arr->GetValue(i, &length);
+    std::string_view value(reinterpret_cast<const char*>(data), length);
+    auto [it, inserted] = dictionary.try_emplace(value, distinct_values.size());
+    if (inserted) {
+      distinct_values.push_back(value);
+      // At least every other row has to repeat a value.
+      if (static_cast<int64_t>(distinct_values.size()) * 2 > col_length) {
+        return false;
+      }
+    }
+    std::memcpy(indices.data() + i * sizeof(int32_t), &it->second, sizeof(int32_t));
+  }
+
+  std::string* values = output_column->mutable_values();
+  std::string* offsets = output_column->mutable_offsets();
+  AppendInt<int32_t>(offsets, 0);
+  for (std::string_view value : distinct_values) {
+    values->append(value);
+    AppendInt<int32_t>(offsets, values->size());
+  }
+  *output_column->mutable_indices() = std::move(indices);
+  output_column->set_dictionary_size(distinct_values.size());
+  return true;
+}
+
+Status CompressColumnBuffers(table_store::schemapb::ColumnBuffers* column) {
+  for (std::string* buf : {column->mutable_values(), column->mutable_offsets(),
+                           column->mutable_indices()}) {
+    if (buf->empty()) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(*buf, zlib::Deflate(*buf, zlib::Format::kZlib));
+  }
+  return Status::OK();
+}
+
+// Deflate can't shrink data by more than this factor, which bounds what a buffer decompresses to.
+constexpr int64_t kMaxDeflateRatio = 1032;
+
+// Checks that a buffer of a column can hold num_elements elements of element_size bytes once
+// decompressed. Counts must pass this before they are multiplied out, so that a corrupt count
+// can't overflow the buffer size or make us allocate more than the buffer can fill.
+Status CheckColumnBufferHolds(const std::string& buf, int64_t num_elements, size_t element_size,
+                              table_store::schemapb::BufferCompression compression) {
+  int64_t max_size = static_cast<int64_t>(buf.size());
+  if (compression != table_store::schemapb::BUFFER_COMPRESSION_NONE) {
+    max_size *= kMaxDeflateRatio;
+  }
+  if (num_elements < 0 || num_elements > max_size / static_cast<int64_t>(element_size)) {
+    return error::Internal("Column buffer of $0 bytes can't hold $1 elements of $2 bytes",
+                           buf.size(), num_elements, element_size);
+  }
+  return Status::OK();
+}
+
+// Returns the contents of a buffer of a column, which must be num_elements elements of
+// element_size bytes once decompressed. Decompressed buffers are stored in storage.
+StatusOr<std::string_view> ReadColumnBuffer(const std::string& buf, int64_t num_elements,
+                                            size_t element_size,
+                                            table_store::schemapb::BufferCompression compression,
+                                            std::string* storage) {
+  PL_RETURN_IF_ERROR(CheckColumnBufferHolds(buf, num_elements, element_size, compression));
+  size_t size = num_elements * element_size;
+  if (compression == table_store::schemapb::BUFFER_COMPRESSION_NONE || size == 0) {
+    if (buf.size() != size) {
+      return error::Internal("Column buffer has $0 bytes, expected $1", buf.size(), size);
+    }
+    return std::string_view(buf);
+  }
+  if (compression != table_store::schemapb::BUFFER_COMPRESSION_ZLIB) {
+    return error::Internal("Received unknown buffer compression '$0'",
+                           magic_enum::enum_name(compression));
+  }
+  PL_ASSIGN_OR_RETURN(*storage, zlib::InflatePrefix(buf, size, zlib::Format::kZlib));
+  if (storage->size() != size) {
+    return error::Internal("Column buffer decompressed to $0 bytes, expected $1",
+                           storage->size(), size);
+  }
+  return std::string_view(*storage);
+}
+
+template <typename TInt>
+TInt ReadInt(std::string_view buf, int64_t idx) {
+  TInt value;
+  std::memcpy(&value, buf.data() + idx * sizeof(TInt), sizeof(TInt));
+  return value;
+}
+
+// Reads a value of a fixed width column. Booleans are read as bytes, since any byte but 0 or 1 is
+// not a valid bool.
+template <typename TNative>
+TNative ReadValue(std::string_view buf, int64_t idx) {
+  return ReadInt<TNative>(buf, idx);
+}
+
+template <>
+bool ReadValue<bool>(std::string_view buf, int64_t idx) {
+  return ReadInt<uint8_t>(buf, idx) != 0;
+}
+
+template <DataType T>
+Status CopyFromColumnBuffers(std::shared_ptr<arrow::Array>* output_column,
+                             const table_store::schemapb::ColumnBuffers& input_column,
+                             table_store::schemapb::BufferCompression compression,
+                             int64_t num_rows) {
+  using native_type = typename types::DataTypeTraits<T>::native_type;
+  using arrow_builder_type = typename types::DataTypeTraits<T>::arrow_builder_type;
+
+  std::string storage;
+  PL_ASSIGN_OR_RETURN(std::string_view values,
+                      ReadColumnBuffer(input_column.values(), num_rows, sizeof(native_type),
+                                       compression, &storage));
+
+  auto builder = MakeArrowBuilder(T, arrow::default_memory_pool());
+  auto typed_builder = static_cast<arrow_builder_type*>(builder.get());
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(num_rows));
+  for (int64_t i = 0; i < num_rows; ++i) {
+    typed_builder->UnsafeAppend(ReadValue<native_type>(values, i));
+  }
+  PL_RETURN_IF_ERROR(builder->Finish(output_column));
+  return Status::OK();
+}
+
+template <>
+Status CopyFromColumnBuffers<DataType::STRING>(
+    std::shared_ptr<arrow::Array>* output_column,
+    const table_store::schemapb::ColumnBuffers& input_column,
+    table_store::schemapb::BufferCompression compression, int64_t num_rows) {
+  bool dictionary_encoded = input_column.dictionary_size() > 0;
+  int64_t num_strings = dictionary_encoded ? input_column.dictionary_size() : num_rows;
+
+  // There is one more offset than strings, so bound the count before adding to it.
+  PL_RETURN_IF_ERROR(
+      CheckColumnBufferHolds(input_column.offsets(), num_strings, sizeof(int32_t), compression));
+  std::string offsets_storage;
+  PL_ASSIGN_OR_RETURN(std::string_view offsets,
+                      ReadColumnBuffer(input_column.offsets(), num_strings + 1, sizeof(int32_t),
+                                       compression, &offsets_storage));
+  // The offsets must rise from the start of the values to their end.
+  int32_t prev_offset = ReadInt<int32_t>(offsets, 0);
+  if (prev_offset != 0) {
+    return error::Internal("String column offsets start at $0, expected 0", prev_offset);
+  }
+  for (int64_t i = 1; i <= num_strings; ++i) {
+    int32_t offset = ReadInt<int32_t>(offsets, i);
+    if (offset < prev_offset) {
+      return error::Internal("String column offsets decrease at $0", i);
+    }
+    prev_offset = offset;
+  }
+
+  std::string values_storage;
+  PL_ASSIGN_OR_RETURN(std::string_view values,
+                      ReadColumnBuffer(input_column.values(), prev_offset, sizeof(char),
+                                       compression, &values_storage));
+
+  std::string indices_storage;
+  std::string_view indices;
+  int64_t total_size = values.size();
+  if (dictionary_encoded) {
+    PL_ASSIGN_OR_RETURN(indices,
+                        ReadColumnBuffer(input_column.indices(), num_rows, sizeof(int32_t),
+                                         compression, &indices_storage));
+    total_size = 0;
+    for (int64_t i = 0; i < num_rows; ++i) {
+      int32_t idx = ReadInt<int32_t>(indices, i);
+      if (idx < 0 || idx >= num_strings) {
+        return error::Internal("String column index $0 is out of the dictionary of $1 strings",
+                               idx, num_strings);
+      }
+      total_size += ReadInt<int32_t>(offsets, idx + 1) - ReadInt<int32_t>(offsets, idx);
+    }
+  }
+
+  auto builder = MakeArrowBuilder(DataType::STRING, arrow::default_memory_pool());
+  auto typed_builder = static_cast<arrow::StringBuilder*>(builder.get());
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(num_rows));
+  PL_RETURN_IF_ERROR(typed_builder->ReserveData(total_size));
+  for (int64_t i = 0; i < num_rows; ++i) {
+    int64_t idx = dictionary_encoded ? ReadInt<int32_t>(indices, i) : i;
+    int32_t start = ReadInt<int32_t>(offsets, idx);
+    int32_t end = ReadInt<int32_t>(offsets, idx + 1);
+    typed_builder->UnsafeAppend(reinterpret_cast<const uint8_t*>(values.data() + start),
+                                end - start);
+  }
+  PL_RETURN_IF_ERROR(builder->Finish(output_column));
+  return Status::OK();
+}
+
+Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto,
+                         const WireFormat& format) const {
   proto->set_num_rows(num_rows_);
   proto->set_eow(eow_);
   proto->set_eos(eos_);
 
+  if (format.columnar) {
+    proto->set_buffer_compression(format.compression);
+    for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
+      auto input_col = ColumnAt(col_idx).get();
+      auto output_col = proto->add_column_buffers();
+      auto dt = desc_.type(col_idx);
+      output_col->set_data_type(dt);
+
+      if (dt != DataType::STRING || !format.dictionary_encode_strings ||
+          !DictionaryEncodeIntoColumnBuffers(output_col, input_col)) {
+#define TYPE_CASE(_dt_) CopyIntoColumnBuffers<_dt_>(output_col, input_col);
+        PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+      }
+      if (format.compression != table_store::schemapb::BUFFER_COMPRESSION_NONE) {
+        PL_RETURN_IF_ERROR(CompressColumnBuffers(output_col));
+      }
+    }
+    return Status::OK();
+  }
+
   for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
     auto input_col = ColumnAt(col_idx).get();
     auto output_col_data = proto->add_cols();
@@ -197,12 +465,44 @@ StatusOr<DataType> ProtoDataType(const table_store::schemapb::Column& proto) {
   }
 }
 
+// PL_CARNOT_UPDATE_FOR_NEW_TYPES
+StatusOr<DataType> ColumnBuffersDataType(const table_store::schemapb::ColumnBuffers& proto) {
+  switch (proto.data_type()) {
+    case DataType::BOOLEAN:
+    case DataType::INT64:
+    case DataType::UINT128:
+    case DataType::TIME64NS:
+    case DataType::FLOAT64:
+    case DataType::STRING:
+      return proto.data_type();
+    default:
+      return error::Internal("Received unknown column data type '$0' in ColumnBuffersDataType",
+                             magic_enum::enum_name(proto.data_type()));
+  }
+}
+
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
     const table_store::schemapb::RowBatchData& proto) {
-  std::vector<DataType> types(proto.cols_size());
-  std::vector<std::shared_ptr<arrow::Array>> data_columns(proto.cols_size());
+  bool columnar = proto.column_buffers_size() > 0;
+  if (columnar && proto.num_rows() < 0) {
+    return error::Internal("Received row batch with $0 rows", proto.num_rows());
+  }
+  int num_cols = columnar ? proto.column_buffers_size() : proto.cols_size();
+  std::vector<DataType> types(num_cols);
+  std::vector<std::shared_ptr<arrow::Array>> data_columns(num_cols);
+
+  for (auto i = 0; i < num_cols; ++i) {
+    if (columnar) {
+      const auto& col = proto.column_buffers(i);
+      PL_ASSIGN_OR_RETURN(types[i], ColumnBuffersDataType(col));
+#define TYPE_CASE(_dt_)                                                                       \
+  PL_RETURN_IF_ERROR(CopyFromColumnBuffers<_dt_>(&data_columns[i], col,                       \
+                                                 proto.buffer_compression(), proto.num_rows()));
+      PL_SWITCH_FOREACH_DATATYPE(types[i], TYPE_CASE);
+#undef TYPE_CASE
+      continue;
+    }
 
-  for (auto i = 0; i < proto.cols_size(); ++i) {
     PL_ASSIGN_OR_RETURN(types[i], ProtoDataType(proto.cols(i)));
     std::shared_ptr<arrow::Array> output_array;
 
@@ -216,7 +516,7 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
   output_rb->set_eow(proto.eow());
   output_rb->set_eos(proto.eos());
 
-  for (auto i = 0; i < proto.cols_size(); ++i) {
+  for (auto i = 0; i < num_cols; ++i) {
     PL_RETURN_IF_ERROR(output_rb->AddColumn(data_columns[i]));
   }
 
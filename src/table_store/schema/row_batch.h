@@ -33,6 +33,18 @@ namespace px {
 namespace table_store {
 namespace schema {
 
+/**
+ * The layout of a row batch on the wire. See RowBatch::ToProto.
+ */
+struct WireFormat {
+  // Packs the columns into ColumnBuffers rather than repeated fields. Only Carnot reads this.
+  bool columnar = false;
+  // Dictionary encodes the string columns whose values repeat. Only applies to the columnar format.
+  bool dictionary_encode_strings = true;
+  // Compresses the buffers of the columnar format.
+  schemapb::BufferCompression compression = schemapb::BUFFER_COMPRESSION_NONE;
+};
+
 /**
  * A RowBatch is a table-like structure which consists of equal-length arrays
  * that match the schema described by the RowDescriptor.
@@ -49,7 +61,11 @@ class RowBatch {
     columns_.reserve(desc_.size());
   }
 
-  Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
+  /**
+   * Serializes the row batch. FromProto reads any of the formats.
+   */
+  Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto,
+                 const WireFormat& format = {}) const;
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
 
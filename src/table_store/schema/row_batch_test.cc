@@ -19,6 +19,8 @@
 #include <arrow/array.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -179,6 +181,123 @@ TEST_F(RowBatchTest, to_from_proto) {
   EXPECT_TRUE(differ.Compare(input_proto, output_proto));
 }
 
+std::unique_ptr<RowBatch> AllTypesRowBatch() {
+  RowDescriptor rd({types::DataType::BOOLEAN, types::DataType::INT64, types::DataType::UINT128,
+                    types::DataType::TIME64NS, types::DataType::FLOAT64, types::DataType::STRING,
+                    types::DataType::STRING});
+  auto rb = std::make_unique<RowBatch>(rd, 4);
+  rb->set_eow(true);
+
+  std::vector<types::BoolValue> in1 = {true, false, true, true};
+  std::vector<types::Int64Value> in2 = {3, -4, 5, 6};
+  std::vector<types::UInt128Value> in3 = {{0, 1}, {2, 3}, {0, 4}, {0, 5}};
+  std::vector<types::Time64NSValue> in4 = {10, 20, 30, 40};
+  std::vector<types::Float64Value> in5 = {3.3, 4.1, 5.6, -1.0};
+  // Repeats enough to be dictionary encoded.
+  std::vector<types::StringValue> in6 = {"GET", "POST", "GET", "GET"};
+  // Sliced, so that its strings don't start at the beginning of its data.
+  std::vector<types::StringValue> in7 = {"skipped", "ABC", "", "DEF", "12345"};
+
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in3, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in4, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in5, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in6, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(types::ToArrow(in7, arrow::default_memory_pool())->Slice(1, 4)));
+  return rb;
+}
+
+class RowBatchWireFormatTest : public ::testing::TestWithParam<WireFormat> {};
+
+TEST_P(RowBatchWireFormatTest, round_trip) {
+  auto rb = AllTypesRowBatch();
+  table_store::schemapb::RowBatchData proto;
+  ASSERT_OK(rb->ToProto(&proto, GetParam()));
+  EXPECT_EQ(GetParam().columnar, proto.cols_size() == 0);
+
+  ASSERT_OK_AND_ASSIGN(auto output_rb, RowBatch::FromProto(proto));
+  EXPECT_EQ(rb->desc(), output_rb->desc());
+  EXPECT_EQ(rb->num_rows(), output_rb->num_rows());
+  EXPECT_TRUE(output_rb->eow());
+  EXPECT_FALSE(output_rb->eos());
+  for (int64_t i = 0; i < rb->num_columns(); ++i) {
+    EXPECT_TRUE(rb->ColumnAt(i)->Equals(output_rb->ColumnAt(i))) << "column " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WireFormats, RowBatchWireFormatTest,
+    ::testing::Values(WireFormat{}, WireFormat{true, false, schemapb::BUFFER_COMPRESSION_NONE},
+                      WireFormat{true, true, schemapb::BUFFER_COMPRESSION_NONE},
+                      WireFormat{true, true, schemapb::BUFFER_COMPRESSION_ZLIB}));
+
+TEST_F(RowBatchTest, columnar_dictionary_encoding) {
+  auto rb = AllTypesRowBatch();
+  table_store::schemapb::RowBatchData proto;
+  ASSERT_OK(rb->ToProto(&proto, WireFormat{true, true, schemapb::BUFFER_COMPRESSION_NONE}));
+
+  ASSERT_EQ(7, proto.column_buffers_size());
+  // Only the column whose strings repeat is dictionary encoded.
+  EXPECT_EQ(2, proto.column_buffers(5).dictionary_size());
+  EXPECT_EQ("GETPOST", proto.column_buffers(5).values());
+  EXPECT_EQ(4 * sizeof(int32_t), proto.column_buffers(5).indices().size());
+  EXPECT_EQ(0, proto.column_buffers(6).dictionary_size());
+  EXPECT_EQ("ABCDEF12345", proto.column_buffers(6).values());
+}
+
+TEST_F(RowBatchTest, columnar_non_canonical_booleans) {
+  auto rb = AllTypesRowBatch();
+  table_store::schemapb::RowBatchData proto;
+  ASSERT_OK(rb->ToProto(&proto, WireFormat{true, false, schemapb::BUFFER_COMPRESSION_NONE}));
+
+  // Any non-zero byte is true.
+  (*proto.mutable_column_buffers(0)->mutable_values())[0] = 2;
+  (*proto.mutable_column_buffers(0)->mutable_values())[2] = static_cast<char>(0xff);
+  ASSERT_OK_AND_ASSIGN(auto output_rb, RowBatch::FromProto(proto));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(output_rb->ColumnAt(0)));
+}
+
+TEST_F(RowBatchTest, columnar_corrupt_buffers) {
+  auto rb = AllTypesRowBatch();
+  table_store::schemapb::RowBatchData proto;
+  ASSERT_OK(rb->ToProto(&proto, WireFormat{true, true, schemapb::BUFFER_COMPRESSION_NONE}));
+
+  auto truncated = proto;
+  truncated.mutable_column_buffers(1)->mutable_values()->pop_back();
+  EXPECT_NOT_OK(RowBatch::FromProto(truncated));
+
+  auto bad_index = proto;
+  (*bad_index.mutable_column_buffers(5)->mutable_indices())[0] = 7;
+  EXPECT_NOT_OK(RowBatch::FromProto(bad_index));
+
+  auto bad_offsets = proto;
+  (*bad_offsets.mutable_column_buffers(6)->mutable_offsets())[4] = 100;
+  EXPECT_NOT_OK(RowBatch::FromProto(bad_offsets));
+}
+
+TEST_F(RowBatchTest, columnar_counts_larger_than_buffers) {
+  auto rb = AllTypesRowBatch();
+  for (auto compression : {schemapb::BUFFER_COMPRESSION_NONE, schemapb::BUFFER_COMPRESSION_ZLIB}) {
+    table_store::schemapb::RowBatchData proto;
+    ASSERT_OK(rb->ToProto(&proto, WireFormat{true, true, compression}));
+
+    // Row counts whose buffer sizes overflow must be rejected, not read past the small buffers.
+    for (int64_t num_rows : {std::numeric_limits<int64_t>::max(),
+                             std::numeric_limits<int64_t>::max() / 4 + 1, int64_t{1} << 40}) {
+      auto huge_rows = proto;
+      huge_rows.set_num_rows(num_rows);
+      EXPECT_NOT_OK(RowBatch::FromProto(huge_rows)) << num_rows;
+    }
+
+    for (int64_t dictionary_size : {std::numeric_limits<int64_t>::max(), int64_t{1} << 40}) {
+      auto huge_dictionary = proto;
+      huge_dictionary.mutable_column_buffers(5)->set_dictionary_size(dictionary_size);
+      EXPECT_NOT_OK(RowBatch::FromProto(huge_dictionary)) << dictionary_size;
+    }
+  }
+}
+
 TEST_F(RowBatchTest, with_zero_rows) {
   bool eow = true;
   bool eos = false;
@@ -319,8 +319,10 @@ Status Table::UpdateTimeRowIndices(types::ColumnWrapperRecordBatch* record_batch
   auto batch_length = record_batch->at(0)->Size();
   DCHECK_GT(batch_length, 0);
   if (time_col_idx_ != -1) {
-    auto first_time = record_batch->at(time_col_idx_)->Get<types::Time64NSValue>(0);
-    auto last_time = record_batch->at(time_col_idx_)->Get<types::Time64NSValue>(batch_length - 1);
+    // Read through the const accessor, which doesn't convert arrow-backed columns.
+    const types::ColumnWrapper& time_col = *record_batch->at(time_col_idx_);
+    auto first_time = time_col.Get<types::Time64NSValue>(0);
+    auto last_time = time_col.Get<types::Time64NSValue>(batch_length - 1);
     hot_time_.emplace_back(first_time.val, last_time.val);
   }
   auto first_row_id = next_row_id_;
@@ -607,6 +609,29 @@ int64_t Table::End() const {
   return next_row_id_;
 }
 
+BatchSlice Table::SliceFromRowID(int64_t row_id, int64_t stop_row_id) const {
+  if (row_id < 0 || row_id >= stop_row_id) {
+    return BatchSlice::Invalid();
+  }
+  absl::MutexLock gen_lock(&generation_lock_);
+  // Locate the batch holding the row, as a slice of that single row.
+  auto slice = BatchSlice::Cold(-1, -1, -1, /* generation */ -1, row_id, row_id);
+  if (!UpdateSliceUnlocked(slice).ok()) {
+    return BatchSlice::Invalid();
+  }
+  int64_t batch_length;
+  if (slice.unsafe_is_hot) {
+    absl::MutexLock hot_lock(&hot_lock_);
+    batch_length = HotBatchLengthUnlocked(slice.unsafe_batch_index);
+  } else {
+    absl::MutexLock cold_lock(&cold_lock_);
+    batch_length = ColdBatchLengthUnlocked(slice.unsafe_batch_index);
+  }
+  slice.uniq_row_end_idx = row_id + batch_length - 1 - slice.unsafe_row_start;
+  slice.unsafe_row_end = batch_length - 1;
+  return SliceIfPastStop(slice, stop_row_id);
+}
+
 BatchSlice Table::NextBatch(const BatchSlice& slice, int64_t stop_row_id) const {
   auto next_slice = NextBatchWithoutStop(slice);
   return SliceIfPastStop(next_slice, stop_row_id);
@@ -297,6 +297,17 @@ class Table : public NotCopyable {
    */
   StopPosition End() const;
 
+  /**
+   * Returns the BatchSlice of the rows from the given unique row identifier to the end of its
+   * batch, cut short at the given stop position. Used to resume reading a table past rows that
+   * were already read.
+   * @param row_id the unique row identifier of the first row of the slice.
+   * @param stop the StopPosition to cut short at.
+   * @return the BatchSlice, or an invalid BatchSlice if the row has been expired from the table,
+   * or is at or past the stop position.
+   */
+  BatchSlice SliceFromRowID(int64_t row_id, StopPosition stop) const;
+
   /**
    * Reduces the extent of a BatchSlice to ensure that it doesn't include rows past the given stop
    * position.
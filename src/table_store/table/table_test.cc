@@ -524,6 +524,47 @@ TEST(TableTest, hot_batches_w_compaction_test) {
   EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, slice_from_row_id) {
+  auto rd = schema::RowDescriptor({types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"col1"});
+  Table table("test_table", rel, 128 * 1024, 4 * sizeof(int64_t));
+
+  auto write_batch = [&](std::vector<types::Int64Value> col1) {
+    schema::RowBatch rb(rd, col1.size());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+  };
+  auto read_col = [&](const BatchSlice& slice) {
+    return table.GetRowBatchSlice(slice, std::vector<int64_t>({0}), arrow::default_memory_pool())
+        .ConsumeValueOrDie()
+        ->ColumnAt(0);
+  };
+  write_batch({0, 1, 2});
+  write_batch({3, 4});
+
+  // A hot batch, from the middle of it, cut short at the stop position.
+  auto slice = table.SliceFromRowID(1, table.End());
+  ASSERT_TRUE(slice.IsValid());
+  EXPECT_TRUE(read_col(slice)->Equals(types::ToArrow(std::vector<types::Int64Value>({1, 2}),
+                                                     arrow::default_memory_pool())));
+  slice = table.NextBatch(slice);
+  EXPECT_TRUE(read_col(slice)->Equals(types::ToArrow(std::vector<types::Int64Value>({3, 4}),
+                                                     arrow::default_memory_pool())));
+  slice = table.SliceFromRowID(3, /* stop */ 4);
+  EXPECT_TRUE(read_col(slice)->Equals(
+      types::ToArrow(std::vector<types::Int64Value>({3}), arrow::default_memory_pool())));
+
+  // The same rows, once compacted into a cold batch.
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  slice = table.SliceFromRowID(2, table.End());
+  ASSERT_TRUE(slice.IsValid());
+  EXPECT_TRUE(read_col(slice)->Equals(types::ToArrow(std::vector<types::Int64Value>({2, 3, 4}),
+                                                     arrow::default_memory_pool())));
+
+  EXPECT_FALSE(table.SliceFromRowID(5, table.End()).IsValid());
+  EXPECT_FALSE(table.SliceFromRowID(2, /* stop */ 2).IsValid());
+}
+
 TEST(TableTest, find_batch_slice_greater_or_eq) {
   schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
                        std::vector<std::string>({"time_"}));
@@ -18,6 +18,7 @@
 
 #include "src/vizier/services/agent/manager/exec.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <utility>
@@ -29,6 +30,19 @@
 #include "src/common/perf/perf.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_int32(max_concurrent_queries, gflags::Int32FromEnv("PL_MAX_CONCURRENT_QUERIES", 0),
+             "The most batch queries the agent executes at a time. Further queries wait for "
+             "admission. 0 is no limit.");
+DEFINE_int32(max_concurrent_streaming_queries,
+             gflags::Int32FromEnv("PL_MAX_CONCURRENT_STREAMING_QUERIES", 0),
+             "The most streaming queries the agent executes at a time. They don't count against "
+             "--max_concurrent_queries. 0 is no limit.");
+DEFINE_int32(query_admission_timeout_ms,
+             gflags::Int32FromEnv("PL_QUERY_ADMISSION_TIMEOUT_MS", 180 * 1000),
+             "The longest a query waits for admission before it is dropped, and the query broker "
+             "is sent a DEADLINE_EXCEEDED error for it. The default matches the time the query "
+             "broker waits for results from the agent. 0 is no limit.");
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -47,7 +61,18 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
 
   sole::uuid query_id() { return query_id_; }
 
+  // Makes the task send the error to the query broker instead of executing the query.
+  void Drop(Status reason) { drop_reason_ = std::move(reason); }
+
   void Work() override {
+    if (!drop_reason_.ok()) {
+      auto s = carnot_->SendExecutionError(req_.plan(), query_id_, drop_reason_);
+      if (!s.ok()) {
+        LOG(ERROR) << absl::Substitute("Failed to send the error of dropped query $0: $1",
+                                       query_id_.str(), s.msg());
+      }
+      return;
+    }
     LOG(INFO) << absl::Substitute("Executing query: id=$0", query_id_.str());
     VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
 
@@ -73,24 +98,100 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
   std::unique_ptr<messages::VizierMessage> msg_;
   const messages::ExecuteQueryRequest& req_;
   sole::uuid query_id_;
+  Status drop_reason_;
 };
 
 ExecuteQueryMessageHandler::ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher,
                                                        Info* agent_info,
                                                        Manager::VizierNATSConnector* nats_conn,
                                                        carnot::Carnot* carnot)
-    : MessageHandler(dispatcher, agent_info, nats_conn), carnot_(carnot) {}
+    : MessageHandler(dispatcher, agent_info, nats_conn),
+      carnot_(carnot),
+      time_source_(dispatcher->GetTimeSource()) {}
+
+ExecuteQueryMessageHandler::QueryPriority ExecuteQueryMessageHandler::PlanPriority(
+    const carnot::planpb::Plan& plan) {
+  for (const auto& fragment : plan.nodes()) {
+    for (const auto& node : fragment.nodes()) {
+      if (node.op().op_type() == carnot::planpb::MEMORY_SOURCE_OPERATOR &&
+          node.op().mem_source_op().streaming()) {
+        return QueryPriority::kStreaming;
+      }
+    }
+  }
+  return QueryPriority::kBatch;
+}
+
+bool ExecuteQueryMessageHandler::CanAdmit(QueryPriority priority) const {
+  int max_queries = priority == QueryPriority::kStreaming ? FLAGS_max_concurrent_streaming_queries
+                                                          : FLAGS_max_concurrent_queries;
+  return max_queries <= 0 || num_running_queries_[static_cast<int>(priority)] < max_queries;
+}
+
+void ExecuteQueryMessageHandler::RunQuery(QueuedQuery* query) {
+  auto queued_time = time_source_.MonotonicTime() - query->queued_at;
+  LOG(INFO) << absl::Substitute(
+      "Admitting query: id=$0, queued for $1, queries in flight: $2", query->query_id.str(),
+      PrettyDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(queued_time).count()),
+      running_queries_.size());
+  auto runnable_ptr = query->runnable.get();
+  running_queries_[query->query_id] = std::move(query->runnable);
+  running_query_priorities_[query->query_id] = query->priority;
+  ++num_running_queries_[static_cast<int>(query->priority)];
+  runnable_ptr->Run();
+}
+
+void ExecuteQueryMessageHandler::DropExpiredQueries() {
+  if (FLAGS_query_admission_timeout_ms <= 0) {
+    return;
+  }
+  auto now = time_source_.MonotonicTime();
+  auto timeout = std::chrono::milliseconds(FLAGS_query_admission_timeout_ms);
+  for (auto& queue : queued_queries_) {
+    // The queues are in FIFO order, so the expired queries are at their front.
+    while (!queue.empty() && now - queue.front().queued_at > timeout) {
+      auto& query = queue.front();
+      auto reason = error::DeadlineExceeded(
+          "Query $0 was not admitted for execution on agent $1 within $2", query.query_id.str(),
+          agent_info()->agent_id.str(),
+          PrettyDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count()));
+      LOG(WARNING) << absl::Substitute("Dropping query: $0", reason.msg());
+      // The task sends the error on the thread pool, since it waits for the query broker.
+      query.task->Drop(reason);
+      auto runnable_ptr = query.runnable.get();
+      running_queries_[query.query_id] = std::move(query.runnable);
+      runnable_ptr->Run();
+      queue.pop_front();
+    }
+  }
+}
+
+void ExecuteQueryMessageHandler::AdmitQueuedQueries() {
+  DropExpiredQueries();
+  for (auto& queue : queued_queries_) {
+    while (!queue.empty() && CanAdmit(queue.front().priority)) {
+      RunQuery(&queue.front());
+      queue.pop_front();
+    }
+  }
+}
 
 Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
-  // Create a task and run it on the threadpool.
+  auto priority = PlanPriority(msg->execute_query_request().plan());
+  // Create a task to run on the threadpool once the query is admitted.
   auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg));
 
   auto query_id = task->query_id();
-  auto runnable = dispatcher()->CreateAsyncTask(std::move(task));
-  auto runnable_ptr = runnable.get();
-  LOG(INFO) << "Queries in flight: " << running_queries_.size();
-  running_queries_[query_id] = std::move(runnable);
-  runnable_ptr->Run();
+  auto task_ptr = task.get();
+  auto& queue = queued_queries_[static_cast<int>(priority)];
+  queue.push_back(QueuedQuery{query_id, priority, task_ptr,
+                              dispatcher()->CreateAsyncTask(std::move(task)),
+                              time_source_.MonotonicTime()});
+  if (queue.size() > 1 || !CanAdmit(priority)) {
+    LOG(INFO) << absl::Substitute("Queueing query: id=$0, queries in flight: $1, queued: $2",
+                                  query_id.str(), running_queries_.size(), queue.size());
+  }
+  AdmitQueuedQueries();
 
   return Status::OK();
 }
@@ -103,6 +204,13 @@ void ExecuteQueryMessageHandler::HandleQueryExecutionComplete(sole::uuid query_i
     return;
   }
   dispatcher()->DeferredDelete(std::move(node.mapped()));
+
+  auto priority = running_query_priorities_.extract(query_id);
+  if (!priority.empty()) {
+    --num_running_queries_[static_cast<int>(priority.mapped())];
+  }
+  // The query's slot is free now, so admit whatever is waiting for it.
+  AdmitQueuedQueries();
 }
 
 }  // namespace agent
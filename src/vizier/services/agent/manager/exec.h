@@ -18,12 +18,19 @@
 
 #pragma once
 
+#include <array>
+#include <deque>
 #include <memory>
 
 #include <absl/container/flat_hash_map.h>
 #include "src/carnot/plan/plan.h"
+#include "src/common/event/time_system.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DECLARE_int32(max_concurrent_queries);
+DECLARE_int32(max_concurrent_streaming_queries);
+DECLARE_int32(query_admission_timeout_ms);
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -34,6 +41,13 @@ namespace agent {
  * otherwise only query execution is performed.
  *
  * This class runs all of it's work on a thread pool and tracks pending queries internally.
+ *
+ * Batch queries are admitted to the thread pool up to --max_concurrent_queries at a time, and the
+ * rest wait in a queue. Streaming queries run until they are cancelled, so they are capped by
+ * --max_concurrent_streaming_queries instead and can't hold the slots of batch queries. Queries
+ * that waited longer than --query_admission_timeout_ms are dropped instead of admitted, since the
+ * query broker is about to give up on them, and their error is sent to it so that the query fails
+ * right away.
  */
 class ExecuteQueryMessageHandler : public Manager::MessageHandler {
  public:
@@ -55,10 +69,38 @@ class ExecuteQueryMessageHandler : public Manager::MessageHandler {
   // Forward declare private task class.
   class ExecuteQueryTask;
 
+  // The classes of queries, which are admitted against separate limits.
+  enum class QueryPriority : int {
+    kBatch = 0,
+    kStreaming = 1,
+  };
+  static constexpr int kNumQueryPriorities = 2;
+
+  struct QueuedQuery {
+    sole::uuid query_id;
+    QueryPriority priority;
+    // The task of the runnable.
+    ExecuteQueryTask* task;
+    px::event::RunnableAsyncTaskUPtr runnable;
+    px::event::MonotonicTimePoint queued_at;
+  };
+
+  static QueryPriority PlanPriority(const carnot::planpb::Plan& plan);
+  bool CanAdmit(QueryPriority priority) const;
+  void RunQuery(QueuedQuery* query);
+  void DropExpiredQueries();
+  void AdmitQueuedQueries();
+
   carnot::Carnot* carnot_;
+  const px::event::TimeSource& time_source_;
 
-  // Map from query_id -> Running query task.
+  // Map from query_id -> Running query task, including the dropped queries that report their error.
   absl::flat_hash_map<sole::uuid, px::event::RunnableAsyncTaskUPtr> running_queries_;
+  // The priority of each running query.
+  absl::flat_hash_map<sole::uuid, QueryPriority> running_query_priorities_;
+  std::array<int, kNumQueryPriorities> num_running_queries_ = {};
+  // The queries waiting for admission, in FIFO order for each priority.
+  std::array<std::deque<QueuedQuery>, kNumQueryPriorities> queued_queries_;
 };
 
 }  // namespace agent
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/carnot.h"
+#include "src/common/event/api_impl.h"
+#include "src/common/event/nats.h"
+#include "src/common/testing/event/simulated_time_system.h"
+#include "src/common/testing/testing.h"
+#include "src/common/uuid/uuid_utils.h"
+#include "src/vizier/messages/messagespb/messages.pb.h"
+#include "src/vizier/services/agent/manager/exec.h"
+#include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/manager/test_utils.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+// FakeCarnot blocks the execution of each query until the test releases it, and records the errors
+// sent for queries that weren't executed.
+class FakeCarnot : public carnot::Carnot {
+ public:
+  Status ExecuteQuery(const std::string&, const sole::uuid&, px::types::Time64NSValue,
+                      bool) override {
+    return error::Unimplemented("Only plans are executed");
+  }
+
+  Status ExecutePlan(const carnot::planpb::Plan&, const sole::uuid& query_id, bool) override {
+    absl::MutexLock lock(&lock_);
+    started_.push_back(query_id);
+    auto released = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      return released_.contains(query_id);
+    };
+    lock_.Await(absl::Condition(&released));
+    return Status::OK();
+  }
+
+  Status SendExecutionError(const carnot::planpb::Plan&, const sole::uuid& query_id,
+                            const Status& exec_error) override {
+    absl::MutexLock lock(&lock_);
+    errors_.emplace_back(query_id, exec_error.code());
+    return Status::OK();
+  }
+
+  void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc) override {}
+  const carnot::udf::Registry* FuncRegistry() const override { return nullptr; }
+
+  void Release(const sole::uuid& query_id) {
+    absl::MutexLock lock(&lock_);
+    released_.insert(query_id);
+  }
+
+  std::vector<sole::uuid> started() {
+    absl::MutexLock lock(&lock_);
+    return started_;
+  }
+
+  std::vector<std::pair<sole::uuid, statuspb::Code>> errors() {
+    absl::MutexLock lock(&lock_);
+    return errors_;
+  }
+
+ private:
+  absl::Mutex lock_;
+  std::vector<sole::uuid> started_ ABSL_GUARDED_BY(lock_);
+  std::vector<std::pair<sole::uuid, statuspb::Code>> errors_ ABSL_GUARDED_BY(lock_);
+  absl::flat_hash_set<sole::uuid> released_ ABSL_GUARDED_BY(lock_);
+};
+
+class ExecuteQueryMessageHandlerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FLAGS_max_concurrent_queries = 1;
+    FLAGS_max_concurrent_streaming_queries = 0;
+    FLAGS_query_admission_timeout_ms = 1000;
+  }
+
+  void TearDown() override {
+    // Let the queries that are still running finish, so that the handler can be deleted.
+    for (const auto& query_id : carnot_.started()) {
+      carnot_.Release(query_id);
+    }
+    WaitFor(
+        [&] { return num_completed_ == carnot_.started().size() + carnot_.errors().size(); });
+    dispatcher_->Exit();
+    FLAGS_max_concurrent_queries = 0;
+    FLAGS_max_concurrent_streaming_queries = 0;
+    FLAGS_query_admission_timeout_ms = 180 * 1000;
+  }
+
+  ExecuteQueryMessageHandlerTest() {
+    start_monotonic_time_ = std::chrono::steady_clock::now();
+    time_system_ = std::make_unique<event::SimulatedTimeSystem>(start_monotonic_time_,
+                                                                std::chrono::system_clock::now());
+    api_ = std::make_unique<px::event::APIImpl>(time_system_.get());
+    dispatcher_ = api_->AllocateDispatcher("manager");
+    nats_conn_ = std::make_unique<FakeNATSConnector<px::vizier::messages::VizierMessage>>();
+    handler_ = std::make_unique<CountingExecuteQueryMessageHandler>(
+        dispatcher_.get(), &agent_info_, nats_conn_.get(), &carnot_, &num_completed_);
+  }
+
+  // Sends a query to the handler, and returns its ID.
+  sole::uuid SendQuery(bool streaming) {
+    auto query_id = sole::uuid4();
+    auto msg = std::make_unique<messages::VizierMessage>();
+    auto req = msg->mutable_execute_query_request();
+    ToProto(query_id, req->mutable_query_id());
+    auto op = req->mutable_plan()->add_nodes()->add_nodes()->mutable_op();
+    op->set_op_type(carnot::planpb::MEMORY_SOURCE_OPERATOR);
+    op->mutable_mem_source_op()->set_streaming(streaming);
+    EXPECT_OK(handler_->HandleMessage(std::move(msg)));
+    return query_id;
+  }
+
+  // Runs the dispatcher until the condition holds, since queries complete on its thread.
+  template <typename TCond>
+  void WaitFor(TCond cond) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!cond() && std::chrono::steady_clock::now() < deadline) {
+      dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(cond());
+  }
+
+  void WaitForStarted(size_t num_queries) {
+    WaitFor([&] { return carnot_.started().size() == num_queries; });
+  }
+
+  // Completes the query, and waits for the handler to admit the queries waiting for it.
+  void Complete(const sole::uuid& query_id) {
+    size_t num_completed = num_completed_;
+    carnot_.Release(query_id);
+    WaitFor([&] { return num_completed_ == num_completed + 1; });
+  }
+
+  // Counts the queries that completed, on the dispatcher thread.
+  class CountingExecuteQueryMessageHandler : public ExecuteQueryMessageHandler {
+   public:
+    CountingExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher, Info* agent_info,
+                                       Manager::VizierNATSConnector* nats_conn,
+                                       carnot::Carnot* carnot, size_t* num_completed)
+        : ExecuteQueryMessageHandler(dispatcher, agent_info, nats_conn, carnot),
+          num_completed_(num_completed) {}
+
+   protected:
+    void HandleQueryExecutionComplete(sole::uuid query_id) override {
+      ExecuteQueryMessageHandler::HandleQueryExecutionComplete(query_id);
+      ++*num_completed_;
+    }
+
+   private:
+    size_t* num_completed_;
+  };
+
+  event::MonotonicTimePoint start_monotonic_time_;
+  std::unique_ptr<event::SimulatedTimeSystem> time_system_;
+  std::unique_ptr<event::APIImpl> api_;
+  std::unique_ptr<event::Dispatcher> dispatcher_;
+  std::unique_ptr<FakeNATSConnector<px::vizier::messages::VizierMessage>> nats_conn_;
+  agent::Info agent_info_;
+  FakeCarnot carnot_;
+  size_t num_completed_ = 0;
+  std::unique_ptr<CountingExecuteQueryMessageHandler> handler_;
+};
+
+TEST_F(ExecuteQueryMessageHandlerTest, AdmitsUpToTheCap) {
+  FLAGS_max_concurrent_queries = 2;
+  auto q1 = SendQuery(/* streaming */ false);
+  auto q2 = SendQuery(/* streaming */ false);
+  auto q3 = SendQuery(/* streaming */ false);
+  WaitForStarted(2);
+  EXPECT_THAT(carnot_.started(), UnorderedElementsAre(q1, q2));
+
+  Complete(q2);
+  WaitForStarted(3);
+  EXPECT_EQ(q3, carnot_.started()[2]);
+}
+
+TEST_F(ExecuteQueryMessageHandlerTest, StreamingQueriesDontHoldBatchSlots) {
+  auto s1 = SendQuery(/* streaming */ true);
+  auto s2 = SendQuery(/* streaming */ true);
+  auto b1 = SendQuery(/* streaming */ false);
+  auto b2 = SendQuery(/* streaming */ false);
+  // The streaming queries don't count against --max_concurrent_queries, so they can't keep batch
+  // queries from running.
+  WaitForStarted(3);
+  EXPECT_THAT(carnot_.started(), UnorderedElementsAre(s1, s2, b1));
+
+  Complete(b1);
+  WaitForStarted(4);
+  EXPECT_EQ(b2, carnot_.started()[3]);
+}
+
+TEST_F(ExecuteQueryMessageHandlerTest, CapsStreamingQueries) {
+  FLAGS_max_concurrent_queries = 0;
+  FLAGS_max_concurrent_streaming_queries = 1;
+  auto s1 = SendQuery(/* streaming */ true);
+  auto s2 = SendQuery(/* streaming */ true);
+  // Batch queries aren't held back by the streaming queries.
+  auto b1 = SendQuery(/* streaming */ false);
+  WaitForStarted(2);
+  EXPECT_THAT(carnot_.started(), UnorderedElementsAre(s1, b1));
+
+  Complete(b1);
+  EXPECT_EQ(2, carnot_.started().size());
+  Complete(s1);
+  WaitForStarted(3);
+  EXPECT_EQ(s2, carnot_.started()[2]);
+}
+
+TEST_F(ExecuteQueryMessageHandlerTest, DropsQueriesPastTheAdmissionTimeout) {
+  auto q1 = SendQuery(/* streaming */ false);
+  WaitForStarted(1);
+  auto q2 = SendQuery(/* streaming */ false);
+
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(1500));
+  auto q3 = SendQuery(/* streaming */ false);
+
+  // q2 waited longer than the timeout, so the query broker is sent its error, and q3 runs instead.
+  WaitFor([&] { return num_completed_ == 1; });
+  EXPECT_THAT(carnot_.errors(),
+              ElementsAre(std::make_pair(q2, statuspb::Code::DEADLINE_EXCEEDED)));
+  Complete(q1);
+  WaitForStarted(2);
+  Complete(q3);
+  EXPECT_THAT(carnot_.started(), ElementsAre(q1, q3));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -56,6 +56,11 @@ px::StatusOr<std::string> GetHostname() {
 
 DEFINE_string(jwt_signing_key, gflags::StringFromEnv("PL_JWT_SIGNING_KEY", ""),
               "The JWT signing key for outgoing requests");
+DEFINE_bool(metadata_filter_split_block,
+            gflags::BoolFromEnv("PL_METADATA_FILTER_SPLIT_BLOCK", false),
+            "Use the split-block bloom filter layout for the agent metadata filter. It is faster "
+            "to probe while planning, but is only understood by query brokers that know the "
+            "layout.");
 
 namespace px {
 namespace vizier {
@@ -125,7 +130,10 @@ Status Manager::Init() {
   PL_ASSIGN_OR_RETURN(
       agent_metadata_filter_,
       md::AgentMetadataFilter::Create(kMetadataFilterMaxEntries, kMetadataFilterMaxErrorRate,
-                                      md::kMetadataFilterEntities));
+                                      md::kMetadataFilterEntities,
+                                      FLAGS_metadata_filter_split_block
+                                          ? bloomfilter::XXHash64BloomFilter::Layout::kSplitBlock
+                                          : bloomfilter::XXHash64BloomFilter::Layout::kClassic));
   chan_cache_ = std::make_unique<ChanCache>(kChanIdleGracePeriod);
   auto hostname_or_s = GetHostname();
   if (!hostname_or_s.ok()) {
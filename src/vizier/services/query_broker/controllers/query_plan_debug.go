@@ -62,6 +62,22 @@ func timeNSToString(timeNS int64) string {
 	return (time.Nanosecond * time.Duration(timeNS)).String()
 }
 
+// latencyHistogramToString formats the non-empty buckets of the histogram as "<upper_bound: count".
+// The last bucket is unbounded and repeats the bound of the bucket before it.
+func latencyHistogramToString(hist *queryresultspb.LatencyHistogram) string {
+	buckets := make([]string, 0, len(hist.GetBuckets()))
+	var prevUpperBoundNs int64
+	for _, bucket := range hist.GetBuckets() {
+		if bucket.UpperBoundNs == prevUpperBoundNs {
+			buckets = append(buckets, fmt.Sprintf(">=%s: %d", timeNSToString(bucket.UpperBoundNs), bucket.Count))
+			continue
+		}
+		buckets = append(buckets, fmt.Sprintf("<%s: %d", timeNSToString(bucket.UpperBoundNs), bucket.Count))
+		prevUpperBoundNs = bucket.UpperBoundNs
+	}
+	return strings.Join(buckets, ", ")
+}
+
 func nodeExecTiming(nodeID int64, execStats *map[int64]*queryresultspb.OperatorExecutionStats) string {
 	stats, ok := (*execStats)[nodeID]
 	if !ok {
@@ -70,8 +86,21 @@ func nodeExecTiming(nodeID int64, execStats *map[int64]*queryresultspb.OperatorE
 	extraStats := []string{
 		fmt.Sprintf("self_time: %s", timeNSToString(stats.SelfExecutionTimeNs)),
 		fmt.Sprintf("total_time: %s", timeNSToString(stats.TotalExecutionTimeNs)),
+		fmt.Sprintf("self_cpu_time: %s", timeNSToString(stats.SelfCpuTimeNs)),
+		fmt.Sprintf("total_cpu_time: %s", timeNSToString(stats.TotalCpuTimeNs)),
+		fmt.Sprintf("wait_time: %s", timeNSToString(stats.WaitTimeNs)),
+		fmt.Sprintf("bytes_input: %s", humanize.IBytes(uint64(stats.BytesInput))),
+		fmt.Sprintf("records_input: %d", stats.RecordsInput),
 		fmt.Sprintf("bytes: %s", humanize.IBytes(uint64(stats.BytesOutput))),
 		fmt.Sprintf("records_processed: %d", stats.RecordsOutput),
+		fmt.Sprintf("self_allocated: %s", humanize.IBytes(uint64(stats.SelfBytesAllocated))),
+	}
+	if hist := latencyHistogramToString(stats.BatchSelfTime); hist != "" {
+		extraStats = append(extraStats, fmt.Sprintf("batch_self_time: %s", hist))
+	}
+	for _, udf := range stats.UdfStats {
+		extraStats = append(extraStats, fmt.Sprintf("udf %s: calls: %d, records: %d, time: %s", udf.Name,
+			udf.Calls, udf.RecordsProcessed, timeNSToString(udf.ExecutionTimeNs)))
 	}
 	for k, v := range stats.ExtraMetrics {
 		extraStats = append(extraStats, fmt.Sprintf("%s: %.3g", k, v))
@@ -112,6 +141,8 @@ func GetQueryPlanAsDotString(distributedPlan *distributedpb.DistributedPlan, pla
 				operatorExecStatsMap[OperatorExecutionStats.NodeId] = OperatorExecutionStats
 			}
 			subGraphName += fmt.Sprintf("\n%s", timeNSToString(agentExecStats.ExecutionTimeNs))
+			subGraphName += fmt.Sprintf("\ncpu_time: %s", timeNSToString(agentExecStats.CpuTimeNs))
+			subGraphName += fmt.Sprintf("\npeak_memory: %s", humanize.IBytes(uint64(agentExecStats.PeakMemoryBytes)))
 		}
 
 		s := g.Subgraph(subGraphName, dot.ClusterOption{})
@@ -131,10 +162,15 @@ func GetQueryPlanAsDotString(distributedPlan *distributedpb.DistributedPlan, pla
 		}
 
 		for _, node := range dag.Nodes {
-			if len(node.SortedChildren) == 0 {
-				continue
+			children := node.SortedChildren
+			// Prefer the operator tree recorded in the profile, which is the one that actually ran.
+			if stats, ok := operatorExecStatsMap[int64(node.Id)]; ok && len(stats.ChildNodeIds) > 0 {
+				children = make([]uint64, len(stats.ChildNodeIds))
+				for i, child := range stats.ChildNodeIds {
+					children[i] = uint64(child)
+				}
 			}
-			for _, child := range node.SortedChildren {
+			for _, child := range children {
 				nodeName := graphNodeName(agentIDStr, node.Id)
 				childName := graphNodeName(agentIDStr, child)
 				s.Edge(nodeMap[nodeName], nodeMap[childName])
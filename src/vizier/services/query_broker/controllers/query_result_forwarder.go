@@ -179,6 +179,12 @@ func newActiveQuery(producerCtx context.Context, tableIDMap map[string]string,
 func (a *activeQuery) updateQueryState(msg *carnotpb.TransferResultChunkRequest) error {
 	queryIDStr := utils.UUIDFromProtoOrNil(msg.QueryID).String()
 
+	// An agent couldn't execute its part of the query, so the query as a whole fails.
+	if execErr := msg.GetExecutionError(); execErr != nil {
+		return fmt.Errorf("Query %s failed on an agent (%s): %s", queryIDStr, execErr.ErrCode.String(),
+			execErr.Msg)
+	}
+
 	// Mark down that we received the exec stats for this query.
 	if execStats := msg.GetExecutionAndTimingInfo(); execStats != nil {
 		if a.gotFinalExecStats {
@@ -224,7 +230,7 @@ func (a *activeQuery) updateQueryState(msg *carnotpb.TransferResultChunkRequest)
 		}
 	}
 
-	return fmt.Errorf("error in ForwardQueryResult: Expected TransferResultChunkRequest to have query result or exec stats")
+	return fmt.Errorf("error in ForwardQueryResult: Expected TransferResultChunkRequest to have query result, exec stats or an execution error")
 }
 
 func (a *activeQuery) queryComplete() bool {